@@ -0,0 +1,10 @@
+#version 430 core
+
+uniform vec4 patchColor;
+
+out vec4 colorsOut;
+
+void main(void)
+{  
+   colorsOut = patchColor;
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <iostream>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "prepShader.h"
+#include "bezierPatches.h"
+
+#define MAX_ORDER 8 // Highest order the tessellation evaluation shader handles.
+
+// Bernstein polynomials of the given order at t by the triangular recurrence.
+static void bernstein(int order, float t, float *B)
+{
+	int j, k;
+	float saved, temp;
+
+	B[0] = 1.0;
+	for (k = 1; k < order; k++)
+	{
+		saved = 0.0;
+		for (j = 0; j < k; j++)
+		{
+			temp = B[j];
+			B[j] = saved + (1.0 - t) * temp;
+			saved = t * temp;
+		}
+		B[k] = saved;
+	}
+}
+
+// Evaluate every patch on the fallback grid.
+static void evaluateGrid(BezierPatches &patches)
+{
+	int numPoints = patches.uOrder * patches.vOrder, gridPoints = BEZIER_CPU_GRID + 1;
+	int p, k, l, i, j, c, first;
+	float uB[MAX_ORDER], vB[MAX_ORDER], *vertex;
+	const float *P;
+
+	patches.gridVertices.resize(patches.numPatches * gridPoints * gridPoints * 4);
+	for (p = 0; p < patches.numPatches; p++)
+		for (l = 0; l < gridPoints; l++)
+		{
+			bernstein(patches.vOrder, (float)l / BEZIER_CPU_GRID, vB);
+			for (k = 0; k < gridPoints; k++)
+			{
+				bernstein(patches.uOrder, (float)k / BEZIER_CPU_GRID, uB);
+				vertex = &patches.gridVertices[((p * gridPoints + l) * gridPoints + k) * 4];
+				for (c = 0; c < 4; c++) vertex[c] = 0.0;
+				for (i = 0; i < patches.vOrder; i++)
+					for (j = 0; j < patches.uOrder; j++)
+					{
+						P = &patches.controlPoints[(p * numPoints + i * patches.uOrder + j) * 4];
+						for (c = 0; c < 4; c++) vertex[c] += vB[i] * uB[j] * P[c];
+					}
+			}
+		}
+
+	if (patches.gridIndices.empty())
+		for (p = 0; p < patches.numPatches; p++)
+			for (l = 0; l < BEZIER_CPU_GRID; l++)
+				for (k = 0; k < BEZIER_CPU_GRID; k++)
+				{
+					first = (p * gridPoints + l) * gridPoints + k;
+					patches.gridIndices.push_back(first);
+					patches.gridIndices.push_back(first + 1);
+					patches.gridIndices.push_back(first + gridPoints + 1);
+					patches.gridIndices.push_back(first);
+					patches.gridIndices.push_back(first + gridPoints + 1);
+					patches.gridIndices.push_back(first + gridPoints);
+				}
+
+	patches.gridValid = true;
+}
+
+// Build the tessellation program and control point buffer for numPatches patches of the
+// given orders. The tessellation path is used only with a GL 4 context.
+void createBezierPatches(BezierPatches &patches, int uOrder, int vOrder, int numPatches)
+{
+	int major = 0, linked = 0;
+	unsigned int vertexShaderId, tessControlShaderId, tessEvaluationShaderId, fragmentShaderId;
+
+	patches.uOrder = uOrder;
+	patches.vOrder = vOrder;
+	patches.numPatches = numPatches;
+	patches.tolerance = 10.0;
+	patches.cpuFallback = false;
+	patches.gridValid = false;
+	patches.controlPoints.assign(numPatches * uOrder * vOrder * 4, 0.0);
+
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	patches.tessellationSupported = (major >= 4) && (uOrder <= MAX_ORDER) && (vOrder <= MAX_ORDER) &&
+		(uOrder * vOrder <= BEZIER_MAX_PATCH_POINTS);
+	if (!patches.tessellationSupported)
+	{
+		std::cout << "Tessellation shaders unavailable: evaluating Bezier patches on the CPU." << std::endl;
+		return;
+	}
+
+	// Create shader program executable.
+	vertexShaderId = setShader("vertex", "Shaders/vertexShader.glsl");
+	tessControlShaderId = setShader("tessControl", "Shaders/tessControlShader.glsl");
+	tessEvaluationShaderId = setShader("tessEvaluation", "Shaders/tessEvaluationShader.glsl");
+	fragmentShaderId = setShader("fragment", "Shaders/fragmentShader.glsl");
+	patches.programId = glCreateProgram();
+	glAttachShader(patches.programId, vertexShaderId);
+	glAttachShader(patches.programId, tessControlShaderId);
+	glAttachShader(patches.programId, tessEvaluationShaderId);
+	glAttachShader(patches.programId, fragmentShaderId);
+	glLinkProgram(patches.programId);
+	glGetProgramiv(patches.programId, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		std::cout << "Tessellation program failed to link: evaluating Bezier patches on the CPU." << std::endl;
+		patches.tessellationSupported = false;
+		return;
+	}
+
+	// Obtain uniform locations.
+	patches.uOrderLoc = glGetUniformLocation(patches.programId, "uOrder");
+	patches.vOrderLoc = glGetUniformLocation(patches.programId, "vOrder");
+	patches.modelViewMatLoc = glGetUniformLocation(patches.programId, "modelViewMat");
+	patches.projMatLoc = glGetUniformLocation(patches.programId, "projMat");
+	patches.viewportSizeLoc = glGetUniformLocation(patches.programId, "viewportSize");
+	patches.toleranceLoc = glGetUniformLocation(patches.programId, "tolerance");
+	patches.patchColorLoc = glGetUniformLocation(patches.programId, "patchColor");
+
+	// Create VAO and VBO and reserve space for the control points.
+	glGenVertexArrays(1, patches.vao);
+	glGenBuffers(1, patches.buffer);
+	glBindVertexArray(patches.vao[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, patches.buffer[0]);
+	glBufferData(GL_ARRAY_BUFFER, patches.controlPoints.size() * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Replace the homogeneous control points of count patches starting at firstPatch.
+void updateBezierPatches(BezierPatches &patches, int firstPatch, int count, const float *controlPoints)
+{
+	int patchFloats = patches.uOrder * patches.vOrder * 4;
+
+	std::copy(controlPoints, controlPoints + count * patchFloats,
+		patches.controlPoints.begin() + firstPatch * patchFloats);
+	patches.gridValid = false;
+
+	if (!patches.tessellationSupported) return;
+	glBindBuffer(GL_ARRAY_BUFFER, patches.buffer[0]);
+	glBufferSubData(GL_ARRAY_BUFFER, firstPatch * patchFloats * sizeof(float),
+		count * patchFloats * sizeof(float), controlPoints);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Draw all the patches in the given color with the current modelview and projection
+// matrices and polygon mode.
+void drawBezierPatches(BezierPatches &patches, const float *color)
+{
+	float modelViewMat[16], projMat[16];
+	int viewport[4];
+
+	if (patches.tessellationSupported && !patches.cpuFallback)
+	{
+		glGetFloatv(GL_MODELVIEW_MATRIX, modelViewMat);
+		glGetFloatv(GL_PROJECTION_MATRIX, projMat);
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		glUseProgram(patches.programId);
+		glUniform1i(patches.uOrderLoc, patches.uOrder);
+		glUniform1i(patches.vOrderLoc, patches.vOrder);
+		glUniformMatrix4fv(patches.modelViewMatLoc, 1, GL_FALSE, modelViewMat);
+		glUniformMatrix4fv(patches.projMatLoc, 1, GL_FALSE, projMat);
+		glUniform2f(patches.viewportSizeLoc, (float)viewport[2], (float)viewport[3]);
+		glUniform1f(patches.toleranceLoc, patches.tolerance);
+		glUniform4fv(patches.patchColorLoc, 1, color);
+
+		glBindVertexArray(patches.vao[0]);
+		glPatchParameteri(GL_PATCH_VERTICES, patches.uOrder * patches.vOrder);
+		glDrawArrays(GL_PATCHES, 0, patches.numPatches * patches.uOrder * patches.vOrder);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		return;
+	}
+
+	if (!patches.gridValid) evaluateGrid(patches);
+	glColor4fv(color);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(4, GL_FLOAT, 0, &patches.gridVertices[0]);
+	glDrawElements(GL_TRIANGLES, patches.gridIndices.size(), GL_UNSIGNED_INT, &patches.gridIndices[0]);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
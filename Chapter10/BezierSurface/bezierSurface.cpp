@@ -4,12 +4,18 @@
 // This program allows the user to design a Bezier surface by moving control points.
 // Also drawn is the control polyghedron.
 //
+// The surface is evaluated by bezierPatches.cpp in tessellation shaders from control
+// points uploaded once and again only when moved, with tessellation levels following
+// the patch's size on screen. Without tessellation shader support it falls back to a
+// 20x20 grid evaluated on the CPU.
+//
 // Interaction:
 // Press space and tab to select a control point.
 // Press the right/left arrow keys to move the control point up/down the x-axis.
 // Press the up/down arrow keys to move the control point up/down the y-axis.
 // Press the page up/down keys to move the control point up/down the z-axis.
 // Press the x, X, y, Y, z, Z keys to rotate the viewpoint.
+// Press 'c' to toggle between GPU tessellation and CPU evaluation.
 //
 //Sumanta Guha.
 //////////////////////////////////////////////////////////////////////////////////// 
@@ -19,6 +25,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "bezierPatches.h"
+
 // Begin globals.
 // Initial control points.
 static float controlPoints[6][4][3] =
@@ -31,6 +39,10 @@ static float controlPoints[6][4][3] =
 	{ { -3.0, 0.0, -5.0 },{ -0.25, 0.0, -5.0 },{ 0.25, 0.0, -5.0 },{ 3.0, 0.0, -5.0 } },
 };
 
+// Control points in homogeneous co-ordinates.
+static float controlPointsHomogeneous[6][4][4];
+
+static BezierPatches surface; // The Bezier surface as a single patch.
 static float Xangle = 30.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate canoe.
 static int rowCount = 0, columnCount = 0; // Indexes of selected control point.
 										  // End globals.
@@ -43,10 +55,27 @@ void writeStrokeString(void *font, char *string)
 	for (c = string; *c != '\0'; c++) glutStrokeCharacter(font, *c);
 }
 
+// Copy the control points with weight 1 to the Bezier patch.
+void updateSurface(void)
+{
+	int i, j, k;
+	for (i = 0; i < 6; i++)
+		for (j = 0; j < 4; j++)
+		{
+			for (k = 0; k < 3; k++) controlPointsHomogeneous[i][j][k] = controlPoints[i][j][k];
+			controlPointsHomogeneous[i][j][3] = 1.0;
+		}
+	updateBezierPatches(surface, 0, 1, controlPointsHomogeneous[0][0]);
+}
+
 // Initialization routine.
 void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
+
+	// Order 4 along u, across a row of control points, and 6 along v.
+	createBezierPatches(surface, 4, 6, 1);
+	updateSurface();
 }
 
 // Drawing routine.
@@ -93,14 +122,9 @@ void drawScene(void)
 	glVertex3fv(controlPoints[rowCount][columnCount]);
 	glEnd();
 
-	// Specify and enable the Bezier surface.
-	glMap2f(GL_MAP2_VERTEX_3, 0, 1, 3, 4, 0, 1, 12, 6, controlPoints[0][0]);
-	glEnable(GL_MAP2_VERTEX_3);
-
-	// Draw the Bezier surface using a mesh approximation.
-	glColor3f(0.0, 0.0, 0.0);
-	glMapGrid2f(20, 0.0, 1.0, 20, 0.0, 1.0);
-	glEvalMesh2(GL_LINE, 0, 20, 0, 20);
+	// Draw the Bezier surface as a mesh.
+	float black[4] = { 0.0, 0.0, 0.0, 1.0 };
+	drawBezierPatches(surface, black);
 
 	// Draw the co-ordinate axes.
 	glLineWidth(2.0);
@@ -213,6 +237,10 @@ void keyInput(unsigned char key, int x, int y)
 	}
 	glutPostRedisplay();
 	break;
+	case 'c':
+		surface.cpuFallback = !surface.cpuFallback;
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
@@ -227,6 +255,7 @@ void specialKeyInput(int key, int x, int y)
 	if (key == GLUT_KEY_UP) controlPoints[rowCount][columnCount][1] += 0.1;
 	if (key == GLUT_KEY_PAGE_DOWN) controlPoints[rowCount][columnCount][2] -= 0.1;
 	if (key == GLUT_KEY_PAGE_UP) controlPoints[rowCount][columnCount][2] += 0.1;
+	updateSurface();
 	glutPostRedisplay();
 }
 
@@ -238,7 +267,8 @@ void printInteraction(void)
 		<< "Press the right/left arrow keys to move the control point up/down the x-axis." << std::endl
 		<< "Press the up/down arrow keys to move the control point up/down the y-axis." << std::endl
 		<< "Press the page up/down keys to move the control point up/down the z-axis." << std::endl
-		<< "Press the x, X, y, Y, z, Z keys to rotate the viewpoint." << std::endl;
+		<< "Press the x, X, y, Y, z, Z keys to rotate the viewpoint." << std::endl
+		<< "Press 'c' to toggle between GPU tessellation and CPU evaluation." << std::endl;
 }
 
 // Main routine.
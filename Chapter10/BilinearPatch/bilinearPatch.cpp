@@ -18,10 +18,12 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "surfaceSampler.h"
+
 // Globals.
 static int p = 8; // Number of grid columns.
 static int q = 8; // Number of grid rows
-static float *vertices = NULL; // Vertex array of the mapped sample on the patch.
+static SurfaceMesh mesh; // Mapped sample on the patch.
 static float Xangle = 330.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate the patch.
 static float
 p1x = -1.0, p1y = 0.0, p1z = 0.0, // First endpoint co-ordinates of first segment. 
@@ -29,38 +31,25 @@ q1x = -1.0, q1y = 2.0, q1z = 0.0, // Second endpoint co-ordinates of first segme
 p2x = 1.0, p2y = 0.0, p2z = 0.0, // First endpoint co-ordinates of second segment. 
 q2x = 1.0, q2y = 0.0, q2z = -2.0; // Second endpoint co-ordinates of second segment. 
 
-// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the patch.
-float f(int i, int j)
+// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the patch,
+// u_i = i/p and v_j = j/q.
+struct Patch
 {
-	return ((1 - (float)i / p)*(1 - (float)j / q)*p1x + ((float)i / p)*(1 - (float)j / q)*q1x +
-		(1 - (float)i / p)*((float)j / q)*p2x + ((float)i / p)*((float)j / q)*q2x);
-}
-
-float g(int i, int j)
-{
-	return ((1 - (float)i / p)*(1 - (float)j / q)*p1y + ((float)i / p)*(1 - (float)j / q)*q1y +
-		(1 - (float)i / p)*((float)j / q)*p2y + ((float)i / p)*((float)j / q)*q2y);
-}
-
-float h(int i, int j)
-{
-	return ((1 - (float)i / p)*(1 - (float)j / q)*p1z + ((float)i / p)*(1 - (float)j / q)*q1z +
-		(1 - (float)i / p)*((float)j / q)*p2z + ((float)i / p)*((float)j / q)*q2z);
-}
+	template <class T> void operator()(const T &u, const T &v, T &f, T &g, T &h) const
+	{
+		f = (1 - u) * (1 - v) * p1x + u * (1 - v) * q1x + (1 - u) * v * p2x + u * v * q2x;
+		g = (1 - u) * (1 - v) * p1y + u * (1 - v) * q1y + (1 - u) * v * p2y + u * v * q2y;
+		h = (1 - u) * (1 - v) * p1z + u * (1 - v) * q1z + (1 - u) * v * p2z + u * v * q2z;
+	}
+};
 
-// Routine to fill the vertex array with co-ordinates of the mapped sample points.
+// Routine to fill the vertex array with co-ordinates of the mapped sample points if the
+// grid has changed since it was last filled.
 void fillVertexArray(void)
 {
-	int i, j, k;
-
-	k = 0;
-	for (j = 0; j <= q; j++)
-		for (i = 0; i <= p; i++)
-		{
-			vertices[k++] = f(i, j);
-			vertices[k++] = g(i, j);
-			vertices[k++] = h(i, j);
-		}
+	if (mesh.p == p && mesh.q == q) return;
+
+	sampleSurface(Patch(), 0.0, 1.0, 0.0, 1.0, p, q, false, false, mesh);
 }
 
 // Initialization routine.
@@ -74,10 +63,10 @@ void setup(void)
 // Drawing routine.
 void drawScene(void)
 {
-	int  i, j;
-	vertices = new float[3 * (p + 1)*(q + 1)]; // Dynamic array allocation with new value of p and q. 
+	// Fill the vertex array.
+	fillVertexArray();
 
-	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glVertexPointer(3, GL_FLOAT, 0, &mesh.vertices[0]);
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	glLoadIdentity();
@@ -92,20 +81,9 @@ void drawScene(void)
 	glRotatef(Yangle, 0.0, 1.0, 0.0);
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
-	// Fill the vertex array.
-	fillVertexArray();
-
-	// Make the approximating triangular mesh.
-	for (j = 0; j < q; j++)
-	{
-		glBegin(GL_TRIANGLE_STRIP);
-		for (i = 0; i <= p; i++)
-		{
-			glArrayElement((j + 1)*(p + 1) + i);
-			glArrayElement(j*(p + 1) + i);
-		}
-		glEnd();
-	}
+	// Make the approximating triangular mesh, a triangle strip between each two rows.
+	glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP, &mesh.countIndices[0], GL_UNSIGNED_INT, &mesh.strips[0], q,
+		&mesh.baseVertices[0]);
 
 	glutSwapBuffers();
 }
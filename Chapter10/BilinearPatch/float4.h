@@ -0,0 +1,88 @@
+#ifndef FLOAT4_H
+#define FLOAT4_H
+
+// Float4 class: four floats operated on together, in an SSE register where the compiler
+// targets SSE and otherwise one after another. Comparisons return masks, each float of
+// which has all its bits set where the comparison holds and none where it does not, to be
+// combined with &, | and andNot(), chosen by with select() and tested with bits().
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define FLOAT4_SSE
+#include <xmmintrin.h>
+#endif
+
+struct Float4
+{
+	union
+	{
+#ifdef FLOAT4_SSE
+		__m128 m;
+#endif
+		float f[4];
+		unsigned int u[4];
+	};
+
+	Float4() {}
+#ifdef FLOAT4_SSE
+	Float4(__m128 m) : m(m) {}
+	Float4(float x) : m(_mm_set1_ps(x)) {}
+	Float4(float a, float b, float c, float d) : m(_mm_setr_ps(a, b, c, d)) {}
+#else
+	Float4(float x) { f[0] = f[1] = f[2] = f[3] = x; }
+	Float4(float a, float b, float c, float d) { f[0] = a; f[1] = b; f[2] = c; f[3] = d; }
+#endif
+	float operator[](int i) const { return f[i]; }
+	float &operator[](int i) { return f[i]; }
+};
+
+#ifdef FLOAT4_SSE
+
+inline Float4 operator+(const Float4 &a, const Float4 &b) { return _mm_add_ps(a.m, b.m); }
+inline Float4 operator-(const Float4 &a, const Float4 &b) { return _mm_sub_ps(a.m, b.m); }
+inline Float4 operator*(const Float4 &a, const Float4 &b) { return _mm_mul_ps(a.m, b.m); }
+inline Float4 operator/(const Float4 &a, const Float4 &b) { return _mm_div_ps(a.m, b.m); }
+inline Float4 min(const Float4 &a, const Float4 &b) { return _mm_min_ps(a.m, b.m); }
+inline Float4 max(const Float4 &a, const Float4 &b) { return _mm_max_ps(a.m, b.m); }
+inline Float4 operator<(const Float4 &a, const Float4 &b) { return _mm_cmplt_ps(a.m, b.m); }
+inline Float4 operator<=(const Float4 &a, const Float4 &b) { return _mm_cmple_ps(a.m, b.m); }
+inline Float4 operator>(const Float4 &a, const Float4 &b) { return _mm_cmpgt_ps(a.m, b.m); }
+inline Float4 operator>=(const Float4 &a, const Float4 &b) { return _mm_cmpge_ps(a.m, b.m); }
+inline Float4 operator&(const Float4 &a, const Float4 &b) { return _mm_and_ps(a.m, b.m); }
+inline Float4 operator|(const Float4 &a, const Float4 &b) { return _mm_or_ps(a.m, b.m); }
+inline Float4 andNot(const Float4 &a, const Float4 &b) { return _mm_andnot_ps(a.m, b.m); } // ~a & b.
+inline int bits(const Float4 &mask) { return _mm_movemask_ps(mask.m); }
+
+#else
+
+#define FLOAT4_OP(op) \
+	inline Float4 operator op(const Float4 &a, const Float4 &b) \
+	{ return Float4(a.f[0] op b.f[0], a.f[1] op b.f[1], a.f[2] op b.f[2], a.f[3] op b.f[3]); }
+FLOAT4_OP(+) FLOAT4_OP(-) FLOAT4_OP(*) FLOAT4_OP(/)
+#undef FLOAT4_OP
+
+#define FLOAT4_CMP(op) \
+	inline Float4 operator op(const Float4 &a, const Float4 &b) \
+	{ Float4 r; for (int i = 0; i < 4; i++) r.u[i] = a.f[i] op b.f[i] ? 0xFFFFFFFF : 0; return r; }
+FLOAT4_CMP(<) FLOAT4_CMP(<=) FLOAT4_CMP(>) FLOAT4_CMP(>=)
+#undef FLOAT4_CMP
+
+#define FLOAT4_BITS(name, expr) \
+	inline Float4 name(const Float4 &a, const Float4 &b) \
+	{ Float4 r; for (int i = 0; i < 4; i++) r.u[i] = expr; return r; }
+FLOAT4_BITS(operator&, a.u[i] & b.u[i]) FLOAT4_BITS(operator|, a.u[i] | b.u[i])
+FLOAT4_BITS(andNot, ~a.u[i] & b.u[i]) // ~a & b.
+#undef FLOAT4_BITS
+
+// Minimum and maximum as SSE takes them, b where either is NaN.
+inline Float4 min(const Float4 &a, const Float4 &b)
+{ Float4 r; for (int i = 0; i < 4; i++) r.f[i] = a.f[i] < b.f[i] ? a.f[i] : b.f[i]; return r; }
+inline Float4 max(const Float4 &a, const Float4 &b)
+{ Float4 r; for (int i = 0; i < 4; i++) r.f[i] = a.f[i] > b.f[i] ? a.f[i] : b.f[i]; return r; }
+inline int bits(const Float4 &mask)
+{ return (mask.u[0] >> 31) | (mask.u[1] >> 31) << 1 | (mask.u[2] >> 31) << 2 | (mask.u[3] >> 31) << 3; }
+
+#endif
+
+inline Float4 select(const Float4 &mask, const Float4 &a, const Float4 &b) { return (mask & a) | andNot(mask, b); }
+
+#endif
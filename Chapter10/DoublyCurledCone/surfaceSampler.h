@@ -0,0 +1,270 @@
+#ifndef SURFACESAMPLER_H
+#define SURFACESAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "float4.h"
+
+#define SURFACE_THREAD_SAMPLES 65536 // Fewest samples a grid needs to be split among threads.
+
+// Sampling of a parametric surface (f(u, v), g(u, v), h(u, v)) over a grid of p columns and
+// q rows, four samples of a grid row at a time, one in each float of a Float4.
+//
+// The surface is any class with a member template
+//
+//    template <class T> void operator()(const T &u, const T &v, T &f, T &g, T &h) const
+//
+// written, as the f(), g() and h() functions of the mesh programs are, with +, -, *, /, sin(),
+// cos(), tan() and sqrt(). It is called with T a Float4 for the vertices alone and with T a
+// SurfaceDual for the vertices with their normals or tangents, whose derivatives along u and
+// v it then carries through every operation, differentiating the surface automatically. A
+// surface that knows its derivatives can write them to the du and dv of f, g and h itself.
+
+// Routine to round four floats to the nearest integers, exactly for magnitudes below 2^22.
+inline Float4 roundFloat4(const Float4 &a)
+{
+	Float4 magic(12582912.0); // 1.5 * 2^23, past which floats have no fraction.
+	return (a + magic) - magic;
+}
+
+inline Float4 operator-(const Float4 &a) { return Float4(0.0) - a; }
+
+inline Float4 sqrt(const Float4 &a)
+{
+#ifdef FLOAT4_SSE
+	return _mm_sqrt_ps(a.m);
+#else
+	Float4 r;
+	for (int i = 0; i < 4; i++) r.f[i] = std::sqrt(a.f[i]);
+	return r;
+#endif
+}
+
+// Routine to find the sines and cosines of four floats, to within a few units in the last
+// place for arguments of moderate size. The argument is reduced by the nearest multiple k
+// of pi/2 to [-pi/4, pi/4], where Cephes' minimax polynomials for sinf() and cosf() are
+// evaluated, then the two are swapped and negated by the quadrant, k mod 4.
+inline void sinCos(const Float4 &a, Float4 &s, Float4 &c)
+{
+	Float4 k = roundFloat4(a * Float4(0.636619772f)); // a / (pi / 2).
+	Float4 x = a - k * Float4(1.5703125f) - k * Float4(4.837512969970703125e-4f) -
+		       k * Float4(7.54978995489188216e-8f); // pi / 2 in three parts, for exact products.
+	Float4 x2 = x * x;
+	Float4 sx = x + x * x2 * (Float4(-1.6666654611e-1f) + x2 * (Float4(8.3321608736e-3f) +
+		                                                         x2 * Float4(-1.9515295891e-4f)));
+	Float4 cx = Float4(1.0) - Float4(0.5) * x2 + x2 * x2 * (Float4(4.166664568298827e-2f) +
+		        x2 * (Float4(-1.388731625493765e-3f) + x2 * Float4(2.443315711809948e-5f)));
+	Float4 quadrant = k - Float4(4.0) * roundFloat4((k - Float4(1.5)) * Float4(0.25)); // 0, 1, 2 or 3.
+	Float4 odd = ((quadrant > Float4(0.5)) & (quadrant < Float4(1.5))) | (quadrant > Float4(2.5));
+	Float4 sinNegative = quadrant > Float4(1.5);
+	Float4 cosNegative = (quadrant > Float4(0.5)) & (quadrant < Float4(2.5));
+
+	s = select(odd, cx, sx);
+	c = select(odd, sx, cx);
+	s = select(sinNegative, -s, s);
+	c = select(cosNegative, -c, c);
+}
+
+inline Float4 sin(const Float4 &a) { Float4 s, c; sinCos(a, s, c); return s; }
+inline Float4 cos(const Float4 &a) { Float4 s, c; sinCos(a, s, c); return c; }
+inline Float4 tan(const Float4 &a) { Float4 s, c; sinCos(a, s, c); return s / c; }
+
+// Dual number class: four values of a function of u and v together with their derivatives
+// along u and v, each operation applying the chain rule.
+struct SurfaceDual
+{
+	Float4 val, du, dv;
+
+	SurfaceDual() {}
+	SurfaceDual(float a) : val(a), du(0.0), dv(0.0) {} // A constant.
+	SurfaceDual(const Float4 &a) : val(a), du(0.0), dv(0.0) {}
+	SurfaceDual(const Float4 &a, const Float4 &aDu, const Float4 &aDv) : val(a), du(aDu), dv(aDv) {}
+};
+
+inline SurfaceDual operator+(const SurfaceDual &a, const SurfaceDual &b)
+{ return SurfaceDual(a.val + b.val, a.du + b.du, a.dv + b.dv); }
+inline SurfaceDual operator-(const SurfaceDual &a, const SurfaceDual &b)
+{ return SurfaceDual(a.val - b.val, a.du - b.du, a.dv - b.dv); }
+inline SurfaceDual operator-(const SurfaceDual &a) { return SurfaceDual(-a.val, -a.du, -a.dv); }
+inline SurfaceDual operator*(const SurfaceDual &a, const SurfaceDual &b)
+{ return SurfaceDual(a.val * b.val, a.du * b.val + a.val * b.du, a.dv * b.val + a.val * b.dv); }
+inline SurfaceDual operator/(const SurfaceDual &a, const SurfaceDual &b)
+{
+	Float4 quotient = a.val / b.val;
+	return SurfaceDual(quotient, (a.du - quotient * b.du) / b.val, (a.dv - quotient * b.dv) / b.val);
+}
+
+inline SurfaceDual sin(const SurfaceDual &a)
+{
+	Float4 s, c;
+	sinCos(a.val, s, c);
+	return SurfaceDual(s, c * a.du, c * a.dv);
+}
+
+inline SurfaceDual cos(const SurfaceDual &a)
+{
+	Float4 s, c;
+	sinCos(a.val, s, c);
+	return SurfaceDual(c, -s * a.du, -s * a.dv);
+}
+
+inline SurfaceDual tan(const SurfaceDual &a)
+{
+	Float4 s, c;
+	sinCos(a.val, s, c);
+	Float4 t = s / c, derivative = Float4(1.0) + t * t;
+	return SurfaceDual(t, derivative * a.du, derivative * a.dv);
+}
+
+inline SurfaceDual sqrt(const SurfaceDual &a)
+{
+	Float4 root = sqrt(a.val), derivative = Float4(0.5) / root;
+	return SurfaceDual(root, derivative * a.du, derivative * a.dv);
+}
+
+// A sampled surface. Its arrays keep their storage when the grid changes, growing only when
+// it does past their size. Every strip is drawn from the same indices, those of the strip 
+// between rows 0 and 1, offset by the first sample of its lower row, so that only they
+// are made again when p changes and nothing of size pq when q does.
+struct SurfaceMesh
+{
+	SurfaceMesh() : p(0), q(0) {}
+
+	int p, q; // Grid columns and rows.
+	std::vector<float> vertices; // Co-ordinates of the (p + 1)(q + 1) samples, a row at a time.
+	std::vector<float> normals; // Unit normals of the samples, (0, 0, 0) where the surface has none,
+	                            // if asked for.
+	std::vector<float> tangents; // Tangents along u then along v, 6 floats a sample, if asked for.
+	std::vector<unsigned int> indices; // Triangle strip between rows 0 and 1.
+	std::vector<int> countIndices; // Indices of each strip, for glMultiDrawElementsBaseVertex().
+	std::vector<const void *> strips; // Start of each strip, all the indices.
+	std::vector<int> baseVertices; // First sample of each strip's lower row.
+};
+
+// Routine to fill the index arrays of a mesh for a grid of p columns and q rows, the
+// strips alternating between the samples of rows j + 1 and j as the mesh programs draw them.
+inline void fillSurfaceIndices(SurfaceMesh &mesh, int p, int q)
+{
+	int i, j;
+
+	if (mesh.p != p)
+	{
+		mesh.indices.resize(2 * (p + 1));
+		for (i = 0; i <= p; i++)
+		{
+			mesh.indices[2 * i] = p + 1 + i;
+			mesh.indices[2 * i + 1] = i;
+		}
+	}
+	mesh.p = p;
+	mesh.q = q;
+	mesh.countIndices.assign(q, 2 * (p + 1));
+	mesh.strips.assign(q, &mesh.indices[0]);
+	mesh.baseVertices.resize(q);
+	for (j = 0; j < q; j++) mesh.baseVertices[j] = j * (p + 1);
+}
+
+// Routine to run job(first, last) on runs of rows 0 to numRows - 1 that together cover them,
+// a run on each hardware thread if there are samples enough to be worth starting threads.
+template <class Job>
+void forSurfaceRows(int numRows, int rowSamples, const Job &job)
+{
+	int numThreads = std::min((int)std::thread::hardware_concurrency(), numRows), t;
+	std::vector<std::thread> threads;
+
+	if (numThreads < 2 || (long long)numRows * rowSamples < SURFACE_THREAD_SAMPLES)
+	{
+		job(0, numRows);
+		return;
+	}
+	for (t = 1; t < numThreads; t++)
+		threads.push_back(std::thread(job, (int)((long long)numRows * t / numThreads),
+			(int)((long long)numRows * (t + 1) / numThreads)));
+	job(0, numRows / numThreads);
+	for (auto &thread : threads) thread.join();
+}
+
+// Sample the surface at the grid vertices (u_i, v_j), u_i = u0 + (u1 - u0) i / p and
+// v_j = v0 + (v1 - v0) j / q, 0 <= i <= p, 0 <= j <= q, with the normals as well if normals
+// and the tangents if tangents. Only the arrays asked for are filled, the others being
+// emptied, as the tangents alone take twice the memory of the vertices. Large grids are 
+// sampled on several threads, each taking a run of rows.
+template <class Surface>
+void sampleSurface(const Surface &surface, float u0, float u1, float v0, float v1, int p, int q,
+	               bool normals, bool tangents, SurfaceMesh &mesh)
+{
+	int numSamples = (p + 1) * (q + 1);
+	float uStep = (u1 - u0) / p, vStep = (v1 - v0) / q;
+	Float4 laneOffsets(0.0, 1.0, 2.0, 3.0), zero(0.0), tiny(1.0e-24f);
+
+	if (mesh.p != p || mesh.q != q) fillSurfaceIndices(mesh, p, q);
+	mesh.vertices.resize(3 * numSamples);
+	mesh.normals.resize(normals ? 3 * numSamples : 0);
+	mesh.tangents.resize(tangents ? 6 * numSamples : 0);
+
+	forSurfaceRows(q + 1, p + 1, [&](int firstRow, int lastRow)
+	{
+		int i, j, k, lanes;
+
+		for (j = firstRow; j < lastRow; j++)
+		{
+			Float4 v(v0 + vStep * j);
+			for (i = 0; i <= p; i += 4)
+			{
+				Float4 u = Float4(u0) + (Float4((float)i) + laneOffsets) * Float4(uStep);
+				float *vertex = &mesh.vertices[3 * (j * (p + 1) + i)];
+				lanes = p + 1 - i < 4 ? p + 1 - i : 4; // The last lanes of a row may be past its end.
+
+				if (!normals && !tangents)
+				{
+					Float4 f, g, h;
+					surface(u, v, f, g, h);
+					for (k = 0; k < lanes; k++)
+					{
+						vertex[3 * k] = f[k]; vertex[3 * k + 1] = g[k]; vertex[3 * k + 2] = h[k];
+					}
+					continue;
+				}
+
+				// Differentiate by seeding u with du = 1 and v with dv = 1.
+				SurfaceDual f, g, h;
+				surface(SurfaceDual(u, Float4(1.0), zero), SurfaceDual(v, zero, Float4(1.0)), f, g, h);
+
+				for (k = 0; k < lanes; k++)
+				{
+					vertex[3 * k] = f.val[k]; vertex[3 * k + 1] = g.val[k]; vertex[3 * k + 2] = h.val[k];
+				}
+
+				if (normals)
+				{
+					// Normal, the unit cross product of the tangents.
+					Float4 nx = g.du * h.dv - h.du * g.dv, ny = h.du * f.dv - f.du * h.dv, nz = f.du * g.dv - g.du * f.dv;
+					Float4 lengthSquared = nx * nx + ny * ny + nz * nz;
+					Float4 scale = select(lengthSquared > tiny, Float4(1.0) / sqrt(lengthSquared), zero);
+					nx = nx * scale; ny = ny * scale; nz = nz * scale;
+
+					float *normal = &mesh.normals[3 * (j * (p + 1) + i)];
+					for (k = 0; k < lanes; k++)
+					{
+						normal[3 * k] = nx[k]; normal[3 * k + 1] = ny[k]; normal[3 * k + 2] = nz[k];
+					}
+				}
+
+				if (tangents)
+				{
+					float *tangent = &mesh.tangents[6 * (j * (p + 1) + i)];
+					for (k = 0; k < lanes; k++)
+					{
+						tangent[6 * k] = f.du[k]; tangent[6 * k + 1] = g.du[k]; tangent[6 * k + 2] = h.du[k];
+						tangent[6 * k + 3] = f.dv[k]; tangent[6 * k + 4] = g.dv[k]; tangent[6 * k + 5] = h.dv[k];
+					}
+				}
+			}
+		}
+	});
+}
+
+#endif
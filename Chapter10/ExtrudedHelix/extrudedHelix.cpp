@@ -17,43 +17,35 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "surfaceSampler.h"
+
 #define PI 3.14159265358979324
 
 // Globals.
 static int p = 32;// Number of grid columns.
 static int q = 6; // Number of grid rows
-static float *vertices = NULL; // Vertex array of the mapped sample on the extruded helix.
+static SurfaceMesh mesh; // Mapped sample on the extruded helix.
 static float Xangle = 150.0, Yangle = 210.0, Zangle = 0.0; // Angles to rotate the extruded helix.
 
-// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the extruded helix.
-float f(int i, int j)
+// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the extruded helix,
+// u_i = 10PI i/p and v_j = 4j/q.
+struct ExtrudedHelix
 {
-	return (4 * cos(10.0*PI*(float)i / p));
-}
-
-float g(int i, int j)
-{
-	return (4 * sin(10.0*PI*(float)i / p));
-}
-
-float h(int i, int j)
-{
-	return (10.0*PI*(float)i / p + 4 * (float)j / q);
-}
+	template <class T> void operator()(const T &u, const T &v, T &f, T &g, T &h) const
+	{
+		f = 4 * cos(u);
+		g = 4 * sin(u);
+		h = u + v;
+	}
+};
 
-// Routine to fill the vertex array with co-ordinates of the mapped sample points.
+// Routine to fill the vertex array with co-ordinates of the mapped sample points if the
+// grid has changed since it was last filled.
 void fillVertexArray(void)
 {
-	int i, j, k;
-
-	k = 0;
-	for (j = 0; j <= q; j++)
-		for (i = 0; i <= p; i++)
-		{
-			vertices[k++] = f(i, j);
-			vertices[k++] = g(i, j);
-			vertices[k++] = h(i, j);
-		}
+	if (mesh.p == p && mesh.q == q) return;
+
+	sampleSurface(ExtrudedHelix(), 0.0, 10.0 * PI, 0.0, 4.0, p, q, false, false, mesh);
 }
 
 // Initialization routine.
@@ -67,10 +59,10 @@ void setup(void)
 // Drawing routine.
 void drawScene(void)
 {
-	int  i, j;
-	vertices = new float[3 * (p + 1)*(q + 1)]; // Dynamic array allocation with new value of p and q. 
+	// Fill the vertex array.
+	fillVertexArray();
 
-	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glVertexPointer(3, GL_FLOAT, 0, &mesh.vertices[0]);
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	glLoadIdentity();
@@ -85,20 +77,9 @@ void drawScene(void)
 	glRotatef(Yangle, 0.0, 1.0, 0.0);
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
-	// Fill the vertex array.
-	fillVertexArray();
-
-	// Make the approximating triangular mesh.
-	for (j = 0; j < q; j++)
-	{
-		glBegin(GL_TRIANGLE_STRIP);
-		for (i = 0; i <= p; i++)
-		{
-			glArrayElement((j + 1)*(p + 1) + i);
-			glArrayElement(j*(p + 1) + i);
-		}
-		glEnd();
-	}
+	// Make the approximating triangular mesh, a triangle strip between each two rows.
+	glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP, &mesh.countIndices[0], GL_UNSIGNED_INT, &mesh.strips[0], q,
+		&mesh.baseVertices[0]);
 
 	glutSwapBuffers();
 }
@@ -5,6 +5,11 @@
 // and a fractal tree, all at various levels of recursion. The same data structures 
 // are applied to draw each by changing only certain class member functions.
 //
+// The snowflakes are recorded, by a GeometryRecorder, into vertex and index buffers
+// the first time they are drawn at a level, and redrawn from the recording until the
+// shape or level changes. The tree, whose branches are of different widths, is drawn
+// in immediate mode.
+//
 // Interaction:
 // Press left/right arrows keys to cycle through the fractals.
 // Press up/down arrow keys to increase/decrease the recursion level.
@@ -21,6 +26,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "geometryRecorder.h"
+
 #define PI 3.14159265
 #define ROOT3 1.73205081
 #define ONEBYROOT3 0.57735027
@@ -36,6 +43,9 @@
 static int maxLevel = 0; // Recursion level.
 static int shape = KOCH; // Shape index.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
+static GeometryRecorder snowflake; // Recording of the current snowflake.
+static GeometryRecorder *recorder = NULL; // Recorder the drawing routines write to, if any,
+                                          // else they draw in immediate mode.
 
 class Source; // Make source class visible.
 
@@ -87,6 +97,15 @@ private:
 // Routine to draw Sequel object in case it represents a Koch snowflake or variant Koch snowflake.
 void Sequel::drawKochOrVariant()
 {
+	if (recorder)
+	{
+		recorder->begin(GL_LINE_STRIP);
+		for (int i = 0; i < 5; i++)
+			recorder->vertex2f(coords[2 * i], coords[2 * i + 1]);
+		recorder->end();
+		return;
+	}
+
 	glBegin(GL_LINE_STRIP);
 	for (int i = 0; i < 5; i++)
 		glVertex2f(coords[2 * i], coords[2 * i + 1]);
@@ -132,6 +151,15 @@ private:
 // Routine to draw source line segment.
 void Source::draw()
 {
+	if (recorder)
+	{
+		recorder->begin(GL_LINES);
+		for (int i = 0; i < 2; i++)
+			recorder->vertex2f(coords[2 * i], coords[2 * i + 1]);
+		recorder->end();
+		return;
+	}
+
 	glBegin(GL_LINES);
 	for (int i = 0; i < 2; i++)
 		glVertex2f(coords[2 * i], coords[2 * i + 1]);
@@ -347,20 +375,38 @@ void drawScene(void)
 
 	writeData();
 
-	if (shape == KOCH)
-		// Produce on all three edges of an equilateral triangle.
+	// Record the snowflake if the shape or level has changed since it was last recorded.
+	float params[] = { (float)shape, (float)maxLevel };
+	unsigned long long key = recordingKey(params, 2);
+	if ((shape == KOCH || shape == KOCHVARIANT) && !snowflake.isRecorded(key))
 	{
-		src1.produceKoch(0);
-		src2.produceKoch(0);
-		src3.produceKoch(0);
+		snowflake.startRecording(key);
+		recorder = &snowflake;
+
+		if (shape == KOCH)
+			// Produce on all three edges of an equilateral triangle.
+		{
+			src1.produceKoch(0);
+			src2.produceKoch(0);
+			src3.produceKoch(0);
+		}
+
+		if (shape == KOCHVARIANT)
+			// Produce on all three edges of an equilateral triangle.
+		{
+			src1.produceKochVariant(0);
+			src2.produceKochVariant(0);
+			src3.produceKochVariant(0);
+		}
+
+		recorder = NULL;
+		snowflake.finishRecording();
 	}
 
-	if (shape == KOCHVARIANT)
-		// Produce on all three edges of an equilateral triangle.
+	if (shape == KOCH || shape == KOCHVARIANT)
 	{
-		src1.produceKochVariant(0);
-		src2.produceKochVariant(0);
-		src3.produceKochVariant(0);
+		glColor3f(0.0, 0.0, 0.0);
+		snowflake.draw();
 	}
 
 	if (shape == TREE)
@@ -0,0 +1,277 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// geometryRecorder.cpp
+//
+// Recording of immediate-mode primitives into indexed vertex buffers, replayed with
+// glDrawElements().
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+
+#include <GL/glew.h>
+
+#include "geometryRecorder.h"
+
+// Constructor.
+GeometryRecorder::GeometryRecorder(bool coreProfileVal)
+{
+	coreProfile = coreProfileVal;
+	recorded = false;
+	recordedKey = 0;
+	mode = GL_POINTS;
+	first = 0;
+	currentColor[0] = currentColor[1] = currentColor[2] = currentColor[3] = 1.0;
+	currentNormal[0] = currentNormal[1] = 0.0; currentNormal[2] = 1.0;
+	hasColors = hasNormals = false;
+	vao = buffer[0] = buffer[1] = 0;
+	numVertices = numTriangleIndices = numLineIndices = numPointIndices = 0;
+	drawColors = drawNormals = false;
+}
+
+// Drop any recording and start one with the given key. The current color and normal start
+// at OpenGL's initial ones.
+void GeometryRecorder::startRecording(unsigned long long key)
+{
+	recorded = false;
+	recordedKey = key;
+	vertices.clear();
+	triangleIndices.clear();
+	lineIndices.clear();
+	pointIndices.clear();
+	currentColor[0] = currentColor[1] = currentColor[2] = currentColor[3] = 1.0;
+	currentNormal[0] = currentNormal[1] = 0.0; currentNormal[2] = 1.0;
+	hasColors = hasNormals = false;
+}
+
+// Start a primitive of the given mode, one of glBegin()'s.
+void GeometryRecorder::begin(unsigned int modeVal)
+{
+	mode = modeVal;
+	first = vertices.size() / RECORDER_STRIDE;
+}
+
+// Set the current color.
+void GeometryRecorder::color4f(float r, float g, float b, float a)
+{
+	currentColor[0] = r; currentColor[1] = g; currentColor[2] = b; currentColor[3] = a;
+	hasColors = true;
+}
+
+// Set the current normal.
+void GeometryRecorder::normal3f(float nx, float ny, float nz)
+{
+	currentNormal[0] = nx; currentNormal[1] = ny; currentNormal[2] = nz;
+	hasNormals = true;
+}
+
+// Add a vertex to the primitive, with the current normal and color.
+void GeometryRecorder::vertex3f(float x, float y, float z)
+{
+	float v[RECORDER_STRIDE] = { x, y, z, currentNormal[0], currentNormal[1], currentNormal[2],
+		                         currentColor[0], currentColor[1], currentColor[2], currentColor[3] };
+
+	vertices.insert(vertices.end(), v, v + RECORDER_STRIDE);
+}
+
+// End the primitive.
+void GeometryRecorder::end()
+{
+	addIndices();
+}
+
+// Routine to turn the vertices of the primitive just ended into indices of triangles, lines
+// or points, dropping those left over as glBegin() would, e.g., the last of a triangle list
+// whose count is not a multiple of 3. Each triangle and line ends with the vertex OpenGL
+// takes the flat-shaded color from for the part of the primitive it comes from, the last
+// vertex of a quadrilateral and the first of a polygon.
+void GeometryRecorder::addIndices()
+{
+	std::vector<unsigned int> &tris = triangleIndices, &lines = lineIndices;
+	unsigned int f = first;
+	int count = vertices.size() / RECORDER_STRIDE - first, i;
+
+	switch (mode)
+	{
+	case GL_POINTS:
+		for (i = 0; i < count; i++) pointIndices.push_back(f + i);
+		break;
+	case GL_LINES:
+		for (i = 0; i + 1 < count; i += 2) { lines.push_back(f + i); lines.push_back(f + i + 1); }
+		break;
+	case GL_LINE_STRIP:
+	case GL_LINE_LOOP:
+		for (i = 0; i + 1 < count; i++) { lines.push_back(f + i); lines.push_back(f + i + 1); }
+		if (mode == GL_LINE_LOOP && count > 2) { lines.push_back(f + count - 1); lines.push_back(f); }
+		break;
+	case GL_TRIANGLES:
+		for (i = 0; i + 2 < count; i += 3)
+		{
+			tris.push_back(f + i); tris.push_back(f + i + 1); tris.push_back(f + i + 2);
+		}
+		break;
+	case GL_TRIANGLE_STRIP:
+		// Every other triangle is taken the other way round, to keep the orientation.
+		for (i = 0; i + 2 < count; i++)
+		{
+			if (i % 2 == 0) { tris.push_back(f + i); tris.push_back(f + i + 1); }
+			else { tris.push_back(f + i + 1); tris.push_back(f + i); }
+			tris.push_back(f + i + 2);
+		}
+		break;
+	case GL_TRIANGLE_FAN:
+		for (i = 1; i + 1 < count; i++)
+		{
+			tris.push_back(f); tris.push_back(f + i); tris.push_back(f + i + 1);
+		}
+		break;
+	case GL_POLYGON:
+		// A fan as above, each triangle turned round to end with the first vertex.
+		for (i = 1; i + 1 < count; i++)
+		{
+			tris.push_back(f + i); tris.push_back(f + i + 1); tris.push_back(f);
+		}
+		break;
+	case GL_QUADS:
+		// Split along the diagonal from the second vertex to the last, which ends both halves.
+		for (i = 0; i + 3 < count; i += 4)
+		{
+			tris.push_back(f + i + 1); tris.push_back(f + i + 2); tris.push_back(f + i + 3);
+			tris.push_back(f + i); tris.push_back(f + i + 1); tris.push_back(f + i + 3);
+		}
+		break;
+	case GL_QUAD_STRIP:
+		// Quadrilateral i has the vertices 2i, 2i + 1, 2i + 3 and 2i + 2 in order, the
+		// flat-shaded color coming from 2i + 3.
+		for (i = 0; i + 3 < count; i += 2)
+		{
+			tris.push_back(f + i); tris.push_back(f + i + 1); tris.push_back(f + i + 3);
+			tris.push_back(f + i + 2); tris.push_back(f + i); tris.push_back(f + i + 3);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+// Copy the recording to the vertex and index buffers, the index buffer holding the
+// triangles, then the lines, then the points, and set up the VAO to replay it. The arrays
+// recorded into are then freed.
+void GeometryRecorder::finishRecording()
+{
+	size_t triangleBytes, lineBytes, pointBytes;
+
+	if (vao == 0)
+	{
+		glGenVertexArrays(1, &vao);
+		glGenBuffers(2, buffer);
+	}
+
+	numVertices = vertices.size() / RECORDER_STRIDE;
+	numTriangleIndices = triangleIndices.size();
+	numLineIndices = lineIndices.size();
+	numPointIndices = pointIndices.size();
+	drawColors = hasColors;
+	drawNormals = hasNormals;
+	triangleBytes = numTriangleIndices * sizeof(unsigned int);
+	lineBytes = numLineIndices * sizeof(unsigned int);
+	pointBytes = numPointIndices * sizeof(unsigned int);
+
+	glBindVertexArray(vao);
+
+	// Vertex buffer.
+	glBindBuffer(GL_ARRAY_BUFFER, buffer[0]);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.empty() ? NULL : &vertices[0],
+		         GL_STATIC_DRAW);
+
+	// Index buffer, reserved then filled in three parts.
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangleBytes + lineBytes + pointBytes, NULL, GL_STATIC_DRAW);
+	if (triangleBytes) glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, triangleBytes, &triangleIndices[0]);
+	if (lineBytes) glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, triangleBytes, lineBytes, &lineIndices[0]);
+	if (pointBytes) glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, triangleBytes + lineBytes, pointBytes,
+		                            &pointIndices[0]);
+
+	// Arrays, interleaved in the vertex buffer.
+	if (coreProfile)
+	{
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, RECORDER_STRIDE * sizeof(float), 0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, RECORDER_STRIDE * sizeof(float),
+			                  (void *)(3 * sizeof(float)));
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, RECORDER_STRIDE * sizeof(float),
+			                  (void *)(6 * sizeof(float)));
+		glEnableVertexAttribArray(0);
+		if (drawNormals) glEnableVertexAttribArray(1); else glDisableVertexAttribArray(1);
+		if (drawColors) glEnableVertexAttribArray(2); else glDisableVertexAttribArray(2);
+	}
+	else
+	{
+		glVertexPointer(3, GL_FLOAT, RECORDER_STRIDE * sizeof(float), 0);
+		glNormalPointer(GL_FLOAT, RECORDER_STRIDE * sizeof(float), (void *)(3 * sizeof(float)));
+		glColorPointer(4, GL_FLOAT, RECORDER_STRIDE * sizeof(float), (void *)(6 * sizeof(float)));
+		glEnableClientState(GL_VERTEX_ARRAY);
+		if (drawNormals) glEnableClientState(GL_NORMAL_ARRAY); else glDisableClientState(GL_NORMAL_ARRAY);
+		if (drawColors) glEnableClientState(GL_COLOR_ARRAY); else glDisableClientState(GL_COLOR_ARRAY);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	std::vector<float>().swap(vertices);
+	std::vector<unsigned int>().swap(triangleIndices);
+	std::vector<unsigned int>().swap(lineIndices);
+	std::vector<unsigned int>().swap(pointIndices);
+	recorded = true;
+}
+
+// Replay the recording, a draw call for each kind of primitive in it. With no normals, or
+// no colors, recorded, the current OpenGL normal, or color, is used, as it is for a display list.
+void GeometryRecorder::draw()
+{
+	if (!recorded) return;
+
+	glBindVertexArray(vao);
+	if (numTriangleIndices)
+		glDrawElements(GL_TRIANGLES, numTriangleIndices, GL_UNSIGNED_INT, 0);
+	if (numLineIndices)
+		glDrawElements(GL_LINES, numLineIndices, GL_UNSIGNED_INT,
+			           (void *)(numTriangleIndices * sizeof(unsigned int)));
+	if (numPointIndices)
+		glDrawElements(GL_POINTS, numPointIndices, GL_UNSIGNED_INT,
+			           (void *)((numTriangleIndices + numLineIndices) * sizeof(unsigned int)));
+	glBindVertexArray(0);
+
+	// Arrays leave the current color and normal undefined after drawing, so restore them
+	// to what they would be after the primitives drawn in immediate mode.
+	if (drawColors && !coreProfile) glColor4fv(currentColor);
+	if (drawNormals && !coreProfile) glNormal3fv(currentNormal);
+}
+
+// Delete the buffers and VAO. They are made again by the next recording.
+void GeometryRecorder::release()
+{
+	if (vao != 0)
+	{
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(2, buffer);
+	}
+	vao = buffer[0] = buffer[1] = 0;
+	recorded = false;
+}
+
+// Key for a recording generated by the given parameters: a 64-bit FNV-1a hash of their bytes.
+unsigned long long recordingKey(const float *params, int count)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	unsigned char bytes[sizeof(float)];
+	int i, j;
+
+	for (i = 0; i < count; i++)
+	{
+		memcpy(bytes, &params[i], sizeof(float));
+		for (j = 0; j < (int)sizeof(float); j++)
+		{
+			hash ^= bytes[j];
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
@@ -3,9 +3,14 @@
 //
 // A shape that looks like a helical pipe is approximated with a triangular mesh.
 //
+// The mesh is sampled by sampleSurface(), four vertices at a time, only when the grid
+// changes, and can be shaded with the normals it finds by differentiating the pipe.
+//
 // Interaction:
 // Press left/right arrow keys to increase/decrease the number of grid columns.
 // Press up/down arrow keys to increase/decrease the number of grid rows.
+// Press page up/down to double/halve the numbers of grid columns and rows.
+// Press l to toggle between the wireframe and the lit, shaded pipe.
 // Press x, X, y, Y, z, Z to turn the pipe.
 // 
 // Sumanta Guha.
@@ -17,88 +22,96 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "surfaceSampler.h"
+
 #define PI 3.14159265358979324
 
 // Globals. 
 static int p = 6; // Number of grid columns.
 static int q = 4; // Number of grid rows
-static float *vertices = NULL; // Vertex array of the mapped sample on the pipe.
+static SurfaceMesh mesh; // Mapped sample on the pipe, with its normals if lit.
 static float Xangle = 150.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate the pipe.
+static int isLit = 0; // Lit?
+static int isSampledLit = 0; // Lit when the mesh was last sampled?
 
-// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the pipe.
-float f(int i, int j)
-{
-	return (cos((-1 + 2 * (float)i / p) * PI) + sin((-1 + 2 * (float)j / q) * PI));
-}
-
-float g(int i, int j)
-{
-	return (sin((-1 + 2 * (float)i / p) * PI) + cos((-1 + 2 * (float)j / q) * PI));
-}
-
-float h(int i, int j)
+// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the pipe,
+// u_i = (-1 + 2i/p)PI and v_j = (-1 + 2j/q)PI.
+struct Pipe
 {
-	return ((-1 + 2 * (float)i / p) * PI);
-}
+	template <class T> void operator()(const T &u, const T &v, T &f, T &g, T &h) const
+	{
+		f = cos(u) + sin(v);
+		g = sin(u) + cos(v);
+		h = u;
+	}
+};
 
-// Routine to fill the vertex array with co-ordinates of the mapped sample points.
+// Routine to fill the vertex array, and the normal array if lit, of the mapped sample points
+// if the grid has changed since they were last filled.
 void fillVertexArray(void)
 {
-	int i, j, k;
-
-	k = 0;
-	for (j = 0; j <= q; j++)
-		for (i = 0; i <= p; i++)
-		{
-			vertices[k++] = f(i, j);
-			vertices[k++] = g(i, j);
-			vertices[k++] = h(i, j);
-		}
+	if (mesh.p == p && mesh.q == q && isSampledLit == isLit) return;
+
+	sampleSurface(Pipe(), -PI, PI, -PI, PI, p, q, isLit != 0, false, mesh);
+	isSampledLit = isLit;
 }
 
 // Initialization routine.
 void setup(void)
 {
+	float lightPos[] = { 0.0, 2.0, 8.0, 1.0 };
+
 	glEnableClientState(GL_VERTEX_ARRAY);
 
+	// Light and material for the lit pipe, both sides colored by glColor*().
+	glEnable(GL_LIGHT0);
+	glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+	glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+	glEnable(GL_COLOR_MATERIAL);
+	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+	glEnable(GL_NORMALIZE);
+
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 }
 
 // Drawing routine.
 void drawScene(void)
 {
-	int  i, j;
-	vertices = new float[3 * (p + 1)*(q + 1)]; // Dynamic array allocation with new value of p and q. 
+	// Fill the vertex array.
+	fillVertexArray();
 
-	glVertexPointer(3, GL_FLOAT, 0, vertices);
-	glClear(GL_COLOR_BUFFER_BIT);
+	glVertexPointer(3, GL_FLOAT, 0, &mesh.vertices[0]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	glLoadIdentity();
 	gluLookAt(0.0, 0.0, 8.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
 
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-	glColor3f(0.0, 0.0, 0.0);
+	if (isLit)
+	{
+		glNormalPointer(GL_FLOAT, 0, &mesh.normals[0]);
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glEnable(GL_LIGHTING);
+		glEnable(GL_DEPTH_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glColor3f(0.8, 0.6, 0.2);
+	}
+	else
+	{
+		glDisableClientState(GL_NORMAL_ARRAY);
+		glDisable(GL_LIGHTING);
+		glDisable(GL_DEPTH_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		glColor3f(0.0, 0.0, 0.0);
+	}
 
 	// Rotate scene.
 	glRotatef(Zangle, 0.0, 0.0, 1.0);
 	glRotatef(Yangle, 0.0, 1.0, 0.0);
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
-	// Fill the vertex array.
-	fillVertexArray();
-
-	// Make the approximating triangular mesh.
-	for (j = 0; j < q; j++)
-	{
-		glBegin(GL_TRIANGLE_STRIP);
-		for (i = 0; i <= p; i++)
-		{
-			glArrayElement((j + 1)*(p + 1) + i);
-			glArrayElement(j*(p + 1) + i);
-		}
-		glEnd();
-	}
+	// Make the approximating triangular mesh, a triangle strip between each two rows.
+	glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP, &mesh.countIndices[0], GL_UNSIGNED_INT, &mesh.strips[0], q,
+		&mesh.baseVertices[0]);
 
 	glutSwapBuffers();
 }
@@ -152,6 +165,10 @@ void keyInput(unsigned char key, int x, int y)
 		if (Zangle < 0.0) Zangle += 360.0;
 		glutPostRedisplay();
 		break;
+	case 'l':
+		isLit = !isLit;
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
@@ -164,6 +181,8 @@ void specialKeyInput(int key, int x, int y)
 	if (key == GLUT_KEY_RIGHT) p += 1;
 	if (key == GLUT_KEY_DOWN) if (q > 3) q -= 1;
 	if (key == GLUT_KEY_UP) q += 1;
+	if (key == GLUT_KEY_PAGE_UP) { p = 2 * p < 4096 ? 2 * p : 4096; q = 2 * q < 4096 ? 2 * q : 4096; }
+	if (key == GLUT_KEY_PAGE_DOWN) { p = p / 2 > 3 ? p / 2 : 3; q = q / 2 > 3 ? q / 2 : 3; }
 
 	glutPostRedisplay();
 }
@@ -174,6 +193,8 @@ void printInteraction(void)
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press left/right arrow keys to increase/decrease the number of grid columns." << std::endl
 		<< "Press up/down arrow keys to increase/decrease the number of grid rows." << std::endl
+		<< "Press page up/down to double/halve the numbers of grid columns and rows." << std::endl
+		<< "Press l to toggle between the wireframe and the lit, shaded pipe." << std::endl
 		<< "Press x, X, y, Y, z, Z to turn the pipe." << std::endl;
 }
 
@@ -186,7 +207,7 @@ int main(int argc, char **argv)
 	glutInitContextVersion(4, 3);
 	glutInitContextProfile(GLUT_COMPATIBILITY_PROFILE);
 
-	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
 	glutInitWindowSize(500, 500);
 	glutInitWindowPosition(100, 100);
 	glutCreateWindow("helicalPipe.cpp");
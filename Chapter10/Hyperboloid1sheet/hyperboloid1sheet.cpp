@@ -18,43 +18,35 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "surfaceSampler.h"
+
 #define PI 3.14159265358979324
 
 // Globals.
 static int p = 8; // Number of grid columns.
 static int q = 8; // Number of grid rows
-static float *vertices = NULL; // Vertex array of the mapped sample on the surface.
+static SurfaceMesh mesh; // Mapped sample on the surface.
 static float Xangle = 330.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate the surface. 
 
-// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the patch.
-float f(int i, int j)
+// Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the surface,
+// u_i = (-1 + 2i/p)PI and v_j = (-0.4 + 0.8j/q)PI.
+struct Hyperboloid
 {
-	return (cos((-1 + 2.0*(float)i / p)*PI) / cos((-0.4 + 0.8*(float)j / q)*PI));
-}
-
-float g(int i, int j)
-{
-	return (sin((-1 + 2.0*(float)i / p)*PI) / cos((-0.4 + 0.8*(float)j / q)*PI));
-}
-
-float h(int i, int j)
-{
-	return (tan((-0.4 + 0.8*(float)j / q)*PI));
-}
+	template <class T> void operator()(const T &u, const T &v, T &f, T &g, T &h) const
+	{
+		f = cos(u) / cos(v);
+		g = sin(u) / cos(v);
+		h = tan(v);
+	}
+};
 
-// Routine to fill the vertex array with co-ordinates of the mapped sample points.
+// Routine to fill the vertex array with co-ordinates of the mapped sample points if the
+// grid has changed since it was last filled.
 void fillVertexArray(void)
 {
-	int i, j, k;
-
-	k = 0;
-	for (j = 0; j <= q; j++)
-		for (i = 0; i <= p; i++)
-		{
-			vertices[k++] = f(i, j);
-			vertices[k++] = g(i, j);
-			vertices[k++] = h(i, j);
-		}
+	if (mesh.p == p && mesh.q == q) return;
+
+	sampleSurface(Hyperboloid(), -PI, PI, -0.4 * PI, 0.4 * PI, p, q, false, false, mesh);
 }
 
 // Initialization routine.
@@ -68,10 +60,10 @@ void setup(void)
 // Drawing routine.
 void drawScene(void)
 {
-	int  i, j;
-	vertices = new float[3 * (p + 1)*(q + 1)]; // Dynamic array allocation with new value of p and q. 
+	// Fill the vertex array.
+	fillVertexArray();
 
-	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glVertexPointer(3, GL_FLOAT, 0, &mesh.vertices[0]);
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	glLoadIdentity();
@@ -86,20 +78,9 @@ void drawScene(void)
 	glRotatef(Yangle, 0.0, 1.0, 0.0);
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
-	// Fill the vertex array.
-	fillVertexArray();
-
-	// Make the approximating triangular mesh.
-	for (j = 0; j < q; j++)
-	{
-		glBegin(GL_TRIANGLE_STRIP);
-		for (i = 0; i <= p; i++)
-		{
-			glArrayElement((j + 1)*(p + 1) + i);
-			glArrayElement(j*(p + 1) + i);
-		}
-		glEnd();
-	}
+	// Make the approximating triangular mesh, a triangle strip between each two rows.
+	glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP, &mesh.countIndices[0], GL_UNSIGNED_INT, &mesh.strips[0], q,
+		&mesh.baseVertices[0]);
 
 	glutSwapBuffers();
 }
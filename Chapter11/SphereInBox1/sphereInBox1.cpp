@@ -3,22 +3,38 @@
 //
 // This program draws a green sphere inside a red box. 
 // There is a single positional light source.
+//
+// It can instead draw the scene with the colors of its vertices baked by 
+// sphereInBoxRadiosity.cpp, with lighting off, so as to show the light the box and
+// sphere reflect onto one another.
 // 
 // Interaction:
 // Press up/down arrow keys to open/close the box.
+// Press r to toggle between OpenGL lighting and the baked radiosity colors.
 //
 // Sumanta Guha.
 //////////////////////////////////////////////////////      
 
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
 #define ONE_BY_ROOT_THREE 0.57735
+#define RADIOSITY_FILE "../../Chapter21/SphereInBoxRadiosity/sphereInBoxRadiosity.txt" // Baked colors.
 
 // Begin globals.
 static int step = 0; // Steps in open/closing the box lid.
+static int isRadiosity = 0; // Drawing the baked radiosity colors?
+
+// Baked radiosity mesh: vertex co-ordinates, colors and triangle indices, and the steps
+// the lid was open when it was baked.
+static std::vector<float> radiosityVertices, radiosityColors;
+static std::vector<unsigned int> radiosityIndices;
+static int radiosityStep = -1;
 
 // Box vertex co-ordinate vectors. 
 static float vertices[] =
@@ -59,6 +75,48 @@ static float normals[] =
 };
 // End globals.
 
+// Routine to read the mesh baked by sphereInBoxRadiosity.cpp, returning if it could.
+bool loadRadiosity(const std::string &fileName)
+{
+	std::ifstream file(fileName.c_str());
+	std::string word;
+	int numVertices, numTriangles, i, j;
+
+	if (!(file >> word >> radiosityStep >> word >> numVertices)) return false;
+	radiosityVertices.resize(3 * numVertices);
+	radiosityColors.resize(3 * numVertices);
+	for (i = 0; i < numVertices; i++)
+	{
+		for (j = 0; j < 3; j++) file >> radiosityVertices[3 * i + j];
+		for (j = 0; j < 3; j++) file >> radiosityColors[3 * i + j];
+	}
+	if (!(file >> word >> numTriangles)) return false;
+	radiosityIndices.resize(3 * numTriangles);
+	for (i = 0; i < 3 * numTriangles; i++) file >> radiosityIndices[i];
+	return (bool)file;
+}
+
+// Routine to draw the baked radiosity mesh, each vertex in its color, with lighting off.
+// Each side of the box is meshed both outside and inside, so back faces are culled.
+void drawRadiosity(void)
+{
+	glDisable(GL_LIGHTING);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+
+	// The box's normal array, left enabled by the lit drawing, has only its 8 corners.
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, &radiosityVertices[0]);
+	glColorPointer(3, GL_FLOAT, 0, &radiosityColors[0]);
+	glDrawElements(GL_TRIANGLES, radiosityIndices.size(), GL_UNSIGNED_INT, &radiosityIndices[0]);
+	glDisableClientState(GL_COLOR_ARRAY);
+
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_LIGHTING);
+}
+
 // Initialization routine.
 void setup(void)
 {
@@ -102,6 +160,13 @@ void drawScene(void)
 	// Position the box for viewing.
 	gluLookAt(0.0, 3.0, 3.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
 
+	if (isRadiosity)
+	{
+		drawRadiosity();
+		glutSwapBuffers();
+		return;
+	}
+
 	// Material properties of the box.
 	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, matAmbAndDif1);
 	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpec);
@@ -161,6 +226,21 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'r':
+		if (isRadiosity) isRadiosity = 0;
+		else if (radiosityStep >= 0 || loadRadiosity(RADIOSITY_FILE))
+		{
+			// The colors are baked for one position of the lid.
+			isRadiosity = 1;
+			step = radiosityStep;
+		}
+		else
+		{
+			radiosityStep = -1;
+			std::cout << "Could not read " << RADIOSITY_FILE << ": run SphereInBoxRadiosity first." << std::endl;
+		}
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
@@ -171,6 +251,7 @@ void specialKeyInput(int key, int x, int y)
 {
 	if (key == GLUT_KEY_UP) if (step < 180) step++;;
 	if (key == GLUT_KEY_DOWN) if (step > 0) step--;;
+	isRadiosity = 0; // The baked colors are of the lid as it was.
 	glutPostRedisplay();
 }
 
@@ -178,7 +259,8 @@ void specialKeyInput(int key, int x, int y)
 void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
-	std::cout << "Press up/down arrow keys to open/close the box." << std::endl;
+	std::cout << "Press up/down arrow keys to open/close the box." << std::endl
+		<< "Press r to toggle between OpenGL lighting and the baked radiosity colors." << std::endl;
 }
 
 // Main routine.
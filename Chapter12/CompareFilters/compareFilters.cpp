@@ -3,6 +3,8 @@
 //
 // This program shows two squares with identical images as textures that can be 
 // filtered separately, and moved together.
+// The textures and their mipmaps are uploaded from Textures/textures.pak if it has been
+// baked with TextureBaker, else read from BMP files with the mipmaps generated at startup.
 //
 // Interaction:
 // Press the up and down arrow keys to move the squares.
@@ -22,27 +24,47 @@
 #include <GL/freeglut.h> 
 
 #include "getBMP.h"
+#include "textureContainer.h"
 
 // Globals.
 static unsigned int texture[12]; // Array of texture indices.
+static TextureContainer container; // Baked textures.
 static float d = 0.0; // Distance parameter in gluLookAt().
 static int filter1 = 0; // Filter id.
 static int filter2 = 6; // Filter id.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
 
+// Specify the image of the texture bound to GL_TEXTURE_2D, with its mipmaps, as that of
+// the named texture baked by TextureBaker, else from its BMP file, which is read into image
+// if not already, generating the mipmaps.
+void specifyTexture(const char *name, imageFile *&image)
+{
+	const ContainerEntry *entry = findContainerEntry(container, name);
+
+	if (entry && !container.images[entry->image].atlas)
+	{
+		uploadContainerImage(container, entry->image);
+		return;
+	}
+	if (!image) image = getBMP(std::string("../../Textures/") + name + ".bmp");
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->width, image->height, 0,
+		         GL_RGBA, GL_UNSIGNED_BYTE, image->data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
 // Load external texture.
 void loadTextures()
 {
 	// Local storage for bmp image data.
-	imageFile *image[1];
+	imageFile *image[1] = {NULL};
 
-	// Load the image.
-	image[0] = getBMP("../../Textures/launch.bmp");
+	// Map the baked textures.
+	if (!openTextureContainer(container, "../../Textures/textures.pak"))
+		std::cout << "No baked textures: run TextureBaker to stop generating mipmaps on every start." << std::endl;
 
 	// Bind image to texture object texture[0] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[0]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-	             GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -50,8 +72,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[1] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[1]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -59,9 +80,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[2] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[2]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
@@ -69,9 +88,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[3] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[3]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
@@ -79,9 +96,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[4] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[4]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
@@ -89,9 +104,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[5] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[5]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -99,8 +112,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[6] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[6]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -108,8 +120,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[7] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[7]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -117,9 +128,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[8] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[8]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
@@ -127,9 +136,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[9] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[9]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
@@ -137,9 +144,7 @@ void loadTextures()
 
 	// Bind image to texture object texture[10] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[10]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
@@ -147,13 +152,13 @@ void loadTextures()
 
 	// Bind image to texture object texture[11] with specified mag and min filters.
 	glBindTexture(GL_TEXTURE_2D, texture[11]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("launch", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	closeTextureContainer(container);
 }
 
 // Routine to draw a bitmap character string.
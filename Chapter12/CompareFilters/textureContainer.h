@@ -0,0 +1,58 @@
+#ifndef TEXTURECONTAINER_H
+#define TEXTURECONTAINER_H
+
+#define CONTAINER_VERSION 1
+#define CONTAINER_MAX_LEVELS 16 // Most mipmap levels of an image.
+#define CONTAINER_ALIGNMENT 256 // Alignment of level data in the file.
+#define CONTAINER_NAME_LENGTH 32 // Longest texture name, with its terminating zero.
+
+// Header at the start of a container file, followed by the image table, the entry table
+// and the level data of the images.
+struct ContainerHeader
+{
+	char magic[4]; // "TXP1".
+	int version; // CONTAINER_VERSION.
+	int numImages; // Images, each a texture of its own.
+	int numEntries; // Named textures, each the whole of an image or a rectangle of an atlas.
+	int imageOffset, entryOffset; // File offsets of the image and entry tables.
+	long long fileSize; // Size of the whole file.
+};
+
+// An image with its mipmap chain, finest level first, each level RGBA with 8-bit
+// sRGB-encoded color and rows bottom to top, ready to be handed to glTexSubImage2D().
+struct ContainerImage
+{
+	int width, height, numLevels; // Size of level 0 and number of levels.
+	int atlas; // 1 if packed from several textures, else 0.
+	long long levelOffsets[CONTAINER_MAX_LEVELS]; // File offset of each level's data.
+	int levelSizes[CONTAINER_MAX_LEVELS]; // Bytes of each level's data.
+};
+
+// A texture baked into the container. In an atlas its texture co-ordinates s, t in
+// [0, 1] become texOffset + texScale * (s, t) in the atlas image's.
+struct ContainerEntry
+{
+	char name[CONTAINER_NAME_LENGTH]; // BMP file name without the extension.
+	int image; // Index of its image.
+	int x, y, width, height; // Rectangle it occupies in level 0 of the image.
+	float texOffset[2], texScale[2]; // Texture co-ordinate transformation into the image.
+};
+
+// A container file mapped into memory, so that level data is handed to the GL straight
+// from the file without being read or copied first.
+struct TextureContainer
+{
+	const unsigned char *data; // The mapped file, NULL if none is open.
+	long long size; // Its size.
+	const ContainerHeader *header;
+	const ContainerImage *images;
+	const ContainerEntry *entries;
+	void *fileHandle, *mappingHandle; // Handles of the file and its mapping on Windows.
+};
+
+bool openTextureContainer(TextureContainer &container, const char *fileName);
+const ContainerEntry *findContainerEntry(const TextureContainer &container, const char *name);
+void uploadContainerImage(const TextureContainer &container, int image);
+void closeTextureContainer(TextureContainer &container);
+
+#endif
@@ -2,9 +2,11 @@
 // fieldAndSky.cpp
 //
 // This program shows a grass-textured field and a textured sky. The viewpoint can be moved.
+// The textures are streamed in by a texture manager after the first frame is drawn.
 //
 // Interaction:
 // Press the up and down arrow keys to move the viewpoint over the field.
+// Press 'i' to output the state of the textures.
 //
 // Sumanta Guha
 //
@@ -18,39 +20,21 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
-#include "getBMP.h"
+#include "textureManager.h"
 
 // Globals.
-static unsigned int texture[2]; // Array of texture indices.
+static TextureManager textures; // Streamed textures.
+static int texture[2]; // Array of streamed texture ids.
 static float d = 0.0; // Distance parameter in gluLookAt().
+static int isStreaming = 1; // Textures still streaming in?
 
-// Load external textures.
+// Add external textures to the texture manager, to be loaded when first drawn.
 void loadTextures()
 {
-    // Local storage for bmp image data.
-	imageFile *image[2];
-
-	// Load the images.
-	image[0] = getBMP("../../Textures/grass.bmp");
-	image[1] = getBMP("../../Textures/sky.bmp");
-
-	// Bind grass image to texture object texture[0]. 
-	glBindTexture(GL_TEXTURE_2D, texture[0]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	// Bind sky image to texture object texture[1]
-	glBindTexture(GL_TEXTURE_2D, texture[1]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[1]->width, image[1]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[1]->data);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	texture[0] = addStreamedTexture(textures, "../../Textures/grass.bmp",
+		GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
+	texture[1] = addStreamedTexture(textures, "../../Textures/sky.bmp",
+		GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST);
 }
 
 // Initialization routine.
@@ -59,8 +43,8 @@ void setup(void)
 	glClearColor(0.0, 0.0, 0.0, 0.0);
 	glEnable(GL_DEPTH_TEST);
 
-	// Create texture ids.
-	glGenTextures(2, texture);
+	// Create the texture manager with a budget of 64 MB.
+	createTextureManager(textures, 64 << 20);
 
 	// Load external textures.
 	loadTextures();
@@ -81,7 +65,7 @@ void drawScene(void)
 	gluLookAt(0.0, 10.0, 15.0 + d, 0.0, 10.0, d, 0.0, 1.0, 0.0);
 
 	// Map the grass texture onto a rectangle along the xz-plane.
-	glBindTexture(GL_TEXTURE_2D, texture[0]);
+	bindStreamedTexture(textures, texture[0]);
 	glBegin(GL_POLYGON);
 	glTexCoord2f(0.0, 0.0); glVertex3f(-100.0, 0.0, 100.0);
 	glTexCoord2f(8.0, 0.0); glVertex3f(100.0, 0.0, 100.0);
@@ -90,7 +74,7 @@ void drawScene(void)
 	glEnd();
 
 	// Map the sky texture onto a rectangle parallel to the xy-plane.
-	glBindTexture(GL_TEXTURE_2D, texture[1]);
+	bindStreamedTexture(textures, texture[1]);
 	glBegin(GL_POLYGON);
 	glTexCoord2f(0.0, 0.0); glVertex3f(-100.0, 0.0, -70.0);
 	glTexCoord2f(1.0, 0.0); glVertex3f(100.0, 0.0, -70.0);
@@ -99,6 +83,14 @@ void drawScene(void)
 	glEnd();
 
 	glutSwapBuffers();
+
+	// Upload texture levels loaded and keep drawing till all are in.
+	if (updateTextureManager(textures)) glutPostRedisplay();
+	else if (isStreaming)
+	{
+		isStreaming = 0;
+		std::cout << "Textures streamed in by " << glutGet(GLUT_ELAPSED_TIME) << " ms." << std::endl;
+	}
 }
 
 // OpenGL window reshape routine.
@@ -120,6 +112,9 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'i':
+		printTextureManagerStats(textures);
+		break;
 	default:
 		break;
 	}
@@ -137,7 +132,8 @@ void specialKeyInput(int key, int x, int y)
 void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
-	std::cout << "Press the up and down arrow keys to move the viewpoint over the field." << std::endl;
+	std::cout << "Press the up and down arrow keys to move the viewpoint over the field." << std::endl
+		<< "Press 'i' to output the state of the textures." << std::endl;
 }
 
 // Main routine.
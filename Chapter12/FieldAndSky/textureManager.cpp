@@ -0,0 +1,620 @@
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <sys/stat.h>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h> 
+
+#include "getBMP.h"
+#include "textureManager.h"
+
+#define CACHE_VERSION 1
+#define CACHE_MAX_SIZE 16384 // Largest width and height of a cached texture.
+
+// Header of a cache file, followed by the data of the levels, coarsest first.
+struct CacheHeader
+{
+	char magic[4]; // "TXC1".
+	int version; // CACHE_VERSION.
+	long long sourceSize, sourceTime; // Size and modification time of the BMP built from.
+	int format, width, height, numLevels; // Data format and size of level 0.
+	int levelOffsets[TEXTURE_MAX_LEVELS]; // File offset of each level's data.
+	int levelSizes[TEXTURE_MAX_LEVELS]; // Bytes of each level's data.
+};
+
+// A request to the loader thread, or its reply: the texture's format and size if level
+// is -1, else the data of that level. A reply of 0 levels is a failed load.
+struct LoadMessage
+{
+	int id, generation, level;
+	std::string fileName;
+	int format, width, height, numLevels;
+	std::vector<unsigned char> data;
+};
+
+// Queues between the main thread and the loader thread.
+struct TextureLoader
+{
+	std::mutex mutex;
+	std::condition_variable wake; // Signalled when a request is queued.
+	std::deque<LoadMessage> requests; // Textures to load.
+	std::deque<LoadMessage> replies; // Loaded levels, in the order to upload.
+	bool compress; // If to cache BC1 rather than RGBA data.
+};
+
+// Width (height) of a level given that of level 0.
+static int levelDimension(int size, int level)
+{
+	return std::max(1, size >> level);
+}
+
+// Bytes of a level of the given format and size.
+static int levelBytes(int format, int width, int height)
+{
+	if (format == TEXTURE_BC1) return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+	return width * height * 4;
+}
+
+// Number of levels of a full mipmap chain.
+static int countLevels(int width, int height)
+{
+	int numLevels = 1;
+
+	while ((width > 1 || height > 1) && numLevels < TEXTURE_MAX_LEVELS)
+	{
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		numLevels++;
+	}
+	return numLevels;
+}
+
+// Halve the RGBA image in with a 2x2 box filter, repeating the last row or column of an
+// odd dimension.
+static void downsample(const unsigned char *in, int width, int height, unsigned char *out)
+{
+	int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+	int x, y, x0, x1, y0, y1, c;
+
+	for (y = 0; y < outHeight; y++)
+	{
+		y0 = std::min(2 * y, height - 1);
+		y1 = std::min(2 * y + 1, height - 1);
+		for (x = 0; x < outWidth; x++)
+		{
+			x0 = std::min(2 * x, width - 1);
+			x1 = std::min(2 * x + 1, width - 1);
+			for (c = 0; c < 4; c++)
+				out[4 * (y * outWidth + x) + c] = (in[4 * (y0 * width + x0) + c] + in[4 * (y0 * width + x1) + c] +
+				                                   in[4 * (y1 * width + x0) + c] + in[4 * (y1 * width + x1) + c] + 2) / 4;
+		}
+	}
+}
+
+// Color 565 and its expansion to 8 bits a channel.
+static unsigned short pack565(const float *color)
+{
+	int r = (int)(color[0] * 31.0 / 255.0 + 0.5), g = (int)(color[1] * 63.0 / 255.0 + 0.5),
+		b = (int)(color[2] * 31.0 / 255.0 + 0.5);
+
+	return (unsigned short)((std::min(std::max(r, 0), 31) << 11) | (std::min(std::max(g, 0), 63) << 5) |
+		std::min(std::max(b, 0), 31));
+}
+
+static void unpack565(unsigned short packed, float *color)
+{
+	int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+
+	color[0] = (float)((r << 3) | (r >> 2));
+	color[1] = (float)((g << 2) | (g >> 4));
+	color[2] = (float)((b << 3) | (b >> 2));
+}
+
+// Indices of the colors of a 4x4 block nearest the four colors of the BC1 palette of the
+// endpoints, where color0 > color1, returning the squared error.
+static float chooseIndices(float pixels[16][3], unsigned short color0, unsigned short color1, unsigned int &indices)
+{
+	float palette[4][3], best, dist, error = 0.0;
+	int i, j, k, index;
+
+	unpack565(color0, palette[0]);
+	unpack565(color1, palette[1]);
+	for (k = 0; k < 3; k++)
+	{
+		palette[2][k] = (2.0 * palette[0][k] + palette[1][k]) / 3.0;
+		palette[3][k] = (palette[0][k] + 2.0 * palette[1][k]) / 3.0;
+	}
+	indices = 0;
+	for (i = 0; i < 16; i++)
+	{
+		best = 1.0e30;
+		index = 0;
+		for (j = 0; j < 4; j++)
+		{
+			dist = 0.0;
+			for (k = 0; k < 3; k++) dist += (pixels[i][k] - palette[j][k]) * (pixels[i][k] - palette[j][k]);
+			if (dist < best) { best = dist; index = j; }
+		}
+		indices |= index << (2 * i);
+		error += best;
+	}
+	return error;
+}
+
+// Endpoints of a 4x4 block for given indices fitted by least squares, ordered so that
+// color0 > color1, false if the fit is degenerate.
+static bool fitEndpoints(float pixels[16][3], unsigned int indices, unsigned short &color0, unsigned short &color1)
+{
+	static const float weights[4] = { 1.0, 0.0, 2.0 / 3.0, 1.0 / 3.0 }; // Weight of color0 by index.
+	float aa = 0.0, ab = 0.0, bb = 0.0, ax[3] = { 0.0, 0.0, 0.0 }, bx[3] = { 0.0, 0.0, 0.0 };
+	float a, b, det, end0[3], end1[3];
+	int i, k;
+
+	for (i = 0; i < 16; i++)
+	{
+		a = weights[(indices >> (2 * i)) & 3];
+		b = 1.0 - a;
+		aa += a * a; ab += a * b; bb += b * b;
+		for (k = 0; k < 3; k++) { ax[k] += a * pixels[i][k]; bx[k] += b * pixels[i][k]; }
+	}
+	det = aa * bb - ab * ab;
+	if (fabs(det) < 1.0e-6) return false;
+	for (k = 0; k < 3; k++)
+	{
+		end0[k] = (ax[k] * bb - bx[k] * ab) / det;
+		end1[k] = (bx[k] * aa - ax[k] * ab) / det;
+	}
+	color0 = pack565(end0);
+	color1 = pack565(end1);
+	if (color0 < color1) std::swap(color0, color1);
+	return color0 != color1;
+}
+
+// Compress a 4x4 block of colors to BC1. The endpoints are first the block's extremes
+// along the principal axis of its colors, found by power iteration on their covariance,
+// then refitted once by least squares to the indices they give.
+static void encodeBlock(float pixels[16][3], unsigned char *out)
+{
+	float mean[3] = { 0.0, 0.0, 0.0 }, cov[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 }, axis[3] = { 1.0, 1.0, 1.0 };
+	float d[3], next[3], length, t, lo = 1.0e30, hi = -1.0e30, error, refitError;
+	unsigned short color0, color1, refit0, refit1;
+	unsigned int indices = 0, refitIndices;
+	int i, j, k, loPixel = 0, hiPixel = 0;
+
+	for (i = 0; i < 16; i++)
+		for (k = 0; k < 3; k++) mean[k] += pixels[i][k] / 16.0;
+	for (i = 0; i < 16; i++)
+	{
+		for (k = 0; k < 3; k++) d[k] = pixels[i][k] - mean[k];
+		cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+		cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+	}
+	for (j = 0; j < 4; j++)
+	{
+		next[0] = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		next[1] = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		next[2] = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		length = std::max(std::max(fabs(next[0]), fabs(next[1])), fabs(next[2]));
+		if (length < 1.0e-6) break;
+		for (k = 0; k < 3; k++) axis[k] = next[k] / length;
+	}
+	for (i = 0; i < 16; i++)
+	{
+		t = pixels[i][0] * axis[0] + pixels[i][1] * axis[1] + pixels[i][2] * axis[2];
+		if (t < lo) { lo = t; loPixel = i; }
+		if (t > hi) { hi = t; hiPixel = i; }
+	}
+
+	// Four color mode needs color0 > color1; equal endpoints take index 0 throughout.
+	color0 = pack565(pixels[hiPixel]);
+	color1 = pack565(pixels[loPixel]);
+	if (color0 < color1) std::swap(color0, color1);
+	if (color0 != color1)
+	{
+		error = chooseIndices(pixels, color0, color1, indices);
+		if (fitEndpoints(pixels, indices, refit0, refit1))
+		{
+			refitError = chooseIndices(pixels, refit0, refit1, refitIndices);
+			if (refitError < error)
+			{
+				color0 = refit0;
+				color1 = refit1;
+				indices = refitIndices;
+			}
+		}
+	}
+
+	out[0] = color0 & 0xFF; out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF; out[3] = color1 >> 8;
+	for (k = 0; k < 4; k++) out[4 + k] = (indices >> (8 * k)) & 0xFF;
+}
+
+// Compress an RGBA image to BC1, repeating edge pixels to fill partial blocks.
+static void compressBC1(const unsigned char *rgba, int width, int height, unsigned char *out)
+{
+	float pixels[16][3];
+	int bx, by, x, y, k;
+
+	for (by = 0; by < (height + 3) / 4; by++)
+		for (bx = 0; bx < (width + 3) / 4; bx++)
+		{
+			for (y = 0; y < 4; y++)
+				for (x = 0; x < 4; x++)
+					for (k = 0; k < 3; k++)
+						pixels[4 * y + x][k] = rgba[4 * (std::min(4 * by + y, height - 1) * width +
+						                                 std::min(4 * bx + x, width - 1)) + k];
+			encodeBlock(pixels, out);
+			out += 8;
+		}
+}
+
+// Size and modification time of a file, false if it does not exist.
+static bool fileStats(const std::string &fileName, long long &size, long long &time)
+{
+	struct stat info;
+
+	if (stat(fileName.c_str(), &info) != 0) return false;
+	size = info.st_size;
+	time = info.st_mtime;
+	return true;
+}
+
+// If a cache header is of the BMP of the given size and modification time, in the given
+// format, and lists a full mipmap chain, each level the size its format and dimensions make it.
+static bool validCache(const CacheHeader &header, int format, long long sourceSize, long long sourceTime)
+{
+	int level;
+
+	if (memcmp(header.magic, "TXC1", 4) || header.version != CACHE_VERSION || header.sourceSize != sourceSize ||
+		header.sourceTime != sourceTime || header.format != format) return false;
+	if (header.width <= 0 || header.width > CACHE_MAX_SIZE || header.height <= 0 || header.height > CACHE_MAX_SIZE ||
+		header.numLevels != countLevels(header.width, header.height)) return false;
+	for (level = 0; level < header.numLevels; level++)
+		if (header.levelOffsets[level] < (int)sizeof(CacheHeader) || header.levelSizes[level] !=
+			levelBytes(format, levelDimension(header.width, level), levelDimension(header.height, level))) return false;
+	return true;
+}
+
+// Decode the BMP, generate its mipmaps, compress them if asked, and write the cache file,
+// if possible. The header and levels are returned.
+static void buildCache(const std::string &fileName, bool compress, long long sourceSize, long long sourceTime,
+	                   CacheHeader &header, std::vector< std::vector<unsigned char> > &levels)
+{
+	imageFile *image = getBMP(fileName);
+	std::vector<unsigned char> rgba(image->data, image->data + 4 * image->width * image->height), half;
+	int level, width, height, offset;
+
+	memcpy(header.magic, "TXC1", 4);
+	header.version = CACHE_VERSION;
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.format = compress ? TEXTURE_BC1 : TEXTURE_RGBA8;
+	header.width = image->width;
+	header.height = image->height;
+	header.numLevels = countLevels(image->width, image->height);
+	delete[] image->data;
+	delete image;
+
+	levels.assign(header.numLevels, std::vector<unsigned char>());
+	for (level = 0; level < header.numLevels; level++)
+	{
+		width = levelDimension(header.width, level);
+		height = levelDimension(header.height, level);
+		if (level > 0)
+		{
+			half.resize(4 * width * height);
+			downsample(&rgba[0], levelDimension(header.width, level - 1), levelDimension(header.height, level - 1),
+				&half[0]);
+			rgba.swap(half);
+		}
+		levels[level].resize(levelBytes(header.format, width, height));
+		if (compress) compressBC1(&rgba[0], width, height, &levels[level][0]);
+		else std::copy(rgba.begin(), rgba.end(), levels[level].begin());
+	}
+
+	// Lay the levels out coarsest first.
+	offset = sizeof(CacheHeader);
+	for (level = header.numLevels - 1; level >= 0; level--)
+	{
+		header.levelOffsets[level] = offset;
+		header.levelSizes[level] = levels[level].size();
+		offset += levels[level].size();
+	}
+
+	std::ofstream outFile((fileName + ".tex").c_str(), std::ios::binary);
+	if (!outFile) return;
+	outFile.write((const char *)&header, sizeof(CacheHeader));
+	for (level = header.numLevels - 1; level >= 0; level--)
+		outFile.write((const char *)&levels[level][0], levels[level].size());
+}
+
+// Queue a reply to the main thread.
+static void reply(TextureLoader *loader, LoadMessage &message)
+{
+	std::lock_guard<std::mutex> lock(loader->mutex);
+	loader->replies.push_back(LoadMessage());
+	std::swap(loader->replies.back(), message);
+}
+
+// Load a texture: reply with its format and size, then each level coarsest first, read
+// from the cache if it is up to date and whole, else built.
+static void load(TextureLoader *loader, const LoadMessage &request)
+{
+	CacheHeader header;
+	std::vector< std::vector<unsigned char> > levels;
+	LoadMessage message;
+	long long sourceSize, sourceTime;
+	int level;
+	bool cached = false;
+
+	message.id = request.id;
+	message.generation = request.generation;
+	message.level = -1;
+	message.numLevels = 0;
+	if (!fileStats(request.fileName, sourceSize, sourceTime))
+	{
+		reply(loader, message);
+		return;
+	}
+
+	// Read the whole cache before replying, so that a short or damaged file can still be rebuilt.
+	std::ifstream inFile((request.fileName + ".tex").c_str(), std::ios::binary);
+	if (inFile.read((char *)&header, sizeof(CacheHeader)) &&
+		validCache(header, loader->compress ? TEXTURE_BC1 : TEXTURE_RGBA8, sourceSize, sourceTime))
+	{
+		cached = true;
+		levels.assign(header.numLevels, std::vector<unsigned char>());
+		for (level = header.numLevels - 1; level >= 0 && cached; level--)
+		{
+			levels[level].resize(header.levelSizes[level]);
+			inFile.seekg(header.levelOffsets[level]);
+			cached = (bool)inFile.read((char *)&levels[level][0], header.levelSizes[level]);
+		}
+	}
+	inFile.close();
+	if (!cached) buildCache(request.fileName, loader->compress, sourceSize, sourceTime, header, levels);
+
+	message.format = header.format;
+	message.width = header.width;
+	message.height = header.height;
+	message.numLevels = header.numLevels;
+	reply(loader, message);
+
+	for (level = header.numLevels - 1; level >= 0; level--)
+	{
+		message.id = request.id;
+		message.generation = request.generation;
+		message.level = level;
+		message.data.swap(levels[level]);
+		reply(loader, message);
+	}
+}
+
+// Loader thread: load requested textures in turn.
+static void loaderThread(TextureLoader *loader)
+{
+	LoadMessage request;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(loader->mutex);
+			while (loader->requests.empty()) loader->wake.wait(lock);
+			request = loader->requests.front();
+			loader->requests.pop_front();
+		}
+		load(loader, request);
+	}
+}
+
+// Create the manager with the given budget of GPU memory in bytes and start its loader
+// thread. The thread is detached, and its queues never freed, so that a program may
+// exit at any time.
+void createTextureManager(TextureManager &manager, long long budgetBytes)
+{
+	unsigned char gray[] = { 128, 128, 128, 255 };
+
+	manager.loader = new TextureLoader;
+	manager.compress = manager.loader->compress = (GLEW_EXT_texture_compression_s3tc != 0);
+	manager.budgetBytes = budgetBytes;
+	manager.residentBytes = 0;
+	manager.uploadBytesPerFrame = 1 << 20;
+	manager.frame = 0;
+
+	glGenBuffers(1, &manager.pixelUnpackBuffer);
+
+	glGenTextures(1, &manager.placeholder);
+	glBindTexture(GL_TEXTURE_2D, manager.placeholder);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, gray);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	std::thread(loaderThread, manager.loader).detach();
+}
+
+// Add a texture to load from the BMP file on first use, returning its id.
+int addStreamedTexture(TextureManager &manager, const std::string &fileName,
+	                   int wrapS, int wrapT, int minFilter, int magFilter)
+{
+	StreamedTexture texture;
+
+	texture.fileName = fileName;
+	texture.wrapS = wrapS;
+	texture.wrapT = wrapT;
+	texture.minFilter = minFilter;
+	texture.magFilter = magFilter;
+	texture.state = TEXTURE_UNLOADED;
+	texture.generation = 0;
+	texture.texture = 0;
+	texture.format = TEXTURE_RGBA8;
+	texture.width = texture.height = texture.numLevels = texture.finestLevel = 0;
+	texture.bytes = 0;
+	texture.lastUsedFrame = -1;
+	manager.textures.push_back(texture);
+	return manager.textures.size() - 1;
+}
+
+// Bind the texture to GL_TEXTURE_2D, or the placeholder if none of it is uploaded yet,
+// requesting it to be loaded if not resident.
+void bindStreamedTexture(TextureManager &manager, int id)
+{
+	StreamedTexture &texture = manager.textures[id];
+
+	texture.lastUsedFrame = manager.frame;
+	if (texture.state == TEXTURE_UNLOADED)
+	{
+		LoadMessage request;
+
+		texture.state = TEXTURE_LOADING;
+		texture.generation++;
+		request.id = id;
+		request.generation = texture.generation;
+		request.fileName = texture.fileName;
+		{
+			std::lock_guard<std::mutex> lock(manager.loader->mutex);
+			manager.loader->requests.push_back(request);
+		}
+		manager.loader->wake.notify_one();
+	}
+
+	if (texture.texture && texture.finestLevel < texture.numLevels) glBindTexture(GL_TEXTURE_2D, texture.texture);
+	else glBindTexture(GL_TEXTURE_2D, manager.placeholder);
+}
+
+// Allocate the texture for the format and size in the reply.
+static void allocateTexture(TextureManager &manager, StreamedTexture &texture, const LoadMessage &message)
+{
+	int level;
+
+	if (message.numLevels == 0)
+	{
+		// Keep the placeholder, and stop counting the texture as loading, without trying again.
+		std::cout << "Cannot load texture " << texture.fileName << std::endl;
+		texture.state = TEXTURE_FAILED;
+		return;
+	}
+
+	texture.format = message.format;
+	texture.width = message.width;
+	texture.height = message.height;
+	texture.numLevels = texture.finestLevel = message.numLevels;
+	texture.bytes = 0;
+	for (level = 0; level < texture.numLevels; level++)
+		texture.bytes += levelBytes(texture.format, levelDimension(texture.width, level),
+			levelDimension(texture.height, level));
+	manager.residentBytes += texture.bytes;
+
+	glGenTextures(1, &texture.texture);
+	glBindTexture(GL_TEXTURE_2D, texture.texture);
+	glTexStorage2D(GL_TEXTURE_2D, texture.numLevels,
+		(texture.format == TEXTURE_BC1) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8, texture.width, texture.height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.wrapT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.magFilter);
+}
+
+// Upload a level through the pixel unpack buffer, orphaned first so as not to wait on
+// the previous upload, and make it the base level.
+static void uploadLevel(TextureManager &manager, StreamedTexture &texture, const LoadMessage &message)
+{
+	int width = levelDimension(texture.width, message.level), height = levelDimension(texture.height, message.level);
+	void *staging;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, manager.pixelUnpackBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, message.data.size(), NULL, GL_STREAM_DRAW);
+	staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, message.data.size(),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	memcpy(staging, &message.data[0], message.data.size());
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	glBindTexture(GL_TEXTURE_2D, texture.texture);
+	if (texture.format == TEXTURE_BC1)
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, message.level, 0, 0, width, height,
+			GL_COMPRESSED_RGB_S3TC_DXT1_EXT, message.data.size(), 0);
+	else glTexSubImage2D(GL_TEXTURE_2D, message.level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, message.level);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	texture.finestLevel = message.level;
+	if (message.level == 0) texture.state = TEXTURE_RESIDENT;
+}
+
+// Routine to call at the end of each frame, after the frame's textures are bound: upload
+// levels the loader thread has ready, up to uploadBytesPerFrame, and evict textures least
+// recently used until within the budget. Returns true while textures are loading, when
+// the program should keep drawing frames.
+bool updateTextureManager(TextureManager &manager)
+{
+	LoadMessage message;
+	int uploaded = 0, i, victim;
+	bool loading = false;
+
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(manager.loader->mutex);
+			if (manager.loader->replies.empty()) break;
+			if (manager.loader->replies.front().level >= 0 && uploaded > 0 &&
+				uploaded + (int)manager.loader->replies.front().data.size() > manager.uploadBytesPerFrame) break;
+			std::swap(message, manager.loader->replies.front());
+			manager.loader->replies.pop_front();
+		}
+
+		StreamedTexture &texture = manager.textures[message.id];
+		if (message.generation != texture.generation) continue;
+		if (message.level < 0) allocateTexture(manager, texture, message);
+		else
+		{
+			uploadLevel(manager, texture, message);
+			uploaded += message.data.size();
+		}
+	}
+
+	// Evict textures not used this frame, least recently used first.
+	while (manager.residentBytes > manager.budgetBytes)
+	{
+		victim = -1;
+		for (i = 0; i < (int)manager.textures.size(); i++)
+			if (manager.textures[i].state == TEXTURE_RESIDENT && manager.textures[i].lastUsedFrame < manager.frame &&
+				(victim < 0 || manager.textures[i].lastUsedFrame < manager.textures[victim].lastUsedFrame))
+				victim = i;
+		if (victim < 0) break;
+
+		StreamedTexture &texture = manager.textures[victim];
+		glDeleteTextures(1, &texture.texture);
+		texture.texture = 0;
+		texture.state = TEXTURE_UNLOADED;
+		manager.residentBytes -= texture.bytes;
+	}
+
+	for (i = 0; i < (int)manager.textures.size(); i++)
+		if (manager.textures[i].state == TEXTURE_LOADING) loading = true;
+	manager.frame++;
+	return loading;
+}
+
+// Output the state and size of each texture and the GPU memory resident.
+void printTextureManagerStats(const TextureManager &manager)
+{
+	static const char *stateNames[] = { "unloaded", "loading", "resident", "failed" };
+
+	for (int i = 0; i < (int)manager.textures.size(); i++)
+	{
+		const StreamedTexture &texture = manager.textures[i];
+		std::cout << texture.fileName << ": " << stateNames[texture.state];
+		if (texture.numLevels > 0)
+			std::cout << ", " << texture.width << "x" << texture.height << ", " << texture.numLevels << " levels, "
+			          << ((texture.format == TEXTURE_BC1) ? "BC1" : "RGBA8") << ", " << texture.bytes / 1024 << " KB";
+		std::cout << std::endl;
+	}
+	std::cout << "Resident: " << manager.residentBytes / 1024 << " KB of " << manager.budgetBytes / 1024
+	          << " KB budgeted." << std::endl;
+}
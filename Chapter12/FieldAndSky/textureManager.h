@@ -0,0 +1,59 @@
+#ifndef TEXTUREMANAGER_H
+#define TEXTUREMANAGER_H
+
+#include <string>
+#include <vector>
+
+#define TEXTURE_MAX_LEVELS 16 // Most mipmap levels of a texture.
+
+enum textureFormat {TEXTURE_RGBA8, TEXTURE_BC1}; // Formats of cached texture data.
+enum textureState {TEXTURE_UNLOADED, TEXTURE_LOADING, TEXTURE_RESIDENT, TEXTURE_FAILED}; // Residency states.
+
+struct TextureLoader; // State shared with the loader thread.
+
+// A texture loaded from a BMP file on demand.
+struct StreamedTexture
+{
+	std::string fileName; // BMP file.
+	int wrapS, wrapT, minFilter, magFilter; // Texture parameters.
+	int state; // Residency state.
+	int generation; // Count of loads, to discard levels of a load since evicted.
+	unsigned int texture; // Texture id while allocated, else 0.
+	int format, width, height, numLevels; // Known once the load has begun.
+	int finestLevel; // Finest level uploaded, numLevels if none.
+	long long bytes; // GPU memory of the whole mipmap chain.
+	int lastUsedFrame; // Frame it was last bound in.
+};
+
+// Streams textures from a cache of mipmapped, block-compressed data on disk, so that
+// no BMP file is decoded before the first frame. On the first use of a texture its
+// cache file, named after the BMP with ".tex" appended, is read by a loader thread,
+// being first built from the BMP if missing or older than it: mipmaps are generated
+// and each level compressed to BC1 (DXT1), an eighth the size of RGBA, if the GL
+// supports it. Levels are stored coarsest first and uploaded as read, at most
+// uploadBytesPerFrame a frame, through a pixel unpack buffer, with the texture's base
+// level lowered as each arrives, so that a blurry texture appears at once and sharpens.
+// Until then a gray placeholder is bound, as it stays for a texture that cannot be
+// loaded. When the textures resident exceed the budget, those least recently used,
+// and not in the current frame, are evicted.
+struct TextureManager
+{
+	std::vector<StreamedTexture> textures; // The textures.
+	TextureLoader *loader; // Loader thread's queues.
+	bool compress; // If to cache BC1 rather than RGBA data.
+	unsigned int pixelUnpackBuffer; // Staging buffer of uploads.
+	unsigned int placeholder; // 1x1 gray texture bound while loading.
+	long long budgetBytes; // Most GPU memory for resident textures.
+	long long residentBytes; // GPU memory of resident textures.
+	int uploadBytesPerFrame; // Most bytes uploaded a frame, unless one level is more.
+	int frame; // Frame count.
+};
+
+void createTextureManager(TextureManager &manager, long long budgetBytes);
+int addStreamedTexture(TextureManager &manager, const std::string &fileName,
+	                   int wrapS, int wrapT, int minFilter, int magFilter);
+void bindStreamedTexture(TextureManager &manager, int id);
+bool updateTextureManager(TextureManager &manager);
+void printTextureManagerStats(const TextureManager &manager);
+
+#endif
@@ -3,6 +3,8 @@
 //
 // This program is based on fieldAndSky.cpp. In addition to the viewpoint being movable, 
 // the grass texture filter can be set at different levels.
+// The textures and their mipmaps are uploaded from Textures/textures.pak if it has been
+// baked with TextureBaker, else read from BMP files with the mipmaps generated at startup.
 //
 // Interaction:
 // Press the up and down arrow keys to move the viewpoint over the field.
@@ -21,27 +23,46 @@
 #include <GL/freeglut.h> 
 
 #include "getBMP.h"
+#include "textureContainer.h"
 
 // Globals.
 static unsigned int texture[7]; // Array of texture indices.
+static TextureContainer container; // Baked textures.
 static float d = 0.0; // Distance parameter in gluLookAt().
 static int filter = 0; // Filter id.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
 
+// Specify the image of the texture bound to GL_TEXTURE_2D, with its mipmaps, as that of
+// the named texture baked by TextureBaker, else from its BMP file, which is read into image
+// if not already, generating the mipmaps.
+void specifyTexture(const char *name, imageFile *&image)
+{
+	const ContainerEntry *entry = findContainerEntry(container, name);
+
+	if (entry && !container.images[entry->image].atlas)
+	{
+		uploadContainerImage(container, entry->image);
+		return;
+	}
+	if (!image) image = getBMP(std::string("../../Textures/") + name + ".bmp");
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->width, image->height, 0,
+		         GL_RGBA, GL_UNSIGNED_BYTE, image->data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
 // Load external textures.
 void loadTextures()
 {
 	// Local storage for bmp image data.
-	imageFile *image[7];
+	imageFile *image[2] = {NULL, NULL};
 
-	// Load the images.
-	image[0] = getBMP("../../Textures/grass.bmp");
-	image[1] = getBMP("../../Textures/sky.bmp");
+	// Map the baked textures.
+	if (!openTextureContainer(container, "../../Textures/textures.pak"))
+		std::cout << "No baked textures: run TextureBaker to stop generating mipmaps on every start." << std::endl;
 
 	// Bind grass image to texture[0] with specified mag and min filters. 
 	glBindTexture(GL_TEXTURE_2D, texture[0]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
+	specifyTexture("grass", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -49,8 +70,7 @@ void loadTextures()
 
 	// Bind grass image to texture[1] with specified mag and min filters. 
 	glBindTexture(GL_TEXTURE_2D, texture[1]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-	        	 GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
+	specifyTexture("grass", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -59,9 +79,7 @@ void loadTextures()
 	// Bind grass image to texture[2] with specified mag and min filters. 
 	// Use mipmapping.
 	glBindTexture(GL_TEXTURE_2D, texture[2]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("grass", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
@@ -70,9 +88,7 @@ void loadTextures()
 	// Bind grass image to texture[3] with specified mag and min filters.
 	// Use mipmapping.
 	glBindTexture(GL_TEXTURE_2D, texture[3]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("grass", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
@@ -81,9 +97,7 @@ void loadTextures()
 	// Bind grass image to texture[4] with specified mag and min filters. 
 	// Use mipmapping.
 	glBindTexture(GL_TEXTURE_2D, texture[4]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("grass", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
@@ -92,9 +106,7 @@ void loadTextures()
 	// Bind grass image to texture[5] with specified mag and min filters. 
 	// Use mipmapping.
 	glBindTexture(GL_TEXTURE_2D, texture[5]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-	             GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	specifyTexture("grass", image[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -102,12 +114,13 @@ void loadTextures()
 
 	// Bind sky image to texture[6]
 	glBindTexture(GL_TEXTURE_2D, texture[6]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[1]->width, image[1]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[1]->data);
+	specifyTexture("sky", image[1]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	closeTextureContainer(container);
 }
 
 // Routine to draw a bitmap character string.
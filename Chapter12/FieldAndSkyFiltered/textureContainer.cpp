@@ -0,0 +1,148 @@
+#include <cstring>
+#include <iostream>
+
+#include <GL/glew.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "textureContainer.h"
+
+// Map the file into memory.
+static bool mapFile(TextureContainer &container, const char *fileName)
+{
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		                      FILE_ATTRIBUTE_NORMAL, NULL);
+	HANDLE mapping;
+
+	if (file == INVALID_HANDLE_VALUE) return false;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+		!(mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	container.data = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!container.data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	container.size = size.QuadPart;
+	container.fileHandle = file;
+	container.mappingHandle = mapping;
+#else
+	struct stat status;
+	int file = open(fileName, O_RDONLY);
+	void *data;
+
+	if (file < 0) return false;
+	if (fstat(file, &status) != 0 || status.st_size == 0 ||
+		(data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0)) == MAP_FAILED)
+	{
+		close(file);
+		return false;
+	}
+	close(file);
+	container.data = (const unsigned char *)data;
+	container.size = status.st_size;
+#endif
+	return true;
+}
+
+// Map a container file written by TextureBaker, returning false, with the container
+// closed, if there is none or it is not valid.
+bool openTextureContainer(TextureContainer &container, const char *fileName)
+{
+	const ContainerHeader *header;
+	int i, level;
+
+	memset(&container, 0, sizeof(container));
+	if (!mapFile(container, fileName)) return false;
+
+	// Check the header and that the tables and level data lie within the file.
+	header = (const ContainerHeader *)container.data;
+	if (container.size < (long long)sizeof(ContainerHeader) || memcmp(header->magic, "TXP1", 4) != 0 ||
+		header->version != CONTAINER_VERSION || header->fileSize != container.size ||
+		header->imageOffset < 0 || header->numImages < 0 || header->entryOffset < 0 || header->numEntries < 0 ||
+		header->imageOffset + header->numImages * (long long)sizeof(ContainerImage) > container.size ||
+		header->entryOffset + header->numEntries * (long long)sizeof(ContainerEntry) > container.size)
+	{
+		std::cout << fileName << " is not a texture container of this version: rerun TextureBaker." << std::endl;
+		closeTextureContainer(container);
+		return false;
+	}
+	container.header = header;
+	container.images = (const ContainerImage *)(container.data + header->imageOffset);
+	container.entries = (const ContainerEntry *)(container.data + header->entryOffset);
+	for (i = 0; i < header->numImages; i++)
+		for (level = 0; level < container.images[i].numLevels; level++)
+			if (container.images[i].numLevels > CONTAINER_MAX_LEVELS ||
+				container.images[i].levelOffsets[level] + container.images[i].levelSizes[level] > container.size)
+			{
+				std::cout << fileName << " is truncated: rerun TextureBaker." << std::endl;
+				closeTextureContainer(container);
+				return false;
+			}
+	return true;
+}
+
+// The entry of the named texture, or NULL if it is not in the container.
+const ContainerEntry *findContainerEntry(const TextureContainer &container, const char *name)
+{
+	int i;
+
+	if (!container.data) return NULL;
+	for (i = 0; i < container.header->numEntries; i++)
+		if (strncmp(container.entries[i].name, name, CONTAINER_NAME_LENGTH) == 0) return &container.entries[i];
+	return NULL;
+}
+
+// Specify the image and its mipmaps as those of the texture currently bound to
+// GL_TEXTURE_2D, as immutable storage if the GL supports it. The levels are read by
+// the GL straight from the mapped file.
+void uploadContainerImage(const TextureContainer &container, int image)
+{
+	const ContainerImage &info = container.images[image];
+	int level, width, height;
+
+	if (GLEW_ARB_texture_storage)
+		glTexStorage2D(GL_TEXTURE_2D, info.numLevels, GL_RGBA8, info.width, info.height);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	for (level = 0; level < info.numLevels; level++)
+	{
+		width = info.width >> level ? info.width >> level : 1;
+		height = info.height >> level ? info.height >> level : 1;
+		if (GLEW_ARB_texture_storage)
+			glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+				            container.data + info.levelOffsets[level]);
+		else
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+				         container.data + info.levelOffsets[level]);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, info.numLevels - 1);
+}
+
+// Unmap the container.
+void closeTextureContainer(TextureContainer &container)
+{
+	if (!container.data) return;
+#ifdef _WIN32
+	UnmapViewOfFile(container.data);
+	CloseHandle((HANDLE)container.mappingHandle);
+	CloseHandle((HANDLE)container.fileHandle);
+#else
+	munmap((void *)container.data, container.size);
+#endif
+	memset(&container, 0, sizeof(container));
+}
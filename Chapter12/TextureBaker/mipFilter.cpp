@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#include <xmmintrin.h>
+#define MIP_SSE
+#endif
+
+#include "mipFilter.h"
+
+#define PI 3.14159265358979324
+#define KAISER_RADIUS 3.0 // Half-width of the Kaiser-windowed sinc in output pixels.
+#define KAISER_ALPHA 4.0 // Kaiser window shape, larger for less ringing and more blur.
+
+// Weights of the input pixels summed into each output pixel along one dimension.
+// Output pixel i takes input pixels index[i*maxTaps + k] with weights weight[i*maxTaps + k],
+// k < count[i].
+struct FilterTaps
+{
+	int maxTaps;
+	std::vector<int> count, index;
+	std::vector<float> weight;
+};
+
+// Table of sRGB-encoded byte to linear value.
+struct SrgbTable
+{
+	float linear[256];
+
+	SrgbTable()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			double c = i / 255.0;
+			linear[i] = (float)(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+		}
+	}
+};
+
+static const float *srgbToLinear()
+{
+	static SrgbTable table;
+	return table.linear;
+}
+
+// Byte sRGB-encoding of linear value c in [0, 1].
+static unsigned char linearToSrgb(float c)
+{
+	double s = c <= 0.0031308 ? 12.92 * c : 1.055 * pow((double)c, 1.0 / 2.4) - 0.055;
+	return (unsigned char)(std::min(std::max(s, 0.0), 1.0) * 255.0 + 0.5);
+}
+
+// Modified Bessel function of the first kind of order 0, by its power series.
+static double besselI0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 50 && term > 1.0e-12 * sum; k++)
+	{
+		term *= (x * x) / (4.0 * k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+// Value at x, in output pixels from the center, of the unnormalized Kaiser-windowed sinc.
+static double kaiserWeight(double x)
+{
+	double t, sinc;
+
+	x = fabs(x);
+	if (x >= KAISER_RADIUS) return 0.0;
+	sinc = x < 1.0e-6 ? 1.0 : sin(PI * x) / (PI * x);
+	t = x / KAISER_RADIUS;
+	return sinc * besselI0(KAISER_ALPHA * sqrt(1.0 - t * t)) / besselI0(KAISER_ALPHA);
+}
+
+// Input pixel j, clamped or wrapped into [0, size).
+static int addressPixel(int j, int size, bool wrap)
+{
+	if (wrap) return ((j % size) + size) % size;
+	return std::min(std::max(j, 0), size - 1);
+}
+
+// Tabulate the filter taps of resampling inSize pixels to outSize <= inSize. The box
+// filter weighs each input pixel by its overlap with the output pixel's footprint,
+// which for halving an even size is the 2-tap average, and for an odd size spreads the
+// middle pixel over its two neighbours rather than dropping a row or column.
+static void buildTaps(int inSize, int outSize, int filter, bool wrap, FilterTaps &taps)
+{
+	double scale = (double)inSize / outSize, center, lo, hi, w, sum;
+	int i, j, k, first, last;
+
+	if (filter == MIP_BOX) taps.maxTaps = (int)ceil(scale) + 1;
+	else taps.maxTaps = (int)ceil(2.0 * KAISER_RADIUS * scale) + 1;
+	taps.count.assign(outSize, 0);
+	taps.index.assign(outSize * taps.maxTaps, 0);
+	taps.weight.assign(outSize * taps.maxTaps, 0.0);
+
+	for (i = 0; i < outSize; i++)
+	{
+		center = (i + 0.5) * scale;
+		if (filter == MIP_BOX)
+		{
+			lo = center - 0.5 * scale;
+			hi = center + 0.5 * scale;
+		}
+		else
+		{
+			lo = center - KAISER_RADIUS * scale;
+			hi = center + KAISER_RADIUS * scale;
+		}
+		first = (int)floor(lo);
+		last = (int)ceil(hi) - 1;
+
+		sum = 0.0;
+		k = 0;
+		for (j = first; j <= last && k < taps.maxTaps; j++)
+		{
+			if (filter == MIP_BOX) w = std::min(hi, j + 1.0) - std::max(lo, (double)j);
+			else w = kaiserWeight((j + 0.5 - center) / scale);
+			if (fabs(w) < 1.0e-7) continue;
+			taps.index[i * taps.maxTaps + k] = addressPixel(j, inSize, wrap);
+			taps.weight[i * taps.maxTaps + k] = (float)w;
+			sum += w;
+			k++;
+		}
+		taps.count[i] = k;
+		for (j = 0; j < k; j++) taps.weight[i * taps.maxTaps + j] = (float)(taps.weight[i * taps.maxTaps + j] / sum);
+	}
+}
+
+// Number of levels of a full mipmap chain.
+int countMipLevels(int width, int height)
+{
+	int numLevels = 1;
+
+	while (width > 1 || height > 1)
+	{
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		numLevels++;
+	}
+	return numLevels;
+}
+
+// Convert an sRGB-encoded image to linear color with premultiplied alpha.
+void decodeImage(const ByteImage &in, LinearImage &out)
+{
+	const float *linear = srgbToLinear();
+	int i, n = in.width * in.height;
+	float a;
+
+	out.width = in.width;
+	out.height = in.height;
+	out.pixels.resize(4 * n);
+	for (i = 0; i < n; i++)
+	{
+		a = in.pixels[4 * i + 3] / 255.0f;
+		out.pixels[4 * i] = linear[in.pixels[4 * i]] * a;
+		out.pixels[4 * i + 1] = linear[in.pixels[4 * i + 1]] * a;
+		out.pixels[4 * i + 2] = linear[in.pixels[4 * i + 2]] * a;
+		out.pixels[4 * i + 3] = a;
+	}
+}
+
+// Convert a linear, premultiplied image back to sRGB encoding, clamping the overshoot of
+// the Kaiser filter's negative lobes.
+void encodeImage(const LinearImage &in, ByteImage &out)
+{
+	int i, c, n = in.width * in.height;
+	float a;
+
+	out.width = in.width;
+	out.height = in.height;
+	out.pixels.resize(4 * n);
+	for (i = 0; i < n; i++)
+	{
+		a = std::min(std::max(in.pixels[4 * i + 3], 0.0f), 1.0f);
+		for (c = 0; c < 3; c++)
+			out.pixels[4 * i + c] = a > 0.0f ? linearToSrgb(std::min(in.pixels[4 * i + c] / a, 1.0f)) : 0;
+		out.pixels[4 * i + 3] = (unsigned char)(a * 255.0f + 0.5f);
+	}
+}
+
+// Resample the image in to the next mipmap level, halving each dimension greater than 1,
+// first along rows and then along columns. A pixel is 4 floats, one SSE register, so the
+// row pass accumulates a whole pixel per tap and the column pass whole rows of pixels.
+void downsampleImage(const LinearImage &in, LinearImage &out, int filter, bool wrap)
+{
+	int outWidth = std::max(1, in.width / 2), outHeight = std::max(1, in.height / 2);
+	int x, y, k, n, rowFloats;
+	FilterTaps xTaps, yTaps;
+	std::vector<float> rows(4 * outWidth * in.height);
+	const float *src, *weight;
+	const int *index;
+	float *dst;
+
+	buildTaps(in.width, outWidth, filter, wrap, xTaps);
+	buildTaps(in.height, outHeight, filter, wrap, yTaps);
+
+	// Filter along rows into rows, outWidth by in.height.
+	for (y = 0; y < in.height; y++)
+	{
+		src = &in.pixels[4 * y * in.width];
+		dst = &rows[4 * y * outWidth];
+		for (x = 0; x < outWidth; x++)
+		{
+			index = &xTaps.index[x * xTaps.maxTaps];
+			weight = &xTaps.weight[x * xTaps.maxTaps];
+#ifdef MIP_SSE
+			__m128 sum = _mm_setzero_ps();
+			for (k = 0; k < xTaps.count[x]; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(src + 4 * index[k])));
+			_mm_storeu_ps(dst + 4 * x, sum);
+#else
+			dst[4 * x] = dst[4 * x + 1] = dst[4 * x + 2] = dst[4 * x + 3] = 0.0;
+			for (k = 0; k < xTaps.count[x]; k++)
+				for (n = 0; n < 4; n++) dst[4 * x + n] += weight[k] * src[4 * index[k] + n];
+#endif
+		}
+	}
+
+	// Filter along columns into out.
+	out.width = outWidth;
+	out.height = outHeight;
+	out.pixels.assign(4 * outWidth * outHeight, 0.0);
+	rowFloats = 4 * outWidth;
+	for (y = 0; y < outHeight; y++)
+	{
+		dst = &out.pixels[y * rowFloats];
+		index = &yTaps.index[y * yTaps.maxTaps];
+		weight = &yTaps.weight[y * yTaps.maxTaps];
+		for (k = 0; k < yTaps.count[y]; k++)
+		{
+			src = &rows[index[k] * rowFloats];
+#ifdef MIP_SSE
+			__m128 w = _mm_set1_ps(weight[k]);
+			for (n = 0; n < rowFloats; n += 4)
+				_mm_storeu_ps(dst + n, _mm_add_ps(_mm_loadu_ps(dst + n), _mm_mul_ps(w, _mm_loadu_ps(src + n))));
+#else
+			for (n = 0; n < rowFloats; n++) dst[n] += weight[k] * src[n];
+#endif
+		}
+	}
+}
+
+// Build the first numLevels levels of the mipmap chain of image, all of them if numLevels
+// is 0. Each level is filtered from the unquantized linear data of the one before.
+void buildMipChain(const ByteImage &image, int filter, bool wrap, int numLevels, std::vector<ByteImage> &levels)
+{
+	LinearImage current, next;
+	int level;
+
+	if (numLevels <= 0) numLevels = countMipLevels(image.width, image.height);
+	levels.resize(numLevels);
+	levels[0] = image;
+	decodeImage(image, current);
+	for (level = 1; level < numLevels; level++)
+	{
+		downsampleImage(current, next, filter, wrap);
+		encodeImage(next, levels[level]);
+		current.width = next.width;
+		current.height = next.height;
+		current.pixels.swap(next.pixels);
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef MIPFILTER_H
+#define MIPFILTER_H
+
+#include <vector>
+
+enum mipFilter {MIP_BOX, MIP_KAISER}; // Downsampling filters.
+
+// An RGBA image in linear color with alpha premultiplied, 4 floats a pixel, rows bottom
+// to top.
+struct LinearImage
+{
+	int width, height;
+	std::vector<float> pixels;
+};
+
+// An RGBA image with 8-bit sRGB-encoded color.
+struct ByteImage
+{
+	int width, height;
+	std::vector<unsigned char> pixels;
+};
+
+int countMipLevels(int width, int height);
+void decodeImage(const ByteImage &in, LinearImage &out);
+void encodeImage(const LinearImage &in, ByteImage &out);
+void downsampleImage(const LinearImage &in, LinearImage &out, int filter, bool wrap);
+void buildMipChain(const ByteImage &image, int filter, bool wrap, int numLevels, std::vector<ByteImage> &levels);
+
+#endif
@@ -0,0 +1,463 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// textureBaker.cpp
+//
+// This command-line program bakes BMP textures into a single container file that the
+// texturing programs map into memory and upload from directly, instead of decoding BMP
+// files and generating mipmaps with glGenerateMipmap() on every start.
+//
+// Each texture's mipmap chain is filtered in linear color, the BMP data being sRGB-encoded,
+// so that the coarser levels do not darken, with either a box filter or a Kaiser-windowed
+// sinc, which keeps more detail. Textures no larger than the small size are packed into
+// atlases instead, each within a border of its own edge pixels so that filtering does not
+// bleed neighbours into it. Textures are loaded and filtered in parallel on several threads.
+//
+// Usage:
+// TextureBaker [-box | -kaiser] [-wrap | -clamp] [-threads n] [-atlas size] [-small size]
+//              [-o output] [BMP files or directories ...]
+// -box, -kaiser  Mipmap filter, Kaiser by default.
+// -wrap, -clamp  Filtering of textures that are not in an atlas at their edges: as 
+//                repeating, as the programs sample them with GL_REPEAT, by default, or
+//                as clamped.
+// -threads n     Number of threads, by default the number of hardware threads.
+// -atlas size    Largest width and height of an atlas, 512 by default.
+// -small size    Largest width and height of a texture packed into an atlas, 100 by
+//                default, 0 for no atlases.
+// -o output      Container file, ../../Textures/textures.pak by default.
+// Directories are searched for BMP files; ../../Textures is searched if none is given.
+//
+// Sumanta Guha
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "getBMP.h"
+#include "mipFilter.h"
+#include "textureContainer.h"
+
+#define ATLAS_LEVELS 4 // Mipmap levels of an atlas, so that textures in it are 8-pixel aligned.
+#define ATLAS_GUTTER 8 // Width of the border around a texture in level 0 of an atlas.
+
+// A texture read from a BMP file.
+struct BakedTexture
+{
+	std::string fileName, name; // BMP file and its name without directory or extension.
+	std::vector<ByteImage> levels; // Its mipmap chain.
+	int atlas; // Atlas it is packed into, -1 if none.
+	int x, y; // Position of its lower-left corner in the atlas.
+};
+
+// An atlas of small textures.
+struct Atlas
+{
+	int width, height; // Size of level 0.
+	std::vector<int> textures; // Textures packed into it.
+	std::vector<ByteImage> levels; // Its mipmap chain.
+};
+
+// Globals.
+static int filter = MIP_KAISER; // Mipmap filter.
+static bool wrap = true; // If to filter textures not in atlases as repeating.
+static int numThreads = 0; // Number of worker threads.
+static int atlasSize = 512; // Largest atlas width and height.
+static int smallSize = 100; // Largest width and height of a texture in an atlas.
+static std::string outputName = "../../Textures/textures.pak"; // Container file.
+
+// Run job(i) for i in [0, numJobs) on numThreads threads, each taking the next job in turn.
+void runJobs(int numJobs, const std::function<void(int)> &job)
+{
+	std::atomic<int> next(0);
+	std::vector<std::thread> threads;
+	int i;
+
+	for (i = 0; i < std::min(numThreads, numJobs); i++)
+		threads.push_back(std::thread([&]()
+		{
+			int j;
+			while ((j = next++) < numJobs) job(j);
+		}));
+	for (i = 0; i < (int)threads.size(); i++) threads[i].join();
+}
+
+// If fileName ends in ".bmp", ignoring case.
+bool isBmpFile(const std::string &fileName)
+{
+	std::string extension;
+
+	if (fileName.size() < 4) return false;
+	extension = fileName.substr(fileName.size() - 4);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return extension == ".bmp";
+}
+
+// Append the BMP files in directory to fileNames, in alphabetical order.
+void listBmpFiles(const std::string &directory, std::vector<std::string> &fileNames)
+{
+	std::vector<std::string> found;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE handle = FindFirstFileA((directory + "/*.bmp").c_str(), &data);
+
+	if (handle != INVALID_HANDLE_VALUE)
+	{
+		do found.push_back(directory + "/" + data.cFileName);
+		while (FindNextFileA(handle, &data));
+		FindClose(handle);
+	}
+#else
+	DIR *dir = opendir(directory.c_str());
+	struct dirent *entry;
+
+	if (dir)
+	{
+		while ((entry = readdir(dir)) != NULL)
+			if (isBmpFile(entry->d_name)) found.push_back(directory + "/" + entry->d_name);
+		closedir(dir);
+	}
+#endif
+	if (found.empty()) std::cout << "No BMP files in " << directory << "." << std::endl;
+	std::sort(found.begin(), found.end());
+	fileNames.insert(fileNames.end(), found.begin(), found.end());
+}
+
+// Name of a texture, its file name without directory or extension.
+std::string textureName(const std::string &fileName)
+{
+	size_t slash = fileName.find_last_of("/\\"), dot = fileName.find_last_of('.');
+	size_t first = (slash == std::string::npos) ? 0 : slash + 1;
+
+	if (dot == std::string::npos || dot < first) dot = fileName.size();
+	return fileName.substr(first, dot - first);
+}
+
+// Read the texture's BMP file into its level 0, returning false if it cannot be read.
+bool readTexture(BakedTexture &texture)
+{
+	std::ifstream inFile(texture.fileName.c_str(), std::ios::binary);
+	imageFile *image;
+	ByteImage &level = texture.levels[0];
+
+	if (!inFile) return false;
+	inFile.close();
+
+	image = getBMP(texture.fileName);
+	level.width = image->width;
+	level.height = image->height;
+	level.pixels.assign(image->data, image->data + 4 * image->width * image->height);
+	delete[] image->data;
+	delete image;
+	return level.width > 0 && level.height > 0;
+}
+
+// Round n up to a multiple of the atlas alignment.
+int alignToAtlas(int n)
+{
+	int alignment = 1 << (ATLAS_LEVELS - 1);
+	return (n + alignment - 1) / alignment * alignment;
+}
+
+// Pack the small textures into atlases on shelves, tallest first, starting a new shelf
+// when one is full and a new atlas when a shelf does not fit.
+void packAtlases(std::vector<BakedTexture> &textures, std::vector<Atlas> &atlases)
+{
+	std::vector<int> order;
+	int i, t, cellWidth, cellHeight, shelfX = 0, shelfY = 0, shelfHeight = 0;
+	Atlas *atlas = NULL;
+
+	for (t = 0; t < (int)textures.size(); t++)
+	{
+		cellWidth = alignToAtlas(textures[t].levels[0].width + 2 * ATLAS_GUTTER);
+		cellHeight = alignToAtlas(textures[t].levels[0].height + 2 * ATLAS_GUTTER);
+		if (textures[t].levels[0].width <= smallSize && textures[t].levels[0].height <= smallSize &&
+			cellWidth <= atlasSize && cellHeight <= atlasSize) order.push_back(t);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+	{
+		return textures[a].levels[0].height > textures[b].levels[0].height;
+	});
+
+	for (i = 0; i < (int)order.size(); i++)
+	{
+		t = order[i];
+		cellWidth = alignToAtlas(textures[t].levels[0].width + 2 * ATLAS_GUTTER);
+		cellHeight = alignToAtlas(textures[t].levels[0].height + 2 * ATLAS_GUTTER);
+		if (atlas && shelfX + cellWidth > atlasSize)
+		{
+			shelfX = 0;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (!atlas || shelfY + cellHeight > atlasSize)
+		{
+			atlases.push_back(Atlas());
+			atlas = &atlases.back();
+			atlas->width = atlas->height = 0;
+			shelfX = shelfY = shelfHeight = 0;
+		}
+		textures[t].atlas = (int)atlases.size() - 1;
+		textures[t].x = shelfX + ATLAS_GUTTER;
+		textures[t].y = shelfY + ATLAS_GUTTER;
+		atlas->textures.push_back(t);
+		shelfX += cellWidth;
+		shelfHeight = std::max(shelfHeight, cellHeight);
+		atlas->width = std::max(atlas->width, shelfX);
+		atlas->height = std::max(atlas->height, shelfY + shelfHeight);
+	}
+}
+
+// Fill a level of an atlas from the same level of its textures, each surrounded by its
+// edge pixels repeated across the gutter, scaled to the level.
+void composeAtlasLevel(const std::vector<BakedTexture> &textures, Atlas &atlas, int level)
+{
+	ByteImage &out = atlas.levels[level];
+	int i, x, y, left, bottom, gutter = std::max(1, ATLAS_GUTTER >> level);
+
+	out.width = std::max(1, atlas.width >> level);
+	out.height = std::max(1, atlas.height >> level);
+	out.pixels.assign(4 * out.width * out.height, 0);
+
+	for (i = 0; i < (int)atlas.textures.size(); i++)
+	{
+		const BakedTexture &texture = textures[atlas.textures[i]];
+		const ByteImage &in = texture.levels[std::min(level, (int)texture.levels.size() - 1)];
+
+		left = texture.x >> level;
+		bottom = texture.y >> level;
+		for (y = -gutter; y < in.height + gutter; y++)
+			for (x = -gutter; x < in.width + gutter; x++)
+				memcpy(&out.pixels[4 * ((bottom + y) * out.width + left + x)],
+					   &in.pixels[4 * (std::min(std::max(y, 0), in.height - 1) * in.width +
+						               std::min(std::max(x, 0), in.width - 1))], 4);
+	}
+}
+
+// Round n up to a multiple of the container's data alignment.
+long long alignToContainer(long long n)
+{
+	return (n + CONTAINER_ALIGNMENT - 1) / CONTAINER_ALIGNMENT * CONTAINER_ALIGNMENT;
+}
+
+// Write the textures not in atlases and then the atlases as the container's images,
+// returning the size of the file, 0 if it could not be written, or -1 if an image has 
+// more levels than the container holds.
+long long writeContainer(const std::vector<BakedTexture> &textures, const std::vector<Atlas> &atlases)
+{
+	std::vector<const std::vector<ByteImage> *> imageLevels;
+	std::vector<ContainerImage> images;
+	std::vector<ContainerEntry> entries;
+	std::vector<int> textureImage(textures.size());
+	ContainerHeader header;
+	long long offset;
+	int i, level;
+
+	for (i = 0; i < (int)textures.size(); i++)
+		if (textures[i].atlas < 0)
+		{
+			textureImage[i] = (int)imageLevels.size();
+			imageLevels.push_back(&textures[i].levels);
+		}
+	for (i = 0; i < (int)atlases.size(); i++) imageLevels.push_back(&atlases[i].levels);
+	for (i = 0; i < (int)imageLevels.size(); i++)
+		if (imageLevels[i]->size() > CONTAINER_MAX_LEVELS) return -1;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "TXP1", 4);
+	header.version = CONTAINER_VERSION;
+	header.numImages = (int)imageLevels.size();
+	header.numEntries = (int)textures.size();
+	header.imageOffset = sizeof(ContainerHeader);
+	header.entryOffset = header.imageOffset + header.numImages * sizeof(ContainerImage);
+
+	// Lay out the level data.
+	offset = alignToContainer(header.entryOffset + header.numEntries * sizeof(ContainerEntry));
+	images.resize(header.numImages);
+	for (i = 0; i < header.numImages; i++)
+	{
+		const std::vector<ByteImage> &levels = *imageLevels[i];
+
+		memset(&images[i], 0, sizeof(ContainerImage));
+		images[i].width = levels[0].width;
+		images[i].height = levels[0].height;
+		images[i].numLevels = (int)levels.size();
+		images[i].atlas = i >= header.numImages - (int)atlases.size();
+		for (level = 0; level < images[i].numLevels; level++)
+		{
+			images[i].levelOffsets[level] = offset;
+			images[i].levelSizes[level] = (int)levels[level].pixels.size();
+			offset = alignToContainer(offset + images[i].levelSizes[level]);
+		}
+	}
+	header.fileSize = offset;
+
+	entries.resize(header.numEntries);
+	for (i = 0; i < header.numEntries; i++)
+	{
+		const BakedTexture &texture = textures[i];
+		ContainerEntry &entry = entries[i];
+
+		memset(&entry, 0, sizeof(ContainerEntry));
+		strncpy(entry.name, texture.name.c_str(), CONTAINER_NAME_LENGTH - 1);
+		entry.width = texture.levels[0].width;
+		entry.height = texture.levels[0].height;
+		if (texture.atlas < 0)
+		{
+			entry.image = textureImage[i];
+			entry.texScale[0] = entry.texScale[1] = 1.0;
+		}
+		else
+		{
+			const Atlas &atlas = atlases[texture.atlas];
+
+			entry.image = header.numImages - (int)atlases.size() + texture.atlas;
+			entry.x = texture.x;
+			entry.y = texture.y;
+			entry.texOffset[0] = (float)texture.x / atlas.width;
+			entry.texOffset[1] = (float)texture.y / atlas.height;
+			entry.texScale[0] = (float)entry.width / atlas.width;
+			entry.texScale[1] = (float)entry.height / atlas.height;
+		}
+	}
+
+	std::ofstream outFile(outputName.c_str(), std::ios::binary);
+	std::vector<char> padding(CONTAINER_ALIGNMENT, 0);
+
+	if (!outFile) return 0;
+	outFile.write((const char *)&header, sizeof(header));
+	outFile.write((const char *)&images[0], images.size() * sizeof(ContainerImage));
+	outFile.write((const char *)&entries[0], entries.size() * sizeof(ContainerEntry));
+	for (i = 0; i < header.numImages; i++)
+		for (level = 0; level < images[i].numLevels; level++)
+		{
+			outFile.write(&padding[0], images[i].levelOffsets[level] - (long long)outFile.tellp());
+			outFile.write((const char *)&(*imageLevels[i])[level].pixels[0], images[i].levelSizes[level]);
+		}
+	outFile.write(&padding[0], header.fileSize - (long long)outFile.tellp());
+	outFile.close();
+	return outFile ? header.fileSize : 0;
+}
+
+// Main routine.
+int main(int argc, char **argv)
+{
+	std::vector<std::string> fileNames;
+	std::vector<BakedTexture> textures;
+	std::vector<Atlas> atlases;
+	std::vector<std::pair<int, int> > atlasLevels;
+	std::vector<char> read;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	long long fileSize;
+	int i, numPacked = 0;
+	bool inputGiven = false;
+
+	for (i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-box") filter = MIP_BOX;
+		else if (arg == "-kaiser") filter = MIP_KAISER;
+		else if (arg == "-wrap") wrap = true;
+		else if (arg == "-clamp") wrap = false;
+		else if (arg == "-threads" && i + 1 < argc) numThreads = atoi(argv[++i]);
+		else if (arg == "-atlas" && i + 1 < argc) atlasSize = atoi(argv[++i]);
+		else if (arg == "-small" && i + 1 < argc) smallSize = atoi(argv[++i]);
+		else if (arg == "-o" && i + 1 < argc) outputName = argv[++i];
+		else if (arg[0] == '-')
+		{
+			std::cout << "Usage: TextureBaker [-box | -kaiser] [-wrap | -clamp] [-threads n] [-atlas size] [-small size]"
+				" [-o output] [BMP files or directories ...]" << std::endl;
+			return 1;
+		}
+		else
+		{
+			if (isBmpFile(arg)) fileNames.push_back(arg);
+			else listBmpFiles(arg, fileNames);
+			inputGiven = true;
+		}
+	}
+	if (!inputGiven) listBmpFiles("../../Textures", fileNames);
+	if (fileNames.empty()) return 1;
+	if (numThreads <= 0) numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	// Read the BMP files.
+	textures.resize(fileNames.size());
+	read.assign(fileNames.size(), false);
+	runJobs((int)textures.size(), [&](int t)
+	{
+		textures[t].fileName = fileNames[t];
+		textures[t].name = textureName(fileNames[t]);
+		textures[t].levels.resize(1);
+		textures[t].atlas = -1;
+		textures[t].x = textures[t].y = 0;
+		read[t] = readTexture(textures[t]);
+	});
+	for (i = 0; i < (int)textures.size(); i++)
+	{
+		if (!read[i])
+		{
+			std::cout << "Could not read " << textures[i].fileName << "." << std::endl;
+			return 1;
+		}
+		if (textures[i].name.size() >= CONTAINER_NAME_LENGTH)
+		{
+			std::cout << "Texture name " << textures[i].name << " is too long." << std::endl;
+			return 1;
+		}
+	}
+
+	// Pack the small textures and build every texture's mipmap chain, those in atlases
+	// clamped at their edges.
+	packAtlases(textures, atlases);
+	runJobs((int)textures.size(), [&](int t)
+	{
+		ByteImage image = textures[t].levels[0];
+		buildMipChain(image, filter, wrap && textures[t].atlas < 0, 0, textures[t].levels);
+	});
+
+	// Compose the levels of the atlases.
+	for (i = 0; i < (int)atlases.size(); i++)
+	{
+		atlases[i].levels.resize(std::min(ATLAS_LEVELS, countMipLevels(atlases[i].width, atlases[i].height)));
+		for (int level = 0; level < (int)atlases[i].levels.size(); level++)
+			atlasLevels.push_back(std::make_pair(i, level));
+		numPacked += (int)atlases[i].textures.size();
+	}
+	runJobs((int)atlasLevels.size(), [&](int j)
+	{
+		composeAtlasLevel(textures, atlases[atlasLevels[j].first], atlasLevels[j].second);
+	});
+
+	fileSize = writeContainer(textures, atlases);
+	if (fileSize < 0)
+	{
+		std::cout << "A texture has more than " << CONTAINER_MAX_LEVELS << " mipmap levels." << std::endl;
+		return 1;
+	}
+	if (!fileSize)
+	{
+		std::cout << "Could not write " << outputName << "." << std::endl;
+		return 1;
+	}
+	std::cout << "Baked " << textures.size() << " textures, " << numPacked << " of them into "
+		<< atlases.size() << " atlases, with the " << (filter == MIP_BOX ? "box" : "Kaiser") << " filter into "
+		<< outputName << " (" << fileSize / 1024 << " KB) in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+		<< " ms on " << numThreads << " threads." << std::endl;
+	return 0;
+}
@@ -2,10 +2,12 @@
 // texturedSphere.cpp
 //
 // This program applies an earth texture onto a sphere using the Mercator projection
-// as texture map.
+// as texture map. The texture is streamed in by a texture manager after the first frame
+// is drawn.
 //
 // Interaction:
 // Press x, X, y, Y, z, Z to turn the sphere.
+// Press 'i' to output the state of the texture.
 //
 // Sumanta Guha
 //
@@ -20,7 +22,7 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
-#include "getBMP.h"
+#include "textureManager.h"
 
 #define PI 3.14159265358979324
 #define R 12.0 // Radius of the sphere.
@@ -30,22 +32,16 @@ static int p = 20; // Number of grid columns.
 static int q = 20; // Number of grid rows
 static float *vertices = NULL; // Vertex array of the mapped sample on the sphere.
 static float *textureCoordinates = NULL; // Texture co-ordinates array of the mapped sample on the sphere.
-static unsigned int texture[1]; // Array of texture indices.
+static TextureManager textures; // Streamed textures.
+static int texture[1]; // Array of streamed texture ids.
 static float Xangle = 0.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate sphere.
+static int isStreaming = 1; // Texture still streaming in?
 
-// Load image as a texture. 
+// Add image to the texture manager, to be loaded when first drawn.
 void loadTextures()
 {
-	imageFile *image[1];
-	image[0] = getBMP("../../Textures/earth.bmp");
-
-	glBindTexture(GL_TEXTURE_2D, texture[0]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		         GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	texture[0] = addStreamedTexture(textures, "../../Textures/earth.bmp",
+		GL_REPEAT, GL_REPEAT, GL_LINEAR, GL_LINEAR);
 }
 
 // Fuctions to map the grid vertex (u_i,v_j) to the mesh vertex (f(u_i,v_j), g(u_i,v_j), h(u_i,v_j)) on the sphere.
@@ -103,8 +99,8 @@ void setup(void)
 
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 
-	// Create texture ids.
-	glGenTextures(1, texture);
+	// Create the texture manager with a budget of 64 MB.
+	createTextureManager(textures, 64 << 20);
 
 	// Load texture.
 	loadTextures();
@@ -148,7 +144,7 @@ void drawScene(void)
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
 	// Map the texture onto the sphere.
-	glBindTexture(GL_TEXTURE_2D, texture[0]);
+	bindStreamedTexture(textures, texture[0]);
 	for (j = 0; j < q; j++)
 	{
 		glBegin(GL_TRIANGLE_STRIP);
@@ -161,6 +157,14 @@ void drawScene(void)
 	}
 
 	glutSwapBuffers();
+
+	// Upload texture levels loaded and keep drawing till all are in.
+	if (updateTextureManager(textures)) glutPostRedisplay();
+	else if (isStreaming)
+	{
+		isStreaming = 0;
+		std::cout << "Texture streamed in by " << glutGet(GLUT_ELAPSED_TIME) << " ms." << std::endl;
+	}
 }
 
 // OpenGL window reshape routine.
@@ -212,6 +216,9 @@ void keyInput(unsigned char key, int x, int y)
 		if (Zangle < 0.0) Zangle += 360.0;
 		glutPostRedisplay();
 		break;
+	case 'i':
+		printTextureManagerStats(textures);
+		break;
 	default:
 		break;
 	}
@@ -221,7 +228,8 @@ void keyInput(unsigned char key, int x, int y)
 void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
-	std::cout << "Press x, X, y, Y, z, Z to turn the sphere." << std::endl;
+	std::cout << "Press x, X, y, Y, z, Z to turn the sphere." << std::endl
+		<< "Press 'i' to output the state of the texture." << std::endl;
 }
 
 // Main routine.
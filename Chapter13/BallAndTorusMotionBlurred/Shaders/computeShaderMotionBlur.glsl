@@ -0,0 +1,64 @@
+#version 430 core
+
+#define TILE 16
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(rgba8, binding = 0) uniform readonly image2D colorImage;
+layout(rg16f, binding = 1) uniform readonly image2D velocityImage;
+layout(rg16f, binding = 2) uniform readonly image2D neighborMaxImage;
+layout(rgba8, binding = 3) uniform writeonly image2D outImage;
+
+uniform int motionSamples;
+
+// Velocity shortened to at most a tile, the furthest the neighborhood can smear.
+vec2 clampVelocity(vec2 velocity)
+{
+   float speed = length(velocity);
+   return (speed > TILE) ? velocity * (TILE / speed) : velocity;
+}
+
+// Weight of a pixel moving at the given speed smearing over a point at the given distance.
+float cone(float dist, float speed)
+{
+   return clamp(1.0 - dist / max(speed, 1.0e-3), 0.0, 1.0);
+}
+
+void main(void)
+{
+   ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+   ivec2 size = imageSize(colorImage);
+   vec2 longest, velocity, sampleVelocity, offset;
+   vec4 color, sum;
+   float speed, weight, totalWeight;
+   ivec2 samplePixel;
+
+   if (any(greaterThanEqual(pixel, size))) return;
+
+   color = imageLoad(colorImage, pixel);
+   longest = clampVelocity(imageLoad(neighborMaxImage, pixel / TILE).xy);
+   if (length(longest) < 0.5)
+   {
+      imageStore(outImage, pixel, color);
+      return;
+   }
+
+   velocity = clampVelocity(imageLoad(velocityImage, pixel).xy);
+   speed = length(velocity);
+
+   // Samples along the neighborhood's longest velocity, centered on the pixel, each
+   // weighted by how far its own motion smears it over the pixel and the pixel's over it.
+   totalWeight = 1.0 / max(speed, 1.0);
+   sum = totalWeight * color;
+   for (int i = 0; i < motionSamples; i++)
+   {
+      offset = longest * (float(i) + 0.5) / float(motionSamples) - 0.5 * longest;
+      samplePixel = clamp(pixel + ivec2(round(offset)), ivec2(0), size - 1);
+      if (samplePixel == pixel) continue;
+      sampleVelocity = clampVelocity(imageLoad(velocityImage, samplePixel).xy);
+      weight = cone(length(offset), 0.5 * length(sampleVelocity)) + cone(length(offset), 0.5 * speed);
+      sum += weight * imageLoad(colorImage, samplePixel);
+      totalWeight += weight;
+   }
+   imageStore(outImage, pixel, sum / totalWeight);
+}
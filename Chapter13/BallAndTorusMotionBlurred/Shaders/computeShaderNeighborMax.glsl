@@ -0,0 +1,23 @@
+#version 430 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(rg16f, binding = 0) uniform readonly image2D tileMaxImage;
+layout(rg16f, binding = 1) uniform writeonly image2D neighborMaxImage;
+
+void main(void)
+{
+   ivec2 tile = ivec2(gl_GlobalInvocationID.xy);
+   ivec2 size = imageSize(tileMaxImage);
+   vec2 longest = vec2(0.0), velocity;
+
+   if (any(greaterThanEqual(tile, size))) return;
+
+   for (int i = -1; i <= 1; i++)
+      for (int j = -1; j <= 1; j++)
+      {
+         velocity = imageLoad(tileMaxImage, clamp(tile + ivec2(i, j), ivec2(0), size - 1)).xy;
+         if (dot(velocity, velocity) > dot(longest, longest)) longest = velocity;
+      }
+   imageStore(neighborMaxImage, tile, vec4(longest, 0.0, 0.0));
+}
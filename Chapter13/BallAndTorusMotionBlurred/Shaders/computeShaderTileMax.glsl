@@ -0,0 +1,32 @@
+#version 430 core
+
+#define TILE 16
+
+layout(local_size_x = TILE, local_size_y = TILE) in;
+
+layout(rg16f, binding = 0) uniform readonly image2D velocityImage;
+layout(rg16f, binding = 1) uniform writeonly image2D tileMaxImage;
+
+shared vec2 velocities[TILE * TILE];
+
+void main(void)
+{
+   ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+   uint localIndex = gl_LocalInvocationIndex;
+   vec2 velocity = vec2(0.0);
+
+   if (all(lessThan(pixel, imageSize(velocityImage)))) velocity = imageLoad(velocityImage, pixel).xy;
+   velocities[localIndex] = velocity;
+   barrier();
+
+   // Reduce the tile to its longest velocity, halving the number of candidates each step.
+   for (uint stride = TILE * TILE / 2; stride > 0; stride /= 2)
+   {
+      if (localIndex < stride && dot(velocities[localIndex + stride], velocities[localIndex + stride]) >
+                            dot(velocities[localIndex], velocities[localIndex]))
+         velocities[localIndex] = velocities[localIndex + stride];
+      barrier();
+   }
+
+   if (localIndex == 0) imageStore(tileMaxImage, ivec2(gl_WorkGroupID.xy), vec4(velocities[0], 0.0, 0.0));
+}
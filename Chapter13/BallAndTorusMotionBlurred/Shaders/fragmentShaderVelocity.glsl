@@ -0,0 +1,16 @@
+#version 430 compatibility
+
+in vec4 clipCoordsExport;
+in vec4 prevClipCoordsExport;
+
+uniform vec2 viewportSize;
+uniform float shutter;
+
+layout(location=0) out vec2 velocityOut;
+
+void main(void)
+{
+   // Motion in pixels since last frame, times the number of frames the shutter is open.
+   velocityOut = shutter * 0.5 * viewportSize * (clipCoordsExport.xy / clipCoordsExport.w - 
+                                                 prevClipCoordsExport.xy / prevClipCoordsExport.w);
+}
@@ -0,0 +1,16 @@
+#version 430 compatibility
+
+uniform mat4 prevMat;
+
+out vec4 clipCoordsExport;
+out vec4 prevClipCoordsExport;
+
+void main(void)
+{
+   // Transformed exactly as by the fixed-function pipeline, so as to pass the depth test.
+   gl_Position = ftransform();
+
+   // Positions this frame and last.
+   clipCoordsExport = gl_Position;
+   prevClipCoordsExport = prevMat * gl_Vertex;
+}
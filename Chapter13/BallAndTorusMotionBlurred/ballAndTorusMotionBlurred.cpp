@@ -2,11 +2,15 @@
 // ballAndTorusMotionBlurred.cpp
 //
 // This program, based on ballAndTorusLitOrthoShadowed.cpp, creates a motion blur effect
-// for the ball by blending in 4 additional copies with lower alpha values.
+// for the ball as post-processing. The scene is drawn into a framebuffer object, then the
+// ball again with a shader writing its motion since the last frame into a velocity buffer,
+// and compute shaders smear each pixel along the velocities around it.
 //
 // Interaction:
 // Press space to toggle between animation on and off.
 // Press the up/down arrow keys to speed up/slow down animation.
+// Press 'm' to toggle motion blur on and off.
+// Press 't' to output the time taken by each pass.
 //
 // Sumanta Guha
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -16,12 +20,26 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "prepShader.h"
+#include "postProcess.h"
+
 // Globals. 
 static float latAngle = 0.0; // Latitudinal angle.
 static float longAngle = 0.0; // Longitudinal angle.
 static int isAnimate = 0; // Animated?
 static int animationPeriod = 1; // Time interval between frames.
 
+static PostProcess post; // Offscreen targets and motion blur passes.
+static float shutter = 4.0; // Frames of motion smeared, as many as the copies of the ball once drawn.
+static float ballModelViewMat[16]; // Modelview matrix the ball was last drawn with.
+static float ballMat[16], prevBallMat[16]; // Its projection x modelview this frame and last.
+static int isPrevBallMat = 0; // Has the ball been drawn before?
+static unsigned int
+	velocityProgramId,
+	prevMatLoc,
+	viewportSizeLoc,
+	shutterLoc;
+
 // Draw the flying ball with both latitudinal and longitudinal rotation angles as parameters.
 void drawFlyingBall(float latAngle, float longAngle)
 {
@@ -37,7 +55,7 @@ void drawFlyingBall(float latAngle, float longAngle)
 }
 
 // Draw ball flying around torus, both black if shadow is true, colored otherwise.
-// Additionally draw copies of the ball just behind it to give blur effect.
+// The ball's modelview matrix is saved when not drawing shadows.
 void drawFlyingBallAndTorus(int shadow)
 {
 	glShadeModel(GL_SMOOTH);
@@ -57,35 +75,47 @@ void drawFlyingBallAndTorus(int shadow)
 	if (shadow) glColor4f(0.0, 0.0, 0.0, 1.0);
 	else glColor4f(0.0, 0.0, 1.0, 1.0);
 	drawFlyingBall(latAngle, longAngle);
+	if (!shadow) glGetFloatv(GL_MODELVIEW_MATRIX, ballModelViewMat);
 	glPopMatrix();
 	// End revolving ball.
 
-	// 4 additional copies of the ball drawn successively behind it with decreasing alpha values.
-	// Copies drawn only when animation is on and not drawn for shadows.
-	//if (isAnimate && !shadow) 
-	if (!shadow)
+	glPopMatrix();
+}
+
+// Draw the ball's velocity into the velocity buffer, where it is not hidden.
+void drawBallVelocity(void)
+{
+	float projMat[16];
+
+	// Ball's projection x modelview matrix, computed in the modelview matrix stack.
+	glGetFloatv(GL_PROJECTION_MATRIX, projMat);
+	glPushMatrix();
+	glLoadMatrixf(projMat);
+	glMultMatrixf(ballModelViewMat);
+	glGetFloatv(GL_MODELVIEW_MATRIX, ballMat);
+	glPopMatrix();
+	if (!isPrevBallMat)
 	{
-		glPushMatrix();
-		glColor4f(0.0, 0.0, 1.0, 0.5);
-		drawFlyingBall(latAngle - 5.0, longAngle - 1.0);
-		glPopMatrix();
-
-		glPushMatrix();
-		glColor4f(0.0, 0.0, 1.0, 0.4);
-		drawFlyingBall(latAngle - 10.0, longAngle - 2.0);
-		glPopMatrix();
-
-		glPushMatrix();
-		glColor4f(0.0, 0.0, 1.0, 0.3);
-		drawFlyingBall(latAngle - 15.0, longAngle - 3.0);
-		glPopMatrix();
-
-		glPushMatrix();
-		glColor4f(0.0, 0.0, 1.0, 0.2);
-		drawFlyingBall(latAngle - 20.0, longAngle - 4.0);
-		glPopMatrix();
+		for (int i = 0; i < 16; i++) prevBallMat[i] = ballMat[i];
+		isPrevBallMat = 1;
 	}
+
+	glDrawBuffer(GL_COLOR_ATTACHMENT1);
+	glDepthFunc(GL_LEQUAL);
+	glUseProgram(velocityProgramId);
+	glUniformMatrix4fv(prevMatLoc, 1, GL_FALSE, prevBallMat);
+	glUniform2f(viewportSizeLoc, (float)post.width, (float)post.height);
+	glUniform1f(shutterLoc, shutter);
+
+	glPushMatrix();
+	glLoadMatrixf(ballModelViewMat);
+	glutSolidSphere(2.0, 20, 20);
 	glPopMatrix();
+
+	glUseProgram(0);
+	glDepthFunc(GL_LESS);
+
+	for (int i = 0; i < 16; i++) prevBallMat[i] = ballMat[i];
 }
 
 // Draw checkered floor.
@@ -170,16 +200,28 @@ void setup(void)
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 
-	glEnable(GL_BLEND); // Enable blending.
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Specify blending parameters.
+	// Create the velocity shader program executable.
+	unsigned int vertexShaderId = setShader("vertex", "Shaders/vertexShaderVelocity.glsl");
+	unsigned int fragmentShaderId = setShader("fragment", "Shaders/fragmentShaderVelocity.glsl");
+	velocityProgramId = glCreateProgram();
+	glAttachShader(velocityProgramId, vertexShaderId);
+	glAttachShader(velocityProgramId, fragmentShaderId);
+	glLinkProgram(velocityProgramId);
+	prevMatLoc = glGetUniformLocation(velocityProgramId, "prevMat");
+	viewportSizeLoc = glGetUniformLocation(velocityProgramId, "viewportSize");
+	shutterLoc = glGetUniformLocation(velocityProgramId, "shutter");
+
+	// Create the post-processing targets and passes, with motion blur on.
+	createPostProcess(post, 500, 500);
+	post.motionBlur = true;
 }
 
 // Drawing routine.
 void drawScene(void)
 {
-	int i = 0;
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// Draw the scene's colors into the post-processing framebuffer.
+	beginPostProcessScene(post);
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
 
 	glLoadIdentity();
 	gluLookAt(0.0, 36.0, 7.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
@@ -204,6 +246,10 @@ void drawScene(void)
 	// Draw real ball and torus.
 	drawFlyingBallAndTorus(0);
 
+	// Draw the ball's velocity, then blur and show.
+	drawBallVelocity();
+	endPostProcessScene(post);
+
 	glutSwapBuffers();
 }
 
@@ -216,6 +262,9 @@ void resize(int w, int h)
 	gluPerspective(90.0, 1.0, 5.0, 100.0);
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
+
+	setPostWindowSize(post, w, h);
+	resizePostProcess(post, w, h);
 }
 
 // Keyboard input processing routine.
@@ -235,6 +284,13 @@ void keyInput(unsigned char key, int x, int y)
 		}
 		glutPostRedisplay();
 		break;
+	case 'm':
+		post.motionBlur = !post.motionBlur;
+		glutPostRedisplay();
+		break;
+	case 't':
+		printPostProcessTimings(post);
+		break;
 	default:
 		break;
 	}
@@ -253,7 +309,9 @@ void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press space to toggle between animation on and off." << std::endl
-		<< "Press the up/down arrow keys to speed up/slow down animation." << std::endl;
+		<< "Press the up/down arrow keys to speed up/slow down animation." << std::endl
+		<< "Press 'm' to toggle motion blur on and off." << std::endl
+		<< "Press 't' to output the time taken by each pass." << std::endl;
 }
 
 // Main routine.
@@ -0,0 +1,290 @@
+#include <cmath>
+#include <iostream>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h> 
+
+#include "prepShader.h"
+#include "postProcess.h"
+
+#define BLUR_TILE 256 // Pixels per work group of the blur, as declared in the blur shader.
+
+static const char *passNames[POST_NUM_PASSES] =
+	{ "scene", "tile max", "neighbor max", "motion blur", "blur horizontal", "blur vertical", "present" };
+
+// Create a compute program from the shader file.
+static unsigned int createComputeProgram(char *shaderFile)
+{
+	unsigned int programId = glCreateProgram();
+
+	glAttachShader(programId, setShader("compute", shaderFile));
+	glLinkProgram(programId);
+	return programId;
+}
+
+// Create a texture of the given format and size, filtered nearest.
+static unsigned int createTexture(unsigned int format, int width, int height)
+{
+	unsigned int texture;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+// Create the targets at the current size.
+static void createTargets(PostProcess &post)
+{
+	unsigned int drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	int tilesX = (post.width + POST_MOTION_TILE - 1) / POST_MOTION_TILE;
+	int tilesY = (post.height + POST_MOTION_TILE - 1) / POST_MOTION_TILE;
+
+	post.colorTexture[0] = createTexture(GL_RGBA8, post.width, post.height);
+	post.colorTexture[1] = createTexture(GL_RGBA8, post.width, post.height);
+	post.velocityTexture = createTexture(GL_RG16F, post.width, post.height);
+	post.tileMaxTexture = createTexture(GL_RG16F, tilesX, tilesY);
+	post.neighborMaxTexture = createTexture(GL_RG16F, tilesX, tilesY);
+
+	glGenRenderbuffers(1, &post.depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, post.depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, post.width, post.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(2, post.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, post.framebuffer[0]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, post.colorTexture[0], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, post.velocityTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, post.depthRenderbuffer);
+	glDrawBuffers(2, drawBuffers);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Post-processing framebuffer incomplete." << std::endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, post.framebuffer[1]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, post.colorTexture[1], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Delete the targets.
+static void deleteTargets(PostProcess &post)
+{
+	glDeleteFramebuffers(2, post.framebuffer);
+	glDeleteRenderbuffers(1, &post.depthRenderbuffer);
+	glDeleteTextures(2, post.colorTexture);
+	glDeleteTextures(1, &post.velocityTexture);
+	glDeleteTextures(1, &post.tileMaxTexture);
+	glDeleteTextures(1, &post.neighborMaxTexture);
+}
+
+// Create the post-processing targets of the given size and the effect programs.
+// Both effects are off to start.
+void createPostProcess(PostProcess &post, int width, int height)
+{
+	post.width = post.windowWidth = width;
+	post.height = post.windowHeight = height;
+	post.current = 0;
+	post.blur = false;
+	post.motionBlur = false;
+	post.motionSamples = 15;
+	post.budgetMs = 2.0;
+	post.queryFrame = 0;
+	post.queriesIssued[0] = post.queriesIssued[1] = false;
+	for (int i = 0; i < POST_NUM_PASSES; i++) post.passMs[i] = 0.0;
+
+	createTargets(post);
+
+	post.blurProgramId = createComputeProgram("Shaders/computeShaderBlur.glsl");
+	post.tileMaxProgramId = createComputeProgram("Shaders/computeShaderTileMax.glsl");
+	post.neighborMaxProgramId = createComputeProgram("Shaders/computeShaderNeighborMax.glsl");
+	post.motionProgramId = createComputeProgram("Shaders/computeShaderMotionBlur.glsl");
+	post.directionLoc = glGetUniformLocation(post.blurProgramId, "direction");
+	post.radiusLoc = glGetUniformLocation(post.blurProgramId, "radius");
+	post.weightsLoc = glGetUniformLocation(post.blurProgramId, "weights");
+	post.motionSamplesLoc = glGetUniformLocation(post.motionProgramId, "motionSamples");
+
+	glGenQueries(2 * (POST_NUM_PASSES + 1), post.queries[0]);
+
+	setBlurKernel(post, POST_GAUSSIAN, 4);
+}
+
+// Resize the offscreen targets, which need not be the size of the window.
+void resizePostProcess(PostProcess &post, int width, int height)
+{
+	if (width == post.width && height == post.height) return;
+	deleteTargets(post);
+	post.width = width;
+	post.height = height;
+	createTargets(post);
+}
+
+// Set the size of the window the result is presented to.
+void setPostWindowSize(PostProcess &post, int width, int height)
+{
+	post.windowWidth = width;
+	post.windowHeight = height;
+}
+
+// Set the blur kernel and radius, clamped to POST_MAX_BLUR_RADIUS. The Gaussian's
+// standard deviation is half the radius.
+void setBlurKernel(PostProcess &post, int kernel, int radius)
+{
+	float sigma, sum;
+	int k;
+
+	post.kernel = kernel;
+	post.radius = (radius < 1) ? 1 : (radius > POST_MAX_BLUR_RADIUS) ? POST_MAX_BLUR_RADIUS : radius;
+
+	sigma = post.radius / 2.0;
+	for (k = 0; k <= post.radius; k++)
+		post.weights[k] = (kernel == POST_BOX) ? 1.0 : exp(-(k * k) / (2.0 * sigma * sigma));
+	sum = post.weights[0];
+	for (k = 1; k <= post.radius; k++) sum += 2.0 * post.weights[k];
+	for (k = 0; k <= post.radius; k++) post.weights[k] /= sum;
+}
+
+// Read back the timestamps of the given frame's set, if issued, and if ready unless
+// waiting for them.
+static void readTimings(PostProcess &post, int frame, bool wait)
+{
+	GLuint64 times[POST_NUM_PASSES + 1];
+	int available = 0, i;
+
+	if (!post.queriesIssued[frame]) return;
+	glGetQueryObjectiv(post.queries[frame][POST_NUM_PASSES], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available && !wait) return;
+	for (i = 0; i <= POST_NUM_PASSES; i++) glGetQueryObjectui64v(post.queries[frame][i], GL_QUERY_RESULT, &times[i]);
+	for (i = 0; i < POST_NUM_PASSES; i++) post.passMs[i] = (times[i + 1] - times[i]) / 1.0e6;
+	post.queriesIssued[frame] = false;
+}
+
+// Record the end of the pass, or of its being skipped.
+static void markPass(PostProcess &post, int pass)
+{
+	glQueryCounter(post.queries[post.queryFrame][pass + 1], GL_TIMESTAMP);
+}
+
+// Bind the scene framebuffer and clear it, velocity to 0, ready for the scene to be drawn.
+// The scene writes color to output 0 and velocity to output 1 of its fragment shader, or,
+// drawn without a shader, changes the draw buffers to write the two separately.
+void beginPostProcessScene(PostProcess &post)
+{
+	unsigned int drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	float zero[] = { 0.0, 0.0, 0.0, 0.0 };
+
+	readTimings(post, post.queryFrame, false);
+	glQueryCounter(post.queries[post.queryFrame][0], GL_TIMESTAMP);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, post.framebuffer[0]);
+	glDrawBuffers(2, drawBuffers);
+	glViewport(0, 0, post.width, post.height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClearBufferfv(GL_COLOR, 1, zero);
+	post.current = 0;
+}
+
+// Separable blur, horizontal from the current color texture to the other, then vertical back.
+static void blur(PostProcess &post)
+{
+	glUseProgram(post.blurProgramId);
+	glUniform1i(post.radiusLoc, post.radius);
+	glUniform1fv(post.weightsLoc, post.radius + 1, post.weights);
+
+	glBindImageTexture(0, post.colorTexture[post.current], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA8);
+	glBindImageTexture(1, post.colorTexture[1 - post.current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glUniform2i(post.directionLoc, 1, 0);
+	glDispatchCompute((post.width + BLUR_TILE - 1) / BLUR_TILE, post.height, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	markPass(post, POST_BLUR_HORIZONTAL);
+
+	glBindImageTexture(0, post.colorTexture[1 - post.current], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA8);
+	glBindImageTexture(1, post.colorTexture[post.current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glUniform2i(post.directionLoc, 0, 1);
+	glDispatchCompute((post.height + BLUR_TILE - 1) / BLUR_TILE, post.width, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	markPass(post, POST_BLUR_VERTICAL);
+}
+
+// Motion blur from the current color texture to the other.
+static void motionBlur(PostProcess &post)
+{
+	int tilesX = (post.width + POST_MOTION_TILE - 1) / POST_MOTION_TILE;
+	int tilesY = (post.height + POST_MOTION_TILE - 1) / POST_MOTION_TILE;
+
+	// Longest velocity in each tile.
+	glUseProgram(post.tileMaxProgramId);
+	glBindImageTexture(0, post.velocityTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG16F);
+	glBindImageTexture(1, post.tileMaxTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+	glDispatchCompute(tilesX, tilesY, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	markPass(post, POST_TILE_MAX);
+
+	// Longest velocity in each tile's 3x3 neighborhood.
+	glUseProgram(post.neighborMaxProgramId);
+	glBindImageTexture(0, post.tileMaxTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG16F);
+	glBindImageTexture(1, post.neighborMaxTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+	glDispatchCompute((tilesX + 7) / 8, (tilesY + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	markPass(post, POST_NEIGHBOR_MAX);
+
+	// Gather along the neighborhood's velocity.
+	glUseProgram(post.motionProgramId);
+	glUniform1i(post.motionSamplesLoc, post.motionSamples);
+	glBindImageTexture(0, post.colorTexture[post.current], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA8);
+	glBindImageTexture(1, post.velocityTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG16F);
+	glBindImageTexture(2, post.neighborMaxTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG16F);
+	glBindImageTexture(3, post.colorTexture[1 - post.current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glDispatchCompute((post.width + 15) / 16, (post.height + 15) / 16, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	post.current = 1 - post.current;
+	markPass(post, POST_MOTION_BLUR);
+}
+
+// Run the enabled effects on the scene and blit the result to the window, scaling it if
+// the targets are not the window's size. Leaves the window's framebuffer bound.
+void endPostProcessScene(PostProcess &post)
+{
+	int pass;
+
+	markPass(post, POST_SCENE);
+
+	if (post.motionBlur) motionBlur(post);
+	else for (pass = POST_TILE_MAX; pass <= POST_MOTION_BLUR; pass++) markPass(post, pass);
+
+	if (post.blur) blur(post);
+	else for (pass = POST_BLUR_HORIZONTAL; pass <= POST_BLUR_VERTICAL; pass++) markPass(post, pass);
+
+	glUseProgram(0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, post.framebuffer[post.current]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, post.width, post.height, 0, 0, post.windowWidth, post.windowHeight,
+		GL_COLOR_BUFFER_BIT, (post.width == post.windowWidth && post.height == post.windowHeight) ? GL_NEAREST : GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, post.windowWidth, post.windowHeight);
+	markPass(post, POST_PRESENT);
+
+	post.queriesIssued[post.queryFrame] = true;
+	post.queryFrame = 1 - post.queryFrame;
+}
+
+// Output the time of each pass of the last frame and the total of the effects against
+// the budget, waiting for them if need be.
+void printPostProcessTimings(PostProcess &post)
+{
+	float total = 0.0;
+	int pass;
+
+	readTimings(post, 1 - post.queryFrame, true);
+	std::cout << "Pass times at " << post.width << "x" << post.height << " (ms):" << std::endl;
+	for (pass = 0; pass < POST_NUM_PASSES; pass++)
+	{
+		std::cout << "  " << passNames[pass] << ": " << post.passMs[pass] << std::endl;
+		if (pass != POST_SCENE) total += post.passMs[pass];
+	}
+	std::cout << "  effects total: " << total << " of " << post.budgetMs << " budgeted"
+		<< ((total > post.budgetMs) ? ", OVER BUDGET" : "") << std::endl;
+}
@@ -0,0 +1,62 @@
+#ifndef POSTPROCESS_H
+#define POSTPROCESS_H
+
+#define POST_MAX_BLUR_RADIUS 32 // Largest blur radius, as declared in the blur shader.
+#define POST_MOTION_TILE 16 // Tile size in pixels of the motion blur, its longest smear.
+
+enum postKernel {POST_BOX, POST_GAUSSIAN}; // Blur kernels.
+enum postPass {POST_SCENE, POST_TILE_MAX, POST_NEIGHBOR_MAX, POST_MOTION_BLUR,
+               POST_BLUR_HORIZONTAL, POST_BLUR_VERTICAL, POST_PRESENT, POST_NUM_PASSES}; // Timed passes, in order.
+
+// Post-processing of a scene rendered into a framebuffer object instead of the window.
+// The framebuffer has a color texture, a velocity texture, to which the scene writes the
+// screen-space motion of each pixel in pixels per frame, and a depth renderbuffer. Effects
+// are compute shaders that read one of two color textures and write the other, ping-pong
+// fashion, and the last one written is blitted to the window.
+//
+// Blurs are separable, run as a horizontal then a vertical pass, each work group loading
+// a row (column) tile of pixels with an apron of the radius on either side into shared
+// memory once and convolving from there. Motion blur first reduces the velocity buffer
+// to the longest velocity in each tile, again in shared memory, then to the longest in
+// each tile's neighborhood, which bounds the smear reaching any pixel from outside its
+// own tile, and gathers along that.
+//
+// Each pass is bracketed by timestamp queries, read back two frames later so as not to stall.
+struct PostProcess
+{
+	int width, height; // Size of the offscreen targets.
+	int windowWidth, windowHeight; // Size of the window presented to.
+
+	unsigned int framebuffer[2]; // Ping-pong framebuffers, the scene drawn to the first.
+	unsigned int colorTexture[2]; // Their color textures.
+	unsigned int velocityTexture; // Second color attachment of the scene framebuffer.
+	unsigned int depthRenderbuffer; // Depth attachment of the scene framebuffer.
+	unsigned int tileMaxTexture, neighborMaxTexture; // Longest velocity per tile.
+	int current; // Color texture holding the latest result.
+
+	unsigned int blurProgramId, tileMaxProgramId, neighborMaxProgramId, motionProgramId; // Programs.
+	unsigned int directionLoc, radiusLoc, weightsLoc, motionSamplesLoc; // Uniform locations.
+
+	bool blur; // If to blur.
+	int kernel; // Blur kernel.
+	int radius; // Blur radius in pixels.
+	float weights[POST_MAX_BLUR_RADIUS + 1]; // Kernel weights at offsets 0 to radius.
+	bool motionBlur; // If to motion blur.
+	int motionSamples; // Samples gathered per pixel by the motion blur.
+
+	unsigned int queries[2][POST_NUM_PASSES + 1]; // Timestamps of two frames.
+	bool queriesIssued[2]; // If the frame's timestamps have been issued.
+	int queryFrame; // Set of timestamps to issue this frame.
+	float passMs[POST_NUM_PASSES]; // Latest time in milliseconds of each pass.
+	float budgetMs; // Time allowed the post-processing passes.
+};
+
+void createPostProcess(PostProcess &post, int width, int height);
+void resizePostProcess(PostProcess &post, int width, int height);
+void setPostWindowSize(PostProcess &post, int width, int height);
+void setBlurKernel(PostProcess &post, int kernel, int radius);
+void beginPostProcessScene(PostProcess &post);
+void endPostProcessScene(PostProcess &post);
+void printPostProcessTimings(PostProcess &post);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef PREPSHADER_H
+#define PREPSHADER_H
+
+int setShader(char* shaderType, char* shaderFile);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#version 430 core
+
+#define MAX_CASCADES 4
+#define FLOOR 0
+
+in vec3 worldCoordsExport;
+in vec3 normalExport;
+in float viewDepthExport;
+
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMats[MAX_CASCADES];
+uniform float splits[MAX_CASCADES];
+uniform int numCascades;
+uniform int showCascades;
+uniform vec3 lightPos;
+uniform vec3 cameraPos;
+uniform uint object;
+uniform vec4 objColor;
+
+out vec4 colorsOut;
+
+const vec4 globAmb = vec4(0.3, 0.3, 0.3, 1.0);
+const float matShine = 50.0;
+const vec3 cascadeColors[MAX_CASCADES] =
+   vec3[](vec3(1.0, 0.6, 0.6), vec3(0.6, 1.0, 0.6), vec3(0.6, 0.6, 1.0), vec3(1.0, 1.0, 0.6));
+
+// Fraction of a 3x3 block of shadow map texels around the fragment it is lit in,
+// each comparison itself filtered by the sampler between 4 texels.
+float visibility(int cascade)
+{
+   vec4 shadowCoords = shadowMats[cascade] * vec4(worldCoordsExport, 1.0);
+   vec3 texCoords;
+   vec2 texelSize;
+   float lit = 0.0;
+
+   if (shadowCoords.w <= 0.0) return 1.0;
+   texCoords = shadowCoords.xyz / shadowCoords.w;
+   if (any(lessThan(texCoords, vec3(0.0))) || any(greaterThan(texCoords, vec3(1.0)))) return 1.0;
+
+   texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+   for (int i = -1; i <= 1; i++)
+      for (int j = -1; j <= 1; j++)
+         lit += texture(shadowMap, vec4(texCoords.xy + vec2(i, j) * texelSize, cascade, texCoords.z));
+   return lit / 9.0;
+}
+
+void main(void)
+{
+   vec4 color = objColor;
+   vec3 normal, lightDirection, eyeDirection, halfway;
+   float shadow;
+   int cascade = 0;
+
+   // Checkered floor of 5 x 5 squares.
+   if (object == FLOOR)
+      color = (mod(floor(worldCoordsExport.x / 5.0) + floor(worldCoordsExport.z / 5.0), 2.0) == 0.0) ?
+         vec4(1.0, 1.0, 1.0, 1.0) : vec4(0.0, 0.5, 0.5, 1.0);
+
+   // Cascade containing the fragment.
+   while (cascade < numCascades - 1 && viewDepthExport > splits[cascade]) cascade++;
+   shadow = visibility(cascade);
+   if (showCascades == 1) color.rgb *= cascadeColors[cascade];
+
+   normal = normalize(normalExport);
+   lightDirection = normalize(lightPos - worldCoordsExport);
+   eyeDirection = normalize(cameraPos - worldCoordsExport);
+   halfway = normalize(lightDirection + eyeDirection);
+
+   colorsOut = globAmb * color;
+   if (dot(normal, lightDirection) > 0.0)
+      colorsOut += shadow * (dot(normal, lightDirection) * color +
+                             pow(max(dot(normal, halfway), 0.0), matShine) * vec4(1.0));
+   colorsOut.a = 1.0;
+}
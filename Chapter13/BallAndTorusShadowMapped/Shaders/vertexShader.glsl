@@ -0,0 +1,23 @@
+#version 430 core
+
+layout(location=0) in vec3 coords;
+layout(location=1) in vec3 normal;
+
+uniform mat4 projMat;
+uniform mat4 viewMat;
+uniform mat4 modelMat;
+
+out vec3 worldCoordsExport;
+out vec3 normalExport;
+out float viewDepthExport;
+
+void main(void)
+{
+   vec4 worldCoords = modelMat * vec4(coords, 1.0);
+   vec4 eyeCoords = viewMat * worldCoords;
+
+   worldCoordsExport = worldCoords.xyz;
+   normalExport = mat3(modelMat) * normal; // Model matrices are rigid motions.
+   viewDepthExport = -eyeCoords.z;
+   gl_Position = projMat * eyeCoords;
+}
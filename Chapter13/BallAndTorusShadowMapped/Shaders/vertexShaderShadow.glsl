@@ -0,0 +1,11 @@
+#version 430 core
+
+layout(location=0) in vec3 coords;
+
+uniform mat4 lightMat;
+uniform mat4 modelMat;
+
+void main(void)
+{
+   gl_Position = lightMat * modelMat * vec4(coords, 1.0);
+}
@@ -4,20 +4,38 @@
 // This program applies shadow mapping to a scene with a single local light source (except for the
 // light source the scene is identical to that of BallAndTorusLitProjectivelyShadowed.cpp).
 //
+// The light's depths are rendered directly into the layers of a depth texture array attached to
+// a framebuffer object, one layer per cascade of the camera's view frustum, and are compared
+// against in the shader through a shadow sampler, with percentage-closer filtering over a 3x3
+// block of texels. The floor and torus do not move, so their depths are rendered only when the
+// cascades change, and each frame only the ball is drawn over a copy of them. The scene is
+// drawn once from the camera with the lighting computed per fragment.
+//
 // Interaction:
 // Press space to toggle between animation on and off.
 // Press the up/down arrow keys to speed up/slow down animation.
+// Press 'c' to cycle through 1 to 4 shadow map cascades.
+// Press 'v' to toggle coloring the scene by cascade.
 //
 // Sumanta Guha
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "prepShader.h"
+#include "shadowMap.h"
+
+#define PI 3.14159265
+
+static enum object {FLOOR, TORUS, BALL}; // VAO ids, also the object uniform.
+
 // Begin globals. 
 static float latAngle = 0.0; // Latitudinal angle.
 static float longAngle = 0.0; // Longitudinal angle.
@@ -26,9 +44,9 @@ static int animationPeriod = 100; // Time interval between frames.
 
 static int winWth, winHgt; // OpenGL window sizes.
 
-static unsigned int shadowMap; // Shadow map.
-static int shadowMapWth = 512; // Shadow map width.
-static int shadowMapHgt = 512; // Shadow map height.
+static ShadowMap shadow; // Cascaded shadow maps.
+static int shadowMapSize = 1024; // Shadow map width and height.
+static int showCascades = 0; // Color the scene by cascade?
 
 // Camera properties.
 static float cameraFovy = 90.0; // gluPerspective from camera: field of view angle.
@@ -43,40 +61,125 @@ static float lightFovy = 120.0; // gluPerspective from light: field of view angl
 static float lightAspect = 1.0; // gluPerspective from light: aspect ratio.
 static float lightNearPlane = 1.0; // gluPerspective from light: near plane.
 static float lightFarPlane = 35.0; // gluPerspective from light: far plane.
-static float lightPos[] = { 0.0, 30.0, 0.0 }; // Light position.
+static float lightPos[] = { 0.0, 30.0, 0.0, 1.0 }; // Light position.
 static float lightLookAt[] = { 0.0, 0.0, 0.0 }; // gluLookAt from light: point looked at (i.e., center).
 static float lightUp[] = { 1.0, 0.0, 0.0 }; // gluLookAt from light: up direction.
-static float lightAmb[] = { 0.0, 0.0, 0.0, 1.0 }; // Light ambient values.
-static float lightDifAndSpec[] = { 1.0, 1.0, 1.0, 1.0 }; // Light diffuse and specular values.
-static float globAmb[] = { 0.3, 0.3, 0.3, 1.0 }; // Global ambient values.
 
-// Material properties.
-float matSpec[] = { 1.0, 1.0, 1.0, 1.0 }; // Material specular values.
-float matShine[] = { 50.0 }; // Material shininess.
+// Bounding box of the scene, including every position of the ball.
+static float sceneMin[] = { -50.0, 0.0, -50.0 };
+static float sceneMax[] = { 50.0, 20.0, 50.0 };
 
 // Matrices (4x4 matrices each written in a 1-dim array in column-major order).
 static float cameraProjMat[16]; // Camera's projection transformation matrix.  
 static float cameraViewMat[16]; // Camera's viewing transformation matrix.  
 static float lightProjMat[16]; // Light's projection transformation matrix.
 static float lightViewMat[16]; // Light's viewing transformation matrix.  
-static float interMat[16]; // Intermediate matrix.
+static float modelMats[3][16]; // Modeling transformation matrix of each object.
+
+// Meshes of position and normal vertices.
+static std::vector<float> vertices[3];
+static std::vector<unsigned int> indices[3];
+
+static unsigned int
+	programId,
+	shadowProgramId,
+	projMatLoc,
+	viewMatLoc,
+	modelMatLoc,
+	shadowMatsLoc,
+	splitsLoc,
+	numCascadesLoc,
+	showCascadesLoc,
+	lightPosLoc,
+	cameraPosLoc,
+	objectLoc,
+	objColorLoc,
+	shadowMapLoc,
+	lightMatLoc,
+	shadowModelMatLoc,
+	buffer[6],
+	vao[3];
 //End globals.
 
-// Draw ball flying around torus.
-void drawFlyingBallAndTorus(void)
+// Routine to append the triangles of a (uSteps + 1) x (vSteps + 1) grid of vertices
+// starting at vertex first, counter-clockwise if the grid's u and v run so.
+void appendGridIndices(std::vector<unsigned int> &ind, int first, int uSteps, int vSteps)
+{
+	int i, j, k;
+
+	for (i = 0; i < uSteps; i++)
+		for (j = 0; j < vSteps; j++)
+		{
+			k = first + i * (vSteps + 1) + j;
+			ind.push_back(k);
+			ind.push_back(k + vSteps + 1);
+			ind.push_back(k + vSteps + 2);
+			ind.push_back(k);
+			ind.push_back(k + vSteps + 2);
+			ind.push_back(k + 1);
+		}
+}
+
+// Routine to append a vertex to the mesh of an object.
+void appendVertex(int obj, float x, float y, float z, float nx, float ny, float nz)
+{
+	float vertex[] = { x, y, z, nx, ny, nz };
+	vertices[obj].insert(vertices[obj].end(), vertex, vertex + 6);
+}
+
+// Routine to fill the meshes: the floor, a torus of the same dimensions as
+// glutSolidTorus(2.0, 12.0, 80, 80) and a sphere as glutSolidSphere(2.0, 20, 20).
+void fillMeshes(void)
 {
-	glShadeModel(GL_SMOOTH);
+	int i, j;
+	float theta, phi;
+
+	// Floor, a square in y = 0 facing up.
+	for (i = 0; i <= 1; i++)
+		for (j = 0; j <= 1; j++)
+			appendVertex(FLOOR, -50.0 + 100.0 * j, 0.0, -50.0 + 100.0 * i, 0.0, 1.0, 0.0);
+	appendGridIndices(indices[FLOOR], 0, 1, 1);
+
+	// Torus about the z-axis.
+	for (i = 0; i <= 80; i++)
+		for (j = 0; j <= 80; j++)
+		{
+			theta = 2.0 * PI * i / 80;
+			phi = 2.0 * PI * j / 80;
+			appendVertex(TORUS, (12.0 + 2.0 * cos(phi)) * cos(theta), (12.0 + 2.0 * cos(phi)) * sin(theta),
+				2.0 * sin(phi), cos(phi) * cos(theta), cos(phi) * sin(theta), sin(phi));
+		}
+	appendGridIndices(indices[TORUS], 0, 80, 80);
 
+	// Sphere about the origin.
+	for (i = 0; i <= 20; i++)
+		for (j = 0; j <= 20; j++)
+		{
+			theta = 2.0 * PI * i / 20;
+			phi = -PI / 2.0 + PI * j / 20;
+			appendVertex(BALL, 2.0 * cos(phi) * cos(theta), 2.0 * sin(phi), -2.0 * cos(phi) * sin(theta),
+				cos(phi) * cos(theta), sin(phi), -cos(phi) * sin(theta));
+		}
+	appendGridIndices(indices[BALL], 0, 20, 20);
+}
+
+// Routine to compute the modeling transformation matrices of the torus and ball, the
+// latter flying around the former. Computations are done in the modelview matrix stack.
+void computeModelMatrices(void)
+{
+	glMatrixMode(GL_MODELVIEW);
 	glPushMatrix();
 
+	glLoadIdentity();
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelMats[FLOOR]);
+
 	glTranslatef(0.0, 10.0, 0.0);
 	glRotatef(90.0, 1.0, 0.0, 0.0);
 
 	// Fixed torus.
-	glColor3f(0.0, 1.0, 0.0);
-	glutSolidTorus(2.0, 12.0, 80, 80);
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelMats[TORUS]);
 
-	// Begin revolving ball.
+	// Revolving ball.
 	glRotatef(longAngle, 0.0, 0.0, 1.0);
 
 	glTranslatef(12.0, 0.0, 0.0);
@@ -84,39 +187,33 @@ void drawFlyingBallAndTorus(void)
 	glTranslatef(-12.0, 0.0, 0.0);
 
 	glTranslatef(20.0, 0.0, 0.0);
-
-	glColor3f(0.0, 0.0, 1.0);
-	glutSolidSphere(2.0, 20, 20);
-	// End revolving ball.
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelMats[BALL]);
 
 	glPopMatrix();
 }
 
-// Draw checkered floor.
-void drawCheckeredFloor(void)
+// Routine to draw an object with the bound program, whose modeling matrix uniform is at loc.
+void drawObject(int obj, unsigned int loc)
 {
-	glShadeModel(GL_FLAT); // Flat shading to get the checkered pattern.
-	int i = 0;
-
-	glPushMatrix();
+	glUniformMatrix4fv(loc, 1, GL_FALSE, modelMats[obj]);
+	glBindVertexArray(vao[obj]);
+	glDrawElements(GL_TRIANGLES, indices[obj].size(), GL_UNSIGNED_INT, 0);
+}
 
-	for (float z = 50.0; z > -50.0; z -= 5.0)
-	{
-		glBegin(GL_TRIANGLE_STRIP);
-		for (float x = -50.0; x < 50.0; x += 5.0)
-		{
-			if (i % 2) glColor3f(0.0, 0.5, 0.5);
-			else glColor3f(1.0, 1.0, 1.0);
-			glNormal3f(0.0, 1.0, 0.0);
-			glVertex3f(x, 0.0, z - 5.0);
-			glVertex3f(x, 0.0, z);
-			i++;
-		}
-		glEnd();
-		i++;
-	}
+// Draw the static shadow casters, the floor and the torus, from the light, as the original
+// drew the whole scene. The floor's top faces the light so is culled with the front faces.
+void drawStaticCasters(const float *lightMat)
+{
+	glUniformMatrix4fv(lightMatLoc, 1, GL_FALSE, lightMat);
+	drawObject(FLOOR, shadowModelMatLoc);
+	drawObject(TORUS, shadowModelMatLoc);
+}
 
-	glPopMatrix();
+// Draw the moving shadow casters from the light.
+void drawDynamicCasters(const float *lightMat)
+{
+	glUniformMatrix4fv(lightMatLoc, 1, GL_FALSE, lightMat);
+	drawObject(BALL, shadowModelMatLoc);
 }
 
 // Timer function.
@@ -137,49 +234,72 @@ void animate(int value)
 // Initialization routine.
 void setup(void)
 {
+	unsigned int vertexShaderId, fragmentShaderId;
+	int obj;
+
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 
 	glClearColor(1.0, 1.0, 1.0, 0.0);
-
-	// Need to set the depth test to <=, rather than the default <, so that the light-source lit regions 
-	// in the third drawing pass can overwrite their ambiently lit versions from the second.
-	glDepthFunc(GL_LEQUAL);
 	glEnable(GL_DEPTH_TEST);
 
-	//Create the shadow map (depth texture).
-	glGenTextures(1, &shadowMap);
-	glBindTexture(GL_TEXTURE_2D, shadowMap);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, shadowMapWth, shadowMapHgt, 0,
-		GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL);
-
-	// Local light source properties.
-	glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmb);
-	glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDifAndSpec);
-	glLightfv(GL_LIGHT0, GL_SPECULAR, lightDifAndSpec);
-	glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-
-	// Global ambient light.
-	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, globAmb);
-
-	// Material properties.
-	glMaterialfv(GL_FRONT, GL_SPECULAR, matSpec);
-	glMaterialfv(GL_FRONT, GL_SHININESS, matShine);
-
-	// Enable color material mode.
-	glEnable(GL_COLOR_MATERIAL);
-	glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
-
-	// Enable texturing.
-	glEnable(GL_TEXTURE_2D);
-
 	// Enable face culling.
 	glEnable(GL_CULL_FACE);
 
+	// Create shader program executables.
+	vertexShaderId = setShader("vertex", "Shaders/vertexShader.glsl");
+	fragmentShaderId = setShader("fragment", "Shaders/fragmentShader.glsl");
+	programId = glCreateProgram();
+	glAttachShader(programId, vertexShaderId);
+	glAttachShader(programId, fragmentShaderId);
+	glLinkProgram(programId);
+
+	vertexShaderId = setShader("vertex", "Shaders/vertexShaderShadow.glsl");
+	fragmentShaderId = setShader("fragment", "Shaders/fragmentShaderShadow.glsl");
+	shadowProgramId = glCreateProgram();
+	glAttachShader(shadowProgramId, vertexShaderId);
+	glAttachShader(shadowProgramId, fragmentShaderId);
+	glLinkProgram(shadowProgramId);
+
+	// Obtain uniform locations.
+	projMatLoc = glGetUniformLocation(programId, "projMat");
+	viewMatLoc = glGetUniformLocation(programId, "viewMat");
+	modelMatLoc = glGetUniformLocation(programId, "modelMat");
+	shadowMatsLoc = glGetUniformLocation(programId, "shadowMats");
+	splitsLoc = glGetUniformLocation(programId, "splits");
+	numCascadesLoc = glGetUniformLocation(programId, "numCascades");
+	showCascadesLoc = glGetUniformLocation(programId, "showCascades");
+	lightPosLoc = glGetUniformLocation(programId, "lightPos");
+	cameraPosLoc = glGetUniformLocation(programId, "cameraPos");
+	objectLoc = glGetUniformLocation(programId, "object");
+	objColorLoc = glGetUniformLocation(programId, "objColor");
+	shadowMapLoc = glGetUniformLocation(programId, "shadowMap");
+	lightMatLoc = glGetUniformLocation(shadowProgramId, "lightMat");
+	shadowModelMatLoc = glGetUniformLocation(shadowProgramId, "modelMat");
+
+	// Create VAOs and VBOs of the meshes.
+	fillMeshes();
+	glGenVertexArrays(3, vao);
+	glGenBuffers(6, buffer);
+	for (obj = FLOOR; obj <= BALL; obj++)
+	{
+		glBindVertexArray(vao[obj]);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer[2 * obj]);
+		glBufferData(GL_ARRAY_BUFFER, vertices[obj].size() * sizeof(float), &vertices[obj][0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[2 * obj + 1]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices[obj].size() * sizeof(unsigned int), &indices[obj][0],
+			GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+	}
+	glBindVertexArray(0);
+
+	// Create the shadow maps.
+	createShadowMap(shadow, shadowMapSize, MAX_CASCADES);
+	setShadowSceneBounds(shadow, sceneMin, sceneMax);
+
 	// Compute and save matrices.
 	// All computations, even projection matrix, are done in the modelview matrix stack.
 	glPushMatrix();
@@ -212,145 +332,58 @@ void setup(void)
 // Drawing routine.
 void drawScene(void)
 {
-	/***************************************************************/
-	// FIRST PASS: Draw the scene from the light's viewpoint and capture the z-buffer in the shadow map.
-	/***************************************************************/
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	// Load the light's projection transformation matrix.
-	glMatrixMode(GL_PROJECTION);
-	glLoadMatrixf(lightProjMat);
+	float objColors[3][4] = { { 1.0, 1.0, 1.0, 1.0 }, { 0.0, 1.0, 0.0, 1.0 }, { 0.0, 0.0, 1.0, 1.0 } };
+	int obj;
 
-	// Load the light's viewing transformation matrix.
-	glMatrixMode(GL_MODELVIEW);
-	glLoadMatrixf(lightViewMat);
-
-	// Create viewport same size as the shadow map.
-	glViewport(0, 0, shadowMapWth, shadowMapHgt);
-
-	// Disable writes to the color buffer so that the scene is not rendered to the window.
-	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-
-	// Cull front faces so that only depths of back faces are written to the z-buffer
-	// as only back (from the light's viewpoint) faces should determine shadows.
-	glCullFace(GL_FRONT);
-
-	// Draw the scene.
-	drawCheckeredFloor();
-	drawFlyingBallAndTorus();
-
-	// Capture the depth buffer in the shadow map.
-	glBindTexture(GL_TEXTURE_2D, shadowMap);
-	glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, 0, 0, shadowMapWth, shadowMapHgt, 0);
+	computeModelMatrices();
 
 	/***************************************************************/
-	// SECOND PASS: Draw the scene from the camera's viewpoint using only global ambient light,
-	// being the light which should illuminate all regions, shadowed or not.
+	// FIRST PASS: Render the light's depths into the shadow map cascades. The static
+	// casters are re-rendered only if the cascades have changed.
 	/***************************************************************/
-	glClear(GL_DEPTH_BUFFER_BIT);
-
-	// Load the camera's projection transformation matrix.
-	glMatrixMode(GL_PROJECTION);
-	glLoadMatrixf(cameraProjMat);
-
-	// Load the camera's viewing transformation matrix.
-	glMatrixMode(GL_MODELVIEW);
-	glLoadMatrixf(cameraViewMat);
-
-	// Create viewport same size as the OpenGL window.
-	glViewport(0, 0, winWth, winHgt);
-
-	// Cull back faces (not visible to the camera).
-	glCullFace(GL_BACK);
-
-	// Allow the scene to be rendered.
-	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-
-	// Enable lighting. This enables ONLY global ambient light as LIGHT0 is NOT enabled.
-	glEnable(GL_LIGHTING);
-
-	// Draw the scene.
-	drawCheckeredFloor();
-	drawFlyingBallAndTorus();
+	updateShadowCascades(shadow, lightProjMat, lightViewMat, cameraProjMat, cameraViewMat,
+		cameraNearPlane, cameraFarPlane);
+	glUseProgram(shadowProgramId);
+	renderShadowMaps(shadow, drawStaticCasters, drawDynamicCasters);
 
 	/***************************************************************/
-	// THIRD PASS: Draw the scene from the camera's viewpoint, turn on
-	// the light source, but draw only non-shadowed fragments.
+	// SECOND PASS: Draw the scene from the camera's viewpoint, lit by global ambient
+	// light everywhere and by the light source where not shadowed.
 	/***************************************************************/
-	glEnable(GL_LIGHT0); // LIGHT0 is the local light source.
-
-	// Begin computing the intermediate matrix. Computations are done in the modelview matrix stack.
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glLoadIdentity();
-
-	// These two transformations generate the bias matrix B.
-	glTranslatef(0.5, 0.5, 0.5);
-	glScalef(0.5, 0.5, 0.5); // MV matrix value = B
-
-	glMultMatrixf(lightProjMat); // MV matrix value = B x P_L
-	glMultMatrixf(lightViewMat); // MV matrix value = B x P_L x V_L
-
-	// Save the current modelview matrix as intermediate matrix.
-	glGetFloatv(GL_MODELVIEW_MATRIX, interMat);
-
-	glPopMatrix();
-
-	// List the rows of the intermediate matrix noting that it is stored in interMat in column-major order.
-	float interMatRow0[] = { interMat[0], interMat[4], interMat[8], interMat[12] };
-	float interMatRow1[] = { interMat[1], interMat[5], interMat[9], interMat[13] };
-	float interMatRow2[] = { interMat[2], interMat[6], interMat[10], interMat[14] };
-	float interMatRow3[] = { interMat[3], interMat[7], interMat[11], interMat[15] };
-
-	// Generate texture coordinates equal to B x P_L x V_L x (V_C)^{-1} x vertex.
-	glEnable(GL_TEXTURE_GEN_S);
-	glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
-	glTexGenfv(GL_S, GL_EYE_PLANE, interMatRow0);
-
-	glEnable(GL_TEXTURE_GEN_T);
-	glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
-	glTexGenfv(GL_T, GL_EYE_PLANE, interMatRow1);
-
-	glEnable(GL_TEXTURE_GEN_R);
-	glTexGeni(GL_R, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
-	glTexGenfv(GL_R, GL_EYE_PLANE, interMatRow2);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glEnable(GL_TEXTURE_GEN_Q);
-	glTexGeni(GL_Q, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
-	glTexGenfv(GL_Q, GL_EYE_PLANE, interMatRow3);
+	glUseProgram(programId);
+	glUniformMatrix4fv(projMatLoc, 1, GL_FALSE, cameraProjMat);
+	glUniformMatrix4fv(viewMatLoc, 1, GL_FALSE, cameraViewMat);
+	glUniformMatrix4fv(shadowMatsLoc, shadow.numCascades, GL_FALSE, shadow.shadowMats[0]);
+	glUniform1fv(splitsLoc, shadow.numCascades, shadow.splits);
+	glUniform1i(numCascadesLoc, shadow.numCascades);
+	glUniform1i(showCascadesLoc, showCascades);
+	glUniform3fv(lightPosLoc, 1, lightPos);
+	glUniform3fv(cameraPosLoc, 1, cameraPos);
 
 	// Activate the shadow map.
-	glBindTexture(GL_TEXTURE_2D, shadowMap);
-
-	// Compare the R-coordinate to the corresponding value stored in the shadow map.
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
-
-	// Comparison should be true if r <= texture, i.e., if the fragment is not shadowed.
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
-
-	// Set shadow comparison to generate an alpha value (0 for failed comparisons, 1 for successful).
-	glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_TEXTURE_MODE, GL_ALPHA);
-
-	// Set alpha test to discard failed comparisons, i.e., shadowed fragments.
-	glEnable(GL_ALPHA_TEST);
-	glAlphaFunc(GL_GREATER, 0.5);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, shadow.texture);
+	glUniform1i(shadowMapLoc, 0);
 
 	// Draw the scene.
-	drawCheckeredFloor();
-	drawFlyingBallAndTorus();
-
-	// Restore states.
-	glDisable(GL_TEXTURE_GEN_S);
-	glDisable(GL_TEXTURE_GEN_T);
-	glDisable(GL_TEXTURE_GEN_R);
-	glDisable(GL_TEXTURE_GEN_Q);
-	glDisable(GL_ALPHA_TEST);
-	glDisable(GL_LIGHTING);
-	glDisable(GL_LIGHT0);
+	for (obj = FLOOR; obj <= BALL; obj++)
+	{
+		glUniform1ui(objectLoc, obj);
+		glUniform4fv(objColorLoc, 1, objColors[obj]);
+		drawObject(obj, modelMatLoc);
+	}
+	glBindVertexArray(0);
+	glUseProgram(0);
 
 	/***************************************************************/
-	// FOURTH PASS: Draw a red sphere at the light's position. 
+	// THIRD PASS: Draw a red sphere at the light's position. 
 	/***************************************************************/
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixf(cameraProjMat);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixf(cameraViewMat);
 	glTranslatef(lightPos[0], lightPos[1], lightPos[2]);
 	glColor3f(1.0, 0.0, 0.0);
 	glutWireSphere(0.2, 10, 10);
@@ -361,6 +394,8 @@ void drawScene(void)
 // OpenGL window reshape routine.
 void resize(int w, int h)
 {
+	glViewport(0, 0, w, h);
+
 	// Update the new window dimensions.
 	winWth = w;
 	winHgt = h;
@@ -381,8 +416,6 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
-	default:
-		break;
 	case ' ':
 		if (isAnimate) isAnimate = 0;
 		else
@@ -391,6 +424,17 @@ void keyInput(unsigned char key, int x, int y)
 			animate(1);
 		}
 		break;
+	case 'c':
+		shadow.numCascades = shadow.numCascades % MAX_CASCADES + 1;
+		std::cout << "Shadow map cascades: " << shadow.numCascades << std::endl;
+		glutPostRedisplay();
+		break;
+	case 'v':
+		showCascades = !showCascades;
+		glutPostRedisplay();
+		break;
+	default:
+		break;
 	}
 }
 
@@ -407,7 +451,9 @@ void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press space to toggle between animation on and off." << std::endl
-		<< "Press the up/down arrow keys to speed up/slow down animation." << std::endl;
+		<< "Press the up/down arrow keys to speed up/slow down animation." << std::endl
+		<< "Press 'c' to cycle through 1 to 4 shadow map cascades." << std::endl
+		<< "Press 'v' to toggle coloring the scene by cascade." << std::endl;
 }
 
 // Main routine.
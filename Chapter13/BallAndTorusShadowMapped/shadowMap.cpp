@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cmath>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h> 
+
+#include "shadowMap.h"
+
+// Product c = a x b of column-major 4x4 matrices.
+static void multiplyMatrices(const float *a, const float *b, float *c)
+{
+	float r[16];
+	int i, j, k;
+
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < 4; j++)
+		{
+			r[4 * j + i] = 0.0;
+			for (k = 0; k < 4; k++) r[4 * j + i] += a[4 * k + i] * b[4 * j + k];
+		}
+	std::copy(r, r + 16, c);
+}
+
+// Invert the column-major 4x4 matrix m into inv by Gauss-Jordan elimination, returning
+// false if it is singular.
+static bool invertMatrix(const float *m, float *inv)
+{
+	double a[4][8], pivot, factor;
+	int i, j, k, best;
+
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < 4; j++)
+		{
+			a[i][j] = m[4 * j + i];
+			a[i][j + 4] = (i == j) ? 1.0 : 0.0;
+		}
+	for (j = 0; j < 4; j++)
+	{
+		best = j;
+		for (i = j + 1; i < 4; i++) if (fabs(a[i][j]) > fabs(a[best][j])) best = i;
+		if (a[best][j] == 0.0) return false;
+		for (k = 0; k < 8; k++) std::swap(a[j][k], a[best][k]);
+		pivot = a[j][j];
+		for (k = 0; k < 8; k++) a[j][k] /= pivot;
+		for (i = 0; i < 4; i++)
+		{
+			if (i == j) continue;
+			factor = a[i][j];
+			for (k = 0; k < 8; k++) a[i][k] -= factor * a[j][k];
+		}
+	}
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < 4; j++) inv[4 * j + i] = a[i][j + 4];
+	return true;
+}
+
+// Create a depth texture array of numCascades layers of the given size, set to compare.
+static unsigned int createDepthArray(int size, int numLayers)
+{
+	unsigned int texture;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, size, size, numLayers);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return texture;
+}
+
+// Create the shadow map with numCascades cascades, each size x size texels. Storage is
+// allocated for MAX_CASCADES so that the number in use can change.
+void createShadowMap(ShadowMap &shadow, int size, int numCascades)
+{
+	shadow.size = size;
+	shadow.numCascades = numCascades;
+	shadow.splitLambda = 0.75;
+	shadow.hasSceneBounds = false;
+	shadow.staticValid = false;
+	for (int c = 0; c < MAX_CASCADES; c++) std::fill(shadow.lightMats[c], shadow.lightMats[c] + 16, 0.0);
+
+	shadow.texture = createDepthArray(size, MAX_CASCADES);
+	shadow.staticTexture = createDepthArray(size, MAX_CASCADES);
+
+	// A framebuffer with no color buffer.
+	glGenFramebuffers(1, &shadow.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, shadow.framebuffer);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Set the bounding box of the scene, to which cascades are cropped.
+void setShadowSceneBounds(ShadowMap &shadow, const float *sceneMin, const float *sceneMax)
+{
+	std::copy(sceneMin, sceneMin + 3, shadow.sceneMin);
+	std::copy(sceneMax, sceneMax + 3, shadow.sceneMax);
+	shadow.hasSceneBounds = true;
+}
+
+// Extend the bounds lo, hi in the light's normalized device x and y by the homogeneous
+// world point, clamped to the light's view. Returns false if the point is behind the light.
+static bool extendLightBounds(const float *lightMat, const float *point, float *lo, float *hi)
+{
+	float clip[4];
+	int j, k;
+
+	for (j = 0; j < 4; j++)
+	{
+		clip[j] = 0.0;
+		for (k = 0; k < 4; k++) clip[j] += lightMat[4 * k + j] * point[k];
+	}
+	if (clip[3] <= 1.0e-6 * fabs(point[3])) return false;
+	for (j = 0; j < 2; j++)
+	{
+		lo[j] = std::min(lo[j], std::max(clip[j] / clip[3], -1.0f));
+		hi[j] = std::max(hi[j], std::min(clip[j] / clip[3], 1.0f));
+	}
+	return true;
+}
+
+// Split the camera's view frustum into the cascades and fit the light's projection to
+// each. Camera matrices are of a perspective projection. The static shadows are
+// invalidated if any cascade's matrix has changed.
+void updateShadowCascades(ShadowMap &shadow, const float *lightProjMat, const float *lightViewMat,
+	                      const float *cameraProjMat, const float *cameraViewMat,
+	                      float cameraNearPlane, float cameraFarPlane)
+{
+	float cameraMat[16], inverseCameraMat[16], lightMat[16], cropMat[16], lightMatCropped[16];
+	float biasMat[16] = { 0.5, 0.0, 0.0, 0.0, 0.0, 0.5, 0.0, 0.0, 0.0, 0.0, 0.5, 0.0, 0.5, 0.5, 0.5, 1.0 };
+	float lo[2], hi[2], sceneLo[2], sceneHi[2], corner[4], world[4];
+	float nearDepth, farDepth, depth, uniform, logarithmic;
+	int c, i, j, k;
+	bool inFront, changed = false;
+
+	multiplyMatrices(cameraProjMat, cameraViewMat, cameraMat);
+	if (!invertMatrix(cameraMat, inverseCameraMat)) return;
+	multiplyMatrices(lightProjMat, lightViewMat, lightMat);
+
+	// Bounds of the scene box in the light's view.
+	sceneLo[0] = sceneLo[1] = -1.0;
+	sceneHi[0] = sceneHi[1] = 1.0;
+	if (shadow.hasSceneBounds)
+	{
+		sceneLo[0] = sceneLo[1] = 1.0;
+		sceneHi[0] = sceneHi[1] = -1.0;
+		inFront = true;
+		for (i = 0; i < 8; i++)
+		{
+			corner[0] = (i & 1) ? shadow.sceneMax[0] : shadow.sceneMin[0];
+			corner[1] = (i & 2) ? shadow.sceneMax[1] : shadow.sceneMin[1];
+			corner[2] = (i & 4) ? shadow.sceneMax[2] : shadow.sceneMin[2];
+			corner[3] = 1.0;
+			if (!extendLightBounds(lightMat, corner, sceneLo, sceneHi)) inFront = false;
+		}
+		if (!inFront)
+		{
+			sceneLo[0] = sceneLo[1] = -1.0;
+			sceneHi[0] = sceneHi[1] = 1.0;
+		}
+	}
+
+	for (c = 0; c < shadow.numCascades; c++)
+	{
+		// Practical split scheme: a blend of logarithmic and uniform splits.
+		logarithmic = cameraNearPlane * pow(cameraFarPlane / cameraNearPlane, (float)(c + 1) / shadow.numCascades);
+		uniform = cameraNearPlane + (cameraFarPlane - cameraNearPlane) * (c + 1) / shadow.numCascades;
+		shadow.splits[c] = shadow.splitLambda * logarithmic + (1.0 - shadow.splitLambda) * uniform;
+		nearDepth = (c == 0) ? cameraNearPlane : shadow.splits[c - 1];
+		farDepth = shadow.splits[c];
+
+		// Bounds in the light's view of the slice's 8 corners, found by unprojecting the
+		// corners of the camera's clip volume at their depth. A slice reaching behind the
+		// light takes the whole view.
+		lo[0] = lo[1] = 1.0;
+		hi[0] = hi[1] = -1.0;
+		inFront = true;
+		for (i = 0; i < 8; i++)
+		{
+			depth = (i & 4) ? farDepth : nearDepth;
+			corner[0] = (i & 1) ? depth : -depth;
+			corner[1] = (i & 2) ? depth : -depth;
+			corner[2] = -cameraProjMat[10] * depth + cameraProjMat[14];
+			corner[3] = depth;
+			for (j = 0; j < 4; j++)
+			{
+				world[j] = 0.0;
+				for (k = 0; k < 4; k++) world[j] += inverseCameraMat[4 * k + j] * corner[k];
+			}
+			if (!extendLightBounds(lightMat, world, lo, hi)) inFront = false;
+		}
+		if (!inFront)
+		{
+			lo[0] = lo[1] = -1.0;
+			hi[0] = hi[1] = 1.0;
+		}
+
+		// Crop to the scene, and if nothing is left keep the whole view.
+		for (j = 0; j < 2; j++)
+		{
+			lo[j] = std::max(lo[j], sceneLo[j]);
+			hi[j] = std::min(hi[j], sceneHi[j]);
+		}
+		if (hi[0] <= lo[0] || hi[1] <= lo[1])
+		{
+			lo[0] = lo[1] = -1.0;
+			hi[0] = hi[1] = 1.0;
+		}
+
+		// Crop matrix scaling and offsetting the bounds to fill the light's view.
+		std::fill(cropMat, cropMat + 16, 0.0);
+		cropMat[0] = 2.0 / (hi[0] - lo[0]);
+		cropMat[5] = 2.0 / (hi[1] - lo[1]);
+		cropMat[10] = cropMat[15] = 1.0;
+		cropMat[12] = -(hi[0] + lo[0]) / (hi[0] - lo[0]);
+		cropMat[13] = -(hi[1] + lo[1]) / (hi[1] - lo[1]);
+		multiplyMatrices(cropMat, lightMat, lightMatCropped);
+
+		for (j = 0; j < 16; j++)
+			if (fabs(lightMatCropped[j] - shadow.lightMats[c][j]) > 1.0e-6) changed = true;
+		std::copy(lightMatCropped, lightMatCropped + 16, shadow.lightMats[c]);
+		multiplyMatrices(biasMat, lightMatCropped, shadow.shadowMats[c]);
+	}
+
+	if (changed) shadow.staticValid = false;
+}
+
+// Have the static casters redrawn at the next renderShadowMaps(), as one has moved.
+void invalidateStaticShadows(ShadowMap &shadow)
+{
+	shadow.staticValid = false;
+}
+
+// Render each cascade: the static casters into their own array if it is out of date,
+// then a copy of that into the shadow map with the dynamic casters over it. Front faces
+// are culled, as in the original single map, so that only back faces set depth, and a
+// polygon offset keeps surfaces from shadowing themselves. The framebuffer and viewport
+// are restored after.
+void renderShadowMaps(ShadowMap &shadow, ShadowCasterFunction drawStatic, ShadowCasterFunction drawDynamic)
+{
+	int viewport[4], c;
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, shadow.framebuffer);
+	glViewport(0, 0, shadow.size, shadow.size);
+	glCullFace(GL_FRONT);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0, 4.0);
+
+	for (c = 0; c < shadow.numCascades; c++)
+	{
+		if (!shadow.staticValid)
+		{
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow.staticTexture, 0, c);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			drawStatic(shadow.lightMats[c]);
+		}
+		glCopyImageSubData(shadow.staticTexture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, c,
+			shadow.texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, c, shadow.size, shadow.size, 1);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow.texture, 0, c);
+		drawDynamic(shadow.lightMats[c]);
+	}
+	shadow.staticValid = true;
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glCullFace(GL_BACK);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -0,0 +1,44 @@
+#ifndef SHADOWMAP_H
+#define SHADOWMAP_H
+
+#define MAX_CASCADES 4 // Most shadow map cascades.
+
+// Routine to draw shadow casters into the bound depth target with the given matrix taking
+// world co-ordinates to the light's clip co-ordinates.
+typedef void (*ShadowCasterFunction)(const float *lightMat);
+
+// Cascaded shadow maps of one light. The camera's view frustum is split along its depth
+// into numCascades slices, and the light's projection is cropped in x and y to each
+// slice, so that near the camera, where a shadow map texel covers the most pixels, the
+// texels are smallest. Depths are rendered straight into the layers of a depth texture
+// array through a framebuffer object and read back through a comparison sampler, whose
+// linear filtering gives hardware percentage-closer filtering. Static casters are
+// rendered into a second array only when the cascades change or invalidateStaticShadows()
+// is called, and each frame that array is copied in before the dynamic casters are drawn.
+// Slices are cropped further to the scene's bounding box if one is given, as for a local
+// light a slice reaching behind the light would otherwise take the light's whole view.
+struct ShadowMap
+{
+	int size; // Width and height of each layer.
+	int numCascades; // Number of cascades in use.
+	float splitLambda; // Blend of logarithmic (1) and uniform (0) cascade splits.
+	unsigned int texture; // Depth texture array, one layer per cascade.
+	unsigned int staticTexture; // Depths of static casters alone.
+	unsigned int framebuffer; // Framebuffer the layers are attached to in turn.
+	float splits[MAX_CASCADES]; // Far distance from the camera of each cascade.
+	float lightMats[MAX_CASCADES][16]; // Crop x light projection x light view.
+	float shadowMats[MAX_CASCADES][16]; // Bias x lightMats, to shadow map co-ordinates.
+	bool hasSceneBounds; // If sceneMin and sceneMax are set.
+	float sceneMin[3], sceneMax[3]; // Bounding box of the scene, world co-ordinates.
+	bool staticValid; // If staticTexture matches lightMats.
+};
+
+void createShadowMap(ShadowMap &shadow, int size, int numCascades);
+void setShadowSceneBounds(ShadowMap &shadow, const float *sceneMin, const float *sceneMax);
+void updateShadowCascades(ShadowMap &shadow, const float *lightProjMat, const float *lightViewMat,
+	                      const float *cameraProjMat, const float *cameraViewMat,
+	                      float cameraNearPlane, float cameraFarPlane);
+void invalidateStaticShadows(ShadowMap &shadow);
+void renderShadowMaps(ShadowMap &shadow, ShadowCasterFunction drawStatic, ShadowCasterFunction drawDynamic);
+
+#endif
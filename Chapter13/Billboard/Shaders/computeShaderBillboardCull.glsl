@@ -0,0 +1,56 @@
+#version 430 core
+
+#define GROUP_SIZE 256 // BILLBOARD_GROUP_SIZE.
+#define CAMERA 2 // BILLBOARD_CAMERA.
+
+layout(local_size_x = GROUP_SIZE) in;
+
+struct Instance
+{
+   vec3 position;
+   float width;
+   float height;
+   uint tile;
+   uint orientation;
+   uint pad;
+};
+
+layout(std430, binding=0) readonly buffer Instances
+{
+   Instance instances[];
+};
+
+layout(std430, binding=1) writeonly buffer Visible
+{
+   uint visible[];
+};
+
+layout(std430, binding=2) buffer Command
+{
+   uint count, instanceCount, first, baseInstance;
+};
+
+uniform vec4 planes[6];
+uniform uint numInstances;
+
+void main(void)
+{
+   uint id = gl_GlobalInvocationID.x;
+   Instance instance;
+   vec3 center;
+   float radius;
+   int i;
+
+   if (id >= numInstances) return;
+   instance = instances[id];
+
+   // Sphere enclosing the rectangle however it is turned.
+   center = instance.position;
+   if (instance.orientation != CAMERA) center.y += 0.5 * instance.height;
+   radius = 0.5 * length(vec2(instance.width, instance.height));
+
+   for (i = 0; i < 6; i++)
+      if (dot(planes[i].xyz, center) + planes[i].w < -radius) return;
+
+   visible[atomicAdd(instanceCount, 1u)] = id;
+}
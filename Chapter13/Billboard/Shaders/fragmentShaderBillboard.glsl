@@ -0,0 +1,15 @@
+#version 430 core
+
+in vec2 texCoordsExport;
+
+layout(binding=0) uniform sampler2D atlasTex;
+
+out vec4 colorsOut;
+
+void main(void)
+{
+   colorsOut = texture(atlasTex, texCoordsExport);
+
+   // The images' white backgrounds are transparent.
+   if (min(colorsOut.r, min(colorsOut.g, colorsOut.b)) > 0.85) discard;
+}
@@ -0,0 +1,64 @@
+#version 430 core
+
+#define MAX_TILES 16 // BILLBOARD_MAX_TILES.
+#define FIXED 0 // BILLBOARD_FIXED.
+#define AXIS 1 // BILLBOARD_AXIS.
+
+struct Instance
+{
+   vec3 position;
+   float width;
+   float height;
+   uint tile;
+   uint orientation;
+   uint pad;
+};
+
+layout(std430, binding=0) readonly buffer Instances
+{
+   Instance instances[];
+};
+
+layout(std430, binding=1) readonly buffer Visible
+{
+   uint visible[];
+};
+
+uniform mat4 viewMat;
+uniform mat4 projMat;
+uniform vec3 cameraPos;
+uniform int isBillboard;
+uniform vec4 tiles[MAX_TILES];
+
+out vec2 texCoordsExport;
+
+void main(void)
+{
+   Instance instance = instances[visible[gl_InstanceID]];
+   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1); // Strip order (0, 0), (1, 0), (0, 1), (1, 1).
+   vec3 right, up, toCamera, coords;
+
+   if (isBillboard == 0 || instance.orientation == FIXED)
+   {
+      right = vec3(1.0, 0.0, 0.0);
+      up = vec3(0.0, 1.0, 0.0);
+   }
+   else if (instance.orientation == AXIS)
+   {
+      // Upright, turned about the y-axis to face the camera.
+      toCamera = cameraPos - instance.position;
+      right = normalize(vec3(toCamera.z, 0.0, -toCamera.x) + vec3(1e-6, 0.0, 0.0));
+      up = vec3(0.0, 1.0, 0.0);
+   }
+   else
+   {
+      // The camera's own right and up directions, the first two rows of the viewing matrix.
+      right = vec3(viewMat[0][0], viewMat[1][0], viewMat[2][0]);
+      up = vec3(viewMat[0][1], viewMat[1][1], viewMat[2][1]);
+      corner.y -= 0.5;
+   }
+
+   coords = instance.position + (corner.x - 0.5) * instance.width * right + corner.y * instance.height * up;
+   texCoordsExport = tiles[instance.tile].xy + vec2(gl_VertexID & 1, gl_VertexID >> 1) * tiles[instance.tile].zw;
+   gl_Position = projMat * viewMat * vec4(coords, 1.0);
+}
@@ -5,51 +5,63 @@
 // two trees are arranged to give the illusion of a backdrop of trees. There is the option 
 // to turn billboarding on and off.
 //
+// The rectangles are drawn by a BillboardField, which turns them toward the camera in the
+// vertex shader and draws all of them in a single call, so that there is also the option
+// of a forest of anywhere from a thousand to a million trees, with stars above, to walk
+// through. The trees stay upright, turning only about the vertical, while the stars face
+// the camera squarely. Trees and stars are textured from one atlas of their two images, and
+// those outside the view frustum are culled on the GPU before drawing.
+//
 // Interaction:
 // Press the space key to toggle between billboarding on and off.
+// Press 'f' to toggle between the backdrop of four trees and the forest.
+// Press +/- to double/halve the number of billboards in the forest.
+// Press the up/down arrow keys to walk forward/back and the left/right arrow keys to turn.
 // 
 // Sumanta Guha
 //
 // Texture Credits: See ExperimenterSource/Textures/TEXTURE_CREDITS.txt
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <cmath>					
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
-#include "getBMP.h"
+#include "billboardField.h"
 
 #define PI 3.14159265358979324
+#define MIN_FOREST 1000 // Fewest billboards in the forest.
+#define MAX_FOREST 1000000 // Most billboards in the forest.
+#define FOREST_SIZE 2000.0 // Side of the square the forest covers.
+#define CLEARING 15.0 // Radius of the clearing about the origin.
+
+static enum tile {TREES, STAR}; // Atlas images.
 
 // Globals.
-static unsigned int texture[1]; // Array of texture indices.
-static unsigned int aRect; // List index.
-static float b = 0.0; // Displacement of the trees image left of line of sight.
-static float d = 0.0; // Distance of the trees image parallel to the line of sight.
+static BillboardField field; // Draws the billboards.
 static int isBillboard = 1; // Is billboarding on?
+static int isForest = 0; // Draw the forest rather than the backdrop?
+static int forestSize = 100000; // Number of billboards in the forest.
+static float cameraPos[] = { 0.0, 0.0, 0.0 }; // Camera position.
+static float heading = 0.0; // Angle of the camera's line of sight left of the -z direction.
+static float viewMat[16]; // Viewing transformation matrix.
+static float projMat[16]; // Projection transformation matrix.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
 
 // Load external textures.
 void loadTextures()
 {
-	// Local storage for bmp image data.
-	imageFile *image[1];
-
-	// Load the image.
-	image[0] = getBMP("../../Textures/trees.bmp");
-
-	// Bind trees image to texture object texture[0]. 
-	glBindTexture(GL_TEXTURE_2D, texture[0]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[0]->width, image[0]->height, 0,
-		GL_RGBA, GL_UNSIGNED_BYTE, image[0]->data);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	std::string fileNames[] = { "../../Textures/trees.bmp", "../../Textures/star.bmp" };
+
+	// Both images in a single atlas.
+	loadBillboardAtlas(field, fileNames, 2);
 }
 
 // Routine to draw a bitmap character string.
@@ -60,89 +72,114 @@ void writeBitmapString(void *font, char *string)
 	for (c = string; *c != '\0'; c++) glutBitmapCharacter(font, *c);
 }
 
+// Routine to return a random number between low and high.
+float randomBetween(float low, float high)
+{
+	return low + (high - low) * rand() / RAND_MAX;
+}
+
+// Routine to set an instance.
+void setInstance(BillboardInstance &instance, float x, float y, float z, float width, float height,
+	             unsigned int tile, unsigned int orientation)
+{
+	instance.position[0] = x;
+	instance.position[1] = y;
+	instance.position[2] = z;
+	instance.width = width;
+	instance.height = height;
+	instance.tile = tile;
+	instance.orientation = orientation;
+	instance.pad = 0;
+}
+
+// Routine to fill the field with the backdrop or the forest.
+void fillField(void)
+{
+	std::vector<BillboardInstance> instances;
+	float b[] = { 15.0, 6.0, -3.0, -12.0 }; // Displacements of the trees images left of line of sight.
+	float d[] = { 10.0, 15.0, 15.0, 10.0 }; // Distances of the trees images parallel to the line of sight.
+	float x, z, width;
+	int i;
+
+	if (!isForest)
+	{
+		// Four trees images of size 10 x 5, centered at a height of 0.
+		instances.resize(4);
+		for (i = 0; i < 4; i++)
+			setInstance(instances[i], -b[i], -2.5, -d[i], 10.0, 5.0, TREES, BILLBOARD_AXIS);
+	}
+	else
+	{
+		// Trees on the ground outside the clearing, and one star for every nine trees.
+		instances.resize(forestSize);
+		srand(1);
+		for (i = 0; i < forestSize; i++)
+		{
+			do
+			{
+				x = randomBetween(-FOREST_SIZE / 2.0, FOREST_SIZE / 2.0);
+				z = randomBetween(-FOREST_SIZE / 2.0, FOREST_SIZE / 2.0);
+			} while (x * x + z * z < CLEARING * CLEARING);
+
+			if (i % 10 == 9)
+			{
+				width = randomBetween(1.0, 3.0);
+				setInstance(instances[i], x, randomBetween(20.0, 60.0), z, width, width, STAR, BILLBOARD_CAMERA);
+			}
+			else
+			{
+				width = randomBetween(6.0, 12.0);
+				setInstance(instances[i], x, -2.5, z, width, width / 2.0, TREES, BILLBOARD_AXIS);
+			}
+		}
+	}
+	setBillboardInstances(field, &instances[0], instances.size());
+}
+
 // Initialization routine.
 void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 	glEnable(GL_DEPTH_TEST);
 
-	// Create texture ids.
-	glGenTextures(1, texture);
+	// Create the field with room for the largest forest.
+	createBillboardField(field, MAX_FOREST);
 
 	// Load external textures.
 	loadTextures();
 
-	// Specify how texture values combine with current surface color values.
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-
-	// Turn on OpenGL texturing.
-	glEnable(GL_TEXTURE_2D);
-
-	aRect = glGenLists(1); // Return a list index.
-
-	// Begin create a display list.
-	glNewList(aRect, GL_COMPILE);
-
-	// Draw a textured rectangle.
-	glBegin(GL_POLYGON);
-	glTexCoord2f(0.0, 0.0); glVertex3f(-5.0, -2.5, 0.0);
-	glTexCoord2f(1.0, 0.0); glVertex3f(5.0, -2.5, 0.0);
-	glTexCoord2f(1.0, 1.0); glVertex3f(5.0, 2.5, 0.0);
-	glTexCoord2f(0.0, 1.0); glVertex3f(-5.0, 2.5, 0.0);
-	glEnd();
-
-	glEndList();
-	// End create a display list.
+	fillField();
 }
 
 // Drawing routine.
 void drawScene(void)
 {
+	char message[64];
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	// Viewing transformation matrix, computed in the modelview matrix stack.
 	glLoadIdentity();
+	gluLookAt(cameraPos[0], cameraPos[1], cameraPos[2],
+		      cameraPos[0] - sin(heading * PI / 180.0), cameraPos[1], cameraPos[2] - cos(heading * PI / 180.0),
+		      0.0, 1.0, 0.0);
+	glGetFloatv(GL_MODELVIEW_MATRIX, viewMat);
+
+	// Draw the billboards.
+	drawBillboardField(field, viewMat, projMat, cameraPos, isBillboard);
 
 	// Write message.
-	glDisable(GL_TEXTURE_2D);
-	glPushMatrix();
+	glLoadIdentity();
 	glColor3f(0.0, 0.0, 0.0);
 	glRasterPos3f(-1.0, 4.0, -5.1);
 	if (isBillboard) writeBitmapString((void*)font, "Billboarding on!");
 	else writeBitmapString((void*)font, "Billboarding off!");
-	glPopMatrix();
-	glEnable(GL_TEXTURE_2D);
-
-	// Place first trees image.
-	b = 15.0; d = 10.0;
-	glPushMatrix();
-	glTranslatef(-b, 0.0, -d);
-	if (isBillboard) glRotatef(atan(b / d)*(180.0 / PI), 0.0, 1.0, 0.0); // Rotate if billboarding is on.
-	glCallList(aRect);
-	glPopMatrix();
-
-	// Place second trees image.
-	b = 6.0; d = 15.0;
-	glPushMatrix();
-	glTranslatef(-b, 0.0, -d);
-	if (isBillboard) glRotatef(atan(b / d)*(180.0 / PI), 0.0, 1.0, 0.0); // Rotate if billboarding is on.
-	glCallList(aRect);
-	glPopMatrix();
-
-	// Place third trees image. 
-	b = -3.0; d = 15.0;
-	glPushMatrix();
-	glTranslatef(-b, 0.0, -d);
-	if (isBillboard) glRotatef(atan(b / d)*(180.0 / PI), 0.0, 1.0, 0.0); // Rotate if billboarding is on.
-	glCallList(aRect);
-	glPopMatrix();
-
-	// Place fourth trees image.
-	b = -12.0; d = 10.0;
-	glPushMatrix();
-	glTranslatef(-b, 0.0, -d);
-	if (isBillboard) glRotatef(atan(b / d)*(180.0 / PI), 0.0, 1.0, 0.0); // Rotate if billboarding is on.
-	glCallList(aRect);
-	glPopMatrix();
+	if (isForest)
+	{
+		sprintf(message, "Forest of %d billboards", forestSize);
+		glRasterPos3f(-1.0, 3.5, -5.1);
+		writeBitmapString((void*)font, message);
+	}
 
 	glutSwapBuffers();
 }
@@ -154,6 +191,7 @@ void resize(int w, int h)
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	glFrustum(-10.0, 10.0, -5.0, 5.0, 5.0, 100.0);
+	glGetFloatv(GL_PROJECTION_MATRIX, projMat);
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 }
@@ -171,16 +209,52 @@ void keyInput(unsigned char key, int x, int y)
 		else isBillboard = 1;
 		glutPostRedisplay();
 		break;
+	case 'f':
+		isForest = !isForest;
+		fillField();
+		glutPostRedisplay();
+		break;
+	case '+':
+		if (forestSize < MAX_FOREST) forestSize = std::min(2 * forestSize, MAX_FOREST);
+		if (isForest) fillField();
+		glutPostRedisplay();
+		break;
+	case '-':
+		if (forestSize > MIN_FOREST) forestSize = std::max(forestSize / 2, MIN_FOREST);
+		if (isForest) fillField();
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
 }
 
+// Callback routine for non-ASCII key entry.
+void specialKeyInput(int key, int x, int y)
+{
+	if (key == GLUT_KEY_UP)
+	{
+		cameraPos[0] -= sin(heading * PI / 180.0);
+		cameraPos[2] -= cos(heading * PI / 180.0);
+	}
+	if (key == GLUT_KEY_DOWN)
+	{
+		cameraPos[0] += sin(heading * PI / 180.0);
+		cameraPos[2] += cos(heading * PI / 180.0);
+	}
+	if (key == GLUT_KEY_LEFT) heading += 5.0;
+	if (key == GLUT_KEY_RIGHT) heading -= 5.0;
+	glutPostRedisplay();
+}
+
 // Routine to output interaction instructions to the C++ window.
 void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
-	std::cout << "Press the space key to toggle between billboarding on and off." << std::endl;
+	std::cout << "Press the space key to toggle between billboarding on and off." << std::endl
+		<< "Press 'f' to toggle between the backdrop of four trees and the forest." << std::endl
+		<< "Press +/- to double/halve the number of billboards in the forest." << std::endl
+		<< "Press the up/down arrow keys to walk forward/back and the left/right arrow keys to turn." << std::endl;
 }
 
 // Main routine.
@@ -199,6 +273,7 @@ int main(int argc, char **argv)
 	glutDisplayFunc(drawScene);
 	glutReshapeFunc(resize);
 	glutKeyboardFunc(keyInput);
+	glutSpecialFunc(specialKeyInput);
 
 	glewExperimental = GL_TRUE;
 	glewInit();
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "billboardField.h"
+#include "getBMP.h"
+#include "prepShader.h"
+
+static enum buffer {INSTANCES, VISIBLE, COMMAND}; // Buffer ids.
+
+// A draw command of glDrawArraysIndirect().
+struct DrawArraysCommand
+{
+	unsigned int count, instanceCount, first, baseInstance;
+};
+
+// Routine to load the images into an atlas, side by side along the bottom with gutters of
+// white between them, mipmapped.
+bool loadBillboardAtlas(BillboardField &field, const std::string *fileNames, int numFiles)
+{
+	std::vector<imageFile *> images;
+	std::vector<unsigned char> atlas;
+	int width = 0, height = 0, x, i, j, numLevels;
+
+	if (numFiles > BILLBOARD_MAX_TILES) return false;
+	for (i = 0; i < numFiles; i++)
+	{
+		images.push_back(getBMP(fileNames[i]));
+		width += images[i]->width + BILLBOARD_GUTTER;
+		height = std::max(height, images[i]->height);
+	}
+
+	// Copy each image's rows into place.
+	atlas.assign(4 * width * height, 0xFF);
+	for (i = 0, x = 0; i < numFiles; i++)
+	{
+		for (j = 0; j < images[i]->height; j++)
+			std::copy(images[i]->data + 4 * images[i]->width * j, images[i]->data + 4 * images[i]->width * (j + 1),
+				      atlas.begin() + 4 * (width * j + x));
+		field.tiles[i][0] = (float)x / width;
+		field.tiles[i][1] = 0.0;
+		field.tiles[i][2] = (float)images[i]->width / width;
+		field.tiles[i][3] = (float)images[i]->height / height;
+		x += images[i]->width + BILLBOARD_GUTTER;
+		delete[] images[i]->data;
+		delete images[i];
+	}
+	field.numTiles = numFiles;
+
+	// Levels stop before the gutters shrink below a texel.
+	for (numLevels = 1; (BILLBOARD_GUTTER >> numLevels) > 0; numLevels++);
+	glGenTextures(1, &field.atlasTexture);
+	glBindTexture(GL_TEXTURE_2D, field.atlasTexture);
+	glTexStorage2D(GL_TEXTURE_2D, numLevels, GL_RGBA8, width, height);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &atlas[0]);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+// Create the programs and buffers for up to maxInstances instances.
+void createBillboardField(BillboardField &field, int maxInstances)
+{
+	unsigned int vertexShaderId, fragmentShaderId, computeShaderId;
+
+	field.maxInstances = maxInstances;
+	field.numInstances = 0;
+
+	// Create shader program executables.
+	vertexShaderId = setShader("vertex", "Shaders/vertexShaderBillboard.glsl");
+	fragmentShaderId = setShader("fragment", "Shaders/fragmentShaderBillboard.glsl");
+	field.programId = glCreateProgram();
+	glAttachShader(field.programId, vertexShaderId);
+	glAttachShader(field.programId, fragmentShaderId);
+	glLinkProgram(field.programId);
+	field.viewMatLoc = glGetUniformLocation(field.programId, "viewMat");
+	field.projMatLoc = glGetUniformLocation(field.programId, "projMat");
+	field.cameraPosLoc = glGetUniformLocation(field.programId, "cameraPos");
+	field.isBillboardLoc = glGetUniformLocation(field.programId, "isBillboard");
+	field.tilesLoc = glGetUniformLocation(field.programId, "tiles");
+
+	computeShaderId = setShader("compute", "Shaders/computeShaderBillboardCull.glsl");
+	field.cullProgramId = glCreateProgram();
+	glAttachShader(field.cullProgramId, computeShaderId);
+	glLinkProgram(field.cullProgramId);
+	field.planesLoc = glGetUniformLocation(field.cullProgramId, "planes");
+	field.numInstancesLoc = glGetUniformLocation(field.cullProgramId, "numInstances");
+
+	// The vertex shader makes up the rectangles, so the vertex array has no attributes.
+	glGenVertexArrays(1, &field.vao);
+
+	// Reserve the instance, visible index and command buffers.
+	glGenBuffers(3, field.buffers);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, field.buffers[INSTANCES]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, maxInstances * sizeof(BillboardInstance), NULL, GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, field.buffers[VISIBLE]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, maxInstances * sizeof(unsigned int), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, field.buffers[COMMAND]);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawArraysCommand), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Replace the instances, up to as many as the buffer holds.
+void setBillboardInstances(BillboardField &field, const BillboardInstance *instances, int numInstances)
+{
+	field.numInstances = std::min(numInstances, field.maxInstances);
+	if (field.numInstances == 0) return;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, field.buffers[INSTANCES]);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, field.numInstances * sizeof(BillboardInstance), instances);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+// Draw the instances seen from the camera at cameraPos with the viewing and projection
+// matrices, turned toward it if isBillboard and otherwise all left facing down the z-axis.
+void drawBillboardField(BillboardField &field, const float *viewMat, const float *projMat, const float *cameraPos,
+	                    int isBillboard)
+{
+	DrawArraysCommand command = { 4, 0, 0, 0 };
+	float clipMat[16], planes[6][4], length;
+	int i, j;
+
+	if (field.numInstances == 0) return;
+
+	// World-space frustum planes from the rows of the product of the matrices, computed
+	// in the modelview matrix stack.
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadMatrixf(projMat);
+	glMultMatrixf(viewMat);
+	glGetFloatv(GL_MODELVIEW_MATRIX, clipMat);
+	glPopMatrix();
+	for (i = 0; i < 3; i++)
+		for (j = 0; j < 4; j++)
+		{
+			planes[2 * i][j] = clipMat[4 * j + 3] + clipMat[4 * j + i];
+			planes[2 * i + 1][j] = clipMat[4 * j + 3] - clipMat[4 * j + i];
+		}
+	for (i = 0; i < 6; i++)
+	{
+		length = sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+		for (j = 0; j < 4; j++) planes[i][j] /= length;
+	}
+
+	// Start the command with no instances, then list the visible ones, counting them in it.
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, field.buffers[COMMAND]);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawArraysCommand), &command);
+	glUseProgram(field.cullProgramId);
+	glUniform4fv(field.planesLoc, 6, &planes[0][0]);
+	glUniform1ui(field.numInstancesLoc, field.numInstances);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, field.buffers[INSTANCES]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, field.buffers[VISIBLE]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, field.buffers[COMMAND]);
+	glDispatchCompute((field.numInstances + BILLBOARD_GROUP_SIZE - 1) / BILLBOARD_GROUP_SIZE, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	// Draw the visible ones.
+	glUseProgram(field.programId);
+	glUniformMatrix4fv(field.viewMatLoc, 1, GL_FALSE, viewMat);
+	glUniformMatrix4fv(field.projMatLoc, 1, GL_FALSE, projMat);
+	glUniform3fv(field.cameraPosLoc, 1, cameraPos);
+	glUniform1i(field.isBillboardLoc, isBillboard);
+	glUniform4fv(field.tilesLoc, field.numTiles, &field.tiles[0][0]);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, field.atlasTexture);
+	glBindVertexArray(field.vao);
+	glDrawArraysIndirect(GL_TRIANGLE_STRIP, 0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glUseProgram(0);
+}
@@ -0,0 +1,58 @@
+#ifndef BILLBOARDFIELD_H
+#define BILLBOARDFIELD_H
+
+#include <string>
+
+#define BILLBOARD_MAX_TILES 16 // Most images in the atlas.
+#define BILLBOARD_GROUP_SIZE 256 // Instances culled per compute shader work group.
+#define BILLBOARD_GUTTER 8 // Texels of white between the images of the atlas.
+
+// Ways a billboard is turned.
+enum BillboardOrientation
+{
+	BILLBOARD_FIXED, // Facing down the z-axis, not turned at all.
+	BILLBOARD_AXIS, // Turned about the y-axis toward the camera, staying upright, as a tree.
+	BILLBOARD_CAMERA // Parallel to the image plane, as a sprite.
+};
+
+// A billboard as laid out in the shader storage buffer (std430).
+struct BillboardInstance
+{
+	float position[3]; // Bottom center, or center if turned to the camera.
+	float width, height; // Size of the rectangle.
+	unsigned int tile; // Image of the atlas.
+	unsigned int orientation; // A BillboardOrientation.
+	unsigned int pad;
+};
+
+// Draws any number of textured rectangles, each turned toward the camera in the vertex
+// shader, in a single call. The instances are kept in a shader storage buffer, and each
+// frame a compute shader tests each against the view frustum and appends the index of
+// each one visible to a second buffer, counting them in the instance count of an indirect
+// draw command. The command then draws a 4-vertex strip per visible instance, the vertex
+// shader reading the instance through its index and placing the corner of the rectangle
+// given by gl_VertexID.
+//
+// The rectangles are textured from an atlas of BMP images laid side by side. The images
+// having no alpha, their white backgrounds are discarded, so that billboards need no
+// blending and can be drawn in any order.
+struct BillboardField
+{
+	int numInstances, maxInstances; // Instances in the buffer and most it holds.
+	int numTiles; // Images in the atlas.
+	float tiles[BILLBOARD_MAX_TILES][4]; // Texture coordinates of each image's lower left corner and its size.
+	unsigned int atlasTexture; // Atlas texture id.
+
+	unsigned int programId, cullProgramId; // Drawing and culling programs.
+	unsigned int viewMatLoc, projMatLoc, cameraPosLoc, isBillboardLoc, tilesLoc,
+		planesLoc, numInstancesLoc; // Uniform locations.
+	unsigned int vao, buffers[3]; // Empty vertex array and instance, visible index and command buffers.
+};
+
+bool loadBillboardAtlas(BillboardField &field, const std::string *fileNames, int numFiles);
+void createBillboardField(BillboardField &field, int maxInstances);
+void setBillboardInstances(BillboardField &field, const BillboardInstance *instances, int numInstances);
+void drawBillboardField(BillboardField &field, const float *viewMat, const float *projMat, const float *cameraPos,
+	                    int isBillboard);
+
+#endif
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+#include <GL/glew.h>
+
+#include "getBMP.h"
+#include "environmentMap.h"
+
+#define PI 3.14159265358979324
+#define CACHE_VERSION 1
+
+// Header of a cache file, followed by the levels finest first, each the six faces in
+// the order +x, -x, +y, -y, +z, -z, each face RGBA rows bottom to top.
+struct CacheHeader
+{
+	char magic[4]; // "ENV1".
+	int version; // CACHE_VERSION.
+	long long sourceSizes[6], sourceTimes[6]; // Size and modification time of the faces.
+	int size, numLevels, samples; // Face size, number of levels and samples filtered with.
+};
+
+// Run job(i) for i in [0, numJobs) on a pool of as many threads as the hardware runs,
+// each taking the next job in turn.
+static void runJobs(int numJobs, const std::function<void(int)> &job)
+{
+	std::atomic<int> next(0);
+	std::vector<std::thread> threads;
+	int i, numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	for (i = 0; i < std::min(numThreads, numJobs); i++)
+		threads.push_back(std::thread([&]()
+		{
+			int j;
+			while ((j = next++) < numJobs) job(j);
+		}));
+	for (i = 0; i < (int)threads.size(); i++) threads[i].join();
+}
+
+// Size and modification time of a file, false if it does not exist.
+static bool fileStats(const std::string &fileName, long long &size, long long &time)
+{
+	struct stat info;
+
+	if (stat(fileName.c_str(), &info) != 0) return false;
+	size = info.st_size;
+	time = info.st_mtime;
+	return true;
+}
+
+// Byte offset of a face of a level in the cached data.
+static int faceOffset(int size, int level, int face)
+{
+	int offset = 0, l, n;
+
+	for (l = 0; l < level; l++)
+	{
+		n = std::max(1, size >> l);
+		offset += 6 * 4 * n * n;
+	}
+	n = std::max(1, size >> level);
+	return offset + face * 4 * n * n;
+}
+
+// Direction, not normalized, through the point (sc, tc) in [-1, 1]^2 of a face, per the
+// cube map face selection table of the OpenGL specification.
+static void faceDirection(int face, float sc, float tc, float *dir)
+{
+	switch (face)
+	{
+	case 0: dir[0] = 1.0; dir[1] = -tc; dir[2] = -sc; break;
+	case 1: dir[0] = -1.0; dir[1] = -tc; dir[2] = sc; break;
+	case 2: dir[0] = sc; dir[1] = 1.0; dir[2] = tc; break;
+	case 3: dir[0] = sc; dir[1] = -1.0; dir[2] = -tc; break;
+	case 4: dir[0] = sc; dir[1] = -tc; dir[2] = 1.0; break;
+	default: dir[0] = -sc; dir[1] = -tc; dir[2] = -1.0; break;
+	}
+}
+
+// Face and co-ordinates (s, t) in [0, 1]^2 on it of a direction.
+static void directionFace(const float *dir, int &face, float &s, float &t)
+{
+	float ax = fabs(dir[0]), ay = fabs(dir[1]), az = fabs(dir[2]), ma, sc, tc;
+
+	if (ax >= ay && ax >= az)
+	{
+		face = dir[0] > 0.0 ? 0 : 1;
+		ma = ax; sc = dir[0] > 0.0 ? -dir[2] : dir[2]; tc = -dir[1];
+	}
+	else if (ay >= az)
+	{
+		face = dir[1] > 0.0 ? 2 : 3;
+		ma = ay; sc = dir[0]; tc = dir[1] > 0.0 ? dir[2] : -dir[2];
+	}
+	else
+	{
+		face = dir[2] > 0.0 ? 4 : 5;
+		ma = az; sc = dir[2] > 0.0 ? dir[0] : -dir[0]; tc = -dir[1];
+	}
+	s = 0.5f * (sc / ma + 1.0f);
+	t = 0.5f * (tc / ma + 1.0f);
+}
+
+// Bilinearly filtered linear color of the environment in a direction at a level of its
+// box-filtered chain, each face size n with 3 floats a texel, clamped at face edges.
+static void sampleFaces(const std::vector<float> *faces, int n, const float *dir, float *color)
+{
+	int face, x0, y0, x1, y1, c;
+	float s, t, fx, fy;
+	const float *texels;
+
+	directionFace(dir, face, s, t);
+	texels = &faces[face][0];
+	fx = std::min(std::max(s * n - 0.5f, 0.0f), n - 1.0f);
+	fy = std::min(std::max(t * n - 0.5f, 0.0f), n - 1.0f);
+	x0 = (int)fx; y0 = (int)fy;
+	x1 = std::min(x0 + 1, n - 1); y1 = std::min(y0 + 1, n - 1);
+	fx -= x0; fy -= y0;
+	for (c = 0; c < 3; c++)
+		color[c] = (1 - fy) * ((1 - fx) * texels[3 * (y0 * n + x0) + c] + fx * texels[3 * (y0 * n + x1) + c]) +
+		           fy * ((1 - fx) * texels[3 * (y1 * n + x0) + c] + fx * texels[3 * (y1 * n + x1) + c]);
+}
+
+// Van der Corput radical inverse of i in base 2, for the Hammersley sample points.
+static float radicalInverse(unsigned int i)
+{
+	i = (i << 16) | (i >> 16);
+	i = ((i & 0x55555555u) << 1) | ((i & 0xAAAAAAAAu) >> 1);
+	i = ((i & 0x33333333u) << 2) | ((i & 0xCCCCCCCCu) >> 2);
+	i = ((i & 0x0F0F0F0Fu) << 4) | ((i & 0xF0F0F0F0u) >> 4);
+	i = ((i & 0x00FF00FFu) << 8) | ((i & 0xFF00FF00u) >> 8);
+	return i * 2.3283064365386963e-10f;
+}
+
+// Byte sRGB-encoding of linear value c.
+static unsigned char encodeSrgb(float c)
+{
+	double s = c <= 0.0031308 ? 12.92 * c : 1.055 * pow((double)c, 1.0 / 2.4) - 0.055;
+	return (unsigned char)(std::min(std::max(s, 0.0), 1.0) * 255.0 + 0.5);
+}
+
+// Filter a face of a level of the environment over the Phong lobe of the given exponent
+// about each texel's direction, by importance sampling the lobe. Each sample is read
+// from the level of the box-filtered chain whose texels subtend about the solid angle
+// the sample stands for, so that few samples suffice without noise.
+static void prefilterFace(const std::vector< std::vector<float> > &chain, int size, int face, int n,
+	                      float exponent, unsigned char *out)
+{
+	float dir[3], tangent[3], bitangent[3], sample[3], color[3], lower[3], sum[3], up[3], length;
+	float u, cosTheta, sinTheta, phi, pdf, lod, frac;
+	double texelAngle = 4.0 * PI / (6.0 * size * size);
+	int x, y, k, c, level, numChainLevels = (int)chain.size() / 6;
+
+	for (y = 0; y < n; y++)
+		for (x = 0; x < n; x++)
+		{
+			// Frame about the texel's direction.
+			faceDirection(face, 2.0f * (x + 0.5f) / n - 1.0f, 2.0f * (y + 0.5f) / n - 1.0f, dir);
+			length = sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+			for (c = 0; c < 3; c++) dir[c] /= length;
+			up[0] = fabs(dir[2]) < 0.999f ? 0.0f : 1.0f; up[1] = 0.0; up[2] = 1.0f - up[0];
+			tangent[0] = up[1] * dir[2] - up[2] * dir[1];
+			tangent[1] = up[2] * dir[0] - up[0] * dir[2];
+			tangent[2] = up[0] * dir[1] - up[1] * dir[0];
+			length = sqrt(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+			for (c = 0; c < 3; c++) tangent[c] /= length;
+			bitangent[0] = dir[1] * tangent[2] - dir[2] * tangent[1];
+			bitangent[1] = dir[2] * tangent[0] - dir[0] * tangent[2];
+			bitangent[2] = dir[0] * tangent[1] - dir[1] * tangent[0];
+
+			sum[0] = sum[1] = sum[2] = 0.0;
+			for (k = 0; k < ENVIRONMENT_SAMPLES; k++)
+			{
+				u = (k + 0.5f) / ENVIRONMENT_SAMPLES;
+				cosTheta = pow(u, 1.0f / (exponent + 1.0f));
+				sinTheta = sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+				phi = 2.0f * PI * radicalInverse(k);
+				for (c = 0; c < 3; c++)
+					sample[c] = sinTheta * (cos(phi) * tangent[c] + sin(phi) * bitangent[c]) + cosTheta * dir[c];
+
+				pdf = (exponent + 1.0f) / (2.0f * PI) * pow(cosTheta, exponent);
+				lod = 0.5f * log2(1.0f / (ENVIRONMENT_SAMPLES * pdf * texelAngle));
+				lod = std::min(std::max(lod, 0.0f), numChainLevels - 1.0f);
+				level = std::min((int)lod, numChainLevels - 2);
+				if (level < 0) level = 0;
+				frac = numChainLevels > 1 ? lod - level : 0.0f;
+				sampleFaces(&chain[6 * level], std::max(1, size >> level), sample, lower);
+				if (frac > 0.0) sampleFaces(&chain[6 * (level + 1)], std::max(1, size >> (level + 1)), sample, color);
+				else color[0] = color[1] = color[2] = 0.0;
+				for (c = 0; c < 3; c++) sum[c] += (1.0f - frac) * lower[c] + frac * color[c];
+			}
+
+			for (c = 0; c < 3; c++) out[4 * (y * n + x) + c] = encodeSrgb(sum[c] / ENVIRONMENT_SAMPLES);
+			out[4 * (y * n + x) + 3] = 0xFF;
+		}
+}
+
+// Decode the faces, prefilter the levels, and write the cache file if possible. Returns
+// false if a face cannot be read or the faces are not squares of the same size.
+static bool buildLevels(const std::string faceFileNames[6], const std::string &cacheFileName,
+	                    CacheHeader &header, std::vector<unsigned char> &data)
+{
+	std::vector< std::vector<float> > chain; // Box-filtered linear levels of the faces.
+	std::vector<imageFile *> images(6, (imageFile *)NULL);
+	float linear[256];
+	int face, i, numChainLevels;
+
+	// Decode the faces in parallel.
+	runJobs(6, [&](int f)
+	{
+		std::ifstream inFile(faceFileNames[f].c_str(), std::ios::binary);
+		if (inFile) images[f] = getBMP(faceFileNames[f]);
+	});
+	for (face = 0; face < 6; face++)
+		if (!images[face] || images[face]->width != images[0]->width || images[face]->height != images[0]->width)
+		{
+			std::cout << "Cube map faces must be squares of the same size." << std::endl;
+			return false;
+		}
+
+	header.size = images[0]->width;
+	header.numLevels = std::min(header.numLevels, (int)log2((double)header.size) + 1);
+	data.assign(faceOffset(header.size, header.numLevels, 0), 0);
+
+	// Level 0 is the faces themselves; convert them to linear color as well.
+	for (i = 0; i < 256; i++)
+	{
+		double s = i / 255.0;
+		linear[i] = (float)(s <= 0.04045 ? s / 12.92 : pow((s + 0.055) / 1.055, 2.4));
+	}
+	numChainLevels = (int)log2((double)header.size) + 1;
+	chain.resize(6 * numChainLevels);
+	runJobs(6, [&](int f)
+	{
+		int j, k, l, m, p, x, y, x0, x1, y0, y1;
+
+		memcpy(&data[faceOffset(header.size, 0, f)], images[f]->data, 4 * header.size * header.size);
+		chain[f].resize(3 * header.size * header.size);
+		for (j = 0; j < header.size * header.size; j++)
+			for (k = 0; k < 3; k++) chain[f][3 * j + k] = linear[images[f]->data[4 * j + k]];
+		for (l = 1; l < numChainLevels; l++)
+		{
+			p = std::max(1, header.size >> (l - 1));
+			m = std::max(1, header.size >> l);
+			const std::vector<float> &in = chain[6 * (l - 1) + f];
+			std::vector<float> &out = chain[6 * l + f];
+			out.resize(3 * m * m);
+			for (y = 0; y < m; y++)
+			{
+				y0 = std::min(2 * y, p - 1); y1 = std::min(2 * y + 1, p - 1);
+				for (x = 0; x < m; x++)
+				{
+					x0 = std::min(2 * x, p - 1); x1 = std::min(2 * x + 1, p - 1);
+					for (k = 0; k < 3; k++)
+						out[3 * (y * m + x) + k] = 0.25f * (in[3 * (y0 * p + x0) + k] + in[3 * (y0 * p + x1) + k] +
+						                                    in[3 * (y1 * p + x0) + k] + in[3 * (y1 * p + x1) + k]);
+				}
+			}
+		}
+		delete[] images[f]->data;
+		delete images[f];
+	});
+
+	// Prefilter the faces of the other levels in parallel.
+	runJobs(6 * (header.numLevels - 1), [&](int j)
+	{
+		int l = 1 + j / 6, f = j % 6;
+		float exponent = (float)pow(4.0, header.numLevels - 1 - l);
+		prefilterFace(chain, header.size, f, std::max(1, header.size >> l), exponent,
+			&data[faceOffset(header.size, l, f)]);
+	});
+
+	std::ofstream outFile(cacheFileName.c_str(), std::ios::binary);
+	if (!outFile) return true;
+	outFile.write((const char *)&header, sizeof(CacheHeader));
+	outFile.write((const char *)&data[0], data.size());
+	return true;
+}
+
+// Load the environment map of the six face BMP files, in the order +x, -x, +y, -y, +z, -z,
+// with numLevels levels or as many as its size allows, from the cache file if it is up to
+// date, else by decoding and prefiltering the faces and writing the cache. The cube map
+// texture is created and left bound. Returns false if the faces cannot be read.
+bool loadEnvironmentMap(EnvironmentMap &environment, const std::string faceFileNames[6],
+	                    const std::string &cacheFileName, int numLevels)
+{
+	CacheHeader header, cached;
+	std::vector<unsigned char> data;
+	int face, level, n;
+
+	memset(&header, 0, sizeof(CacheHeader));
+	memcpy(header.magic, "ENV1", 4);
+	header.version = CACHE_VERSION;
+	header.numLevels = std::min(std::max(numLevels, 1), ENVIRONMENT_MAX_LEVELS);
+	header.samples = ENVIRONMENT_SAMPLES;
+	for (face = 0; face < 6; face++)
+		if (!fileStats(faceFileNames[face], header.sourceSizes[face], header.sourceTimes[face]))
+		{
+			std::cout << "Could not read " << faceFileNames[face] << "." << std::endl;
+			return false;
+		}
+
+	// Read the cache if it was filtered from the same faces with the same settings.
+	std::ifstream inFile(cacheFileName.c_str(), std::ios::binary);
+	environment.fromCache = false;
+	if (inFile && inFile.read((char *)&cached, sizeof(CacheHeader)) && memcmp(cached.magic, "ENV1", 4) == 0 &&
+		cached.version == CACHE_VERSION && cached.samples == header.samples &&
+		cached.numLevels == std::min(header.numLevels, (int)log2((double)cached.size) + 1) &&
+		memcmp(cached.sourceSizes, header.sourceSizes, sizeof(header.sourceSizes)) == 0 &&
+		memcmp(cached.sourceTimes, header.sourceTimes, sizeof(header.sourceTimes)) == 0)
+	{
+		data.resize(faceOffset(cached.size, cached.numLevels, 0));
+		environment.fromCache = (bool)inFile.read((char *)&data[0], data.size());
+		if (environment.fromCache) header = cached;
+	}
+	inFile.close();
+	if (!environment.fromCache && !buildLevels(faceFileNames, cacheFileName, header, data)) return false;
+
+	// Allocate the cube map once and specify every face of every level.
+	environment.size = header.size;
+	environment.numLevels = header.numLevels;
+	glGenTextures(1, &environment.texture);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, environment.texture);
+	if (GLEW_ARB_texture_storage)
+		glTexStorage2D(GL_TEXTURE_CUBE_MAP, header.numLevels, GL_RGBA8, header.size, header.size);
+	for (level = 0; level < header.numLevels; level++)
+	{
+		n = std::max(1, header.size >> level);
+		for (face = 0; face < 6; face++)
+			if (GLEW_ARB_texture_storage)
+				glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, 0, 0, n, n, GL_RGBA, GL_UNSIGNED_BYTE,
+					            &data[faceOffset(header.size, level, face)]);
+			else
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGBA, n, n, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+					         &data[faceOffset(header.size, level, face)]);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, header.numLevels - 1);
+	return true;
+}
@@ -0,0 +1,31 @@
+#ifndef ENVIRONMENTMAP_H
+#define ENVIRONMENTMAP_H
+
+#include <string>
+
+#define ENVIRONMENT_MAX_LEVELS 8 // Most prefiltered levels of an environment map.
+#define ENVIRONMENT_SAMPLES 64 // Directions sampled per texel when prefiltering.
+
+// A cube map of an environment whose mipmap levels are prefiltered for reflection by
+// ever rougher surfaces: level 0 is the environment itself, for a mirror, and each level
+// after it, at half the resolution, averages the environment over a Phong lobe of a
+// quarter the exponent of the one before, down to 1 at the last level. A reflective
+// object then picks its roughness by the level it samples, at the cost of a single
+// texture lookup.
+//
+// The faces are decoded from their BMP files on a pool of threads, the levels filtered
+// on the same pool, and the result cached in a file, so that later runs, finding the
+// cache newer than the faces, upload it without decoding or filtering anything. The
+// cube map is allocated once with glTexStorage2D() where the GL supports it.
+struct EnvironmentMap
+{
+	unsigned int texture; // Cube map texture id.
+	int size; // Width and height of a face in level 0.
+	int numLevels; // Number of levels.
+	bool fromCache; // If the levels were read from the cache rather than filtered.
+};
+
+bool loadEnvironmentMap(EnvironmentMap &environment, const std::string faceFileNames[6],
+	                    const std::string &cacheFileName, int numLevels);
+
+#endif
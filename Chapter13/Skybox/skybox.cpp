@@ -2,11 +2,14 @@
 // skybox.cpp
 //
 // This program creates a skybox using cube map textures. Additionally, there is
-// a black ball in the scene.
+// a ball in the scene reflecting the sky. The cube map's mipmap levels are prefiltered
+// for ever rougher reflection and cached in Textures/IceRiver/radiance.env, so only the
+// first run decodes and filters the faces.
 //
 // Interaction:
 // Press the up/down arrow keys to move the viewpoint, the left/right arrow and 
 // page up/page down keys to turn it.
+// Press r/R to make the ball rougher/smoother.
 //
 // Sumanta Guha.
 /////////////////////////////////////////////////////////////////////////////// 
@@ -20,39 +23,36 @@
 
 #define PI 3.14159265
 
-#include "getBMP.h"
+#include "environmentMap.h"
 
 // Globals.
-static unsigned int textureCube;
+static EnvironmentMap environment; // Cube map of the sky.
+static float roughness = 0.0; // Level of the cube map reflected by the ball.
 static float zVal = 0.0; // z-displacement of eye.
 static float longAngle = 0.0, latAngle = 0.0; // Angles of point of view.
 
 // Load external textures.
 void loadTextures()
 {
-	// Local storage for bmp image data.
-	imageFile *imageCube[6];
-
-	// Load the six cube map images.
-	imageCube[0] = getBMP("../../Textures/IceRiver/posx.bmp");
-	imageCube[1] = getBMP("../../Textures/IceRiver/negx.bmp");
-	imageCube[2] = getBMP("../../Textures/IceRiver/posy.bmp");
-	imageCube[3] = getBMP("../../Textures/IceRiver/negy.bmp");
-	imageCube[4] = getBMP("../../Textures/IceRiver/posz.bmp");
-	imageCube[5] = getBMP("../../Textures/IceRiver/negz.bmp");
-
-	// Bind the cube map texture and define its 6 component textures.
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureCube);
-	for (int face = 0; face < 6; face++)
+	// The six cube map images.
+	std::string faceFileNames[6] = 
 	{
-		int target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
-		glTexImage2D(target, 0, GL_RGBA, imageCube[0]->width, imageCube[0]->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageCube[face]->data);
-	}
+		"../../Textures/IceRiver/posx.bmp", "../../Textures/IceRiver/negx.bmp",
+		"../../Textures/IceRiver/posy.bmp", "../../Textures/IceRiver/negy.bmp",
+		"../../Textures/IceRiver/posz.bmp", "../../Textures/IceRiver/negz.bmp"
+	};
+
+	// Create the cube map texture with its prefiltered levels, from the cache if built.
+	if (!loadEnvironmentMap(environment, faceFileNames, "../../Textures/IceRiver/radiance.env", 6)) exit(1);
+	if (!environment.fromCache) std::cout << "Cube map levels prefiltered and cached." << std::endl;
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Filter across cube map face edges, which shows in the rougher levels.
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 }
 
 void setup(void)
@@ -60,9 +60,6 @@ void setup(void)
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 	glEnable(GL_DEPTH_TEST);
 
-	// Create texture ids.
-	glGenTextures(1, &textureCube);
-
 	// Load external texture. 
 	loadTextures();
 
@@ -98,7 +95,9 @@ void drawScene(void)
 	glPushMatrix();
 	glRotatef(-latAngle, 1.0, 0.0, 0.0);
 	glRotatef(-longAngle, 0.0, 1.0, 0.0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureCube);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, environment.texture);
+	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_LOD, 0.0);
+	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LOD, 0.0);
 	glBegin(GL_POLYGON);
 	glTexCoord3f(-1.0, 1.0, 1.0); glVertex3f(-50.0, -50.0, -25.0);
 	glTexCoord3f(1.0, 1.0, 1.0); glVertex3f(50.0, -50.0, -25.0);
@@ -110,11 +109,26 @@ void drawScene(void)
 	// Enable depth buffer.
 	glDepthMask(GL_TRUE);
 
-	// Draw sphere.
-	glDisable(GL_TEXTURE_CUBE_MAP);
+	// Draw sphere reflecting the sky: eye-space reflection vectors are generated as texture
+	// co-ordinates and taken to the skybox's cube map directions by the texture matrix,
+	// the level sampled being fixed by the roughness.
+	glMatrixMode(GL_TEXTURE);
+	glScalef(1.0, -1.0, -1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_LOD, roughness);
+	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LOD, roughness);
+	glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
+	glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
+	glTexGeni(GL_R, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
+	glEnable(GL_TEXTURE_GEN_S);
+	glEnable(GL_TEXTURE_GEN_T);
+	glEnable(GL_TEXTURE_GEN_R);
 	glTranslatef(0.0, 0.0, -25.0);
-	glColor3f(0.0, 0.0, 0.0);
-	glutWireSphere(5.0, 20, 20);
+	glutSolidSphere(5.0, 40, 40);
+	glDisable(GL_TEXTURE_GEN_S);
+	glDisable(GL_TEXTURE_GEN_T);
+	glDisable(GL_TEXTURE_GEN_R);
+	glDisable(GL_TEXTURE_CUBE_MAP);
 
 	glutSwapBuffers();
 }
@@ -137,6 +151,14 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'r':
+		if (roughness < environment.numLevels - 1) roughness += 0.25;
+		glutPostRedisplay();
+		break;
+	case 'R':
+		if (roughness > 0.0) roughness -= 0.25;
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
@@ -171,6 +193,7 @@ void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press the up/down arrow keys to move the viewpoint, the left/right arrow and page up/page down keys to turn it." << std::endl;
+	std::cout << "Press r/R to make the ball rougher/smoother." << std::endl;
 }
 
 // Main routine.
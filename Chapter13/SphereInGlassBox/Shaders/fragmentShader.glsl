@@ -0,0 +1,28 @@
+#version 430 core
+
+in vec3 eyeCoordsExport;
+in vec3 normalExport;
+in vec4 colorExport;
+
+const vec3 lightPos = vec3(0.0, 1.5, 3.0); // In eye coordinates.
+const vec3 globAmb = vec3(0.2, 0.2, 0.2);
+const float matShine = 50.0;
+
+// Color of the fragment, lit on both sides by a white light with a local viewer,
+// its alpha that of the surface.
+vec4 shade(void)
+{
+   vec3 normal = normalize(normalExport);
+   vec3 lightDirection = normalize(lightPos - eyeCoordsExport);
+   vec3 eyeDirection = normalize(-eyeCoordsExport);
+   vec3 halfway = normalize(lightDirection + eyeDirection);
+   vec3 color;
+
+   if (!gl_FrontFacing) normal = -normal;
+
+   color = globAmb * colorExport.rgb;
+   if (dot(normal, lightDirection) > 0.0)
+      color += dot(normal, lightDirection) * colorExport.rgb +
+               pow(max(dot(normal, halfway), 0.0), matShine) * vec3(1.0);
+   return vec4(color, colorExport.a);
+}
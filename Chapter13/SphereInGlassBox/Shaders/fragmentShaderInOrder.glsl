@@ -0,0 +1,10 @@
+#version 430 core
+
+vec4 shade(void);
+
+out vec4 colorsOut;
+
+void main(void)
+{
+   colorsOut = shade();
+}
@@ -0,0 +1,28 @@
+#version 430 core
+
+layout(early_fragment_tests) in;
+
+layout(binding=0, r32ui) uniform coherent uimage2D heads;
+layout(binding=0, offset=0) uniform atomic_uint numNodes;
+layout(std430, binding=0) buffer Nodes
+{
+   uvec4 nodes[]; // Packed color, depth bits, 1 + index of the next node (0 for none).
+};
+
+uniform uint maxNodes;
+
+vec4 shade(void);
+
+void main(void)
+{
+   vec4 color = shade();
+   uint node;
+
+   if (color.a == 0.0) return;
+
+   // Take the next free node, if any remain, and make it the head of the pixel's list.
+   node = atomicCounterIncrement(numNodes);
+   if (node >= maxNodes) return;
+   nodes[node] = uvec4(packUnorm4x8(color), floatBitsToUint(gl_FragCoord.z),
+                       imageAtomicExchange(heads, ivec2(gl_FragCoord.xy), node + 1u), 0u);
+}
@@ -0,0 +1,47 @@
+#version 430 core
+
+#define MAX_LAYERS 48 // OIT_MAX_LAYERS.
+
+layout(binding=0, r32ui) uniform readonly uimage2D heads;
+layout(std430, binding=0) readonly buffer Nodes
+{
+   uvec4 nodes[];
+};
+
+out vec4 colorsOut;
+
+void main(void)
+{
+   uvec2 layers[MAX_LAYERS]; // Packed colors and depth bits, nearest first.
+   uint next = imageLoad(heads, ivec2(gl_FragCoord.xy)).r;
+   uvec4 node;
+   vec4 color, result = vec4(0.0);
+   int count = 0, i;
+
+   if (next == 0u) discard; // No translucent fragments.
+
+   // Insertion sort of the list, keeping the nearest MAX_LAYERS fragments.
+   while (next != 0u)
+   {
+      node = nodes[next - 1u];
+      next = node.z;
+      if (count < MAX_LAYERS) i = count++;
+      else if (uintBitsToFloat(node.y) < uintBitsToFloat(layers[MAX_LAYERS - 1].y)) i = MAX_LAYERS - 1;
+      else continue;
+      while (i > 0 && uintBitsToFloat(layers[i - 1].y) > uintBitsToFloat(node.y))
+      {
+         layers[i] = layers[i - 1];
+         i--;
+      }
+      layers[i] = node.xy;
+   }
+
+   // Blend front to back, premultiplied, to be blended in turn over the opaque image.
+   for (i = 0; i < count; i++)
+   {
+      color = unpackUnorm4x8(layers[i].x);
+      result.rgb += (1.0 - result.a) * color.a * color.rgb;
+      result.a += (1.0 - result.a) * color.a;
+   }
+   colorsOut = result;
+}
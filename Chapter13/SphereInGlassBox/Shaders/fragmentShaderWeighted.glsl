@@ -0,0 +1,19 @@
+#version 430 core
+
+vec4 shade(void);
+
+layout(location=0) out vec4 accumOut;
+layout(location=1) out float revealageOut;
+
+void main(void)
+{
+   vec4 color = shade();
+
+   // Weight falling off with depth and rising with alpha, bounded to keep the sums in
+   // half-float range.
+   float weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0),
+                        1e-2, 3e3);
+
+   accumOut = vec4(color.rgb * color.a, color.a) * weight;
+   revealageOut = color.a;
+}
@@ -0,0 +1,21 @@
+#version 430 core
+
+layout(binding=0) uniform sampler2D accumTex;
+layout(binding=1) uniform sampler2D revealageTex;
+
+out vec4 colorsOut;
+
+void main(void)
+{
+   ivec2 texel = ivec2(gl_FragCoord.xy);
+   float revealage = texelFetch(revealageTex, texel, 0).r;
+   vec4 accum;
+
+   if (revealage == 1.0) discard; // No translucent fragments.
+
+   // Where the sums overflowed, fall back to an unweighted gray.
+   accum = texelFetch(accumTex, texel, 0);
+   if (isinf(max(max(abs(accum.r), abs(accum.g)), max(abs(accum.b), abs(accum.a))))) accum.rgb = vec3(accum.a);
+
+   colorsOut = vec4(accum.rgb / max(accum.a, 1e-5), 1.0 - revealage);
+}
@@ -0,0 +1,22 @@
+#version 430 core
+
+layout(location=0) in vec3 coords;
+layout(location=1) in vec3 normal;
+layout(location=2) in vec4 color;
+
+layout(location=0) uniform mat4 projMat;
+layout(location=1) uniform mat4 modelViewMat;
+
+out vec3 eyeCoordsExport;
+out vec3 normalExport;
+out vec4 colorExport;
+
+void main(void)
+{
+   vec4 eyeCoords = modelViewMat * vec4(coords, 1.0);
+
+   eyeCoordsExport = eyeCoords.xyz;
+   normalExport = mat3(modelViewMat) * normal; // Modelview matrices are rigid motions.
+   colorExport = color;
+   gl_Position = projMat * eyeCoords;
+}
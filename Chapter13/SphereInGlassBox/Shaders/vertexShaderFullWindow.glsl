@@ -0,0 +1,9 @@
+#version 430 core
+
+// A triangle covering the window, drawn with no vertex attributes.
+void main(void)
+{
+   vec2 coords = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+   gl_Position = vec4(2.0 * coords - 1.0, 0.0, 1.0);
+}
@@ -4,76 +4,226 @@
 // This program builds on sphereInBox2.cpp with the sides of the box given low alpha values
 // to make them appear translucent. The box side normals are unaveraged (straight).
 //
+// The scene is drawn with shaders, lit per fragment as the fixed-function pipeline lit it,
+// and the translucent surfaces are drawn after the opaque sphere, in any order, by one of
+// three methods: blended in the order drawn, as before, which is only right when they are
+// drawn back to front, weighted blended order-independent transparency, or per-pixel
+// linked lists sorted by depth. A stress scene adds a crowd of translucent quads inside
+// and around the box, overlapping in every order. The GPU time spent on the translucent
+// surfaces is reported every 100 frames.
+//
 // Interaction:
 // Press up/down arrow keys to open/close the box.
 // Press the x, X, y, Y, z, Z keys to rotate the box.
+// Press 'o' to cycle through the ways of drawing translucent surfaces.
+// Press 's' to toggle the stress scene of translucent quads.
 //
 // Sumanta Guha.
 //////////////////////////////////////////////////////////////////////////////////////////// 
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "prepShader.h"
+#include "transparency.h"
+
+#define PI 3.14159265
+#define NUM_QUADS 2000 // Translucent quads of the stress scene.
+
+static enum object {SPHERE, BOX, LID, QUADS}; // VAO ids.
+static enum uniform {PROJ_MAT, MODELVIEW_MAT}; // Uniform locations, fixed in the vertex shader.
+
 // Globals.
-static unsigned int aSide; // List index.
 static int step = 0; // Steps in open/closing box lid.
 static float Xangle = 0.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate scene.
+static int isStress = 0; // Draw the stress scene?
+
+// Matrices (4x4 matrices each written in a 1-dim array in column-major order).
+static float projMat[16]; // Projection transformation matrix.
+static float modelViewMat[16]; // Modelview transformation matrix of the sphere and box.
+static float lidMat[16]; // Modelview transformation matrix of the lid.
+
+// Meshes of position, normal and color vertices.
+static std::vector<float> vertices[4];
+static std::vector<unsigned int> indices[4];
+
+static Transparency transparency; // Draws the translucent surfaces.
+
+static unsigned int
+	buffer[8],
+	vao[4];
+
+// Routine to append the triangles of a (uSteps + 1) x (vSteps + 1) grid of vertices
+// starting at vertex first, counter-clockwise if the grid's u and v run so.
+void appendGridIndices(std::vector<unsigned int> &ind, int first, int uSteps, int vSteps)
+{
+	int i, j, k;
+
+	for (i = 0; i < uSteps; i++)
+		for (j = 0; j < vSteps; j++)
+		{
+			k = first + i * (vSteps + 1) + j;
+			ind.push_back(k);
+			ind.push_back(k + vSteps + 1);
+			ind.push_back(k + vSteps + 2);
+			ind.push_back(k);
+			ind.push_back(k + vSteps + 2);
+			ind.push_back(k + 1);
+		}
+}
+
+// Routine to append a vertex to the mesh of an object.
+void appendVertex(int obj, const float *coords, const float *normal, const float *color)
+{
+	vertices[obj].insert(vertices[obj].end(), coords, coords + 3);
+	vertices[obj].insert(vertices[obj].end(), normal, normal + 3);
+	vertices[obj].insert(vertices[obj].end(), color, color + 4);
+}
+
+// Routine to append the side of the box in the plane where coordinate axis is sign, facing
+// out, along its normal: the grid's u and v axes are the next two axes cyclically, which run
+// counter-clockwise seen from outside, swapped for the sides where sign is negative.
+void appendSide(int obj, int axis, float sign, const float *color)
+{
+	float coords[3], normal[3] = { 0.0, 0.0, 0.0 };
+	int first = vertices[obj].size() / 10, uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3, i, j;
+
+	if (sign < 0.0) std::swap(uAxis, vAxis);
+
+	normal[axis] = sign;
+	coords[axis] = sign;
+	for (i = 0; i <= 1; i++)
+		for (j = 0; j <= 1; j++)
+		{
+			coords[uAxis] = -1.0 + 2.0 * i;
+			coords[vAxis] = -1.0 + 2.0 * j;
+			appendVertex(obj, coords, normal, color);
+		}
+	appendGridIndices(indices[obj], first, 1, 1);
+}
+
+// Routine to return a random number between low and high.
+float randomBetween(float low, float high)
+{
+	return low + (high - low) * rand() / RAND_MAX;
+}
+
+// Routine to fill the meshes: a sphere as glutSolidSphere(1.0, 40, 40), the five sides and
+// the top of the box and the randomly placed quads of the stress scene.
+void fillMeshes(void)
+{
+	float sphColor[] = { 0.0, 0.9, 0.0, 1.0 }; // Alpha value of sphere = 1.0.
+	float boxColor[] = { 0.9, 0.0, 0.0, 0.5 }; // Alpha value of box sides = 0.5.
+	float coords[3], normal[3], color[4], center[3], u[3], v[3];
+	float theta, phi;
+	int i, j, k, quad;
+
+	// Sphere about the origin.
+	for (i = 0; i <= 40; i++)
+		for (j = 0; j <= 40; j++)
+		{
+			theta = 2.0 * PI * i / 40;
+			phi = -PI / 2.0 + PI * j / 40;
+			normal[0] = cos(phi) * cos(theta);
+			normal[1] = sin(phi);
+			normal[2] = -cos(phi) * sin(theta);
+			appendVertex(SPHERE, normal, normal, sphColor);
+		}
+	appendGridIndices(indices[SPHERE], 0, 40, 40);
+
+	// The bottom and four sides of the box, and the top.
+	appendSide(BOX, 1, -1.0, boxColor);
+	appendSide(BOX, 2, -1.0, boxColor);
+	appendSide(BOX, 2, 1.0, boxColor);
+	appendSide(BOX, 0, 1.0, boxColor);
+	appendSide(BOX, 0, -1.0, boxColor);
+	appendSide(LID, 1, 1.0, boxColor);
+
+	// Quads of random colors, translucencies and orientations, each spanned by two random
+	// half-edges u and v about its center.
+	srand(1);
+	for (quad = 0; quad < NUM_QUADS; quad++)
+	{
+		for (k = 0; k < 3; k++)
+		{
+			center[k] = randomBetween(-1.5, 1.5);
+			u[k] = randomBetween(-0.3, 0.3);
+			v[k] = randomBetween(-0.3, 0.3);
+			color[k] = randomBetween(0.0, 1.0);
+		}
+		color[3] = randomBetween(0.1, 0.5);
+		normal[0] = u[1] * v[2] - u[2] * v[1];
+		normal[1] = u[2] * v[0] - u[0] * v[2];
+		normal[2] = u[0] * v[1] - u[1] * v[0];
+
+		for (i = 0; i <= 1; i++)
+			for (j = 0; j <= 1; j++)
+			{
+				for (k = 0; k < 3; k++) coords[k] = center[k] + (2 * i - 1) * u[k] + (2 * j - 1) * v[k];
+				appendVertex(QUADS, coords, normal, color);
+			}
+		appendGridIndices(indices[QUADS], 4 * quad, 1, 1);
+	}
+}
+
+// Routine to draw an object with the bound program and the modelview matrix.
+void drawObject(int obj, const float *mat)
+{
+	glUniformMatrix4fv(MODELVIEW_MAT, 1, GL_FALSE, mat);
+	glBindVertexArray(vao[obj]);
+	glDrawElements(GL_TRIANGLES, indices[obj].size(), GL_UNSIGNED_INT, 0);
+}
 
 // Initialization routine.
 void setup(void)
 {
-	aSide = glGenLists(1); // Return a list index.
-
-	// A side of the box in a display list.
-	glNewList(aSide, GL_COMPILE);
-	glBegin(GL_POLYGON);
-	glNormal3f(0.0, -1.0, 0.0);
-	glVertex3f(1.0, -1.0, 1.0);
-	glVertex3f(-1.0, -1.0, 1.0);
-	glVertex3f(-1.0, -1.0, -1.0);
-	glVertex3f(1.0, -1.0, -1.0);
-	glEnd();
-	glEndList();
+	unsigned int vertexShaderId, fragmentShaderId;
+	int obj;
 
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 	glEnable(GL_DEPTH_TEST); // Enable depth testing.
 
-	// Turn on OpenGL lighting.
-	glEnable(GL_LIGHTING);
-
-	// Light property vectors.
-	float lightAmb[] = { 0.0, 0.0, 0.0, 1.0 };
-	float lightDifAndSpec[] = { 1.0, 1.0, 1.0, 1.0 };
-	float lightPos[] = { 0.0, 1.5, 3.0, 1.0 };
-	float globAmb[] = { 0.2, 0.2, 0.2, 1.0 };
-
-	// Light properties.
-	glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmb);
-	glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDifAndSpec);
-	glLightfv(GL_LIGHT0, GL_SPECULAR, lightDifAndSpec);
-	glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-
-	glEnable(GL_LIGHT0); // Enable particular light source.
-	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, globAmb); // Global ambient light.
-	glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE); // Enable two-sided lighting.
-	glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE); // Enable local viewpoint.
+	// Create the shaders, which the transparency programs link with their own.
+	vertexShaderId = setShader("vertex", "Shaders/vertexShader.glsl");
+	fragmentShaderId = setShader("fragment", "Shaders/fragmentShader.glsl");
+	createTransparency(transparency, vertexShaderId, fragmentShaderId,
+		               glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
+
+	// Create VAOs and VBOs of the meshes.
+	fillMeshes();
+	glGenVertexArrays(4, vao);
+	glGenBuffers(8, buffer);
+	for (obj = SPHERE; obj <= QUADS; obj++)
+	{
+		glBindVertexArray(vao[obj]);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer[2 * obj]);
+		glBufferData(GL_ARRAY_BUFFER, vertices[obj].size() * sizeof(float), &vertices[obj][0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[2 * obj + 1]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices[obj].size() * sizeof(unsigned int), &indices[obj][0],
+			GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 10 * sizeof(float), 0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void *)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void *)(6 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+	}
+	glBindVertexArray(0);
 
-	glEnable(GL_BLEND); // Enable blending.
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Specify blending parameters.
+	std::cout << transparencyModeName(transparency.mode) << "." << std::endl;
 }
 
 // Drawing routine.
 void drawScene()
 {
-	// Material property vectors.
-	float matAmbAndDif1[] = { 0.9, 0.0, 0.0, 0.5 }; // Alpha value of box sides = 0.5.
-	float matAmbAndDif2[] = { 0.0, 0.9, 0.0, 1.0 }; // Alpha value of sphere = 1.0.
-	float matSpec[] = { 1.0, 1.0, 1.0, 1.0 };
-	float matShine[] = { 50.0 };
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// Compute the modelview matrices in the modelview matrix stack.
+	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 
 	// Position the box for viewing.
@@ -83,52 +233,26 @@ void drawScene()
 	glRotatef(Zangle, 0.0, 0.0, 1.0);
 	glRotatef(Yangle, 0.0, 1.0, 0.0);
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelViewMat);
 
-	// Material properties of the sphere (only the front is ever seen).
-	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, matAmbAndDif2);
-
-	// Opaque sphere.
-	glutSolidSphere(1.0, 40, 40);
-
-	glDepthMask(GL_FALSE); // Make depth buffer read-only.
-
-	// Material properties of the box.
-	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, matAmbAndDif1);
-	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpec);
-	glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, matShine);
-
-	// Six translucent sides of the box, including the top, drawn with calls to the display list.
-	glCallList(aSide); // Side 1.
-
-	glPushMatrix();
-	glRotatef(90.0, 1.0, 0.0, 0.0);
-	glCallList(aSide); // Side 2.
-	glPopMatrix();
-
-	glPushMatrix();
-	glRotatef(270.0, 1.0, 0.0, 0.0);
-	glCallList(aSide); // Side 3.
-	glPopMatrix();
-
-	glPushMatrix();
-	glRotatef(90.0, 0.0, 0.0, 1.0);
-	glCallList(aSide); // Side 4.
-	glPopMatrix();
-
-	glPushMatrix();
-	glRotatef(270.0, 0.0, 0.0, 1.0);
-	glCallList(aSide); // Side 5.
-	glPopMatrix();
-
-	glPushMatrix();
+	// Lid hinged at the back of the top.
 	glTranslatef(0.0, 1.0, -1.0);
 	glRotatef((float)step, -1.0, 0.0, 0.0);
 	glTranslatef(0.0, -1.0, 1.0);
-	glRotatef(180.0, 1.0, 0.0, 0.0);
-	glCallList(aSide); // Top.
-	glPopMatrix();
+	glGetFloatv(GL_MODELVIEW_MATRIX, lidMat);
 
-	glDepthMask(GL_TRUE); // Make depth buffer writable.
+	// Opaque sphere.
+	beginOpaque(transparency);
+	glUniformMatrix4fv(PROJ_MAT, 1, GL_FALSE, projMat);
+	drawObject(SPHERE, modelViewMat);
+
+	// Translucent sides of the box, including the top, and the quads, in no particular order.
+	beginTranslucent(transparency);
+	glUniformMatrix4fv(PROJ_MAT, 1, GL_FALSE, projMat);
+	drawObject(BOX, modelViewMat);
+	drawObject(LID, lidMat);
+	if (isStress) drawObject(QUADS, modelViewMat);
+	endTransparency(transparency);
 
 	glutSwapBuffers();
 
@@ -142,7 +266,10 @@ void resize(int w, int h)
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	gluPerspective(60.0, (float)w / (float)h, 1.0, 20.0);
+	glGetFloatv(GL_PROJECTION_MATRIX, projMat);
 	glMatrixMode(GL_MODELVIEW);
+
+	resizeTransparency(transparency, w, h);
 }
 
 // Keyboard input processing routine.
@@ -183,6 +310,16 @@ void keyInput(unsigned char key, int x, int y)
 		if (Zangle < 0.0) Zangle += 360.0;
 		glutPostRedisplay();
 		break;
+	case 'o':
+		setTransparencyMode(transparency, (transparency.mode + 1) % OIT_NUM_MODES);
+		std::cout << transparencyModeName(transparency.mode) << "." << std::endl;
+		glutPostRedisplay();
+		break;
+	case 's':
+		isStress = !isStress;
+		std::cout << "Stress scene " << (isStress ? "on." : "off.") << std::endl;
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
@@ -201,7 +338,9 @@ void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press up/down arrow keys to open/close the box." << std::endl
-		<< "Press the x, X, y, Y, z, Z keys to rotate the box." << std::endl;
+		<< "Press the x, X, y, Y, z, Z keys to rotate the box." << std::endl
+		<< "Press 'o' to cycle through the ways of drawing translucent surfaces." << std::endl
+		<< "Press 's' to toggle the stress scene of translucent quads." << std::endl;
 }
 
 // Main routine.
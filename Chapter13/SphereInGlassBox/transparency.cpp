@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "prepShader.h"
+#include "transparency.h"
+
+#define OIT_MAX_NODES (1 << 22) // Most linked list nodes, of 16 bytes each, whatever the window size.
+
+static enum texture {OPAQUE_COLOR, DEPTH, ACCUM, REVEALAGE}; // Texture ids.
+static enum framebuffer {OPAQUE, WEIGHTED}; // Framebuffer ids.
+static enum buffer {NODES, COUNTER}; // Buffer ids.
+
+// Routine to link a program of the given shaders.
+static unsigned int linkProgram(unsigned int shaderId0, unsigned int shaderId1, unsigned int shaderId2)
+{
+	unsigned int programId = glCreateProgram();
+
+	glAttachShader(programId, shaderId0);
+	glAttachShader(programId, shaderId1);
+	if (shaderId2) glAttachShader(programId, shaderId2);
+	glLinkProgram(programId);
+	return programId;
+}
+
+// Routine to create a 2D texture of the size, with a single level, sampled as is.
+static void createTarget(unsigned int texture, GLenum internalFormat, int width, int height)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+// Create the programs of each mode, linking the application's vertex shader and shade()
+// fragment shader, and the targets for a window of the size.
+void createTransparency(Transparency &transparency, unsigned int vertexShaderId, unsigned int shadeShaderId,
+	                    int width, int height)
+{
+	unsigned int resolveVertexShaderId;
+
+	transparency.mode = OIT_WEIGHTED;
+	transparency.programs[OIT_IN_ORDER] =
+		linkProgram(vertexShaderId, shadeShaderId, setShader("fragment", "Shaders/fragmentShaderInOrder.glsl"));
+	transparency.programs[OIT_WEIGHTED] =
+		linkProgram(vertexShaderId, shadeShaderId, setShader("fragment", "Shaders/fragmentShaderWeighted.glsl"));
+	transparency.programs[OIT_LINKED_LIST] =
+		linkProgram(vertexShaderId, shadeShaderId, setShader("fragment", "Shaders/fragmentShaderLinkedList.glsl"));
+	transparency.maxNodesLoc = glGetUniformLocation(transparency.programs[OIT_LINKED_LIST], "maxNodes");
+
+	resolveVertexShaderId = setShader("vertex", "Shaders/vertexShaderFullWindow.glsl");
+	transparency.compositeProgramId =
+		linkProgram(resolveVertexShaderId, setShader("fragment", "Shaders/fragmentShaderWeightedComposite.glsl"), 0);
+	transparency.resolveProgramId =
+		linkProgram(resolveVertexShaderId, setShader("fragment", "Shaders/fragmentShaderLinkedListResolve.glsl"), 0);
+
+	glGenVertexArrays(1, &transparency.vao);
+	glGenQueries(2, transparency.queries);
+	transparency.frame = transparency.numTimed = 0;
+	transparency.gpuTime = 0.0;
+
+	glGenFramebuffers(2, transparency.framebuffers);
+	glGenBuffers(2, transparency.buffers);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, transparency.buffers[COUNTER]);
+	glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(unsigned int), NULL, GL_DYNAMIC_DRAW);
+	transparency.width = transparency.height = 0;
+	resizeTransparency(transparency, width, height);
+}
+
+// Routine to recreate the targets, the list heads and the node buffer for the window size.
+void resizeTransparency(Transparency &transparency, int width, int height)
+{
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	if (width == transparency.width && height == transparency.height) return;
+	if (transparency.width > 0)
+	{
+		glDeleteTextures(4, transparency.textures);
+		glDeleteTextures(1, &transparency.headTexture);
+	}
+	transparency.width = width;
+	transparency.height = height;
+
+	// Immutable textures cannot be resized, so they are created anew.
+	glGenTextures(4, transparency.textures);
+	glGenTextures(1, &transparency.headTexture);
+	createTarget(transparency.textures[OPAQUE_COLOR], GL_RGBA8, width, height);
+	createTarget(transparency.textures[DEPTH], GL_DEPTH_COMPONENT24, width, height);
+	createTarget(transparency.textures[ACCUM], GL_RGBA16F, width, height);
+	createTarget(transparency.textures[REVEALAGE], GL_R16F, width, height);
+	createTarget(transparency.headTexture, GL_R32UI, width, height);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// The opaque framebuffer, and the accumulation framebuffer sharing its depths.
+	glBindFramebuffer(GL_FRAMEBUFFER, transparency.framebuffers[OPAQUE]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, transparency.textures[OPAQUE_COLOR], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, transparency.textures[DEPTH], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, transparency.framebuffers[WEIGHTED]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, transparency.textures[ACCUM], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, transparency.textures[REVEALAGE], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, transparency.textures[DEPTH], 0);
+	GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+	glDrawBuffers(2, drawBuffers);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Transparency framebuffer incomplete." << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Nodes of 16 bytes: packed color, depth and the index of the next node.
+	transparency.maxNodes = std::min(width * height * OIT_NODES_PER_PIXEL, OIT_MAX_NODES);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, transparency.buffers[NODES]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, transparency.maxNodes * 4 * sizeof(unsigned int), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glProgramUniform1ui(transparency.programs[OIT_LINKED_LIST], transparency.maxNodesLoc, transparency.maxNodes);
+}
+
+// Routine to bind the opaque framebuffer and clear it, returning the program to draw
+// opaque surfaces with, which writes shade() as it is.
+unsigned int beginOpaque(Transparency &transparency)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, transparency.framebuffers[OPAQUE]);
+	glViewport(0, 0, transparency.width, transparency.height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glUseProgram(transparency.programs[OIT_IN_ORDER]);
+	return transparency.programs[OIT_IN_ORDER];
+}
+
+// Routine to set up drawing the translucent surfaces in the current mode, returning the
+// program to draw them with. The depth buffer is left read-only.
+unsigned int beginTranslucent(Transparency &transparency)
+{
+	static const float zeros[] = {0.0, 0.0, 0.0, 0.0}, ones[] = {1.0, 1.0, 1.0, 1.0};
+	static const unsigned int zero = 0;
+
+	glBeginQuery(GL_TIME_ELAPSED, transparency.queries[transparency.frame % 2]);
+	glDepthMask(GL_FALSE);
+
+	if (transparency.mode == OIT_WEIGHTED)
+	{
+		// Sums start at zero and products of 1 - alpha at one.
+		glBindFramebuffer(GL_FRAMEBUFFER, transparency.framebuffers[WEIGHTED]);
+		glClearBufferfv(GL_COLOR, 0, zeros);
+		glClearBufferfv(GL_COLOR, 1, ones);
+		glEnable(GL_BLEND);
+		glBlendFunci(0, GL_ONE, GL_ONE);
+		glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+	}
+	else if (transparency.mode == OIT_LINKED_LIST)
+	{
+		// Empty every list, index 0 meaning none, and restart the node counter.
+		if (GLEW_ARB_clear_texture)
+			glClearTexImage(transparency.headTexture, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		else
+		{
+			std::vector<unsigned int> heads(transparency.width * transparency.height, 0);
+			glBindTexture(GL_TEXTURE_2D, transparency.headTexture);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, transparency.width, transparency.height, GL_RED_INTEGER,
+				            GL_UNSIGNED_INT, &heads[0]);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+		glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, transparency.buffers[COUNTER]);
+		glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(unsigned int), &zero);
+
+		glBindImageTexture(0, transparency.headTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+		glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, transparency.buffers[COUNTER]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, transparency.buffers[NODES]);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		// Fragments are only listed, against the opaque depths.
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDisable(GL_BLEND);
+	}
+	else
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	glUseProgram(transparency.programs[transparency.mode]);
+	return transparency.programs[transparency.mode];
+}
+
+// Routine to composite the translucent surfaces over the opaque ones and copy the result
+// to the window, timing it with the translucent pass and reporting the time every
+// OIT_REPORT_FRAMES frames.
+void endTransparency(Transparency &transparency)
+{
+	GLuint64 elapsed;
+
+	if (transparency.mode == OIT_WEIGHTED)
+	{
+		// Average color = weighted sum / sum of weights, with coverage 1 - product of 1 - alpha.
+		glBindFramebuffer(GL_FRAMEBUFFER, transparency.framebuffers[OPAQUE]);
+		glDisable(GL_DEPTH_TEST);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glUseProgram(transparency.compositeProgramId);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, transparency.textures[ACCUM]);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, transparency.textures[REVEALAGE]);
+		glBindVertexArray(transparency.vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glActiveTexture(GL_TEXTURE0);
+		glEnable(GL_DEPTH_TEST);
+	}
+	else if (transparency.mode == OIT_LINKED_LIST)
+	{
+		// Sort each pixel's list and blend it, already premultiplied, over the opaque color.
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		glUseProgram(transparency.resolveProgramId);
+		glBindVertexArray(transparency.vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glEnable(GL_DEPTH_TEST);
+	}
+	glBindVertexArray(0);
+	glEndQuery(GL_TIME_ELAPSED);
+
+	// Copy the image to the window.
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, transparency.framebuffers[OPAQUE]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, transparency.width, transparency.height, 0, 0, transparency.width, transparency.height,
+		              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Read the last frame's time, which is ready by now or nearly.
+	if (transparency.frame > 0)
+	{
+		glGetQueryObjectui64v(transparency.queries[(transparency.frame + 1) % 2], GL_QUERY_RESULT, &elapsed);
+		transparency.gpuTime += elapsed / 1.0e6;
+		if (++transparency.numTimed == OIT_REPORT_FRAMES)
+		{
+			std::cout << transparencyModeName(transparency.mode) << ": "
+				      << transparency.gpuTime / transparency.numTimed << " ms drawing translucent surfaces."
+				      << std::endl;
+			transparency.numTimed = 0;
+			transparency.gpuTime = 0.0;
+		}
+	}
+	transparency.frame++;
+}
+
+// Routine to switch to a mode, restarting the timing.
+void setTransparencyMode(Transparency &transparency, int mode)
+{
+	transparency.mode = mode;
+	transparency.frame = transparency.numTimed = 0;
+	transparency.gpuTime = 0.0;
+}
+
+// Name of a mode.
+const char *transparencyModeName(int mode)
+{
+	static const char *names[] = {"Blended in order", "Weighted blended OIT", "Linked list OIT"};
+	return names[mode];
+}
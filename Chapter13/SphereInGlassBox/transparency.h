@@ -0,0 +1,70 @@
+#ifndef TRANSPARENCY_H
+#define TRANSPARENCY_H
+
+#define OIT_MAX_LAYERS 48 // Most translucent fragments of a pixel the linked list blends.
+#define OIT_NODES_PER_PIXEL 16 // Linked list nodes allotted per pixel on average.
+#define OIT_REPORT_FRAMES 100 // Frames timed per report.
+
+// Ways of drawing translucent surfaces.
+enum TransparencyMode
+{
+	OIT_IN_ORDER, // Blended in the order drawn, correct only if drawn back to front.
+	OIT_WEIGHTED, // Weighted blended: a single pass, approximate.
+	OIT_LINKED_LIST, // Per-pixel linked lists, sorted when resolved: exact.
+	OIT_NUM_MODES
+};
+
+// Order-independent transparency. The opaque surfaces are drawn first, into a framebuffer
+// object whose depth texture the translucent surfaces are then depth tested against
+// without writing it, and the translucent surfaces are drawn in any order.
+//
+// Weighted blended transparency sums each translucent fragment's premultiplied color,
+// weighted by its alpha and depth, into one floating-point target, and multiplies its
+// 1 - alpha into another, and a full-window pass divides out the weights and composites
+// the average over the opaque image: constant cost, but only an approximation where
+// surfaces differ much in alpha.
+//
+// Per-pixel linked lists instead append each translucent fragment to a storage buffer of
+// nodes, the next free node given by an atomic counter, and swap it into the head of its
+// pixel's list, an image of node indices. A full-window pass then sorts each pixel's
+// list by depth and blends it front to back over the opaque image: exact, up to
+// OIT_MAX_LAYERS fragments a pixel, the nearest kept, and as many fragments in all as
+// the node buffer holds, further fragments being dropped.
+//
+// The application provides one vertex shader and one fragment shader defining
+// vec4 shade(void), the lit color of a fragment with its alpha, and the translucent
+// programs of each mode link these with a main() of their own. Their uniforms are given
+// explicit locations by the application, so that the same locations serve every
+// program, and are set on whichever program is current.
+//
+// The GPU time of the translucent surfaces and of compositing them is measured with
+// timer queries, read a frame late so as not to stall.
+struct Transparency
+{
+	int mode; // A TransparencyMode.
+	int width, height; // Size of the targets.
+	unsigned int programs[OIT_NUM_MODES]; // Translucent programs, by mode.
+	unsigned int compositeProgramId, resolveProgramId; // Full-window passes of the two OIT modes.
+	unsigned int textures[4]; // Opaque color, depth, weighted accumulation and revealage.
+	unsigned int framebuffers[2]; // Opaque and weighted accumulation framebuffers.
+	unsigned int headTexture; // Head node of each pixel's list.
+	unsigned int buffers[2]; // Node and atomic counter buffers.
+	unsigned int maxNodesLoc; // Uniform location.
+	int maxNodes; // Nodes the node buffer holds.
+	unsigned int vao; // Empty vertex array of the full-window passes.
+	unsigned int queries[2]; // Timer queries of this frame and the last.
+	int frame; // Frames drawn.
+	int numTimed; // Frames timed since the last report.
+	double gpuTime; // Their translucent GPU time in ms.
+};
+
+void createTransparency(Transparency &transparency, unsigned int vertexShaderId, unsigned int shadeShaderId,
+	                    int width, int height);
+void resizeTransparency(Transparency &transparency, int width, int height);
+unsigned int beginOpaque(Transparency &transparency);
+unsigned int beginTranslucent(Transparency &transparency);
+void endTransparency(Transparency &transparency);
+void setTransparencyMode(Transparency &transparency, int mode);
+const char *transparencyModeName(int mode);
+
+#endif
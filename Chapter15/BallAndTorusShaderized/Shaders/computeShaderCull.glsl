@@ -0,0 +1,55 @@
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+struct Object
+{
+   mat4 modelViewMat;
+   vec4 color;
+   vec4 bounds;
+   uvec4 range; // Index count, first index and base vertex of its mesh.
+};
+
+struct DrawCommand
+{
+   uint count;
+   uint instanceCount;
+   uint firstIndex;
+   int baseVertex;
+   uint baseInstance;
+};
+
+layout(std430, binding=0) readonly buffer Objects
+{
+   Object objects[];
+};
+
+layout(std430, binding=1) writeonly buffer Commands
+{
+   DrawCommand commands[];
+};
+
+uniform vec4 planes[6]; // Eye-space frustum planes, normals pointing inward.
+uniform uint numObjects;
+
+void main(void)
+{
+   uint i = gl_GlobalInvocationID.x;
+   if (i >= numObjects) return;
+
+   // Bounding sphere in eye space, its radius scaled by the largest scale of the modelview matrix.
+   mat4 modelViewMat = objects[i].modelViewMat;
+   vec4 center = modelViewMat * vec4(objects[i].bounds.xyz, 1.0);
+   float scale = max(length(modelViewMat[0].xyz), max(length(modelViewMat[1].xyz), length(modelViewMat[2].xyz)));
+   float radius = objects[i].bounds.w * scale;
+
+   uint visible = 1;
+   for (int j = 0; j < 6; j++)
+      if (dot(planes[j].xyz, center.xyz) + planes[j].w < -radius) visible = 0;
+
+   commands[i].count = objects[i].range.x;
+   commands[i].instanceCount = visible;
+   commands[i].firstIndex = objects[i].range.y;
+   commands[i].baseVertex = int(objects[i].range.z);
+   commands[i].baseInstance = i;
+}
@@ -1,15 +1,10 @@
 #version 430 core
 
-#define SPHERE 0
-#define TORUS 1
-
-uniform uint object;
-uniform vec4 sphColor, torColor;
+flat in vec4 colorsExport;
 
 out vec4 colorsOut;
 
 void main(void)
 {
-   if (object == SPHERE) colorsOut = sphColor; 
-   if (object == TORUS) colorsOut = torColor;
-}
\ No newline at end of file
+   colorsOut = colorsExport;
+}
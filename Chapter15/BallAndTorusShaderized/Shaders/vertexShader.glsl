@@ -1,21 +1,27 @@
 #version 430 core
 
-#define SPHERE 0
-#define TORUS 1
+struct Object
+{
+   mat4 modelViewMat;
+   vec4 color;
+   vec4 bounds;
+   uvec4 range;
+};
+
+layout(location=0) in vec4 coords;
+layout(location=1) in uint objectId;
 
-layout(location=0) in vec4 sphCoords;
-layout(location=1) in vec4 torCoords;
+layout(std430, binding=0) readonly buffer Objects
+{
+   Object objects[];
+};
 
 uniform mat4 projMat;
-uniform mat4 modelViewMat;
-uniform uint object;
 
-vec4 coords;
+flat out vec4 colorsExport;
 
 void main(void)
 {
-   if (object == SPHERE) coords = sphCoords;
-   if (object == TORUS) coords = torCoords;
-   
-   gl_Position = projMat * modelViewMat * coords;
+   gl_Position = projMat * objects[objectId].modelViewMat * coords;
+   colorsExport = objects[objectId].color;
 }
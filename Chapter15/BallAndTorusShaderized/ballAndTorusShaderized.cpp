@@ -3,10 +3,16 @@
 //
 // Forward-compatible core GL 4.3 version of ballAndTorus.cpp.
 //
+// The torus and any number of balls spaced evenly around it are drawn by a
+// SceneRenderer with a single glMultiDrawElementsIndirect() call, whose commands
+// are written by a frustum-culling compute shader or, with culling off, on the CPU.
+//
 // Interaction:
 // Press space to toggle between animation on and off.
 // Press the up/down arrow keys to speed up/slow down animation.
 // Press the x, X, y, Y, z, Z keys to rotate the scene.
+// Press +/- to add/remove a ball.
+// Press c to toggle frustum culling on the GPU on and off.
 //
 // Sumanta Guha
 //////////////////////////////////////////////////////////////// 
@@ -23,13 +29,15 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "prepShader.h"
+#include "sceneRenderer.h"
 #include "sphere.h"
 #include "torus.h"
 
 using namespace glm;
 
-static enum object {SPHERE, TORUS}; // VAO ids.
-static enum buffer {SPH_VERTICES, SPH_INDICES, TOR_VERTICES, TOR_INDICES}; // VBO ids.
+#define MAX_BALLS 64 // Most balls around the torus.
+
+static enum mesh {SPHERE, TORUS}; // Mesh ids.
 
 // Globals.
 static float latAngle = 0.0; // Latitudinal angle.
@@ -37,6 +45,7 @@ static float longAngle = 0.0; // Longitudinal angle.
 static float Xangle = 0.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate scene.
 static int isAnimate = 0; // Animated?
 static int animationPeriod = 100; // Time interval between frames.
+static int numBalls = 1; // Number of balls.
 
 // Sphere data.
 static Vertex sphVertices[(SPH_LONGS + 1) * (SPH_LATS + 1)]; 
@@ -54,17 +63,7 @@ static vec4 torColors = vec4(TOR_COLORS);
 
 static mat4 modelViewMat, projMat;
 
-static unsigned int
-   programId,
-   vertexShaderId,
-   fragmentShaderId,
-   modelViewMatLoc,
-   projMatLoc,
-   objectLoc,
-   sphColorLoc,
-   torColorLoc,
-   buffer[4], 
-   vao[2]; 
+static SceneRenderer scene; // Renderer of the torus and balls.
 
 // Initialization routine.
 void setup(void) 
@@ -72,55 +71,18 @@ void setup(void)
    glClearColor(1.0, 1.0, 1.0, 0.0); 
    glEnable(GL_DEPTH_TEST);
 
-   // Create shader program executable.
-   vertexShaderId = setShader("vertex", "Shaders/vertexShader.glsl");
-   fragmentShaderId = setShader("fragment", "Shaders/fragmentShader.glsl");
-   programId = glCreateProgram(); 
-   glAttachShader(programId, vertexShaderId); 
-   glAttachShader(programId, fragmentShaderId);    
-   glLinkProgram(programId); 
-   glUseProgram(programId); 
-
    // Initialize shpere and torus.
    fillSphere(sphVertices, sphIndices, sphCounts, sphOffsets);
    fillTorus(torVertices, torIndices, torCounts, torOffsets);
 
-   // Create VAOs and VBOs... 
-   glGenVertexArrays(2, vao);
-   glGenBuffers(4, buffer); 
-
-   // ...and associate sphere data with vertex shader.
-   glBindVertexArray(vao[SPHERE]);  
-   glBindBuffer(GL_ARRAY_BUFFER, buffer[SPH_VERTICES]);
-   glBufferData(GL_ARRAY_BUFFER, sizeof(sphVertices), sphVertices, GL_STATIC_DRAW);
-   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[SPH_INDICES]);
-   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(sphIndices), sphIndices, GL_STATIC_DRAW);
-   glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-   glEnableVertexAttribArray(0);
-
-   // ...and associate torus data with vertex shader.
-   glBindVertexArray(vao[TORUS]);
-   glBindBuffer(GL_ARRAY_BUFFER, buffer[TOR_VERTICES]);
-   glBufferData(GL_ARRAY_BUFFER, sizeof(torVertices), torVertices, GL_STATIC_DRAW);
-   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[TOR_INDICES]);
-   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(torIndices), torIndices, GL_STATIC_DRAW);
-   glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-   glEnableVertexAttribArray(1);
-
-   // Obtain projection matrix uniform location and set value.
-   projMatLoc = glGetUniformLocation(programId,"projMat"); 
-   projMat = frustum(-5.0, 5.0, -5.0, 5.0, 5.0, 100.0); 
-   glUniformMatrix4fv(projMatLoc, 1, GL_FALSE, value_ptr(projMat));
-
-   // Obtain color uniform locations and set values.
-   sphColorLoc = glGetUniformLocation(programId, "sphColor");
-   glUniform4fv(sphColorLoc, 1, &sphColors[0]);
-   torColorLoc = glGetUniformLocation(programId, "torColor");
-   glUniform4fv(torColorLoc, 1, &torColors[0]);
+   // Pack both meshes into the shared buffers, then add the torus and the balls.
+   addSceneMesh(scene, sphVertices, (SPH_LONGS + 1) * (SPH_LATS + 1), &sphIndices[0][0], sphCounts, SPH_LATS);
+   addSceneMesh(scene, torVertices, (TOR_LONGS + 1) * (TOR_LATS + 1), &torIndices[0][0], torCounts, TOR_LATS);
+   addSceneObject(scene, TORUS, torColors);
+   for (int i = 0; i < numBalls; i++) addSceneObject(scene, SPHERE, sphColors);
+   createSceneRenderer(scene, 1 + MAX_BALLS);
 
-   // Obtain modelview matrix uniform and object uniform locations.
-   modelViewMatLoc = glGetUniformLocation(programId,"modelViewMat"); 
-   objectLoc = glGetUniformLocation(programId, "object");
+   projMat = frustum(-5.0, 5.0, -5.0, 5.0, 5.0, 100.0); 
 
    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 }
@@ -137,24 +99,23 @@ void drawScene(void)
    modelViewMat = rotate(modelViewMat, radians(Yangle), vec3(0.0, 1.0, 0.0));
    modelViewMat = rotate(modelViewMat, radians(Xangle), vec3(1.0, 0.0, 0.0));
 
-   // Draw torus.
-   glUniform1ui(objectLoc, TORUS); // Update object name.
-   glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat)); // Update modelview matrix.
-   glBindVertexArray(vao[TORUS]);
-   glMultiDrawElements(GL_TRIANGLE_STRIP, torCounts, GL_UNSIGNED_INT, (const void **)torOffsets, TOR_LATS);
+   // Torus.
+   scene.objects[0].modelViewMat = modelViewMat;
 
-   // Calculate modelview matrix.
-   modelViewMat = rotate(modelViewMat, radians(longAngle), vec3(0.0, 0.0, 1.0));
-   modelViewMat = translate(modelViewMat, vec3(12.0, 0.0, 0.0));
-   modelViewMat = rotate(modelViewMat, radians(latAngle), vec3(0.0, 1.0, 0.0));
-   modelViewMat = translate(modelViewMat, vec3(-12.0, 0.0, 0.0));
-   modelViewMat = translate(modelViewMat, vec3(20.0, 0.0, 0.0));
-   
-   // Draw ball.
-   glUniform1ui(objectLoc, SPHERE); // Update object name.
-   glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat)); // Update modelview matrix.
-   glBindVertexArray(vao[SPHERE]);
-   glMultiDrawElements(GL_TRIANGLE_STRIP, sphCounts, GL_UNSIGNED_INT, (const void **)sphOffsets, SPH_LATS);
+   // Balls, spaced evenly around the torus.
+   for (int i = 0; i < numBalls; i++)
+   {
+      mat4 ballMat = modelViewMat;
+      ballMat = rotate(ballMat, radians(longAngle + i * 360.0f / numBalls), vec3(0.0, 0.0, 1.0));
+      ballMat = translate(ballMat, vec3(12.0, 0.0, 0.0));
+      ballMat = rotate(ballMat, radians(latAngle), vec3(0.0, 1.0, 0.0));
+      ballMat = translate(ballMat, vec3(-12.0, 0.0, 0.0));
+      ballMat = translate(ballMat, vec3(20.0, 0.0, 0.0));
+      scene.objects[1 + i].modelViewMat = ballMat;
+   }
+
+   // Draw all of them in a single call.
+   drawSceneObjects(scene, projMat);
 
    glutSwapBuffers();
 }
@@ -226,6 +187,27 @@ void keyInput(unsigned char key, int x, int y)
 		 if (Zangle < 0.0) Zangle += 360.0;
          glutPostRedisplay();
          break;
+      case '+':
+         if (numBalls < MAX_BALLS)
+         {
+            addSceneObject(scene, SPHERE, sphColors);
+            numBalls++;
+         }
+         glutPostRedisplay();
+         break;
+      case '-':
+         if (numBalls > 0)
+         {
+            scene.objects.pop_back();
+            numBalls--;
+         }
+         glutPostRedisplay();
+         break;
+      case 'c':
+         scene.gpuCulling = !scene.gpuCulling;
+         std::cout << "Frustum culling on the GPU " << (scene.gpuCulling ? "on." : "off.") << std::endl;
+         glutPostRedisplay();
+         break;
       default:
          break;
    }
@@ -245,7 +227,9 @@ void printInteraction(void)
    std::cout << "Interaction:" << std::endl;
    std::cout << "Press space to toggle between animation on and off." << std::endl
 	    << "Press the up/down arrow keys to speed up/slow down animation." << std::endl
-        << "Press the x, X, y, Y, z, Z keys to rotate the scene." << std::endl;
+        << "Press the x, X, y, Y, z, Z keys to rotate the scene." << std::endl
+        << "Press +/- to add/remove a ball." << std::endl
+        << "Press c to toggle frustum culling on the GPU on and off." << std::endl;
 }
 
 // Main routine.
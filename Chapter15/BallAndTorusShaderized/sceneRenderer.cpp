@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <iostream>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "prepShader.h"
+#include "sceneRenderer.h"
+
+static enum buffer {VERTICES, INDICES, OBJECT_IDS, OBJECTS, COMMANDS}; // Buffer ids.
+
+// Append a mesh of numStrips triangle strips, the i-th strip being counts[i] of the
+// indices, which follow one another, into the vertices, returning the mesh's index.
+int addSceneMesh(SceneRenderer &scene, const Vertex *vertices, int numVertices,
+                 const unsigned int *indices, const int *counts, int numStrips)
+{
+   SceneMesh mesh;
+   glm::vec3 low, high, center;
+   float radius = 0.0;
+   int i, j;
+
+   mesh.baseVertex = scene.vertices.size();
+   mesh.firstIndex = scene.indices.size();
+   scene.vertices.insert(scene.vertices.end(), vertices, vertices + numVertices);
+   for (i = 0; i < numStrips; i++)
+   {
+      if (i > 0) scene.indices.push_back(SCENE_RESTART_INDEX);
+      scene.indices.insert(scene.indices.end(), indices, indices + counts[i]);
+      indices += counts[i];
+   }
+   mesh.count = scene.indices.size() - mesh.firstIndex;
+
+   // Bounding sphere about the center of the bounding box.
+   low = high = glm::vec3(vertices[0].coords.x, vertices[0].coords.y, vertices[0].coords.z);
+   for (i = 1; i < numVertices; i++)
+      for (j = 0; j < 3; j++)
+      {
+         low[j] = std::min(low[j], vertices[i].coords[j]);
+         high[j] = std::max(high[j], vertices[i].coords[j]);
+      }
+   center = 0.5f * (low + high);
+   for (i = 0; i < numVertices; i++)
+      radius = std::max(radius, glm::length(glm::vec3(vertices[i].coords.x, vertices[i].coords.y,
+                                                      vertices[i].coords.z) - center));
+   mesh.bounds = glm::vec4(center, radius);
+
+   scene.meshes.push_back(mesh);
+   return scene.meshes.size() - 1;
+}
+
+// Add an object drawing the mesh in the color with an identity modelview matrix,
+// returning the object's index.
+int addSceneObject(SceneRenderer &scene, int mesh, const glm::vec4 &color)
+{
+   SceneObject object;
+
+   object.modelViewMat = glm::mat4(1.0);
+   object.color = color;
+   object.bounds = scene.meshes[mesh].bounds;
+   object.count = scene.meshes[mesh].count;
+   object.firstIndex = scene.meshes[mesh].firstIndex;
+   object.baseVertex = scene.meshes[mesh].baseVertex;
+   object.pad = 0;
+   scene.objects.push_back(object);
+   return scene.objects.size() - 1;
+}
+
+// Create the programs and buffers for up to maxObjects objects, once the meshes are added.
+void createSceneRenderer(SceneRenderer &scene, int maxObjects)
+{
+   unsigned int vertexShaderId, fragmentShaderId, computeShaderId;
+   std::vector<unsigned int> objectIds(maxObjects);
+   int i;
+
+   scene.maxObjects = maxObjects;
+   scene.gpuCulling = true;
+   scene.commands.resize(maxObjects);
+
+   // Create shader program executables.
+   vertexShaderId = setShader("vertex", "Shaders/vertexShader.glsl");
+   fragmentShaderId = setShader("fragment", "Shaders/fragmentShader.glsl");
+   scene.programId = glCreateProgram();
+   glAttachShader(scene.programId, vertexShaderId);
+   glAttachShader(scene.programId, fragmentShaderId);
+   glLinkProgram(scene.programId);
+   scene.projMatLoc = glGetUniformLocation(scene.programId, "projMat");
+
+   computeShaderId = setShader("compute", "Shaders/computeShaderCull.glsl");
+   scene.cullProgramId = glCreateProgram();
+   glAttachShader(scene.cullProgramId, computeShaderId);
+   glLinkProgram(scene.cullProgramId);
+   scene.planesLoc = glGetUniformLocation(scene.cullProgramId, "planes");
+   scene.numObjectsLoc = glGetUniformLocation(scene.cullProgramId, "numObjects");
+
+   // Create VAO and buffers...
+   glGenVertexArrays(1, scene.vao);
+   glGenBuffers(5, scene.buffer);
+
+   // ...and associate the shared mesh data with the vertex shader...
+   glBindVertexArray(scene.vao[0]);
+   glBindBuffer(GL_ARRAY_BUFFER, scene.buffer[VERTICES]);
+   glBufferData(GL_ARRAY_BUFFER, scene.vertices.size() * sizeof(Vertex), &scene.vertices[0], GL_STATIC_DRAW);
+   glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+   glEnableVertexAttribArray(0);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.buffer[INDICES]);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, scene.indices.size() * sizeof(unsigned int), &scene.indices[0],
+                GL_STATIC_DRAW);
+
+   // ...and the object ids, one per instance, so that the base instance of a command
+   // selects its object.
+   for (i = 0; i < maxObjects; i++) objectIds[i] = i;
+   glBindBuffer(GL_ARRAY_BUFFER, scene.buffer[OBJECT_IDS]);
+   glBufferData(GL_ARRAY_BUFFER, maxObjects * sizeof(unsigned int), &objectIds[0], GL_STATIC_DRAW);
+   glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(unsigned int), 0);
+   glVertexAttribDivisor(1, 1);
+   glEnableVertexAttribArray(1);
+   glBindVertexArray(0);
+
+   // Reserve the object and command buffers.
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, scene.buffer[OBJECTS]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, maxObjects * sizeof(SceneObject), NULL, GL_DYNAMIC_DRAW);
+   glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene.buffer[COMMANDS]);
+   glBufferData(GL_DRAW_INDIRECT_BUFFER, maxObjects * sizeof(DrawCommand), NULL, GL_DYNAMIC_DRAW);
+
+   glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+}
+
+// Draw all the objects with the projection matrix in one call.
+void drawSceneObjects(SceneRenderer &scene, const glm::mat4 &projMat)
+{
+   int numObjects = std::min((int)scene.objects.size(), scene.maxObjects), i, j;
+   glm::vec4 planes[6];
+
+   if (numObjects == 0) return;
+
+   // Upload the objects.
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, scene.buffer[OBJECTS]);
+   glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, numObjects * sizeof(SceneObject), &scene.objects[0]);
+
+   if (scene.gpuCulling)
+   {
+      // Eye-space frustum planes from the rows of the projection matrix.
+      for (i = 0; i < 3; i++)
+         for (j = 0; j < 4; j++)
+         {
+            planes[2 * i][j] = projMat[j][3] + projMat[j][i];
+            planes[2 * i + 1][j] = projMat[j][3] - projMat[j][i];
+         }
+      for (i = 0; i < 6; i++) planes[i] = planes[i] / glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+
+      // Write a command per object, drawing it only if its bounding sphere meets the frustum.
+      glUseProgram(scene.cullProgramId);
+      glUniform4fv(scene.planesLoc, 6, &planes[0][0]);
+      glUniform1ui(scene.numObjectsLoc, numObjects);
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scene.buffer[COMMANDS]);
+      glDispatchCompute((numObjects + SCENE_GROUP_SIZE - 1) / SCENE_GROUP_SIZE, 1, 1);
+      glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+   }
+   else
+   {
+      for (i = 0; i < numObjects; i++)
+      {
+         scene.commands[i].count = scene.objects[i].count;
+         scene.commands[i].instanceCount = 1;
+         scene.commands[i].firstIndex = scene.objects[i].firstIndex;
+         scene.commands[i].baseVertex = scene.objects[i].baseVertex;
+         scene.commands[i].baseInstance = i;
+      }
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene.buffer[COMMANDS]);
+      glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, numObjects * sizeof(DrawCommand), &scene.commands[0]);
+   }
+
+   glUseProgram(scene.programId);
+   glUniformMatrix4fv(scene.projMatLoc, 1, GL_FALSE, glm::value_ptr(projMat));
+   glBindVertexArray(scene.vao[0]);
+   glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene.buffer[COMMANDS]);
+   glMultiDrawElementsIndirect(GL_TRIANGLE_STRIP, GL_UNSIGNED_INT, 0, numObjects, 0);
+   glBindVertexArray(0);
+}
@@ -0,0 +1,66 @@
+#ifndef SCENERENDERER_H
+#define SCENERENDERER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.h"
+
+#define SCENE_RESTART_INDEX 0xFFFFFFFF // Index separating the strips of a mesh.
+#define SCENE_GROUP_SIZE 64 // Objects culled per compute shader work group.
+
+// A mesh's range of the shared buffers and its bounding sphere.
+struct SceneMesh
+{
+   unsigned int count, firstIndex, baseVertex; // Index count and offsets in the shared buffers.
+   glm::vec4 bounds; // Center and radius of a sphere enclosing it.
+};
+
+// An object as laid out in the shader storage buffer (std430).
+struct SceneObject
+{
+   glm::mat4 modelViewMat; // Modelview matrix.
+   glm::vec4 color; // Color.
+   glm::vec4 bounds; // Bounding sphere of its mesh.
+   unsigned int count, firstIndex, baseVertex, pad; // Its mesh's range of the shared buffers.
+};
+
+// A draw command of glMultiDrawElementsIndirect().
+struct DrawCommand
+{
+   unsigned int count, instanceCount, firstIndex;
+   int baseVertex;
+   unsigned int baseInstance;
+};
+
+// Draws any number of objects, each an instance of one of a set of meshes made of
+// triangle strips, with a single glMultiDrawElementsIndirect() call. The meshes share
+// one vertex and one index buffer, their strips joined by primitive restart, and every
+// object's data is in a shader storage buffer. Each object has a draw command of its
+// own whose base instance is its index, which the vertex shader receives through an
+// instanced attribute and uses to read the object's data. The commands are written
+// either on the CPU, every object drawn, or by a compute shader that zeroes the
+// instance count of objects outside the view frustum.
+struct SceneRenderer
+{
+   std::vector<Vertex> vertices; // Vertices of all meshes.
+   std::vector<unsigned int> indices; // Indices of all meshes.
+   std::vector<SceneMesh> meshes; // The meshes.
+   std::vector<SceneObject> objects; // The objects, whose matrices and colors may be changed.
+   bool gpuCulling; // If a compute shader culls objects and writes the commands.
+   int maxObjects; // Most objects the buffers hold.
+
+   unsigned int programId, cullProgramId; // Drawing and culling programs.
+   unsigned int projMatLoc, planesLoc, numObjectsLoc; // Uniform locations.
+   unsigned int vao[1], buffer[5]; // Vertex array and vertex, index, object id, object and command buffers.
+   std::vector<DrawCommand> commands; // Commands written on the CPU.
+};
+
+int addSceneMesh(SceneRenderer &scene, const Vertex *vertices, int numVertices,
+                 const unsigned int *indices, const int *counts, int numStrips);
+int addSceneObject(SceneRenderer &scene, int mesh, const glm::vec4 &color);
+void createSceneRenderer(SceneRenderer &scene, int maxObjects);
+void drawSceneObjects(SceneRenderer &scene, const glm::mat4 &projMat);
+
+#endif
@@ -11,9 +11,6 @@ struct Light
    vec4 specCols;
    vec4 coords;
 };
-uniform Light light0;
-
-uniform vec4 globAmb;
   
 struct Material
 {
@@ -23,7 +20,13 @@ struct Material
    vec4 emitCols;
    float shininess;
 };
-uniform Material planeFandB;
+
+layout(std140, binding=1) uniform Lighting
+{
+   Light light0;
+   vec4 globAmb;
+   Material planeFandB;
+};
 
 vec3 normal, lightDirection, eyeDirection, halfway;
 vec4 fAndBEmit, fAndBGlobAmb, fAndBAmb, fAndBDif, fAndBSpec;
@@ -1,22 +1,31 @@
 #version 430 core
 
+// Features, one program built for each combination used:
+// BUMP_MAPPED - the plane is lit with its bumped normals rather than its flat ones.
+
 layout(location=0) in vec4 planeCoords;
-layout(location=1) in vec3 planeNormal;
+#ifdef BUMP_MAPPED
 layout(location=2) in vec3 planeBumpedNormal;
+#else
+layout(location=1) in vec3 planeNormal;
+#endif
 
-uniform mat4 modelViewMat;
-uniform mat4 projMat;
-uniform mat3 normalMat;
-uniform uint isBumpMapped;
+layout(std140, binding=0) uniform Matrices
+{
+   mat4 modelViewMat;
+   mat4 projMat;
+   mat4 normalMat;
+};
 
 out vec3 normalExport;
 
-vec3 normal;
-
 void main(void)
 {   
-   normal = (isBumpMapped == 1)? planeBumpedNormal : planeNormal;
-   normalExport = normalMat * normal;
+#ifdef BUMP_MAPPED
+   normalExport = mat3(normalMat) * planeBumpedNormal;
+#else
+   normalExport = mat3(normalMat) * planeNormal;
+#endif
    
    gl_Position = projMat * modelViewMat * planeCoords;
 }
@@ -9,6 +9,10 @@
 // which implements per-vertex lighting. Only the associated 
 // shaders are different.
 //
+// The shaders are written once with an #ifdef for bump mapping,
+// and a program is specialized for each case rather than the
+// vertex shader branching on a uniform.
+//
 // Interaction:
 // Press space to toggle between bump mapping on and off.
 //
@@ -26,15 +30,17 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "prepShader.h"
 #include "plane.h"
 #include "light.h"
 #include "material.h"
+#include "shaderPermutations.h"
 
 using namespace glm;
 
 static enum object {PLANE}; // VAO ids.
-static enum buffer {PLANE_VERTICES, PLANE_INDICES}; // VBO ids.
+static enum buffer {PLANE_VERTICES, PLANE_INDICES, MATRICES, LIGHTING}; // Buffer ids.
+static enum feature {BUMP_MAPPED = 1}; // Shader features, by key bit.
+static const char *featureNames[] = {"BUMP_MAPPED"}; // Their macros, in the same order.
 
 // Globals.
 // Light properties.
@@ -56,7 +62,8 @@ static const Material planeFandB =
 	vec4(0.0, 0.5, 0.5, 1.0),
 	vec4(1.0, 1.0, 1.0, 1.0),
 	vec4(0.0, 0.0, 0.0, 1.0),
-	50.0
+	50.0,
+	{ 0.0, 0.0, 0.0 }
 };
 
 // Plane data.
@@ -65,18 +72,27 @@ static unsigned int planeIndices[PLANE_LATS][2*(PLANE_LONGS+1)];
 static int planeCounts[PLANE_LATS]; 
 static void* planeOffsets[PLANE_LATS]; 
 
+// Matrices block (std140), the normal matrix padded to a mat4.
+static struct
+{
+   mat4 modelViewMat, projMat, normalMat;
+} matrices;
+
+// Lighting block (std140).
+static struct
+{
+   Light light0;
+   vec4 globAmb;
+   Material planeFandB;
+} lighting;
+
 static mat4 modelViewMat, projMat;
 static mat3 normalMat;
 
+static ShaderPermutations permutations; // Programs with and without bump mapping.
+
 static unsigned int
-   programId,
-   vertexShaderId,
-   fragmentShaderId,
-   modelViewMatLoc,
-   projMatLoc,
-   normalMatLoc,
-   isBumpMappedLoc,
-   buffer[2], 
+   buffer[4], 
    vao[1]; 
 
 static uint isBumpMapped = 0; // Is bump mapping on?
@@ -87,21 +103,20 @@ void setup(void)
    glClearColor(1.0, 1.0, 1.0, 0.0); 
    glEnable(GL_DEPTH_TEST);
 
-   // Create shader program executable.
-   vertexShaderId = setShader("vertex", "Shaders/vertexShader.glsl");
-   fragmentShaderId = setShader("fragment", "Shaders/fragmentShader.glsl");
-   programId = glCreateProgram(); 
-   glAttachShader(programId, vertexShaderId); 
-   glAttachShader(programId, fragmentShaderId); 
-   glLinkProgram(programId); 
-   glUseProgram(programId);  
+   // Build, or load from the cache, the programs with and without bump mapping.
+   createShaderPermutations(permutations, "Shaders/vertexShader.glsl", "Shaders/fragmentShader.glsl",
+                            featureNames, 1, "Shaders/program");
+   getPermutation(permutations, 0);
+   getPermutation(permutations, BUMP_MAPPED);
+   std::cout << permutations.numCompiled << " programs compiled, " 
+             << permutations.numLoaded << " loaded from the cache." << std::endl;
 
    // Initialize plane.
    fillPlane(planeVertices, planeIndices, planeCounts, planeOffsets);
 
    // Create VAOs and VBOs...
    glGenVertexArrays(1, vao);
-   glGenBuffers(2, buffer); 
+   glGenBuffers(4, buffer); 
 
    // ,,,and associate plane data with vertex shader.
    glBindVertexArray(vao[PLANE]);
@@ -116,34 +131,19 @@ void setup(void)
    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bumpedNormal));
    glEnableVertexAttribArray(2);
 
-   // Obtain projection matrix uniform location and set value.
-   projMatLoc = glGetUniformLocation(programId,"projMat"); 
+   // Create the uniform blocks shared by both programs: the matrices, and the light
+   // and material, which never change.
    projMat = frustum(-5.0, 5.0, -5.0, 5.0, 5.0, 100.0); 
-   glUniformMatrix4fv(projMatLoc, 1, GL_FALSE, value_ptr(projMat));
-
-   // Obtain modelview matrix and normal matrix uniform locations.
-   modelViewMatLoc = glGetUniformLocation(programId,"modelViewMat"); 
-   normalMatLoc = glGetUniformLocation(programId,"normalMat"); 
-   
-   // Obtain isBumpMapped uniform location and set value.
-   isBumpMappedLoc = glGetUniformLocation(programId, "isBumpMapped");
-   glUniform1uiv(isBumpMappedLoc, 1, &isBumpMapped);
-
-   // Obtain light property uniform locations and set values.
-   glUniform4fv(glGetUniformLocation(programId, "light0.ambCols"), 1, &light0.ambCols[0]);
-   glUniform4fv(glGetUniformLocation(programId, "light0.difCols"), 1, &light0.difCols[0]);
-   glUniform4fv(glGetUniformLocation(programId, "light0.specCols"), 1, &light0.specCols[0]);
-   glUniform4fv(glGetUniformLocation(programId, "light0.coords"), 1, &light0.coords[0]);
-
-   // Obtain global ambient uniform location and set value.
-   glUniform4fv(glGetUniformLocation(programId, "globAmb"), 1, &globAmb[0]);
-
-   // Obtain material property uniform locations and set values.
-   glUniform4fv(glGetUniformLocation(programId, "planeFandB.ambRefl"), 1, &planeFandB.ambRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "planeFandB.difRefl"), 1, &planeFandB.difRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "planeFandB.specRefl"), 1, &planeFandB.specRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "planeFandB.emitCols"), 1, &planeFandB.emitCols[0]);
-   glUniform1f(glGetUniformLocation(programId, "planeFandB.shininess"), planeFandB.shininess);
+   matrices.projMat = projMat;
+   lighting.light0 = light0;
+   lighting.globAmb = globAmb;
+   lighting.planeFandB = planeFandB;
+   glBindBuffer(GL_UNIFORM_BUFFER, buffer[MATRICES]);
+   glBufferData(GL_UNIFORM_BUFFER, sizeof(matrices), &matrices, GL_DYNAMIC_DRAW);
+   glBindBufferBase(GL_UNIFORM_BUFFER, 0, buffer[MATRICES]);
+   glBindBuffer(GL_UNIFORM_BUFFER, buffer[LIGHTING]);
+   glBufferData(GL_UNIFORM_BUFFER, sizeof(lighting), &lighting, GL_STATIC_DRAW);
+   glBindBufferBase(GL_UNIFORM_BUFFER, 1, buffer[LIGHTING]);
 }
 
 // Drawing routine.
@@ -154,13 +154,16 @@ void drawScene(void)
    // Calculate and update modelview matrix.
    modelViewMat = mat4(1.0);
    modelViewMat = lookAt(vec3(0.0, 5.0, 30.0), vec3(0.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0));
-   glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat));
+   matrices.modelViewMat = modelViewMat;
 
    // Calculate and update normal matrix.
    normalMat = transpose(inverse(mat3(modelViewMat)));
-   glUniformMatrix3fv(normalMatLoc, 1, GL_FALSE, value_ptr(normalMat));
+   matrices.normalMat = mat4(normalMat);
+   glBindBuffer(GL_UNIFORM_BUFFER, buffer[MATRICES]);
+   glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), &matrices);
    
-   // Draw plane.
+   // Draw plane with the program for bump mapping or not.
+   usePermutation(permutations, isBumpMapped ? BUMP_MAPPED : 0);
    glMultiDrawElements(GL_TRIANGLE_STRIP, planeCounts, GL_UNSIGNED_INT, (const void **)planeOffsets, PLANE_LATS);
   
    glutSwapBuffers();
@@ -182,7 +185,6 @@ void keyInput(unsigned char key, int x, int y)
          break;
       case ' ':
 		 isBumpMapped = isBumpMapped? 0 : 1;
-		 glUniform1uiv(isBumpMappedLoc, 1, &isBumpMapped);
          glutPostRedisplay();
 		 break;
       default:
@@ -10,6 +10,7 @@ struct Material
    glm::vec4 specRefl;
    glm::vec4 emitCols;
    float shininess;
+   float pad[3]; // Pads the struct to the std140 size of the shaders' Material.
 };
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef SHADERPERMUTATIONS_H
+#define SHADERPERMUTATIONS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#define PERMUTATION_MAX_FEATURES 16 // Most features a set of permutations may have.
+
+// The programs specialized from one vertex and one fragment shader, each written once with
+// #ifdef blocks on a set of feature macros. A permutation is picked by a key whose bit i
+// is set to have features[i] defined, so that an object compiles in only the paths its
+// material needs, rather than every object branching at run time on which it is.
+//
+// Each permutation is built the first time it is asked for, by inserting its #defines
+// after the #version line of both sources, and kept for the rest of the run. Its binary
+// is also cached in a file, which later runs load instead of compiling as long as neither
+// source has changed since and the driver accepts it. As the programs of a set are
+// distinct, what they share, such as uniform blocks and sampler units, should be given
+// fixed bindings in the shaders rather than set program by program.
+struct ShaderPermutations
+{
+   std::string vertexFileName, fragmentFileName; // The annotated sources.
+   std::vector<std::string> features; // Feature macros, in key bit order.
+   std::string cacheFileName; // Binaries are cached in cacheFileName<key>.bin, none if empty.
+   std::map<unsigned int, unsigned int> programs; // Programs built, by key.
+   int numCompiled, numLoaded; // Permutations compiled from source and loaded from the cache.
+};
+
+void createShaderPermutations(ShaderPermutations &permutations, const std::string &vertexFileName,
+                              const std::string &fragmentFileName, const char **features, int numFeatures,
+                              const std::string &cacheFileName);
+unsigned int getPermutation(ShaderPermutations &permutations, unsigned int key);
+unsigned int usePermutation(ShaderPermutations &permutations, unsigned int key);
+
+#endif
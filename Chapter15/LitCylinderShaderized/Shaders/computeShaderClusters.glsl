@@ -0,0 +1,99 @@
+#version 430 core
+
+#define TILES_X 16
+#define TILES_Y 9
+#define SLICES 24
+#define MAX_LIGHTS 512
+#define GROUP_SIZE 128
+
+layout(local_size_x=GROUP_SIZE) in;
+
+struct PointLight
+{
+   vec4 coords;
+   vec4 cols;
+};
+
+layout(std140, binding=4) uniform Clusters
+{
+   mat4 invProjMat;
+   vec4 tiles;
+   vec4 slices;
+};
+
+layout(std430, binding=0) readonly buffer PointLights
+{
+   PointLight lights[];
+};
+
+layout(std430, binding=1) writeonly buffer ClusterCounts
+{
+   uint counts[];
+};
+
+layout(std430, binding=2) writeonly buffer ClusterIndices
+{
+   uint indices[];
+};
+
+uniform uint numLights;
+
+shared vec4 sharedCoords[GROUP_SIZE];
+
+// Eye-space point on the near plane at the window position.
+vec3 nearPoint(vec2 windowCoords)
+{
+   vec4 point = invProjMat * vec4(2.0 * windowCoords / tiles.zw - 1.0, -1.0, 1.0);
+   return point.xyz / point.w;
+}
+
+void main(void)
+{
+   uint cluster = gl_GlobalInvocationID.x;
+   uint tileX = cluster % TILES_X, tileY = (cluster / TILES_X) % TILES_Y, slice = cluster / (TILES_X * TILES_Y);
+   uint count = 0, first, i, j;
+   vec3 corners[4], low, high, closest;
+   vec4 light;
+   float nearZ, farZ;
+
+   // The corners of the cluster's tile on the near plane...
+   corners[0] = nearPoint(vec2(tileX, tileY) * tiles.xy);
+   corners[1] = nearPoint(vec2(tileX + 1, tileY) * tiles.xy);
+   corners[2] = nearPoint(vec2(tileX, tileY + 1) * tiles.xy);
+   corners[3] = nearPoint(vec2(tileX + 1, tileY + 1) * tiles.xy);
+
+   // ...are pushed along their lines of sight to the near and far depths of its slice,
+   // spaced evenly in log(depth), to box the cluster in eye space.
+   nearZ = -slices.x * exp(float(slice) / slices.y);
+   farZ = -slices.x * exp(float(slice + 1) / slices.y);
+   low = vec3(1.0e30);
+   high = vec3(-1.0e30);
+   for (i = 0; i < 4; i++)
+   {
+      low = min(low, min(corners[i] * (nearZ / corners[i].z), corners[i] * (farZ / corners[i].z)));
+      high = max(high, max(corners[i] * (nearZ / corners[i].z), corners[i] * (farZ / corners[i].z)));
+   }
+
+   // The work group reads the lights a batch at a time into shared memory, each cluster
+   // then listing those of the batch whose range meets its box.
+   for (first = 0; first < numLights; first += GROUP_SIZE)
+   {
+      i = first + gl_LocalInvocationIndex;
+      sharedCoords[gl_LocalInvocationIndex] = (i < numLights) ? lights[i].coords : vec4(0.0, 0.0, 1.0e30, 0.0);
+      barrier();
+
+      for (j = 0; j < min(uint(GROUP_SIZE), numLights - first); j++)
+      {
+         light = sharedCoords[j];
+         closest = clamp(light.xyz, low, high);
+         if (dot(closest - light.xyz, closest - light.xyz) <= light.w * light.w && count < MAX_LIGHTS)
+         {
+            indices[cluster * MAX_LIGHTS + count] = first + j;
+            count++;
+         }
+      }
+      barrier();
+   }
+
+   counts[cluster] = count;
+}
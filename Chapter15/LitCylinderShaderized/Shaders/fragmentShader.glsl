@@ -1,10 +1,115 @@
 #version 430 core
 
-in vec4 frontColsExport, backColsExport;
+#define TILES_X 16
+#define TILES_Y 9
+#define SLICES 24
+#define MAX_LIGHTS 512
+
+in vec3 eyeCoordsExport, normalExport;
 
 out vec4 colorsOut;
 
+struct Light
+{
+   vec4 ambCols;
+   vec4 difCols;
+   vec4 specCols;
+   vec4 coords;
+};
+  
+struct Material
+{
+   vec4 ambRefl;
+   vec4 difRefl;
+   vec4 specRefl;
+   vec4 emitCols;
+   float shininess;
+};
+
+struct PointLight
+{
+   vec4 coords;
+   vec4 cols;
+};
+
+layout(std140, binding=1) uniform Lights
+{
+   Light light0;
+   vec4 globAmb;
+};
+
+layout(std140, binding=2) uniform Materials
+{
+   Material cylFront, cylBack;
+};
+
+layout(std140, binding=4) uniform Clusters
+{
+   mat4 invProjMat;
+   vec4 tiles;
+   vec4 slices;
+};
+
+layout(std430, binding=0) readonly buffer PointLights
+{
+   PointLight lights[];
+};
+
+layout(std430, binding=1) readonly buffer ClusterCounts
+{
+   uint counts[];
+};
+
+layout(std430, binding=2) readonly buffer ClusterIndices
+{
+   uint indices[];
+};
+
+Material material;
+vec3 normal, eyeDirection;
+
+// Diffuse and specular terms of OpenGL's lighting equation for a light in the direction
+// with the colors.
+vec4 difSpec(vec3 lightDirection, vec4 difCols, vec4 specCols)
+{
+   vec3 halfway = (length(lightDirection + eyeDirection) == 0.0) ? 
+                  vec3(0.0) : normalize(lightDirection + eyeDirection);
+
+   return max(dot(normal, lightDirection), 0.0) * difCols * material.difRefl +
+          pow(max(dot(normal, halfway), 0.0), material.shininess) * specCols * material.specRefl;
+}
+
 void main(void)
 {
-   colorsOut = gl_FrontFacing? frontColsExport : backColsExport;
-}
\ No newline at end of file
+   uvec3 clusterCoords;
+   uint cluster, i;
+   vec4 cols;
+   vec3 toLight;
+   float dist, falloff;
+
+   // Back faces take the back material and the normal reversed.
+   material = gl_FrontFacing ? cylFront : cylBack;
+   normal = normalize(normalExport);
+   if (!gl_FrontFacing) normal = -1.0 * normal;
+   eyeDirection = -1.0 * normalize(eyeCoordsExport);
+
+   // Implementing OpenGL's lighting equation for light0.
+   cols = material.emitCols + globAmb * material.ambRefl + light0.ambCols * material.ambRefl +
+          difSpec(normalize(vec3(light0.coords)), light0.difCols, light0.specCols);
+
+   // Adding the point lights listed for the fragment's cluster, each falling off smoothly
+   // to nothing at its range.
+   clusterCoords.xy = min(uvec2(gl_FragCoord.xy / tiles.xy), uvec2(TILES_X - 1, TILES_Y - 1));
+   clusterCoords.z = uint(clamp(log(-eyeCoordsExport.z / slices.x) * slices.y, 0.0, SLICES - 1.0));
+   cluster = (clusterCoords.z * TILES_Y + clusterCoords.y) * TILES_X + clusterCoords.x;
+   for (i = 0; i < counts[cluster]; i++)
+   {
+      PointLight light = lights[indices[cluster * MAX_LIGHTS + i]];
+      toLight = light.coords.xyz - eyeCoordsExport;
+      dist = length(toLight);
+      falloff = clamp(1.0 - (dist * dist) / (light.coords.w * light.coords.w), 0.0, 1.0);
+      if (falloff > 0.0) cols += falloff * falloff * difSpec(toLight / dist, light.cols, light.cols);
+   }
+
+   colorsOut = vec4(vec3(min(cols, vec4(1.0))), 1.0);
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include <glm/glm.hpp>
+
+#include "prepShader.h"
+#include "clusteredLights.h"
+
+static enum buffer {LIGHTS, COUNTS, INDICES}; // Buffer ids.
+
+// Create the light assignment program and the buffers for up to maxLights lights.
+void createLightClusters(LightClusters &clusters, int maxLights)
+{
+   unsigned int computeShaderId;
+
+   clusters.maxLights = maxLights;
+   clusters.numLights = 0;
+
+   computeShaderId = setShader("compute", "Shaders/computeShaderClusters.glsl");
+   clusters.programId = glCreateProgram();
+   glAttachShader(clusters.programId, computeShaderId);
+   glLinkProgram(clusters.programId);
+   clusters.numLightsLoc = glGetUniformLocation(clusters.programId, "numLights");
+
+   // The lights, written by the CPU, and the cluster lists, written and read only by the GPU.
+   glGenBuffers(3, clusters.buffer);
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.buffer[LIGHTS]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, maxLights * sizeof(PointLight), NULL, GL_STREAM_DRAW);
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.buffer[COUNTS]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNT * sizeof(unsigned int), NULL, GL_DYNAMIC_COPY);
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.buffer[INDICES]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNT * CLUSTER_MAX_LIGHTS * sizeof(unsigned int), NULL,
+                GL_DYNAMIC_COPY);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_LIGHTS_BINDING, clusters.buffer[LIGHTS]);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNTS_BINDING, clusters.buffer[COUNTS]);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDICES_BINDING, clusters.buffer[INDICES]);
+
+   // No cluster lists a light until some are assigned.
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.buffer[COUNTS]);
+   glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+   clusters.isEmpty = 1;
+
+   clusters.constants.invProjMat = glm::mat4(1.0);
+   clusters.constants.tiles = clusters.constants.slices = glm::vec4(0.0);
+   createUniformBlock(clusters.block, CLUSTERS_BINDING, sizeof(ClusterConstants), &clusters.constants);
+}
+
+// Routine to fit the cluster grid to the projection, whose near and far planes are at
+// the distances given, and to the window, updating the block only if it changes.
+void setClusterView(LightClusters &clusters, const glm::mat4 &projMat, float nearDist, float farDist,
+                    int width, int height)
+{
+   ClusterConstants constants;
+
+   constants.invProjMat = glm::inverse(projMat);
+   width = std::max(width, 1);
+   height = std::max(height, 1);
+   constants.tiles = glm::vec4((width + CLUSTER_TILES_X - 1) / CLUSTER_TILES_X,
+                               (height + CLUSTER_TILES_Y - 1) / CLUSTER_TILES_Y, width, height);
+   constants.slices = glm::vec4(nearDist, CLUSTER_SLICES / log(farDist / nearDist), 0.0, 0.0);
+
+   if (constants.invProjMat != clusters.constants.invProjMat || constants.tiles != clusters.constants.tiles ||
+       constants.slices != clusters.constants.slices)
+   {
+      clusters.constants = constants;
+      updateUniformBlock(clusters.block, &clusters.constants);
+   }
+}
+
+// Upload the frame's lights, in eye space, orphaning the light buffer's previous contents
+// so that the GPU may still be reading them. Nothing is uploaded while there are none.
+void updatePointLights(LightClusters &clusters, const PointLight *lights, int numLights)
+{
+   numLights = std::max(std::min(numLights, clusters.maxLights), 0);
+   if (numLights == 0 && clusters.numLights == 0) return;
+   clusters.numLights = numLights;
+
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.buffer[LIGHTS]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, clusters.maxLights * sizeof(PointLight), NULL, GL_STREAM_DRAW);
+   if (clusters.numLights > 0)
+      glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, clusters.numLights * sizeof(PointLight), lights);
+}
+
+// Routine to list the uploaded lights meeting each cluster, for the draws to follow. With
+// no lights there is nothing to assign, only the counts of the last lights to clear.
+void assignClusterLights(LightClusters &clusters)
+{
+   if (clusters.numLights == 0)
+   {
+      if (!clusters.isEmpty)
+      {
+         glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.buffer[COUNTS]);
+         glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+         clusters.isEmpty = 1;
+      }
+      return;
+   }
+
+   glUseProgram(clusters.programId);
+   glUniform1ui(clusters.numLightsLoc, clusters.numLights);
+   glDispatchCompute(CLUSTER_COUNT / CLUSTER_GROUP_SIZE, 1, 1);
+   glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+   clusters.isEmpty = 0;
+}
+
+// Routine to read back the lights listed by the clusters, the mean over those listing any
+// and the most any lists, which waits for the GPU to finish assigning them.
+void countClusterLights(LightClusters &clusters, float &meanLights, int &mostLights)
+{
+   std::vector<unsigned int> counts(CLUSTER_COUNT);
+   int numListing = 0, total = 0;
+
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.buffer[COUNTS]);
+   glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, CLUSTER_COUNT * sizeof(unsigned int), &counts[0]);
+
+   mostLights = 0;
+   for (int i = 0; i < CLUSTER_COUNT; i++)
+      if (counts[i] > 0)
+      {
+         numListing++;
+         total += counts[i];
+         mostLights = std::max(mostLights, (int)counts[i]);
+      }
+   meanLights = (numListing > 0) ? (float)total / numListing : 0.0;
+}
@@ -0,0 +1,66 @@
+#ifndef CLUSTEREDLIGHTS_H
+#define CLUSTEREDLIGHTS_H
+
+#include <glm/glm.hpp>
+
+#include "frameConstants.h"
+
+#define CLUSTER_TILES_X 16 // Clusters across the window.
+#define CLUSTER_TILES_Y 9 // Clusters down the window.
+#define CLUSTER_SLICES 24 // Clusters in depth, between the near and far planes.
+#define CLUSTER_COUNT (CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES)
+#define CLUSTER_MAX_LIGHTS 512 // Most lights listed for one cluster.
+#define CLUSTER_GROUP_SIZE 128 // Clusters, and lights shared, per compute shader work group.
+
+// Binding points, matching the binding qualifiers of the shaders.
+#define CLUSTERS_BINDING 4 // Uniform block of the cluster grid.
+#define POINT_LIGHTS_BINDING 0 // Storage buffer of the point lights.
+#define CLUSTER_COUNTS_BINDING 1 // Storage buffer of each cluster's number of lights.
+#define CLUSTER_INDICES_BINDING 2 // Storage buffer of each cluster's light indices.
+
+// A point light as laid out in the shader storage buffer (std430).
+struct PointLight
+{
+   glm::vec4 coords; // Eye-space position, its range in w: it lights nothing further away.
+   glm::vec4 cols; // Diffuse and specular color.
+};
+
+// Cluster grid block (std140).
+struct ClusterConstants
+{
+   glm::mat4 invProjMat; // Inverse projection matrix.
+   glm::vec4 tiles; // Tile width and height, and window width and height, in pixels.
+   glm::vec4 slices; // Near distance and slices per unit of log(depth), the rest unused.
+};
+
+// Point lights shaded per fragment by clustered forward shading. The view frustum is
+// cut into CLUSTER_TILES_X x CLUSTER_TILES_Y tiles of the window and each tile into
+// CLUSTER_SLICES slices, thinner near the eye as depth is sliced evenly in log(depth).
+// A compute shader, run once a frame after the lights are uploaded, bounds each cluster
+// by a box in eye space and lists the lights whose range meets it, and a fragment then
+// finds its cluster from its window position and depth and shades with only the lights
+// listed there, so that thousands of lights cost each fragment the few near it.
+//
+// The lights are given in eye space, as light0 is, and each cluster lists at most
+// CLUSTER_MAX_LIGHTS of them, the rest being dropped. With no lights the compute shader
+// is not run at all, the clusters' counts being cleared once instead.
+struct LightClusters
+{
+   unsigned int programId; // Light assignment program.
+   unsigned int numLightsLoc; // Uniform location.
+   unsigned int buffer[3]; // Point light, cluster count and cluster index buffers.
+   UniformBlock block; // Cluster grid block.
+   ClusterConstants constants; // Its contents.
+   int maxLights; // Most lights the light buffer holds.
+   int numLights; // Lights uploaded.
+   int isEmpty; // Are the clusters' counts all zero?
+};
+
+void createLightClusters(LightClusters &clusters, int maxLights);
+void setClusterView(LightClusters &clusters, const glm::mat4 &projMat, float nearDist, float farDist,
+                    int width, int height);
+void updatePointLights(LightClusters &clusters, const PointLight *lights, int numLights);
+void assignClusterLights(LightClusters &clusters);
+void countClusterLights(LightClusters &clusters, float &meanLights, int &mostLights);
+
+#endif
@@ -0,0 +1,105 @@
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "frameConstants.h"
+
+// Create a uniform buffer of size bytes from the data and bind it at the binding point.
+void createUniformBlock(UniformBlock &block, unsigned int binding, int size, const void *data)
+{
+   block.binding = binding;
+   block.size = size;
+   glGenBuffers(1, &block.buffer);
+   glBindBuffer(GL_UNIFORM_BUFFER, block.buffer);
+   glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+   glBindBufferBase(GL_UNIFORM_BUFFER, binding, block.buffer);
+}
+
+// Replace the contents of a uniform block.
+void updateUniformBlock(const UniformBlock &block, const void *data)
+{
+   glBindBuffer(GL_UNIFORM_BUFFER, block.buffer);
+   glBufferSubData(GL_UNIFORM_BUFFER, 0, block.size, data);
+}
+
+// Create a ring of maxObjects object blocks per frame for the binding point.
+void createObjectRing(ObjectRing &ring, unsigned int binding, int maxObjects)
+{
+   int alignment, size;
+
+   glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+   ring.binding = binding;
+   ring.slotSize = (sizeof(ObjectConstants) + alignment - 1) / alignment * alignment;
+   ring.maxObjects = maxObjects;
+   ring.persistent = GLEW_ARB_buffer_storage != 0;
+   ring.mapped = ring.region = NULL;
+   ring.frame = 0;
+   for (int i = 0; i < FRAME_RING_FRAMES; i++) ring.fences[i] = NULL;
+
+   size = FRAME_RING_FRAMES * maxObjects * ring.slotSize;
+   glGenBuffers(1, &ring.buffer);
+   glBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+   if (ring.persistent)
+   {
+      GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      glBufferStorage(GL_UNIFORM_BUFFER, size, NULL, flags);
+      ring.mapped = (unsigned char *)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags);
+   }
+   else glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_STREAM_DRAW);
+}
+
+// Routine to wait, if need be, for the GPU to finish with the current frame's region
+// so that its object blocks can be written.
+void beginObjectRing(ObjectRing &ring)
+{
+   int regionSize = ring.maxObjects * ring.slotSize;
+   GLsync fence = (GLsync)ring.fences[ring.frame];
+
+   if (fence)
+   {
+      // Flush on the first wait so that the fence is sure to be signaled.
+      GLbitfield flags = 0;
+      while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+         flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+      glDeleteSync(fence);
+      ring.fences[ring.frame] = NULL;
+   }
+
+   if (ring.persistent) ring.region = ring.mapped + ring.frame * regionSize;
+   else
+   {
+      glBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+      ring.region = (unsigned char *)glMapBufferRange(GL_UNIFORM_BUFFER, ring.frame * regionSize, regionSize,
+         GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+   }
+}
+
+// An object's block of the current frame, to be written between beginObjectRing()
+// and commitObjectRing().
+ObjectConstants *ringObject(const ObjectRing &ring, int object)
+{
+   return (ObjectConstants *)(ring.region + object * ring.slotSize);
+}
+
+// Routine to make the frame's object blocks visible to the GPU once written.
+void commitObjectRing(ObjectRing &ring)
+{
+   if (ring.persistent) return; // Coherent: nothing to do.
+
+   glBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+   glUnmapBuffer(GL_UNIFORM_BUFFER);
+   ring.region = NULL;
+}
+
+// Bind an object's block of the current frame for the next draw.
+void bindRingObject(const ObjectRing &ring, int object)
+{
+   glBindBufferRange(GL_UNIFORM_BUFFER, ring.binding, ring.buffer,
+                     (ring.frame * ring.maxObjects + object) * ring.slotSize, sizeof(ObjectConstants));
+}
+
+// Routine to fence the current frame's region after its draws and move on to the next.
+void endObjectRing(ObjectRing &ring)
+{
+   ring.fences[ring.frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   ring.frame = (ring.frame + 1) % FRAME_RING_FRAMES;
+}
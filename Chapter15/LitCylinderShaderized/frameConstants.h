@@ -0,0 +1,87 @@
+#ifndef FRAMECONSTANTS_H
+#define FRAMECONSTANTS_H
+
+#include <glm/glm.hpp>
+
+#include "light.h"
+#include "material.h"
+
+#define FRAME_RING_FRAMES 3 // Frames of object data in flight.
+
+// Uniform block binding points, matching the binding qualifiers of the shaders.
+#define CAMERA_BINDING 0
+#define LIGHTS_BINDING 1
+#define MATERIALS_BINDING 2
+#define OBJECT_BINDING 3
+
+// Camera block (std140).
+struct CameraConstants
+{
+   glm::mat4 projMat; // Projection matrix.
+};
+
+// Lights block (std140).
+struct LightConstants
+{
+   Light light0; // The light.
+   glm::vec4 globAmb; // Global ambient.
+};
+
+// Materials block (std140).
+struct MaterialConstants
+{
+   Material front, back; // Front and back materials.
+};
+
+// Object block (std140), one per object per frame. The normal matrix is
+// stored as a mat4 as std140 pads each column of a mat3 to a vec4 anyway.
+struct ObjectConstants
+{
+   glm::mat4 modelViewMat; // Modelview matrix.
+   glm::mat4 normalMat; // Normal matrix.
+};
+
+// A uniform buffer holding one block, bound once at its binding point for every
+// program declaring the block with that binding, so that no program queries uniform
+// locations or sets the block's members one at a time.
+struct UniformBlock
+{
+   unsigned int buffer; // Buffer id.
+   unsigned int binding; // Binding point.
+   int size; // Size of the block.
+};
+
+// A ring of FRAME_RING_FRAMES regions of object blocks, each region written by the
+// CPU for one frame while the GPU may still be reading the regions of the frames
+// before it. Each region is fenced when its frame has been submitted and waited on
+// only when the ring comes round to it again, which, with three frames in flight,
+// it hardly ever has to.
+//
+// Where the GL has ARB_buffer_storage the buffer is mapped once, persistently and
+// coherently, and objects are written straight into it; otherwise each frame's region
+// is mapped unsynchronized on beginning the frame and unmapped on committing it.
+// Either way drawing an object costs one glBindBufferRange() call.
+struct ObjectRing
+{
+   unsigned int buffer; // Buffer id.
+   unsigned int binding; // Binding point.
+   int slotSize; // Size of an object block, rounded up to the buffer offset alignment.
+   int maxObjects; // Object blocks per region.
+   bool persistent; // If the buffer is persistently mapped.
+   unsigned char *mapped; // The persistently mapped buffer.
+   unsigned char *region; // The current frame's region while it is written.
+   int frame; // Region of the current frame.
+   void *fences[FRAME_RING_FRAMES]; // Fence of each region's last frame, NULL if none.
+};
+
+void createUniformBlock(UniformBlock &block, unsigned int binding, int size, const void *data);
+void updateUniformBlock(const UniformBlock &block, const void *data);
+
+void createObjectRing(ObjectRing &ring, unsigned int binding, int maxObjects);
+void beginObjectRing(ObjectRing &ring);
+ObjectConstants *ringObject(const ObjectRing &ring, int object);
+void commitObjectRing(ObjectRing &ring);
+void bindRingObject(const ObjectRing &ring, int object);
+void endObjectRing(ObjectRing &ring);
+
+#endif
@@ -3,13 +3,26 @@
 //
 // Forward-compatible core GL 4.3 version of litCylinder.cpp.
 //
+// The projection matrix, light and materials are in uniform blocks set once rather
+// than uniforms set one by one, and the cylinder's modelview and normal matrices are
+// written each frame into a persistently mapped ring of object blocks.
+//
+// Lighting is per fragment: light0 and any number of point lights, which are assigned
+// to clusters of the view frustum by a compute shader so that each fragment is shaded
+// with only the lights near it. The benchmark scene is a grid of cylinders and spheres
+// lit by thousands of moving point lights of a fixed range, the time spent assigning and
+// shading printed every BENCH_REPORT frames along with how many lights the clusters list.
+//
 // Interaction:
 // Press x, X, y, Y, z, Z to turn the cylinder.
+// Press b to toggle between the cylinder and the benchmark scene.
+// Press +/- to add/remove 1000 point lights in the benchmark scene.
 //
 // Sumanta Guha
 ///////////////////////////////////////////////////////////// 
 
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 
@@ -23,16 +36,29 @@
 
 #include "prepShader.h"
 #include "cylinder.h"
+#include "sphere.h"
+#include "clusteredLights.h"
+#include "frameConstants.h"
 #include "light.h"
 #include "material.h"
 
 using namespace glm;
 
-static enum object {CYLINDER}; // VAO ids.
-static enum buffer {CYL_VERTICES, CYL_INDICES}; // VBO ids.
+#define BENCH_GRID 10 // Objects along each side of the benchmark grid.
+#define BENCH_SPACING 3.0 // Distance between neighbouring objects of the grid.
+#define BENCH_STEP 1000 // Point lights added or removed at a time.
+#define BENCH_MAX_LIGHTS 10000 // Most point lights.
+#define BENCH_RANGE 1.5 // Range of each point light, however many there are.
+#define BENCH_REPORT 100 // Frames timed per report.
+
+static enum object {CYLINDER, SPHERE}; // VAO ids.
+static enum buffer {CYL_VERTICES, CYL_INDICES, SPH_VERTICES, SPH_INDICES}; // VBO ids.
+static enum query {FRAME_START, LIGHTS_ASSIGNED, FRAME_DRAWN}; // Timestamp query ids.
 
 // Globals.
 static float Xangle = 150.0, Yangle = 60.0, Zangle = 0.0; // Angles to rotate the cylinder.
+static int isBenchmark = 0; // Benchmark scene?
+static int numPointLights = BENCH_STEP; // Point lights of the benchmark scene.
 
 // Light properties.
 static const Light light0 = 
@@ -46,6 +72,15 @@ static const Light light0 =
 // Global ambient.
 static const vec4 globAmb = vec4(0.2, 0.2, 0.2, 1.0);
 
+// Dimmer light0 of the benchmark scene, leaving the point lights to light it.
+static const Light benchLight0 = 
+{
+	vec4(0.0, 0.0, 0.0, 1.0),
+	vec4(0.2, 0.2, 0.2, 1.0),
+	vec4(0.2, 0.2, 0.2, 1.0),
+	vec4(0.0, 1.0, 1.0, 0.0)
+};
+
 // Front material properties.
 static const Material cylFront = 
 {
@@ -53,7 +88,8 @@ static const Material cylFront =
 	vec4(0.9, 0.0, 0.0, 1.0),
 	vec4(1.0, 1.0, 1.0, 1.0),
 	vec4(0.0, 0.0, 0.0, 1.0),
-	50.0
+	50.0,
+	{ 0.0, 0.0, 0.0 }
 };
 
 // Back material properties.
@@ -63,7 +99,19 @@ static const Material cylBack =
 	vec4(0.0, 0.9, 0.0, 1.0),
 	vec4(1.0, 1.0, 1.0, 1.0),
 	vec4(0.0, 0.0, 0.0, 1.0),
-	50.0
+	50.0,
+	{ 0.0, 0.0, 0.0 }
+};
+
+// Material, front and back, of the benchmark scene, white to show the lights' colors.
+static const Material benchMaterial = 
+{
+	vec4(0.8, 0.8, 0.8, 1.0),
+	vec4(0.8, 0.8, 0.8, 1.0),
+	vec4(1.0, 1.0, 1.0, 1.0),
+	vec4(0.0, 0.0, 0.0, 1.0),
+	50.0,
+	{ 0.0, 0.0, 0.0 }
 };
 
 // Cylinder data.
@@ -72,21 +120,100 @@ static unsigned int cylIndices[CYL_LATS][2*(CYL_LONGS+1)];
 static int cylCounts[CYL_LATS]; 
 static void* cylOffsets[CYL_LATS]; 
 
+// Sphere data.
+static Vertex sphVertices[(SPH_LONGS + 1) * (SPH_LATS + 1)]; 
+static unsigned int sphIndices[SPH_LATS][2*(SPH_LONGS+1)]; 
+static int sphCounts[SPH_LATS]; 
+static void* sphOffsets[SPH_LATS]; 
+
+// Point lights of the benchmark scene, each circling the vertical axis at its own speed.
+struct OrbitingLight
+{
+   float radius, height, angle, speed; // Circle, starting angle and radians per second.
+   vec4 cols; // Color.
+};
+static OrbitingLight orbitingLights[BENCH_MAX_LIGHTS];
+static PointLight pointLights[BENCH_MAX_LIGHTS]; // The lights in eye space, uploaded each frame.
+
 static mat4 modelViewMat, projMat;
 static mat3 normalMat;
 
+static CameraConstants camera; // Camera block.
+static UniformBlock cameraBlock, lightsBlock, materialsBlock; // Uniform blocks.
+static ObjectRing objectRing; // Ring of object blocks.
+static LightClusters clusters; // Clustered point lights.
+
+// Timestamps of each frame of the object ring, read when the ring comes round to it.
+static unsigned int queries[FRAME_RING_FRAMES][3];
+static int isQueried[FRAME_RING_FRAMES];
+static int numTimed = 0, startTime; // Frames timed and when the first began.
+static double assignTime = 0.0, shadeTime = 0.0; // Their GPU time in ms.
+
 static unsigned int
    programId,
    vertexShaderId,
    fragmentShaderId,
-   modelViewMatLoc,
-   normalMatLoc,
-   projMatLoc,
-   buffer[2], 
-   vao[1],
+   buffer[4], 
+   vao[2],
    width, // OpenGL window width.
    height; // OpenGL window height.
 
+// Routine to scatter the benchmark lights about the grid.
+void fillOrbitingLights(void)
+{
+   float halfWidth = 0.5 * BENCH_GRID * BENCH_SPACING;
+
+   for (int i = 0; i < BENCH_MAX_LIGHTS; i++)
+   {
+      orbitingLights[i].radius = halfWidth * sqrt((float)rand() / RAND_MAX);
+      orbitingLights[i].height = 0.2 + 2.8 * (float)rand() / RAND_MAX;
+      orbitingLights[i].angle = 2.0 * PI * (float)rand() / RAND_MAX;
+      orbitingLights[i].speed = -0.5 + (float)rand() / RAND_MAX;
+      orbitingLights[i].cols = vec4((float)rand() / RAND_MAX, (float)rand() / RAND_MAX, 
+                                    (float)rand() / RAND_MAX, 1.0);
+   }
+}
+
+// Routine to set the uniform blocks of light0 and the materials for the scene.
+void setSceneConstants(void)
+{
+   LightConstants lights = {isBenchmark ? benchLight0 : light0, globAmb};
+   MaterialConstants materials = {cylFront, cylBack};
+   if (isBenchmark) materials.front = materials.back = benchMaterial;
+   updateUniformBlock(lightsBlock, &lights);
+   updateUniformBlock(materialsBlock, &materials);
+}
+
+// Routine to start timing frames afresh.
+void resetTimings(void)
+{
+   for (int i = 0; i < FRAME_RING_FRAMES; i++) isQueried[i] = 0;
+   numTimed = 0;
+   assignTime = shadeTime = 0.0;
+   startTime = glutGet(GLUT_ELAPSED_TIME);
+}
+
+// Routine to print the timings of the frames timed, once there are BENCH_REPORT of them,
+// and the lights listed per cluster by the last frame, whose reading is left out of the
+// next report's time.
+void reportTimings(void)
+{
+   float meanLights;
+   int mostLights;
+
+   if (numTimed < BENCH_REPORT) return;
+
+   std::cout << numPointLights << " point lights: "
+             << (double)(glutGet(GLUT_ELAPSED_TIME) - startTime) / numTimed << " ms per frame, "
+             << assignTime / numTimed << " ms assigning lights, "
+             << shadeTime / numTimed << " ms drawing, ";
+   countClusterLights(clusters, meanLights, mostLights);
+   std::cout << meanLights << " lights per lit cluster, at most " << mostLights << "." << std::endl;
+   numTimed = 0;
+   assignTime = shadeTime = 0.0;
+   startTime = glutGet(GLUT_ELAPSED_TIME);
+}
+
 // Initialization routine.
 void setup(void) 
 {
@@ -102,12 +229,14 @@ void setup(void)
    glLinkProgram(programId); 
    glUseProgram(programId); 
 
-   // Initialize cylinder.
+   // Initialize cylinder, sphere and the benchmark lights.
    fillCylinder(cylVertices, cylIndices, cylCounts, cylOffsets);
+   fillSphere(sphVertices, sphIndices, sphCounts, sphOffsets);
+   fillOrbitingLights();
 
    // Create VAOs and VBOs... 
-   glGenVertexArrays(1, vao);
-   glGenBuffers(2, buffer); 
+   glGenVertexArrays(2, vao);
+   glGenBuffers(4, buffer); 
 
    // ...and associate cylinder data with vertex shader.
    glBindVertexArray(vao[CYLINDER]);
@@ -120,43 +249,92 @@ void setup(void)
    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
    glEnableVertexAttribArray(1);
 
-   // Obtain modelview matrix, projection matrix and normal matrix uniform locations.
-   modelViewMatLoc = glGetUniformLocation(programId,"modelViewMat"); 
-   projMatLoc = glGetUniformLocation(programId,"projMat"); 
-   normalMatLoc = glGetUniformLocation(programId,"normalMat"); 
-
-   // Obtain light property uniform locations and set values.
-   glUniform4fv(glGetUniformLocation(programId, "light0.ambCols"), 1, &light0.ambCols[0]);
-   glUniform4fv(glGetUniformLocation(programId, "light0.difCols"), 1, &light0.difCols[0]);
-   glUniform4fv(glGetUniformLocation(programId, "light0.specCols"), 1, &light0.specCols[0]);
-   glUniform4fv(glGetUniformLocation(programId, "light0.coords"), 1, &light0.coords[0]);
-
-   // Obtain global ambient uniform location and set value.
-   glUniform4fv(glGetUniformLocation(programId, "globAmb"), 1, &globAmb[0]);
-
-   // Obtain front material property uniform locations and set values.
-   glUniform4fv(glGetUniformLocation(programId, "cylFront.ambRefl"), 1, &cylFront.ambRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "cylFront.difRefl"), 1, &cylFront.difRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "cylFront.specRefl"), 1, &cylFront.specRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "cylFront.emitCols"), 1, &cylFront.emitCols[0]);
-   glUniform1f(glGetUniformLocation(programId, "cylFront.shininess"), cylFront.shininess);
-
-   // Obtain back material property uniform locations and set values.
-   glUniform4fv(glGetUniformLocation(programId, "cylBack.ambRefl"), 1, &cylBack.ambRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "cylBack.difRefl"), 1, &cylBack.difRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "cylBack.specRefl"), 1, &cylBack.specRefl[0]);
-   glUniform4fv(glGetUniformLocation(programId, "cylBack.emitCols"), 1, &cylBack.emitCols[0]);
-   glUniform1f(glGetUniformLocation(programId, "cylBack.shininess"), cylBack.shininess);
+   // ...and sphere data.
+   glBindVertexArray(vao[SPHERE]);
+   glBindBuffer(GL_ARRAY_BUFFER, buffer[SPH_VERTICES]);
+   glBufferData(GL_ARRAY_BUFFER, sizeof(sphVertices), sphVertices, GL_STATIC_DRAW);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[SPH_INDICES]);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(sphIndices), sphIndices, GL_STATIC_DRAW);
+   glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+   glEnableVertexAttribArray(0);
+   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+   glEnableVertexAttribArray(1);
+
+   // Create the uniform blocks of the light and materials, which change only with the
+   // scene, of the projection matrix, which changes with the window, and the object ring,
+   // with a block for every object of the benchmark grid.
+   LightConstants lights = {light0, globAmb};
+   MaterialConstants materials = {cylFront, cylBack};
+   createUniformBlock(cameraBlock, CAMERA_BINDING, sizeof(camera), &camera);
+   createUniformBlock(lightsBlock, LIGHTS_BINDING, sizeof(lights), &lights);
+   createUniformBlock(materialsBlock, MATERIALS_BINDING, sizeof(materials), &materials);
+   createObjectRing(objectRing, OBJECT_BINDING, BENCH_GRID * BENCH_GRID);
+
+   // Create the light clusters and the timestamp queries.
+   createLightClusters(clusters, BENCH_MAX_LIGHTS);
+   glGenQueries(3 * FRAME_RING_FRAMES, &queries[0][0]);
+   for (int i = 0; i < FRAME_RING_FRAMES; i++) isQueried[i] = 0;
 }
 
-// Drawing routine.
-void drawScene(void)
+// Routine to draw the benchmark grid, alternately standing cylinders and spheres, lit by
+// the point lights circling over it.
+void drawBenchmark(void)
 {
-   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   float time = glutGet(GLUT_ELAPSED_TIME) / 1000.0, angle, offset = 0.5 * (BENCH_GRID - 1) * BENCH_SPACING;
+   mat4 viewMat;
+   int i, j, k;
+
+   viewMat = lookAt(vec3(0.0, 15.0, 30.0), vec3(0.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0));
+
+   // Move the lights into eye space and list them in the clusters.
+   for (i = 0; i < numPointLights; i++)
+   {
+      angle = orbitingLights[i].angle + orbitingLights[i].speed * time;
+      pointLights[i].coords = viewMat * vec4(orbitingLights[i].radius * cos(angle), orbitingLights[i].height,
+                                             orbitingLights[i].radius * sin(angle), 1.0);
+      pointLights[i].coords.w = BENCH_RANGE;
+      pointLights[i].cols = orbitingLights[i].cols;
+   }
+   updatePointLights(clusters, pointLights, numPointLights);
+   assignClusterLights(clusters);
+   glQueryCounter(queries[objectRing.frame][LIGHTS_ASSIGNED], GL_TIMESTAMP);
+
+   // Write the object blocks of the grid...
+   for (j = 0; j < BENCH_GRID; j++)
+      for (i = 0; i < BENCH_GRID; i++)
+      {
+         k = j * BENCH_GRID + i;
+         modelViewMat = translate(viewMat, vec3(i * BENCH_SPACING - offset, 1.0, j * BENCH_SPACING - offset));
+         if ((i + j) % 2 == 0) modelViewMat = rotate(modelViewMat, radians(90.0f), vec3(1.0, 0.0, 0.0));
+         ringObject(objectRing, k)->modelViewMat = modelViewMat;
+         ringObject(objectRing, k)->normalMat = mat4(transpose(inverse(mat3(modelViewMat))));
+      }
+   commitObjectRing(objectRing);
+
+   // ...and draw it.
+   glUseProgram(programId);
+   for (k = 0; k < BENCH_GRID * BENCH_GRID; k++)
+   {
+      bindRingObject(objectRing, k);
+      if ((k / BENCH_GRID + k % BENCH_GRID) % 2 == 0)
+      {
+         glBindVertexArray(vao[CYLINDER]);
+         glMultiDrawElements(GL_TRIANGLE_STRIP, cylCounts, GL_UNSIGNED_INT, (const void **)cylOffsets, CYL_LATS);
+      }
+      else
+      {
+         glBindVertexArray(vao[SPHERE]);
+         glMultiDrawElements(GL_TRIANGLE_STRIP, sphCounts, GL_UNSIGNED_INT, (const void **)sphOffsets, SPH_LATS);
+      }
+   }
+}
 
-   // Calculate and update projection matrix.
-   projMat = perspective(radians(60.0f), (float)width/(float)height, 1.0f, 50.0f); 
-   glUniformMatrix4fv(projMatLoc, 1, GL_FALSE, value_ptr(projMat));
+// Routine to draw the cylinder, lit by light0 alone.
+void drawCylinder(void)
+{
+   // No point lights.
+   updatePointLights(clusters, NULL, 0);
+   assignClusterLights(clusters);
 
    // Calculate and update modelview matrix.
    modelViewMat = mat4(1.0);
@@ -164,18 +342,71 @@ void drawScene(void)
    modelViewMat = rotate(modelViewMat, radians(Zangle), vec3(0.0, 0.0, 1.0));
    modelViewMat = rotate(modelViewMat, radians(Yangle), vec3(0.0, 1.0, 0.0));
    modelViewMat = rotate(modelViewMat, radians(Xangle), vec3(1.0, 0.0, 0.0));
-   glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat));
 
-   // Calculate and update normal matrix.
+   // Calculate normal matrix.
    normalMat = transpose(inverse(mat3(modelViewMat)));
-   glUniformMatrix3fv(normalMatLoc, 1, GL_FALSE, value_ptr(normalMat));
+
+   // Write the cylinder's object block.
+   ringObject(objectRing, CYLINDER)->modelViewMat = modelViewMat;
+   ringObject(objectRing, CYLINDER)->normalMat = mat4(normalMat);
+   commitObjectRing(objectRing);
 
    // Draw cylinder.
+   glUseProgram(programId);
+   glBindVertexArray(vao[CYLINDER]);
+   bindRingObject(objectRing, CYLINDER);
    glMultiDrawElements(GL_TRIANGLE_STRIP, cylCounts, GL_UNSIGNED_INT, (const void **)cylOffsets, CYL_LATS);
+}
+
+// Drawing routine.
+void drawScene(void)
+{
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+   // Calculate and update projection matrix, and fit the light clusters to it.
+   float farDist = isBenchmark ? 80.0 : 50.0;
+   projMat = perspective(radians(60.0f), (float)width/(float)height, 1.0f, farDist); 
+   if (projMat != camera.projMat)
+   {
+      camera.projMat = projMat;
+      updateUniformBlock(cameraBlock, &camera);
+   }
+   setClusterView(clusters, projMat, 1.0, farDist, width, height);
+
+   // Once the object ring comes round to a frame, the GPU is done with it and its
+   // timestamps can be read without waiting.
+   beginObjectRing(objectRing);
+   if (isQueried[objectRing.frame])
+   {
+      GLuint64 stamps[3];
+      for (int i = 0; i < 3; i++) 
+         glGetQueryObjectui64v(queries[objectRing.frame][i], GL_QUERY_RESULT, &stamps[i]);
+      assignTime += (stamps[LIGHTS_ASSIGNED] - stamps[FRAME_START]) / 1.0e6;
+      shadeTime += (stamps[FRAME_DRAWN] - stamps[LIGHTS_ASSIGNED]) / 1.0e6;
+      isQueried[objectRing.frame] = 0;
+      numTimed++;
+      reportTimings();
+   }
+
+   if (isBenchmark)
+   {
+      glQueryCounter(queries[objectRing.frame][FRAME_START], GL_TIMESTAMP);
+      drawBenchmark();
+      glQueryCounter(queries[objectRing.frame][FRAME_DRAWN], GL_TIMESTAMP);
+      isQueried[objectRing.frame] = 1;
+   }
+   else drawCylinder();
+   endObjectRing(objectRing);
 
    glutSwapBuffers();
 }
 
+// Routine to redraw the benchmark scene continually.
+void animate(void)
+{
+   glutPostRedisplay();
+}
+
 // OpenGL window reshape routine.
 void resize(int w, int h)
 {
@@ -221,6 +452,21 @@ void keyInput(unsigned char key, int x, int y)
 		 if (Zangle < 0.0) Zangle += 360.0;
          glutPostRedisplay();
          break;
+      case 'b':
+         isBenchmark = !isBenchmark;
+         setSceneConstants();
+         resetTimings();
+         glutIdleFunc(isBenchmark ? animate : NULL);
+         glutPostRedisplay();
+         break;
+      case '+':
+         if (numPointLights < BENCH_MAX_LIGHTS) numPointLights += BENCH_STEP;
+         resetTimings();
+         break;
+      case '-':
+         if (numPointLights > BENCH_STEP) numPointLights -= BENCH_STEP;
+         resetTimings();
+         break;
       default:
          break;
    }
@@ -230,7 +476,9 @@ void keyInput(unsigned char key, int x, int y)
 void printInteraction(void)
 {
    std::cout << "Interaction:" << std::endl;
-   std::cout << "Press x, X, y, Y, z, Z to turn the cylinder." << std::endl;
+   std::cout << "Press x, X, y, Y, z, Z to turn the cylinder." << std::endl
+        << "Press b to toggle between the cylinder and the benchmark scene." << std::endl
+        << "Press +/- to add/remove 1000 point lights in the benchmark scene." << std::endl;
 }
 
 // Main routine.
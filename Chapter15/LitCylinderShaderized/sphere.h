@@ -0,0 +1,21 @@
+#ifndef SPHERE_H
+#define SPHERE_H
+
+#include "vertex.h"
+
+#define PI 3.14159265
+#define SPH_RADIUS 1.0 // Sphere radius.
+#define SPH_LONGS 20 // Number of longitudinal slices.
+#define SPH_LATS 10 // Number of latitudinal slices.
+
+void fillSphVertexArray(Vertex sphVertices[(SPH_LONGS + 1) * (SPH_LATS + 1)]);
+void fillSphIndices(unsigned int sphIndices[SPH_LATS][2*(SPH_LONGS+1)]);
+void fillSphCounts(int sphCounts[SPH_LATS]);
+void fillSphOffsets(void* sphOffsets[SPH_LATS]);
+
+void fillSphere(Vertex sphVertices[(SPH_LONGS + 1) * (SPH_LATS + 1)], 
+	         unsigned int sphIndices[SPH_LATS][2*(SPH_LONGS+1)],
+			 int sphCounts[SPH_LATS],
+			 void* sphOffsets[SPH_LATS]);
+
+#endif
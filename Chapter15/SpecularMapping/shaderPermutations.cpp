@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "shaderPermutations.h"
+
+#define CACHE_VERSION 1
+
+// Header of a cached program binary, followed by the binary.
+struct CacheHeader
+{
+   char magic[4]; // "PRG1".
+   int version; // CACHE_VERSION.
+   unsigned int key; // Permutation.
+   long long sourceSizes[2], sourceTimes[2]; // Size and modification time of the sources.
+   int format, length; // Binary format and length.
+};
+
+// Size and modification time of a file, false if it does not exist.
+static bool fileStats(const std::string &fileName, long long &size, long long &time)
+{
+   struct stat info;
+
+   if (stat(fileName.c_str(), &info) != 0) return false;
+   size = info.st_size;
+   time = info.st_mtime;
+   return true;
+}
+
+// Name of the file caching a permutation's binary.
+static std::string cacheName(const ShaderPermutations &permutations, unsigned int key)
+{
+   std::ostringstream name;
+   name << permutations.cacheFileName << key << ".bin";
+   return name.str();
+}
+
+// Compile a shader of the type from the source with the permutation's #defines inserted
+// after its #version line, and a #line directive so that errors keep their line numbers
+// wherever in the file that line is.
+static unsigned int compilePermutation(const ShaderPermutations &permutations, unsigned int key,
+                                       GLenum type, const std::string &fileName)
+{
+   std::ifstream inFile(fileName.c_str(), std::ios::binary);
+   std::stringstream source;
+   std::ostringstream lineDirective;
+   std::string text, head, defines, tail, log;
+   size_t version, end;
+   unsigned int shaderId;
+   int status, length;
+
+   source << inFile.rdbuf();
+   text = source.str();
+   version = text.find("#version");
+   if (version == std::string::npos) end = 0;
+   else
+   {
+      end = text.find('\n', version);
+      end = (end == std::string::npos) ? text.size() : end + 1;
+   }
+   head = text.substr(0, end);
+   tail = text.substr(end);
+   if (!head.empty() && head[head.size() - 1] != '\n') defines = "\n";
+   for (unsigned int i = 0; i < permutations.features.size(); i++)
+      if (key & (1 << i)) defines += "#define " + permutations.features[i] + "\n";
+   lineDirective << "#line " << std::count(head.begin(), head.end(), '\n') + 1 << "\n";
+   defines += lineDirective.str();
+
+   const char *strings[3] = {head.c_str(), defines.c_str(), tail.c_str()};
+   shaderId = glCreateShader(type);
+   glShaderSource(shaderId, 3, strings, NULL);
+   glCompileShader(shaderId);
+
+   glGetShaderiv(shaderId, GL_COMPILE_STATUS, &status);
+   if (!status)
+   {
+      glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &length);
+      log.resize(length + 1);
+      glGetShaderInfoLog(shaderId, length, NULL, &log[0]);
+      std::cout << fileName << ", permutation " << key << ":" << std::endl << log.c_str() << std::endl;
+   }
+   return shaderId;
+}
+
+// Load a permutation's program from its cached binary if the binary was built from the
+// sources as they are now and the driver still accepts it. Returns 0 if not.
+static unsigned int loadPermutation(const ShaderPermutations &permutations, unsigned int key,
+                                    const CacheHeader &header)
+{
+   CacheHeader cached;
+   std::vector<char> binary;
+   unsigned int programId;
+   int status;
+
+   std::ifstream inFile(cacheName(permutations, key).c_str(), std::ios::binary);
+   if (!inFile || !inFile.read((char *)&cached, sizeof(CacheHeader)) || memcmp(cached.magic, "PRG1", 4) != 0 ||
+       cached.version != CACHE_VERSION || cached.key != key || cached.length <= 0 ||
+       memcmp(cached.sourceSizes, header.sourceSizes, sizeof(header.sourceSizes)) != 0 ||
+       memcmp(cached.sourceTimes, header.sourceTimes, sizeof(header.sourceTimes)) != 0)
+      return 0;
+   binary.resize(cached.length);
+   if (!inFile.read(&binary[0], cached.length)) return 0;
+
+   programId = glCreateProgram();
+   glProgramBinary(programId, cached.format, &binary[0], cached.length);
+   glGetProgramiv(programId, GL_LINK_STATUS, &status);
+   if (status) return programId;
+   glDeleteProgram(programId);
+   return 0;
+}
+
+// Compile and link a permutation's program, and cache its binary.
+static unsigned int buildPermutation(const ShaderPermutations &permutations, unsigned int key,
+                                     CacheHeader &header)
+{
+   unsigned int programId, vertexShaderId, fragmentShaderId;
+   std::vector<char> binary;
+   std::string log;
+   int status, length;
+   GLenum format;
+
+   vertexShaderId = compilePermutation(permutations, key, GL_VERTEX_SHADER, permutations.vertexFileName);
+   fragmentShaderId = compilePermutation(permutations, key, GL_FRAGMENT_SHADER, permutations.fragmentFileName);
+   programId = glCreateProgram();
+   glAttachShader(programId, vertexShaderId);
+   glAttachShader(programId, fragmentShaderId);
+   if (!permutations.cacheFileName.empty())
+      glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+   glLinkProgram(programId);
+   glDetachShader(programId, vertexShaderId);
+   glDetachShader(programId, fragmentShaderId);
+   glDeleteShader(vertexShaderId);
+   glDeleteShader(fragmentShaderId);
+
+   glGetProgramiv(programId, GL_LINK_STATUS, &status);
+   if (!status)
+   {
+      glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &length);
+      log.resize(length + 1);
+      glGetProgramInfoLog(programId, length, NULL, &log[0]);
+      std::cout << "Permutation " << key << ":" << std::endl << log.c_str() << std::endl;
+      return programId;
+   }
+
+   // Cache the binary, if the driver can give one.
+   if (permutations.cacheFileName.empty()) return programId;
+   glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+   if (length <= 0) return programId;
+   binary.resize(length);
+   glGetProgramBinary(programId, length, NULL, &format, &binary[0]);
+   header.format = format;
+   header.length = length;
+   std::ofstream outFile(cacheName(permutations, key).c_str(), std::ios::binary);
+   if (!outFile) return programId;
+   outFile.write((const char *)&header, sizeof(CacheHeader));
+   outFile.write(&binary[0], length);
+   return programId;
+}
+
+// Set up the permutations of the vertex and fragment shader files with the features, the
+// i-th the macro of key bit i, caching binaries by the name given, or not if it is empty.
+void createShaderPermutations(ShaderPermutations &permutations, const std::string &vertexFileName,
+                              const std::string &fragmentFileName, const char **features, int numFeatures,
+                              const std::string &cacheFileName)
+{
+   permutations.vertexFileName = vertexFileName;
+   permutations.fragmentFileName = fragmentFileName;
+   permutations.features.assign(features, features + std::min(numFeatures, PERMUTATION_MAX_FEATURES));
+   permutations.cacheFileName = cacheFileName;
+   permutations.programs.clear();
+   permutations.numCompiled = permutations.numLoaded = 0;
+}
+
+// The program of a permutation, built, or loaded from the cache, if it is not already.
+unsigned int getPermutation(ShaderPermutations &permutations, unsigned int key)
+{
+   std::map<unsigned int, unsigned int>::iterator found = permutations.programs.find(key);
+   CacheHeader header;
+   unsigned int programId = 0;
+
+   if (found != permutations.programs.end()) return found->second;
+
+   memset(&header, 0, sizeof(CacheHeader));
+   memcpy(header.magic, "PRG1", 4);
+   header.version = CACHE_VERSION;
+   header.key = key;
+   fileStats(permutations.vertexFileName, header.sourceSizes[0], header.sourceTimes[0]);
+   fileStats(permutations.fragmentFileName, header.sourceSizes[1], header.sourceTimes[1]);
+
+   if (!permutations.cacheFileName.empty()) programId = loadPermutation(permutations, key, header);
+   if (programId) permutations.numLoaded++;
+   else
+   {
+      programId = buildPermutation(permutations, key, header);
+      permutations.numCompiled++;
+   }
+
+   permutations.programs[key] = programId;
+   return programId;
+}
+
+// Make the program of a permutation current, returning it.
+unsigned int usePermutation(ShaderPermutations &permutations, unsigned int key)
+{
+   unsigned int programId = getPermutation(permutations, key);
+   glUseProgram(programId);
+   return programId;
+}
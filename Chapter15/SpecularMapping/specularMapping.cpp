@@ -4,6 +4,10 @@
 // This program enhances litTexturedCylinderShaderized to control the highlights
 // with a specular map.
 //
+// The shaders are written once with #ifdef blocks for lighting and specular mapping,
+// and each object is drawn with a program specialized to just the features it uses
+// instead of every fragment branching on which object it belongs to.
+//
 // Interaction:
 // Press x, X, y, Y, z, Z to turn the can.
 // Press space to toggle between specular mapping on and off.
@@ -25,17 +29,19 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
 
-#include "prepShader.h"
 #include "cylinder.h"
 #include "disc.h"
 #include "light.h"
 #include "material.h"
 #include "getBMP.h"
+#include "shaderPermutations.h"
 
 using namespace glm;
 
 static enum object { CYLINDER, DISC, RECTANGLE }; // VAO ids.
-static enum buffer { CYL_VERTICES, CYL_INDICES, DISC_VERTICES, RECTANGLE_VERTICES }; // VBO ids.
+static enum buffer { CYL_VERTICES, CYL_INDICES, DISC_VERTICES, RECTANGLE_VERTICES, MATRICES, LIGHTING }; // Buffer ids.
+static enum feature { LIT = 1, SPECULAR_MAP = 2 }; // Shader features, by key bit.
+static const char *featureNames[] = { "LIT", "SPECULAR_MAP" }; // Their macros, in the same order.
 
 // Globals.
 static float Xangle = 210.0, Yangle = 230.0, Zangle = 0.0; // Angles to rotate the cylinder.
@@ -59,7 +65,8 @@ static const Material canFandB =
 	vec4(1.0, 1.0, 1.0, 1.0),
 	vec4(1.0, 1.0, 1.0, 1.0),
 	vec4(0.0, 0.0, 0.0, 1.0),
-	50.0f
+	50.0f,
+	{ 0.0f, 0.0f, 0.0f }
 };
 
 // Cylinder data.
@@ -80,24 +87,27 @@ static Vertex rectangleVertices[] =
 	{ vec4(-0.7, 1.7, 0.0, 1.0), vec3(0.0, 0.0, 1.0), vec2(1.0, 1.0) }
 };
 
+// Matrices block (std140), the normal matrix padded to a mat4.
+static struct
+{
+	mat4 modelViewMat, projMat, normalMat;
+} matrices;
+
+// Lighting block (std140).
+static struct
+{
+	Light light0;
+	vec4 globAmb;
+	Material canFandB;
+} lighting;
+
 static mat4 modelViewMat, projMat;
 static mat3 normalMat;
 
+static ShaderPermutations permutations; // Programs for each combination of features.
+
 static unsigned int
-programId,
-vertexShaderId,
-fragmentShaderId,
-modelViewMatLoc,
-normalMatLoc,
-projMatLoc,
-canLabelTexLoc,
-canTopTexLoc,
-canLabelSpecularMapTexLoc,
-specMapOnTexLoc,
-specMapOffTexLoc,
-isSpecularMappedLoc,
-objectLoc,
-buffer[4],
+buffer[6],
 vao[3],
 texture[5],
 width,
@@ -112,14 +122,15 @@ void setup(void)
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 	glEnable(GL_DEPTH_TEST);
 
-	// Create shader program executable.
-	vertexShaderId = setShader("vertex", "Shaders/vertexShader.glsl");
-	fragmentShaderId = setShader("fragment", "Shaders/fragmentShader.glsl");
-	programId = glCreateProgram();
-	glAttachShader(programId, vertexShaderId);
-	glAttachShader(programId, fragmentShaderId);
-	glLinkProgram(programId);
-	glUseProgram(programId);
+	// Build, or load from the cache, the program of each combination of features drawn:
+	// the unlit rectangle, the disc and the cylinder lit, and the cylinder specular mapped.
+	createShaderPermutations(permutations, "Shaders/vertexShader.glsl", "Shaders/fragmentShader.glsl",
+		featureNames, 2, "Shaders/program");
+	getPermutation(permutations, 0);
+	getPermutation(permutations, LIT);
+	getPermutation(permutations, LIT | SPECULAR_MAP);
+	std::cout << permutations.numCompiled << " programs compiled, " 
+		<< permutations.numLoaded << " loaded from the cache." << std::endl;
 
 	// Initialize cylinder and disc.
 	fillCylinder(cylVertices, cylIndices, cylCounts, cylOffsets);
@@ -127,7 +138,7 @@ void setup(void)
 
 	// Create VAOs and VBOs... 
 	glGenVertexArrays(3, vao);
-	glGenBuffers(4, buffer);
+	glGenBuffers(6, buffer);
 
 	// ...and associate cylinder data with vertex shader.
 	glBindVertexArray(vao[CYLINDER]);
@@ -146,49 +157,35 @@ void setup(void)
 	glBindVertexArray(vao[DISC]);
 	glBindBuffer(GL_ARRAY_BUFFER, buffer[DISC_VERTICES]);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(discVertices), discVertices, GL_STATIC_DRAW);
-	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
-	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+	glEnableVertexAttribArray(2);
 
 	// ...and associate rectangle data with vertex shader.
 	glBindVertexArray(vao[RECTANGLE]);
 	glBindBuffer(GL_ARRAY_BUFFER, buffer[RECTANGLE_VERTICES]);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(rectangleVertices), rectangleVertices, GL_STATIC_DRAW);
-	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glEnableVertexAttribArray(6);
-	glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-	glEnableVertexAttribArray(7);
-	glVertexAttribPointer(8, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
-	glEnableVertexAttribArray(8);
-
-	// Obtain modelview matrix, projection matrix, normal matrix and object uniform locations.
-	modelViewMatLoc = glGetUniformLocation(programId, "modelViewMat");
-	projMatLoc = glGetUniformLocation(programId, "projMat");
-	normalMatLoc = glGetUniformLocation(programId, "normalMat");
-	objectLoc = glGetUniformLocation(programId, "object");
-
-	// Obtain isSpecularMapped uniform location and set value.
-	isSpecularMappedLoc = glGetUniformLocation(programId, "isSpecularMapped");
-	glUniform1uiv(isSpecularMappedLoc, 1, &isSpecularMapped);
-
-	// Obtain light property uniform locations and set values.
-	glUniform4fv(glGetUniformLocation(programId, "light0.ambCols"), 1, &light0.ambCols[0]);
-	glUniform4fv(glGetUniformLocation(programId, "light0.difCols"), 1, &light0.difCols[0]);
-	glUniform4fv(glGetUniformLocation(programId, "light0.specCols"), 1, &light0.specCols[0]);
-	glUniform4fv(glGetUniformLocation(programId, "light0.coords"), 1, &light0.coords[0]);
-
-	// Obtain global ambient uniform location and set value.
-	glUniform4fv(glGetUniformLocation(programId, "globAmb"), 1, &globAmb[0]);
-
-	// Obtain material property uniform locations and set values.
-	glUniform4fv(glGetUniformLocation(programId, "canFandB.ambRefl"), 1, &canFandB.ambRefl[0]);
-	glUniform4fv(glGetUniformLocation(programId, "canFandB.difRefl"), 1, &canFandB.difRefl[0]);
-	glUniform4fv(glGetUniformLocation(programId, "canFandB.specRefl"), 1, &canFandB.specRefl[0]);
-	glUniform4fv(glGetUniformLocation(programId, "canFandB.emitCols"), 1, &canFandB.emitCols[0]);
-	glUniform1f(glGetUniformLocation(programId, "canFandB.shininess"), canFandB.shininess);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+	glEnableVertexAttribArray(2);
+
+	// Create the uniform blocks shared by all the programs: the matrices, changing with 
+	// each object, and the light and material, which never change.
+	lighting.light0 = light0;
+	lighting.globAmb = globAmb;
+	lighting.canFandB = canFandB;
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer[MATRICES]);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(matrices), NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, buffer[MATRICES]);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer[LIGHTING]);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(lighting), &lighting, GL_STATIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 1, buffer[LIGHTING]);
 
 	// Load the images.
 	image[0] = getBMP("../../Textures/canLabel.bmp");
@@ -197,7 +194,7 @@ void setup(void)
 	image[3] = getBMP("../../Textures/specMapOn.bmp");
 	image[4] = getBMP("../../Textures/specMapOff.bmp");
 
-	// Create texture ids.
+	// Create texture ids. Each object's image is bound to unit 0 when it is drawn.
 	glGenTextures(5, texture);
 
 	// Bind can label image.
@@ -209,11 +206,9 @@ void setup(void)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	canLabelTexLoc = glGetUniformLocation(programId, "canLabelTex");
-	glUniform1i(canLabelTexLoc, 0);
 
 	// Bind can top image.
-	glActiveTexture(GL_TEXTURE1);
+	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, texture[1]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[1]->width, image[1]->height, 0,
 		GL_RGBA, GL_UNSIGNED_BYTE, image[1]->data);
@@ -221,11 +216,9 @@ void setup(void)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	canTopTexLoc = glGetUniformLocation(programId, "canTopTex");
-	glUniform1i(canTopTexLoc, 1);
 
-	// Bind can label specular map.
-	glActiveTexture(GL_TEXTURE2);
+	// Bind can label specular map, to unit 1 for good.
+	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_2D, texture[2]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[2]->width, image[2]->height, 0,
 		GL_RGBA, GL_UNSIGNED_BYTE, image[2]->data);
@@ -233,11 +226,9 @@ void setup(void)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	canLabelSpecularMapTexLoc = glGetUniformLocation(programId, "canLabelSpecularMapTex");
-	glUniform1i(canLabelSpecularMapTexLoc, 2);
 
 	// Bind image "Specular mapping on!".
-	glActiveTexture(GL_TEXTURE3);
+	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, texture[3]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[3]->width, image[3]->height, 0,
 		GL_RGBA, GL_UNSIGNED_BYTE, image[3]->data);
@@ -245,11 +236,9 @@ void setup(void)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	specMapOnTexLoc = glGetUniformLocation(programId, "specMapOnTex");
-	glUniform1i(specMapOnTexLoc, 3);
 
 	// Bind image "Specular mapping off!".
-	glActiveTexture(GL_TEXTURE4);
+	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, texture[4]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image[4]->width, image[4]->height, 0,
 		GL_RGBA, GL_UNSIGNED_BYTE, image[4]->data);
@@ -257,8 +246,13 @@ void setup(void)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	specMapOffTexLoc = glGetUniformLocation(programId, "specMapOffTex");
-	glUniform1i(specMapOffTexLoc, 4);
+}
+
+// Routine to update the matrices block.
+void updateMatrices(void)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer[MATRICES]);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), &matrices);
 }
 
 // Drawing routine.
@@ -266,17 +260,19 @@ void drawScene(void)
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Calculate and update projection matrix.
+	// Calculate projection matrix.
 	projMat = perspective(radians(60.0f), (float)width / (float)height, 1.0f, 50.0f);
-	glUniformMatrix4fv(projMatLoc, 1, GL_FALSE, value_ptr(projMat));
+	matrices.projMat = projMat;
 
 	// Calculate and update modelview matrix.
 	modelViewMat = mat4(1.0);
 	modelViewMat = lookAt(vec3(0.0, 0.0, 3.0), vec3(0.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0));
-	glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat));
+	matrices.modelViewMat = modelViewMat;
+	updateMatrices();
 
-	// Draw (label) rectangle.
-	glUniform1ui(objectLoc, RECTANGLE);
+	// Draw (label) rectangle, unlit.
+	usePermutation(permutations, 0);
+	glBindTexture(GL_TEXTURE_2D, texture[isSpecularMapped ? 3 : 4]);
 	glBindVertexArray(vao[RECTANGLE]);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
@@ -284,19 +280,22 @@ void drawScene(void)
 	modelViewMat = rotate(modelViewMat, radians(Zangle), vec3(0.0, 0.0, 1.0));
 	modelViewMat = rotate(modelViewMat, radians(Yangle), vec3(0.0, 1.0, 0.0));
 	modelViewMat = rotate(modelViewMat, radians(Xangle), vec3(1.0, 0.0, 0.0));
-	glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat));
+	matrices.modelViewMat = modelViewMat;
 
 	// Calculate and update normal matrix.
 	normalMat = transpose(inverse(mat3(modelViewMat)));
-	glUniformMatrix3fv(normalMatLoc, 1, GL_FALSE, value_ptr(normalMat));
+	matrices.normalMat = mat4(normalMat);
+	updateMatrices();
 
-	// Draw cylinder.
-	glUniform1ui(objectLoc, CYLINDER);
+	// Draw cylinder, lit, with highlights only where the specular map allows if it is on.
+	usePermutation(permutations, isSpecularMapped ? LIT | SPECULAR_MAP : LIT);
+	glBindTexture(GL_TEXTURE_2D, texture[0]);
 	glBindVertexArray(vao[CYLINDER]);
 	glMultiDrawElements(GL_TRIANGLE_STRIP, cylCounts, GL_UNSIGNED_INT, (const void **)cylOffsets, CYL_LATS);
 
-	// Draw disc.
-	glUniform1ui(objectLoc, DISC);
+	// Draw disc, lit.
+	usePermutation(permutations, LIT);
+	glBindTexture(GL_TEXTURE_2D, texture[1]);
 	glBindVertexArray(vao[DISC]);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, DISC_SEGS);
 
@@ -320,7 +319,6 @@ void keyInput(unsigned char key, int x, int y)
 		break;
 	case ' ':
 		isSpecularMapped = isSpecularMapped ? 0 : 1;
-		glUniform1uiv(isSpecularMappedLoc, 1, &isSpecularMapped);
 		glutPostRedisplay();
 		break;
 	case 'x':
@@ -2,44 +2,70 @@
 
 #define SPHERE 0
 #define TORUS 1
-#define NONE 2
+#define OUTLINE 2
 
-layout(std430, binding=0) buffer shaderStorage 
+#define PICK_NONE 0
+#define PICK_POINT 1
+#define PICK_RECTANGLE 2
+#define PICK_LASSO 3
+#define MAX_LASSO_POINTS 64
+
+// GPU pick results. pickKey is the least, over fragments within a pixel of the pick
+// point, of depth in the top 24 bits over object id in the bottom 8, so atomicMin()
+// leaves the nearest object whatever order fragments arrive in. regionMask has bit
+// object set for each object with a fragment in the pick rectangle or lasso.
+layout(std430, binding=0) buffer pickResults
 {
-   ivec2 clickedCoords; 
-   uint clickedObj; 
-   float minClickedDepth;
+   uint pickKey;
+   uint regionMask;
 };
 
-layout(origin_upper_left, pixel_center_integer) in  vec4 gl_FragCoord;
-
 uniform uint object;
+uniform uint selectedObjs;
 uniform vec4 sphColor, torColor, highlightColor;
 uniform int highlightFrames;
-uniform int isSelecting;
+uniform int pickMode;
+uniform ivec2 pickPoint;
+uniform vec4 pickRect; // xMin, yMin, xMax, yMax.
+uniform int lassoCount;
+uniform vec2 lasso[MAX_LASSO_POINTS];
 
 out vec4 colorsOut;
 
+// Is p inside the lasso by the even-odd rule?
+bool insideLasso(vec2 p)
+{
+   bool inside = false;
+   for (int i = 0, j = lassoCount - 1; i < lassoCount; j = i++)
+      if ( ((lasso[i].y > p.y) != (lasso[j].y > p.y)) &&
+           (p.x < lasso[j].x + (p.y - lasso[j].y) * (lasso[i].x - lasso[j].x) / (lasso[i].y - lasso[j].y)) )
+         inside = !inside;
+   return inside;
+}
+
 void main(void)
 {
-   if (isSelecting == 1)
-   if (     (abs(gl_FragCoord.x - clickedCoords.x) <= 1) 
-         && (abs(gl_FragCoord.y - clickedCoords.y) <= 1) 
-		 && (gl_FragCoord.z < minClickedDepth)
-	  )
-   {	  
-	  minClickedDepth = gl_FragCoord.z;
-      clickedObj = object;
+   if (object != OUTLINE)
+   {
+      if ( (pickMode == PICK_POINT) && 
+           all(lessThanEqual(abs(gl_FragCoord.xy - (vec2(pickPoint) + 0.5)), vec2(1.0))) )
+         atomicMin(pickKey, (uint(gl_FragCoord.z * 16777215.0) << 8) | object);
+      if ( (pickMode == PICK_RECTANGLE) && 
+           all(greaterThanEqual(gl_FragCoord.xy, pickRect.xy)) && all(lessThanEqual(gl_FragCoord.xy, pickRect.zw)) )
+         atomicOr(regionMask, 1u << object);
+      if ( (pickMode == PICK_LASSO) && insideLasso(gl_FragCoord.xy) )
+         atomicOr(regionMask, 1u << object);
    }
-   
+
    if (object == SPHERE) 
    {
-      if ( (clickedObj == SPHERE) && (highlightFrames > 0) ) colorsOut = highlightColor;
+      if ( ((selectedObjs & (1u << SPHERE)) != 0u) && (highlightFrames > 0) ) colorsOut = highlightColor;
       else colorsOut = sphColor; 
    }
    if (object == TORUS)   
    {
-      if ( (clickedObj == TORUS) && (highlightFrames > 0) ) colorsOut = highlightColor;
+      if ( ((selectedObjs & (1u << TORUS)) != 0u) && (highlightFrames > 0) ) colorsOut = highlightColor;
       else colorsOut = torColor; 
    }
+   if (object == OUTLINE) colorsOut = vec4(0.0, 0.0, 0.0, 1.0);
 }
\ No newline at end of file
@@ -2,9 +2,11 @@
 
 #define SPHERE 0
 #define TORUS 1
+#define OUTLINE 2
 
 layout(location=0) in vec4 sphCoords;
 layout(location=1) in vec4 torCoords;
+layout(location=2) in vec4 outlineCoords;
 
 uniform mat4 projMat;
 uniform mat4 modelViewMat;
@@ -17,5 +19,6 @@ void main(void)
    if (object == SPHERE) coords = sphCoords;
    if (object == TORUS) coords = torCoords;
    
-   gl_Position = projMat * modelViewMat * coords;
+   if (object == OUTLINE) gl_Position = outlineCoords;
+   else gl_Position = projMat * modelViewMat * coords;
 }
@@ -3,11 +3,22 @@
 //
 // Forward-compatible core GL 4.3 version of ballAndTorusPicking.cpp.
 //
+// Picks are made on the CPU by casting the ray under the cursor against a
+// bounding volume hierarchy over the triangles of each object, or on the GPU
+// by the fragment shader while drawing the next frame. The GPU resolves a
+// click with atomicMin() on a key packing depth above object id, and a
+// rectangle or lasso with atomicOr() on a mask of object ids, and the results
+// are read back through a pixel pack buffer behind a fence, so that no frame
+// waits on them.
+//
 // Interaction:
 // Press space to toggle between animation on and off.
 // Press the up/down arrow keys to speed up/slow down animation.
 // Press the x, X, y, Y, z, Z keys to rotate the scene.
 // Click left mouse button to pick either ball or torus.
+// Press 'g' to toggle between CPU and GPU picking. When picking on the GPU,
+// drag with the left mouse button to select objects in a rectangle, or
+// with shift held to select objects in a lasso.
 //
 // Sumanta Guha
 ///////////////////////////////////////////////////////////////////////////
@@ -15,6 +26,7 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
@@ -26,13 +38,17 @@
 #include "prepShader.h"
 #include "sphere.h"
 #include "torus.h"
+#include "bvh.h"
 
 using namespace glm;
 
 #define HIGHLIGHT_COLORS 1.0, 0.0, 0.0, 1.0 // Colors to highlight picked object.
+#define MAX_LASSO_POINTS 64 // Most lasso vertices, as declared in the fragment shader.
 
-static enum object {SPHERE, TORUS, NONE}; // VAO ids and NONE = 2.
-static enum buffer {SPH_VERTICES, SPH_INDICES, TOR_VERTICES, TOR_INDICES, SHADER_STORAGE}; // VBO ids.
+static enum object {SPHERE, TORUS, OUTLINE, NONE}; // VAO ids and NONE = 3.
+static enum buffer {SPH_VERTICES, SPH_INDICES, TOR_VERTICES, TOR_INDICES, OUTLINE_VERTICES,
+                    PICK_STORAGE, PICK_READBACK}; // Buffer ids.
+static enum pickMode {PICK_NONE, PICK_POINT, PICK_RECTANGLE, PICK_LASSO}; // GPU pick modes.
 
 // Globals.
 static float latAngle = 0.0; // Latitudinal angle.
@@ -58,6 +74,8 @@ static vec4 torColors = vec4(TOR_COLORS);
 static vec4 highlightColors = vec4(HIGHLIGHT_COLORS);
 
 static mat4 modelViewMat, projMat;
+static mat4 torModelViewMat, sphModelViewMat; // Modelview matrices last drawn with.
+static Bvh sphBvh, torBvh; // Bounding volume hierarchies of the sphere and torus.
 
 static unsigned int
    programId,
@@ -66,19 +84,45 @@ static unsigned int
    modelViewMatLoc,
    projMatLoc,
    objectLoc,
-   isSelectingLoc,
+   selectedObjsLoc,
    highlightFramesLoc,
+   pickModeLoc,
+   pickPointLoc,
+   pickRectLoc,
+   lassoCountLoc,
+   lassoLoc,
    sphColorLoc,
    torColorLoc,
    highlightColorLoc,
-   buffer[5], 
-   vao[2]; 
+   buffer[7], 
+   vao[3]; 
 
-static int clickX, clickY; // Mouse click coordinates.
 static int highlightFrames = 0; // Number of frames to keep highlight.
-static int isSelecting = 0; // In selection mode?
-static int* storageBufferPtrInt; // int type pointer to buffer data.
-static float* storageBufferPtrFloat; // float type pointer to buffer data.
+static unsigned int selectedObjs = 0; // Bit mask of picked objects.
+
+static int isGpuPicking = 0; // Pick on the GPU instead of on the CPU?
+static int pendingPick = PICK_NONE; // GPU pick to make while drawing the next frame.
+static int inFlightPick = PICK_NONE; // GPU pick made but not yet read back.
+static GLsync pickFence; // Signalled when the GPU pick results can be read back.
+static int isDragging = 0; // Dragging out a rectangle or lasso?
+static int isLasso = 0; // Dragging out a lasso?
+static std::vector<vec2> dragPoints; // Cursor positions of the drag, origin bottom left.
+
+// Routine to build the hierarchies over the sphere and torus triangle strips.
+void buildBvhs(void)
+{
+   std::vector<float> triangles;
+   int j;
+
+   for (j = 0; j < SPH_LATS; j++)
+      appendTriangleStrip(triangles, &sphVertices[0].coords[0], 4, sphIndices[j], sphCounts[j]);
+   buildBvh(sphBvh, triangles);
+
+   triangles.clear();
+   for (j = 0; j < TOR_LATS; j++)
+      appendTriangleStrip(triangles, &torVertices[0].coords[0], 4, torIndices[j], torCounts[j]);
+   buildBvh(torBvh, triangles);
+}
 
 // Initialization routine.
 void setup(void) 
@@ -98,10 +142,11 @@ void setup(void)
    // Initialize shpere and torus.
    fillSphere(sphVertices, sphIndices, sphCounts, sphOffsets);
    fillTorus(torVertices, torIndices, torCounts, torOffsets);
+   buildBvhs();
 
-   // Create VAOs, VBOs and shader storage buffer object... 
-   glGenVertexArrays(2, vao);
-   glGenBuffers(5, buffer); 
+   // Create VAOs and VBOs... 
+   glGenVertexArrays(3, vao);
+   glGenBuffers(7, buffer); 
 
    // ...and associate sphere data with vertex shader.
    glBindVertexArray(vao[SPHERE]);  
@@ -121,17 +166,21 @@ void setup(void)
    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
    glEnableVertexAttribArray(1);
 
-   // ...and bind shader storage buffer object to buffer block in fragment shader.
-   glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer[SHADER_STORAGE]);
-   glBufferData(GL_SHADER_STORAGE_BUFFER, 16, NULL, GL_DYNAMIC_COPY);
-   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer[SHADER_STORAGE]);
-
-   // Return an int type pointer to the shader storage buffer data...
-   storageBufferPtrInt = (int*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_WRITE);
-   
-   // ...and also cast it as a float type pointer 
-   // (to access float data in the fragment shader buffer block).
-   storageBufferPtrFloat = (float*)&storageBufferPtrInt[0];
+   // ...and reserve space for the outline of a drag.
+   glBindVertexArray(vao[OUTLINE]);
+   glBindBuffer(GL_ARRAY_BUFFER, buffer[OUTLINE_VERTICES]);
+   glBufferData(GL_ARRAY_BUFFER, MAX_LASSO_POINTS * sizeof(vec4), NULL, GL_DYNAMIC_DRAW);
+   glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(vec4), 0);
+   glEnableVertexAttribArray(2);
+
+   // Create the GPU pick results buffer, bound to the fragment shader buffer block,
+   // and the buffer they are copied to for reading back.
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer[PICK_STORAGE]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(unsigned int), NULL, GL_DYNAMIC_COPY);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer[PICK_STORAGE]);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer[PICK_READBACK]);
+   glBufferData(GL_PIXEL_PACK_BUFFER, 2 * sizeof(unsigned int), NULL, GL_STREAM_READ);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
    // Obtain projection matrix uniform location and set value.
    projMatLoc = glGetUniformLocation(programId,"projMat"); 
@@ -150,9 +199,17 @@ void setup(void)
    modelViewMatLoc = glGetUniformLocation(programId,"modelViewMat"); 
    objectLoc = glGetUniformLocation(programId, "object");
    
-   // Obtain isSelecting uniform location and set value.
-   isSelectingLoc = glGetUniformLocation(programId, "isSelecting");
-   glUniform1i(isSelectingLoc, isSelecting);
+   // Obtain selectedObjs uniform location and set value.
+   selectedObjsLoc = glGetUniformLocation(programId, "selectedObjs");
+   glUniform1ui(selectedObjsLoc, selectedObjs);
+
+   // Obtain GPU pick uniform locations and set pick mode.
+   pickModeLoc = glGetUniformLocation(programId, "pickMode");
+   pickPointLoc = glGetUniformLocation(programId, "pickPoint");
+   pickRectLoc = glGetUniformLocation(programId, "pickRect");
+   lassoCountLoc = glGetUniformLocation(programId, "lassoCount");
+   lassoLoc = glGetUniformLocation(programId, "lasso");
+   glUniform1i(pickModeLoc, PICK_NONE);
 
    // Obtain highlightFrames uniform location and set value.
    highlightFramesLoc = glGetUniformLocation(programId, "highlightFrames");
@@ -161,32 +218,165 @@ void setup(void)
    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 }
 
+// Routine to highlight the objects in the mask and list them in the C++ window.
+void showSelection(unsigned int mask)
+{
+   selectedObjs = mask;
+   glUniform1ui(selectedObjsLoc, selectedObjs);
+   if (selectedObjs != 0)
+   {
+      highlightFrames = 10;
+      glUniform1i(highlightFramesLoc, highlightFrames);
+   }
+
+   std::cout << "Picked:";
+   if (selectedObjs & (1 << SPHERE)) std::cout << " ball";
+   if (selectedObjs & (1 << TORUS)) std::cout << " torus";
+   if (selectedObjs == 0) std::cout << " nothing";
+   std::cout << std::endl;
+}
+
+// Routine to read back the results of the GPU pick in flight if the GPU has written
+// them, without waiting for it if not.
+void collectPick(void)
+{
+   unsigned int *results;
+   GLenum status;
+
+   if (inFlightPick == PICK_NONE) return;
+   status = glClientWaitSync(pickFence, 0, 0);
+   if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+   glDeleteSync(pickFence);
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer[PICK_READBACK]);
+   results = (unsigned int*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 2 * sizeof(unsigned int), GL_MAP_READ_BIT);
+   if (inFlightPick == PICK_POINT) showSelection((results[0] == 0xffffffff) ? 0 : 1 << (results[0] & 0xff));
+   else showSelection(results[1]);
+   glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   inFlightPick = PICK_NONE;
+}
+
+// Routine to request a GPU pick at the end of a drag, setting its uniforms.
+void requestPick(void)
+{
+   vec2 lo, hi;
+   unsigned int i;
+
+   lo = hi = dragPoints[0];
+   for (i = 1; i < dragPoints.size(); i++)
+   {
+      lo = min(lo, dragPoints[i]);
+      hi = max(hi, dragPoints[i]);
+   }
+
+   // A drag of under 3 pixels is a click.
+   if (hi.x - lo.x < 3.0 && hi.y - lo.y < 3.0)
+   {
+      pendingPick = PICK_POINT;
+      glUniform2i(pickPointLoc, (int)dragPoints[0].x, (int)dragPoints[0].y);
+   }
+   else if (isLasso && dragPoints.size() >= 3)
+   {
+      pendingPick = PICK_LASSO;
+      glUniform1i(lassoCountLoc, dragPoints.size());
+      glUniform2fv(lassoLoc, dragPoints.size(), value_ptr(dragPoints[0]));
+   }
+   else
+   {
+      pendingPick = PICK_RECTANGLE;
+      glUniform4f(pickRectLoc, lo.x, lo.y, hi.x + 1.0, hi.y + 1.0);
+   }
+}
+
 // Mouse callback routine.
 void mouseControl(int button, int state, int x, int y)
 {
-   // Don't react unless left button is pressed.
-   if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN) return;
-   
-   // Set the fields of the fragment shader buffer block:
-   // clickedCoords.x and y from the mouse, clickedObj to NONE, clickedDepth to max depth. 
-   storageBufferPtrInt[0] = x; 
-   storageBufferPtrInt[1] = y;
-   storageBufferPtrInt[2] = NONE;
-   storageBufferPtrFloat[3] = 1.0;
-  
-   // Enter object selection mode.
-   isSelecting = 1;
-   glUniform1i(isSelectingLoc, isSelecting);
-
-   // Run the drawing routine in selection mode.
+   int viewport[4];
+   float origin[3], direction[3], t = 1.0;
+   unsigned int clickedObj;
+
+   // Don't react unless left button is used.
+   if (button != GLUT_LEFT_BUTTON) return;
+   glGetIntegerv(GL_VIEWPORT, viewport);
+
+   // GPU picking: start a drag on press, request the pick on release.
+   if (isGpuPicking)
+   {
+      if (state == GLUT_DOWN)
+      {
+         isDragging = 1;
+         isLasso = (glutGetModifiers() & GLUT_ACTIVE_SHIFT) != 0;
+         dragPoints.assign(1, vec2(x, viewport[3] - 1 - y));
+      }
+      else if (isDragging)
+      {
+         isDragging = 0;
+         requestPick();
+      }
+      glutPostRedisplay();
+      return;
+   }
+
+   if (state != GLUT_DOWN) return;
+
+   // Cast the ray under the cursor at each object in its own co-ordinates, keeping the
+   // nearest hit: t is shared as the ray runs from the near to the far plane for both.
+   clickedObj = NONE;
+   if (pickRay(value_ptr(torModelViewMat), value_ptr(projMat), viewport, x, viewport[3] - 1 - y, origin, direction) &&
+       intersectBvh(torBvh, origin, direction, t)) clickedObj = TORUS;
+   if (pickRay(value_ptr(sphModelViewMat), value_ptr(projMat), viewport, x, viewport[3] - 1 - y, origin, direction) &&
+       intersectBvh(sphBvh, origin, direction, t)) clickedObj = SPHERE;
+   showSelection((clickedObj == NONE) ? 0 : 1 << clickedObj);
+
    glutPostRedisplay(); 
 }
 
+// Mouse motion callback routine.
+void mouseMotion(int x, int y)
+{
+   int viewport[4];
+   vec2 point;
+
+   if (!isDragging) return;
+   glGetIntegerv(GL_VIEWPORT, viewport);
+   point = vec2(x, viewport[3] - 1 - y);
+
+   // A lasso gains a vertex every 4 pixels up to its limit, a rectangle only moves its corner.
+   if (isLasso)
+   {
+      if (dragPoints.size() < MAX_LASSO_POINTS && distance(point, dragPoints.back()) >= 4.0)
+         dragPoints.push_back(point);
+   }
+   else
+   {
+      if (dragPoints.size() < 2) dragPoints.push_back(point);
+      else dragPoints[1] = point;
+   }
+   glutPostRedisplay();
+}
+
 // Drawing routine.
 void drawScene(void)
 {
+   int viewport[4];
+   unsigned int i, resetResults[2] = { 0xffffffff, 0 };
+   std::vector<vec4> outline;
+
    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+   // Make a pending GPU pick while drawing this frame, once the last one is read back:
+   // reset the results and let the fragment shader record into them.
+   collectPick();
+   if (inFlightPick != PICK_NONE && pendingPick != PICK_NONE) glutPostRedisplay();
+   else if (pendingPick != PICK_NONE)
+   {
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer[PICK_STORAGE]);
+      glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(resetResults), resetResults);
+      glUniform1i(pickModeLoc, pendingPick);
+   }
+
    // Calculate and update modelview matrix.
    modelViewMat = mat4(1.0);
    modelViewMat = translate(modelViewMat, vec3(0.0, 0.0, -25.0));
@@ -194,6 +384,7 @@ void drawScene(void)
    modelViewMat = rotate(modelViewMat, radians(Yangle), vec3(0.0, 1.0, 0.0));
    modelViewMat = rotate(modelViewMat, radians(Xangle), vec3(1.0, 0.0, 0.0));
    glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat)); 
+   torModelViewMat = modelViewMat;
 
    // Draw torus.
    glUniform1ui(objectLoc, TORUS); // Update object name.
@@ -209,20 +400,48 @@ void drawScene(void)
 
    // Draw ball.
    glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat)); // Update modelview matrix.
+   sphModelViewMat = modelViewMat;
    glUniform1ui(objectLoc, SPHERE); // Update object name.
    glBindVertexArray(vao[SPHERE]);
    glMultiDrawElements(GL_TRIANGLE_STRIP, sphCounts, GL_UNSIGNED_INT, (const void **)sphOffsets, SPH_LATS);
 
-   // If drawing was done in selection mode...
-   if (isSelecting == 1)
-   {   
-      // ... set number of frames to highlight picked object.
-	  highlightFrames = 10;
-      glUniform1i(highlightFramesLoc, highlightFrames);  
+   // Copy the pick results to the readback buffer and fence them, to be mapped once the
+   // GPU has passed the fence.
+   if (inFlightPick == PICK_NONE && pendingPick != PICK_NONE)
+   {
+      glUniform1i(pickModeLoc, PICK_NONE);
+      glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+      glBindBuffer(GL_COPY_READ_BUFFER, buffer[PICK_STORAGE]);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, buffer[PICK_READBACK]);
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, 2 * sizeof(unsigned int));
+      pickFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      inFlightPick = pendingPick;
+      pendingPick = PICK_NONE;
+   }
 
-      // ...restore non-selection mode.
-      isSelecting = 0;
-	  glUniform1i(isSelectingLoc, isSelecting);
+   // Draw the rectangle or lasso being dragged out, in normalized device co-ordinates.
+   if (isDragging && dragPoints.size() > 1)
+   {
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      if (isLasso)
+         for (i = 0; i < dragPoints.size(); i++) outline.push_back(vec4(dragPoints[i], 0.0, 1.0));
+      else
+      {
+         outline.push_back(vec4(dragPoints[0], 0.0, 1.0));
+         outline.push_back(vec4(dragPoints[1].x, dragPoints[0].y, 0.0, 1.0));
+         outline.push_back(vec4(dragPoints[1], 0.0, 1.0));
+         outline.push_back(vec4(dragPoints[0].x, dragPoints[1].y, 0.0, 1.0));
+      }
+      for (i = 0; i < outline.size(); i++)
+      {
+         outline[i].x = 2.0 * (outline[i].x + 0.5) / viewport[2] - 1.0;
+         outline[i].y = 2.0 * (outline[i].y + 0.5) / viewport[3] - 1.0;
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, buffer[OUTLINE_VERTICES]);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, outline.size() * sizeof(vec4), &outline[0]);
+      glUniform1ui(objectLoc, OUTLINE);
+      glBindVertexArray(vao[OUTLINE]);
+      glDrawArrays(GL_LINE_LOOP, 0, outline.size());
    }
 
    glutSwapBuffers();
@@ -247,6 +466,7 @@ void animate(int value)
 	  
    if (highlightFrames > 0) highlightFrames--;
    glUniform1i(highlightFramesLoc, highlightFrames);
+   collectPick();
    
    glutPostRedisplay();
    glutTimerFunc(animationPeriod, animate, 1);
@@ -268,6 +488,11 @@ void keyInput(unsigned char key, int x, int y)
 			animate(1);
 		 }
 		 break;
+      case 'g':
+         if (isGpuPicking) isGpuPicking = 0;
+         else isGpuPicking = 1;
+         std::cout << (isGpuPicking ? "GPU" : "CPU") << " picking." << std::endl;
+         break;
       case 'x':
          Xangle += 5.0;
 		 if (Xangle > 360.0) Xangle -= 360.0;
@@ -318,7 +543,10 @@ void printInteraction(void)
    std::cout << "Press space to toggle between animation on and off." << std::endl
 	    << "Press the up/down arrow keys to speed up/slow down animation." << std::endl
         << "Press the x, X, y, Y, z, Z keys to rotate the scene." << std::endl << std::endl
-        << "Click left mouse button to pick either ball or torus." << std::endl;
+        << "Click left mouse button to pick either ball or torus." << std::endl
+        << "Press 'g' to toggle between CPU and GPU picking. When picking on the GPU," << std::endl
+        << "drag with the left mouse button to select objects in a rectangle, or" << std::endl
+        << "with shift held to select objects in a lasso." << std::endl;
 }
 
 
@@ -342,6 +570,7 @@ int main(int argc, char **argv)
    glutSpecialFunc(specialKeyInput);
    glutTimerFunc(5, animate, 1);
    glutMouseFunc(mouseControl); 
+   glutMotionFunc(mouseMotion);
 
    glewExperimental = GL_TRUE;
    glewInit();
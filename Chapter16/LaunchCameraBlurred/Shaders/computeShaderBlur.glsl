@@ -0,0 +1,44 @@
+#version 430 core
+
+#define TILE 256
+#define MAX_RADIUS 32
+
+layout(local_size_x = TILE) in;
+
+layout(rgba8, binding = 0) uniform readonly image2D inImage;
+layout(rgba8, binding = 1) uniform writeonly image2D outImage;
+
+uniform ivec2 direction; // (1, 0) to blur along rows, (0, 1) along columns.
+uniform int radius;
+uniform float weights[MAX_RADIUS + 1];
+
+// A tile of the row (column) with an apron of radius pixels either side.
+shared vec4 line[TILE + 2 * MAX_RADIUS];
+
+void main(void)
+{
+   ivec2 size = imageSize(inImage);
+   ivec2 across = ivec2(direction.y, direction.x);
+   int lineLength = (direction.x == 1) ? size.x : size.y;
+   int lineIndex = int(gl_WorkGroupID.y);
+   int tileStart = int(gl_WorkGroupID.x) * TILE;
+   int localIndex = int(gl_LocalInvocationID.x);
+   int i, pos;
+   vec4 sum;
+
+   // Load the tile and apron, clamping at the image's edges.
+   for (i = localIndex; i < TILE + 2 * radius; i += TILE)
+   {
+      pos = clamp(tileStart + i - radius, 0, lineLength - 1);
+      line[i] = imageLoad(inImage, direction * pos + across * lineIndex);
+   }
+   barrier();
+
+   pos = tileStart + localIndex;
+   if (pos >= lineLength) return;
+
+   sum = weights[0] * line[localIndex + radius];
+   for (i = 1; i <= radius; i++)
+      sum += weights[i] * (line[localIndex + radius - i] + line[localIndex + radius + i]);
+   imageStore(outImage, direction * pos + across * lineIndex, sum);
+}
@@ -3,24 +3,20 @@
 #define LAUNCH 0
 
 in vec2 texCoordsExport;
+in vec4 clipCoordsExport;
+in vec4 prevClipCoordsExport;
 
 uniform sampler2D launchTex;
-uniform uint isBlurred;
+uniform vec2 viewportSize;
 
-out vec4 colorsOut;
-
-vec4 launchTexColor;
+layout(location=0) out vec4 colorsOut;
+layout(location=1) out vec2 velocityOut;
 
 void main(void)
 {  
-   // Not blurred.
-   if (isBlurred == 0) launchTexColor = texture(launchTex, texCoordsExport);
+   colorsOut = texture(launchTex, texCoordsExport);
 
-   // Camera blur implemented with a weighted sum of 4 pixel color values starting with the original pixel and moving right.
-   else launchTexColor = 0.4 * texture(launchTex, texCoordsExport) + 
-	                     0.3 * texture(launchTex, texCoordsExport + vec2(0.005, 0.0)) +
-                         0.2 * texture(launchTex, texCoordsExport + vec2(0.01, 0.0)) + 
-						 0.1 * texture(launchTex, texCoordsExport + vec2(0.015, 0.0));
-   
-   colorsOut = launchTexColor;
-}
\ No newline at end of file
+   // Motion in pixels since last frame.
+   velocityOut = 0.5 * viewportSize * (clipCoordsExport.xy / clipCoordsExport.w - 
+                                       prevClipCoordsExport.xy / prevClipCoordsExport.w);
+}
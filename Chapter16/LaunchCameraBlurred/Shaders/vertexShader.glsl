@@ -6,9 +6,12 @@ layout(location=0) in vec4 launchCoords;
 layout(location=1) in vec2 launchTexCoords;
 
 uniform mat4 modelViewMat;
+uniform mat4 prevModelViewMat;
 uniform mat4 projMat;
 
 out vec2 texCoordsExport;
+out vec4 clipCoordsExport;
+out vec4 prevClipCoordsExport;
 
 vec4 coords;
 
@@ -17,5 +20,9 @@ void main(void)
    coords = launchCoords;
    texCoordsExport = launchTexCoords;
 
-   gl_Position = projMat * modelViewMat * coords;
+   // Positions this frame and last, for the velocity buffer.
+   clipCoordsExport = projMat * modelViewMat * coords;
+   prevClipCoordsExport = projMat * prevModelViewMat * coords;
+
+   gl_Position = clipCoordsExport;
 }
@@ -1,10 +1,17 @@
 ///////////////////////////////////////////////////////////////////////          
 // launchCameraBlurredcpp
 //
-// Camera blur of a texture implemented in the fragment shader.
+// Camera blur of a texture implemented as post-processing. The launch is drawn into a
+// framebuffer object together with a velocity buffer, then blurred by compute shaders,
+// either with a separable Gaussian or box kernel or along the velocity of a camera shake.
 //
 // Interaction:
 // Press space to toggle between blurred and not blurred.
+// Press 'k' to toggle between a Gaussian and a box kernel.
+// Press the +/- keys to increase/decrease the blur radius.
+// Press 'm' to toggle camera shake motion blur.
+// Press '4' to toggle rendering at 3840x2160 and scaling to the window.
+// Press 't' to output the time taken by each pass.
 //
 // Sumanta Guha
 //
@@ -26,6 +33,7 @@
 #include "prepShader.h"
 #include "getBMP.h"
 #include "vertex.h"
+#include "postProcess.h"
 
 using namespace glm;
 
@@ -41,22 +49,27 @@ static Vertex launchVertices[4] =
 	{vec4(-6.0, 6.0, -6.0, 1.0), vec2(0.0, 1.0)}
 }; 
 
-static mat4 modelViewMat, projMat;
+static mat4 modelViewMat, prevModelViewMat, projMat;
 
 static unsigned int
    programId,
    vertexShaderId,
    fragmentShaderId,
    modelViewMatLoc,
+   prevModelViewMatLoc,
    projMatLoc,
+   viewportSizeLoc,
    launchTexLoc, 
-   isBlurredLoc,
    buffer[1], 
    vao[1],
    texture[1]; 
 
 static imageFile *image[1]; // Local storage for bmp image data.
-static uint isBlurred = 0; // Is the texture blurred?
+
+static PostProcess post; // Offscreen targets and blur passes.
+static float cameraShake = 0.18; // Camera's sideways movement per frame when shaking.
+static int isHighRes = 0; // Rendering at 3840x2160?
+static int winWth = 500, winHgt = 500; // OpenGL window sizes.
 
 // Initialization routine.
 void setup(void) 
@@ -93,10 +106,10 @@ void setup(void)
    
    // Obtain modelview matrix uniform locations.
    modelViewMatLoc = glGetUniformLocation(programId,"modelViewMat");  
+   prevModelViewMatLoc = glGetUniformLocation(programId,"prevModelViewMat");  
 
-   // Obtain isBlurred uniform location and set value.
-   isBlurredLoc = glGetUniformLocation(programId, "isBlurred");
-   glUniform1uiv(isBlurredLoc, 1, &isBlurred);
+   // Obtain viewport size uniform location.
+   viewportSizeLoc = glGetUniformLocation(programId, "viewportSize");
 
    // Load the images.
    image[0] = getBMP("../../Textures/launch.bmp"); 
@@ -115,21 +128,33 @@ void setup(void)
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
    launchTexLoc = glGetUniformLocation(programId, "launchTex");
    glUniform1i(launchTexLoc, 0);
+
+   // Create the post-processing targets and passes.
+   createPostProcess(post, winWth, winHgt);
 }
 
 // Drawing routine.
 void drawScene(void)
 {
-   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   // Draw into the post-processing framebuffer.
+   beginPostProcessScene(post);
+   glUseProgram(programId);
+   glUniform2f(viewportSizeLoc, (float)post.width, (float)post.height);
 
-   // Calculate and update modelview matrix.
+   // Calculate and update modelview matrix, and that of last frame, which differs
+   // by the camera's movement if shaking.
    modelViewMat = mat4(1.0);
    glUniformMatrix4fv(modelViewMatLoc, 1, GL_FALSE, value_ptr(modelViewMat)); 
+   prevModelViewMat = post.motionBlur ? translate(modelViewMat, vec3(cameraShake, 0.0, 0.0)) : modelViewMat;
+   glUniformMatrix4fv(prevModelViewMatLoc, 1, GL_FALSE, value_ptr(prevModelViewMat)); 
 
    // Draw launch.
    glBindVertexArray(vao[LAUNCH]);
    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
+   // Blur and show.
+   endPostProcessScene(post);
+
    glutSwapBuffers();
 }
 
@@ -137,6 +162,11 @@ void drawScene(void)
 void resize(int w, int h)
 {
    glViewport(0, 0, w, h); 
+
+   winWth = w;
+   winHgt = h;
+   setPostWindowSize(post, w, h);
+   if (!isHighRes) resizePostProcess(post, w, h);
 }
 
 // Keyboard input processing routine.
@@ -148,10 +178,37 @@ void keyInput(unsigned char key, int x, int y)
          exit(0);
          break;
       case ' ':
-		 isBlurred = isBlurred? 0 : 1;
-		 glUniform1uiv(isBlurredLoc, 1, &isBlurred);
+         post.blur = !post.blur;
+         glutPostRedisplay();
+         break;
+      case 'k':
+         setBlurKernel(post, (post.kernel == POST_GAUSSIAN) ? POST_BOX : POST_GAUSSIAN, post.radius);
+         std::cout << ((post.kernel == POST_GAUSSIAN) ? "Gaussian" : "Box") << " kernel." << std::endl;
+         glutPostRedisplay();
+         break;
+      case '+':
+         setBlurKernel(post, post.kernel, post.radius + 1);
+         std::cout << "Blur radius: " << post.radius << std::endl;
          glutPostRedisplay();
-		 break;
+         break;
+      case '-':
+         setBlurKernel(post, post.kernel, post.radius - 1);
+         std::cout << "Blur radius: " << post.radius << std::endl;
+         glutPostRedisplay();
+         break;
+      case 'm':
+         post.motionBlur = !post.motionBlur;
+         glutPostRedisplay();
+         break;
+      case '4':
+         isHighRes = !isHighRes;
+         if (isHighRes) resizePostProcess(post, 3840, 2160);
+         else resizePostProcess(post, winWth, winHgt);
+         glutPostRedisplay();
+         break;
+      case 't':
+         printPostProcessTimings(post);
+         break;
       default:
          break;
    }
@@ -161,7 +218,12 @@ void keyInput(unsigned char key, int x, int y)
 void printInteraction(void)
 {
    std::cout << "Interaction:" << std::endl;
-   std::cout << "Press space to toggle between blurred and not blurred." << std::endl; 
+   std::cout << "Press space to toggle between blurred and not blurred." << std::endl
+             << "Press 'k' to toggle between a Gaussian and a box kernel." << std::endl
+             << "Press the +/- keys to increase/decrease the blur radius." << std::endl
+             << "Press 'm' to toggle camera shake motion blur." << std::endl
+             << "Press '4' to toggle rendering at 3840x2160 and scaling to the window." << std::endl
+             << "Press 't' to output the time taken by each pass." << std::endl; 
 }
 
 // Main routine.
@@ -36,6 +36,7 @@ int setShader(char* shaderType, char* shaderFile)
    if (shaderType == "tessEvaluation") shaderId = glCreateShader(GL_TESS_EVALUATION_SHADER); 
    if (shaderType == "geometry") shaderId = glCreateShader(GL_GEOMETRY_SHADER); 
    if (shaderType == "fragment") shaderId = glCreateShader(GL_FRAGMENT_SHADER); 
+   if (shaderType == "compute") shaderId = glCreateShader(GL_COMPUTE_SHADER); 
 
    glShaderSource(shaderId, 1, (const char**) &shader, NULL); 
    glCompileShader(shaderId); 
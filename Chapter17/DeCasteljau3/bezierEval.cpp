@@ -0,0 +1,340 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "bezierEval.h"
+
+// Bernstein polynomials of the given order at t by the triangular recurrence.
+static void bernstein(int order, float t, float *B)
+{
+	int j, k;
+	float saved, temp;
+
+	B[0] = 1.0;
+	for (k = 1; k < order; k++)
+	{
+		saved = 0.0;
+		for (j = 0; j < k; j++)
+		{
+			temp = B[j];
+			B[j] = saved + (1.0 - t) * temp;
+			saved = t * temp;
+		}
+		B[k] = saved;
+	}
+}
+
+// Tabulate the Bernstein polynomials of the given order and their derivatives at the
+// parameter values. The derivatives of the polynomials of degree d are differences of
+// those of degree d - 1 and d - 2.
+void createBernsteinTable(BernsteinTable &table, int order, const float *params, int numParams)
+{
+	std::vector<float> B1(order), B2(order);
+	float lower1, lower2;
+	int degree = order - 1, k, n;
+
+	table.order = order;
+	table.numParams = numParams;
+	table.params = new float[numParams];
+	table.B = new float[order * numParams];
+	table.dB = new float[order * numParams];
+	table.ddB = new float[order * numParams];
+
+	for (n = 0; n < numParams; n++)
+	{
+		table.params[n] = params[n];
+		bernstein(order, params[n], &B1[0]);
+		for (k = 0; k < order; k++) table.B[k * numParams + n] = B1[k];
+
+		// First derivatives from degree - 1.
+		if (degree >= 1) bernstein(order - 1, params[n], &B1[0]);
+		for (k = 0; k < order; k++)
+		{
+			if (degree < 1) { table.dB[k * numParams + n] = 0.0; continue; }
+			lower1 = (k > 0) ? B1[k - 1] : 0.0;
+			lower2 = (k < degree) ? B1[k] : 0.0;
+			table.dB[k * numParams + n] = degree * (lower1 - lower2);
+		}
+
+		// Second derivatives from degree - 2.
+		if (degree >= 2) bernstein(order - 2, params[n], &B2[0]);
+		for (k = 0; k < order; k++)
+		{
+			if (degree < 2) { table.ddB[k * numParams + n] = 0.0; continue; }
+			table.ddB[k * numParams + n] = degree * (degree - 1) *
+				(((k >= 2) ? B2[k - 2] : 0.0) - ((k >= 1) && (k - 1 <= degree - 2) ? 2.0 * B2[k - 1] : 0.0) +
+				((k <= degree - 2) ? B2[k] : 0.0));
+		}
+	}
+}
+
+// Tabulate at numParams equally spaced parameter values from 0 to 1.
+void createUniformBernsteinTable(BernsteinTable &table, int order, int numParams)
+{
+	std::vector<float> params(numParams);
+	int n;
+
+	for (n = 0; n < numParams; n++) params[n] = (numParams > 1) ? (float)n / (numParams - 1) : 0.0;
+	createBernsteinTable(table, order, &params[0], numParams);
+}
+
+// Release the table's storage.
+void deleteBernsteinTable(BernsteinTable &table)
+{
+	delete[] table.params;
+	delete[] table.B;
+	delete[] table.dB;
+	delete[] table.ddB;
+	table.params = table.B = table.dB = table.ddB = NULL;
+	table.numParams = 0;
+}
+
+// De Casteljau's algorithm to evaluate at u a Bezier curve of the given order with
+// control points of dimension dim (at most 4). The working points are on the stack up to
+// BEZIER_MAX_ORDER and on the heap beyond.
+void deCasteljau(int order, const float *controlPoints, int dim, float u, float *point)
+{
+	float stackQ[BEZIER_MAX_ORDER][4], (*q)[4] = stackQ;
+	std::vector<float> heapQ;
+	int j, r, c;
+
+	if (order > BEZIER_MAX_ORDER)
+	{
+		heapQ.resize(4 * order);
+		q = (float (*)[4])&heapQ[0];
+	}
+
+	for (j = 0; j < order; j++)
+		for (c = 0; c < dim; c++) q[j][c] = controlPoints[j * dim + c];
+	for (r = 1; r < order; r++)
+		for (j = 0; j < order - r; j++)
+			for (c = 0; c < dim; c++) q[j][c] = (1.0 - u) * q[j][c] + u * q[j + 1][c];
+	for (c = 0; c < dim; c++) point[c] = q[0][c];
+}
+
+// Accumulate sum over k of table[k] * homogeneous control point k (4 floats each) into
+// the co-ordinate arrays acc[0..3], each numParams long. The w co-ordinate is
+// accumulated only for a rational curve.
+static void accumulate(const float *table, int order, int numParams, const float *homogeneous,
+	                   bool rational, float *acc[4])
+{
+	float *ax = acc[0], *ay = acc[1], *az = acc[2], *aw = acc[3];
+	float hx, hy, hz, hw;
+	const float *b;
+	int k, n;
+
+	for (k = 0; k < order; k++)
+	{
+		hx = homogeneous[4 * k];
+		hy = homogeneous[4 * k + 1];
+		hz = homogeneous[4 * k + 2];
+		hw = homogeneous[4 * k + 3];
+		b = table + k * numParams;
+		for (n = 0; n < numParams; n++)
+		{
+			ax[n] += b[n] * hx;
+			ay[n] += b[n] * hy;
+			az[n] += b[n] * hz;
+		}
+		if (rational) for (n = 0; n < numParams; n++) aw[n] += b[n] * hw;
+	}
+}
+
+// Weighted control points in homogeneous co-ordinates.
+static void homogenize(int numPoints, const float *controlPoints, const float *weights, float *homogeneous)
+{
+	int k, c;
+
+	for (k = 0; k < numPoints; k++)
+	{
+		homogeneous[4 * k + 3] = weights ? weights[k] : 1.0;
+		for (c = 0; c < 3; c++) homogeneous[4 * k + c] = controlPoints[3 * k + c] * homogeneous[4 * k + 3];
+	}
+}
+
+// Evaluate at all the table's parameter values the Bezier curve of the table's order
+// with 3D control points and optional weights (NULL for a polynomial curve). Writes
+// points and, where not NULL, unit tangents and unit principal normals, 3 floats each.
+// Where the curve is straight the normal is taken perpendicular to the tangent in
+// the xy-plane.
+void evaluateBezierCurve(const BernsteinTable &table, const float *controlPoints, const float *weights,
+	                     float *points, float *tangents, float *normals)
+{
+	int N = table.numParams, n, c;
+	std::vector<float> A(4 * N, 0.0), dA, ddA, homogeneous(4 * table.order);
+	float *acc[4], C[3], dC[3], ddC[3], w, dw, ddw, length, dot;
+	bool rational = (weights != NULL);
+
+	homogenize(table.order, controlPoints, weights, &homogeneous[0]);
+	for (c = 0; c < 4; c++) acc[c] = &A[c * N];
+	accumulate(table.B, table.order, N, &homogeneous[0], rational, acc);
+	if (tangents || normals)
+	{
+		dA.assign(4 * N, 0.0);
+		for (c = 0; c < 4; c++) acc[c] = &dA[c * N];
+		accumulate(table.dB, table.order, N, &homogeneous[0], rational, acc);
+	}
+	if (normals)
+	{
+		ddA.assign(4 * N, 0.0);
+		for (c = 0; c < 4; c++) acc[c] = &ddA[c * N];
+		accumulate(table.ddB, table.order, N, &homogeneous[0], rational, acc);
+	}
+
+	// Points only, interleaved from the co-ordinate arrays.
+	if (!tangents && !normals)
+	{
+		if (rational)
+			for (n = 0; n < N; n++)
+			{
+				w = 1.0 / A[3 * N + n];
+				for (c = 0; c < 3; c++) points[3 * n + c] = A[c * N + n] * w;
+			}
+		else
+			for (n = 0; n < N; n++)
+				for (c = 0; c < 3; c++) points[3 * n + c] = A[c * N + n];
+		return;
+	}
+
+	for (n = 0; n < N; n++)
+	{
+		w = rational ? A[3 * N + n] : 1.0;
+		for (c = 0; c < 3; c++) points[3 * n + c] = C[c] = A[c * N + n] / w;
+
+		// Quotient rule for the derivatives of the projected curve.
+		dw = rational ? dA[3 * N + n] : 0.0;
+		for (c = 0; c < 3; c++) dC[c] = (dA[c * N + n] - dw * C[c]) / w;
+		length = sqrt(dC[0] * dC[0] + dC[1] * dC[1] + dC[2] * dC[2]);
+		if (length > 0.0) for (c = 0; c < 3; c++) dC[c] /= length;
+		if (tangents) for (c = 0; c < 3; c++) tangents[3 * n + c] = dC[c];
+		if (!normals) continue;
+
+		ddw = rational ? ddA[3 * N + n] : 0.0;
+		for (c = 0; c < 3; c++) ddC[c] = (ddA[c * N + n] - 2.0 * dw * dC[c] * length - ddw * C[c]) / w;
+		dot = ddC[0] * dC[0] + ddC[1] * dC[1] + ddC[2] * dC[2];
+		for (c = 0; c < 3; c++) ddC[c] -= dot * dC[c];
+		length = sqrt(ddC[0] * ddC[0] + ddC[1] * ddC[1] + ddC[2] * ddC[2]);
+		if (length > 1.0e-6) for (c = 0; c < 3; c++) normals[3 * n + c] = ddC[c] / length;
+		else
+		{
+			normals[3 * n] = -dC[1];
+			normals[3 * n + 1] = dC[0];
+			normals[3 * n + 2] = 0.0;
+		}
+	}
+}
+
+// Evaluate the Bezier curve with 3D control points and optional weights at numSteps + 1
+// equally spaced parameter values from 0 to 1 by forward differencing, which costs one
+// addition per degree and co-ordinate for each point. Differences are kept in double
+// precision, but the error still grows as numSteps to the power of the degree, so this
+// suits low-degree curves; use evaluateBezierCurve() otherwise.
+void evaluateBezierCurveForwardDiff(int order, const float *controlPoints, const float *weights,
+	                                int numSteps, float *points)
+{
+	double stackD[BEZIER_MAX_ORDER][4], stackQ[BEZIER_MAX_ORDER][4], (*D)[4] = stackD, (*q)[4] = stackQ, u;
+	std::vector<double> heapDQ;
+	int degree = order - 1, j, k, r, c, n;
+
+	if (order > BEZIER_MAX_ORDER)
+	{
+		heapDQ.resize(8 * order);
+		D = (double (*)[4])&heapDQ[0];
+		q = (double (*)[4])&heapDQ[4 * order];
+	}
+
+	// Values at the first order parameter values by de Casteljau's algorithm, then
+	// differenced in place so that D[r] is the r-th forward difference at 0. Both in
+	// double precision, as the differences lose digits.
+	for (j = 0; j < order; j++)
+	{
+		u = (double)j / numSteps;
+		for (k = 0; k < order; k++)
+		{
+			q[k][3] = weights ? weights[k] : 1.0;
+			for (c = 0; c < 3; c++) q[k][c] = controlPoints[3 * k + c] * q[k][3];
+		}
+		for (r = 1; r < order; r++)
+			for (k = 0; k < order - r; k++)
+				for (c = 0; c < 4; c++) q[k][c] = (1.0 - u) * q[k][c] + u * q[k + 1][c];
+		for (c = 0; c < 4; c++) D[j][c] = q[0][c];
+	}
+	for (r = 1; r <= degree; r++)
+		for (j = degree; j >= r; j--)
+			for (c = 0; c < 4; c++) D[j][c] -= D[j - 1][c];
+
+	for (n = 0; n <= numSteps; n++)
+	{
+		for (c = 0; c < 3; c++) points[3 * n + c] = D[0][c] / D[0][3];
+		for (r = 0; r < degree; r++)
+			for (c = 0; c < 4; c++) D[r][c] += D[r + 1][c];
+	}
+}
+
+// Evaluate the Bezier surface with control point i along v and j along u at
+// controlPoints[3*(i*uOrder + j)], and optional weights at weights[i*uOrder + j], at every
+// pair of the tables' parameter values. Writes points and, where not NULL, unit normals
+// Su x Sv, 3 floats each, for u-parameter k and v-parameter l at index l*uParams + k.
+void evaluateBezierSurface(const BernsteinTable &uTable, const BernsteinTable &vTable,
+	                       const float *controlPoints, const float *weights, float *points, float *normals)
+{
+	int uOrder = uTable.order, vOrder = vTable.order, NU = uTable.numParams, NV = vTable.numParams;
+	int i, j, l, n, c;
+	std::vector<float> homogeneous(4 * uOrder * vOrder), rows(4 * uOrder), dRows(4 * uOrder);
+	std::vector<float> A(4 * NU), Au(4 * NU), Av(4 * NU);
+	float *acc[4], vB, vdB, S[3], Su[3], Sv[3], w, dw, length, *normal;
+	bool rational = (weights != NULL);
+
+	homogenize(uOrder * vOrder, controlPoints, weights, &homogeneous[0]);
+	for (l = 0; l < NV; l++)
+	{
+		// Collapse each column of control points along v to a homogeneous point and its
+		// v-derivative, the control points of a curve along u.
+		rows.assign(4 * uOrder, 0.0);
+		dRows.assign(4 * uOrder, 0.0);
+		for (i = 0; i < vOrder; i++)
+		{
+			vB = vTable.B[i * NV + l];
+			vdB = vTable.dB[i * NV + l];
+			for (j = 0; j < uOrder; j++)
+				for (c = 0; c < 4; c++)
+				{
+					rows[4 * j + c] += vB * homogeneous[4 * (i * uOrder + j) + c];
+					dRows[4 * j + c] += vdB * homogeneous[4 * (i * uOrder + j) + c];
+				}
+		}
+
+		A.assign(4 * NU, 0.0);
+		for (c = 0; c < 4; c++) acc[c] = &A[c * NU];
+		accumulate(uTable.B, uOrder, NU, &rows[0], rational, acc);
+		if (normals)
+		{
+			Au.assign(4 * NU, 0.0);
+			for (c = 0; c < 4; c++) acc[c] = &Au[c * NU];
+			accumulate(uTable.dB, uOrder, NU, &rows[0], rational, acc);
+			Av.assign(4 * NU, 0.0);
+			for (c = 0; c < 4; c++) acc[c] = &Av[c * NU];
+			accumulate(uTable.B, uOrder, NU, &dRows[0], rational, acc);
+		}
+
+		for (n = 0; n < NU; n++)
+		{
+			w = rational ? A[3 * NU + n] : 1.0;
+			for (c = 0; c < 3; c++) points[3 * (l * NU + n) + c] = S[c] = A[c * NU + n] / w;
+			if (!normals) continue;
+			for (c = 0; c < 3; c++)
+			{
+				dw = rational ? Au[3 * NU + n] : 0.0;
+				Su[c] = (Au[c * NU + n] - dw * S[c]) / w;
+				dw = rational ? Av[3 * NU + n] : 0.0;
+				Sv[c] = (Av[c * NU + n] - dw * S[c]) / w;
+			}
+			normal = &normals[3 * (l * NU + n)];
+			normal[0] = Su[1] * Sv[2] - Su[2] * Sv[1];
+			normal[1] = Su[2] * Sv[0] - Su[0] * Sv[2];
+			normal[2] = Su[0] * Sv[1] - Su[1] * Sv[0];
+			length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 0.0) for (c = 0; c < 3; c++) normal[c] /= length;
+		}
+	}
+}
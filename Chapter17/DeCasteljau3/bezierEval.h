@@ -0,0 +1,31 @@
+#ifndef BEZIEREVAL_H
+#define BEZIEREVAL_H
+
+#define BEZIER_MAX_ORDER 16 // Highest order evaluated in stack arrays, higher ones using the heap.
+
+// Bernstein polynomials of one order and their first two derivatives tabulated at a
+// fixed set of parameter values. Entry k*numParams + n of each array is the value of the
+// k-th polynomial at the n-th parameter value, so that evaluating a curve runs down
+// consecutive parameter values in the innermost loop, which the compiler vectorizes.
+struct BernsteinTable
+{
+	int order; // Order of the polynomials, one more than the degree.
+	int numParams; // Number of parameter values.
+	float *params; // The parameter values.
+	float *B, *dB, *ddB; // The polynomials and their first and second derivatives.
+};
+
+void createBernsteinTable(BernsteinTable &table, int order, const float *params, int numParams);
+void createUniformBernsteinTable(BernsteinTable &table, int order, int numParams);
+void deleteBernsteinTable(BernsteinTable &table);
+
+void deCasteljau(int order, const float *controlPoints, int dim, float u, float *point);
+
+void evaluateBezierCurve(const BernsteinTable &table, const float *controlPoints, const float *weights,
+	                     float *points, float *tangents, float *normals);
+void evaluateBezierCurveForwardDiff(int order, const float *controlPoints, const float *weights,
+	                                int numSteps, float *points);
+void evaluateBezierSurface(const BernsteinTable &uTable, const BernsteinTable &vTable,
+	                       const float *controlPoints, const float *weights, float *points, float *normals);
+
+#endif
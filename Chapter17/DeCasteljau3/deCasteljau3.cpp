@@ -4,18 +4,26 @@
 // This program illustrates de Casteljau's algorithm to create a quadratic
 // Bezier curve approximating 3 control points.
 //
+// The curve is evaluated on the CPU by the batched Bernstein evaluator in
+// bezierEval.cpp rather than by OpenGL evaluators.
+//
 // Interaction: 
 // Press the left/right arrows to decrease/increase the curve parameter u. 
+// Press 'b' to time the curve evaluators, output to the C++ window.
 //
 // Sumanta Guha
 //////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "bezierEval.h"
+
 // Begin globals.
 static float u = 0.0; // Curve parameter.
 static char theStringBuffer[10]; // String buffer.
@@ -26,6 +34,8 @@ static float ctrlpoints[3][3] =
 {
 	{ -40.0, -20.0, 0.0 },{ 0.0, 40.0, 0.0 },{ 40.0, -20.0, 0.0 }
 };
+
+static float curvePoints[101][3]; // Points on the curve at u = 0, 0.01, ..., 1.
 // End globals.
 
 // Routine to draw a bitmap character string.
@@ -46,13 +56,21 @@ void floatToString(char * destStr, int precision, float val)
 // Initialization routine.
 void setup(void)
 {
+	BernsteinTable table;
+
 	glClearColor(1.0, 1.0, 1.0, 0.0);
+
+	// The curve points are evaluated once as the control points are fixed.
+	createUniformBernsteinTable(table, 3, 101);
+	evaluateBezierCurve(table, &ctrlpoints[0][0], NULL, &curvePoints[0][0], NULL, NULL);
+	deleteBernsteinTable(table);
 }
 
 // Drawing routine.
 void drawScene(void)
 {
 	int i;
+	float point[3];
 
 	glClear(GL_COLOR_BUFFER_BIT);
 
@@ -66,10 +84,10 @@ void drawScene(void)
 	// The Bezier curve is drawn from 0 to parameter value.
 	glColor3f(1.0, 0.0, 1.0);
 	glLineWidth(2.0);
-	glMap1f(GL_MAP1_VERTEX_3, 0.0, 1.0, 3, 3, &ctrlpoints[0][0]);
-	glEnable(GL_MAP1_VERTEX_3);
-	glMapGrid1f(100, 0.0, 1.0);
-	glEvalMesh1(GL_LINE, 0, (int)(u * 100));
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, curvePoints);
+	glDrawArrays(GL_LINE_STRIP, 0, (int)(u * 100) + 1);
+	glDisableClientState(GL_VERTEX_ARRAY);
 	glLineWidth(1.0);
 
 	// The control points as dots.
@@ -88,19 +106,17 @@ void drawScene(void)
 	glEnd();
 
 	// The point interpolating between the first two control points.
-	glMap1f(GL_MAP1_VERTEX_3, 0.0, 1.0, 3, 2, &ctrlpoints[0][0]);
-	glEnable(GL_MAP1_VERTEX_3);
+	deCasteljau(2, &ctrlpoints[0][0], 3, u, point);
 	glColor3f(1.0, 0.0, 0.0);
 	glBegin(GL_POINTS);
-	glEvalCoord1f(u);
+	glVertex3fv(point);
 	glEnd();
 
 	// The point interpolating between the last two control points.
-	glMap1f(GL_MAP1_VERTEX_3, 0.0, 1.0, 3, 2, &ctrlpoints[1][0]);
-	glEnable(GL_MAP1_VERTEX_3);
+	deCasteljau(2, &ctrlpoints[1][0], 3, u, point);
 	glColor3f(0.0, 1.0, 0.0);
 	glBegin(GL_POINTS);
-	glEvalCoord1f(u);
+	glVertex3fv(point);
 	glEnd();
 
 	// The line joining the two points drawn above.
@@ -115,17 +131,41 @@ void drawScene(void)
 	glEnd();
 
 	// The point interpolating between the two points drawn above.
-	glColor3f(1.0, 0.0, 0.0);
-	glMap1f(GL_MAP1_VERTEX_3, 0.0, 1.0, 3, 3, &ctrlpoints[0][0]);
-	glEnable(GL_MAP1_VERTEX_3);
+	deCasteljau(3, &ctrlpoints[0][0], 3, u, point);
 	glColor3f(0.0, 0.0, 1.0);
 	glBegin(GL_POINTS);
-	glEvalCoord1f(u);
+	glVertex3fv(point);
 	glEnd();
 
 	glutSwapBuffers();
 }
 
+// Routine to time evaluation of the curve at a million parameter values by the
+// Bernstein table and by forward differencing.
+void benchmarkCurve(void)
+{
+	const int numParams = 1000000, numRuns = 10;
+	BernsteinTable table;
+	std::vector<float> points(3 * numParams);
+	std::chrono::steady_clock::time_point start;
+	double seconds;
+	int i;
+
+	createUniformBernsteinTable(table, 3, numParams);
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < numRuns; i++)
+		evaluateBezierCurve(table, &ctrlpoints[0][0], NULL, &points[0], NULL, NULL);
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Bernstein table: " << numRuns * numParams / seconds / 1.0e6 << " million points/sec" << std::endl;
+	deleteBernsteinTable(table);
+
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < numRuns; i++)
+		evaluateBezierCurveForwardDiff(3, &ctrlpoints[0][0], NULL, numParams - 1, &points[0]);
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Forward differencing: " << numRuns * numParams / seconds / 1.0e6 << " million points/sec" << std::endl;
+}
+
 // OpenGL window reshape routine.
 void resize(int w, int h)
 {
@@ -145,6 +185,9 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'b':
+		benchmarkCurve();
+		break;
 	default:
 		break;
 	}
@@ -165,6 +208,7 @@ void printInteraction(void)
 {
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press the left/right arrows to decrease/increase the curve parameter u." << std::endl;
+	std::cout << "Press 'b' to time the curve evaluators." << std::endl;
 }
 
 // Main routine.
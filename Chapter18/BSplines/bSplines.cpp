@@ -11,15 +11,24 @@
 // Press space to select a knot points.
 // Press the left/right arrow keys to move the selected knot point.
 // Press delete to reset knot values.
+// Press 'b' to benchmark curve evaluation, written to the C++ window.
+//
+// The B-spline values are looked up from a table of the non-zero basis functions
+// at each drawing parameter value, which is refreshed only over the parameter
+// interval affected when a knot moves.
 //
 // Sumanta Guha
 ///////////////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <cmath>
+#include <chrono>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "bSplineBasis.h"
+
 // Begin globals.
 static int selectedKnot = 0; // Selected knot number.
 static int splineOrder = 1; // Order of spline.
@@ -27,6 +36,8 @@ static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
 
 // Knot values scaled by a factor of 10 to avoid floating point error when comparing knot values.
 static float knots[9] = { 0.0, 10.0, 20.0, 30.0, 40.0, 50.0, 60.0, 70.0, 80.0 };
+
+static BasisTable basisTable; // Non-zero B-spline values of the current order on the drawing grid.
 // End globals.
 
 // Routine to draw a bitmap character string.
@@ -37,10 +48,47 @@ void writeBitmapString(void *font, char *string)
 	for (c = string; *c != '\0'; c++) glutBitmapCharacter(font, *c);
 }
 
+// Tabulate from scratch the B-splines of the current order.
+void rebuildBasisTable(void)
+{
+	deleteBasisTable(basisTable);
+	createBasisTable(basisTable, splineOrder, 0.0, 80.0, 0.005);
+	fillBasisTable(basisTable, knots, 9, 0.0, 80.0);
+}
+
+// Re-tabulate only where the B-splines changed after knots moved from oldKnots.
+// A B-spline of order m depends on knots i through i+m, so the change is confined to
+// the m knot spans either side of the moved knots, taken before and after the move.
+void updateBasisTable(float oldKnots[9])
+{
+	int i, first = 9, last = -1;
+	float uLo, uHi;
+
+	for (i = 0; i < 9; i++)
+		if (oldKnots[i] != knots[i])
+		{
+			if (first == 9) first = i;
+			last = i;
+		}
+	if (last == -1) return;
+
+	first = (first - splineOrder < 0) ? 0 : first - splineOrder;
+	last = (last + splineOrder > 8) ? 8 : last + splineOrder;
+	uLo = (oldKnots[first] < knots[first]) ? oldKnots[first] : knots[first];
+	uHi = (oldKnots[last] > knots[last]) ? oldKnots[last] : knots[last];
+	fillBasisTable(basisTable, knots, 9, uLo, uHi);
+
+	// Grid points beyond the end knots take the end non-empty spans, so refresh them too.
+	fillBasisTable(basisTable, knots, 9, 0.0, (oldKnots[0] > knots[0]) ? oldKnots[0] : knots[0]);
+	fillBasisTable(basisTable, knots, 9, (oldKnots[8] < knots[8]) ? oldKnots[8] : knots[8], 80.0);
+}
+
 // Initialization routine.
 void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
+
+	rebuildBasisTable();
 }
 
 // Function to increase value of a knot.
@@ -79,9 +127,10 @@ void resetKnots(void)
 	int i;
 	for (i = 0; i < 9; i++) knots[i] = 10.0*i;
 	selectedKnot = 0;
+	fillBasisTable(basisTable, knots, 9, 0.0, 80.0);
 }
 
-// Recursive computation of B-spline functions.
+// Recursive computation of B-spline functions, kept as the reference for the benchmark.
 float Bspline(int index, int order, float u)
 {
 	float coef1, coef2;
@@ -114,8 +163,8 @@ float Bspline(int index, int order, float u)
 // Draw a B-spline function graph as line strip and joints as points.
 void drawSpline(int index, int order)
 {
-	float x;
-	int j;
+	float x, N[MAX_ORDER];
+	int g, gFirst, gLast, j, span;
 
 	// Drawing are scaled by factor of 3 in the y-direction.
 	// Special case to handle order 1 to avoid vertical edges.
@@ -136,17 +185,27 @@ void drawSpline(int index, int order)
 	}
 	else
 	{
-		// Spline curve.
+		// Spline curve from the grid points of the basis table under the B-spline's support.
+		gFirst = (int)ceil((knots[index] - basisTable.uMin) / basisTable.uStep - 0.001);
+		gLast = (int)floor((knots[index + order] - basisTable.uMin) / basisTable.uStep + 0.001);
 		glBegin(GL_LINE_STRIP);
-		for (x = knots[index]; x <= knots[index + order]; x += 0.005)
-			glVertex3f(-40.0 + x, 30 * Bspline(index, order, x) - 20.0, 0.0);
+		for (g = gFirst; g <= gLast; g++)
+		{
+			x = basisTable.uMin + g * basisTable.uStep;
+			glVertex3f(-40.0 + x,
+				30 * basisValue(basisTable.values[g], basisTable.spans[g], order, index) - 20.0, 0.0);
+		}
 		glEnd();
 
 		// Joints.
 		glColor3f(0.0, 0.0, 0.0);
 		glBegin(GL_POINTS);
 		for (j = index; j <= index + order; j++)
-			glVertex3f(-40.0 + knots[j], 30 * Bspline(index, order, knots[j]) - 20.0, 0.0);
+		{
+			span = findSpan(knots, 9, knots[j]);
+			basisFuns(knots, 9, span, order, knots[j], N);
+			glVertex3f(-40.0 + knots[j], 30 * basisValue(N, span, order, index) - 20.0, 0.0);
+		}
 		glEnd();
 	}
 }
@@ -322,6 +381,90 @@ void resize(int w, int h)
 	glLoadIdentity();
 }
 
+// Time evaluation of points on the B-spline curve with the current order and knots,
+// and control points alternating in height, by summing recursively computed B-splines,
+// by de Boor's algorithm and by lookup in the basis table. The throughputs are written
+// to the C++ window.
+void benchmarkCurve(void)
+{
+	float controlPoints[8][2], point[2], u, uLo, uHi, *N, clampedN[MAX_ORDER];
+	int numControlPoints = 9 - splineOrder, numPoints, g, i, k, span, repeat;
+	int repeats = 20;
+	double seconds;
+	volatile float sink = 0.0; // Stops the compiler discarding the evaluations.
+	std::chrono::high_resolution_clock::time_point start;
+
+	for (i = 0; i < numControlPoints; i++)
+	{
+		controlPoints[i][0] = 10.0*i;
+		controlPoints[i][1] = (i % 2) ? 10.0 : -10.0;
+	}
+
+	// The curve's domain runs between knots splineOrder - 1 and numControlPoints.
+	uLo = knots[splineOrder - 1];
+	uHi = knots[numControlPoints];
+	numPoints = 0;
+	for (g = 0; g < basisTable.numSamples; g++)
+	{
+		u = basisTable.uMin + g * basisTable.uStep;
+		if ((u >= uLo) && (u <= uHi)) numPoints++;
+	}
+	if (numPoints == 0) return;
+
+	std::cout << "Order " << splineOrder << " curve, " << numPoints << " points per pass:" << std::endl;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (repeat = 0; repeat < repeats; repeat++)
+		for (g = 0; g < basisTable.numSamples; g++)
+		{
+			u = basisTable.uMin + g * basisTable.uStep;
+			if ((u < uLo) || (u > uHi)) continue;
+			point[0] = point[1] = 0.0;
+			for (i = 0; i < numControlPoints; i++)
+				for (k = 0; k < 2; k++) point[k] += controlPoints[i][k] * Bspline(i, splineOrder, u);
+			sink = sink + point[1];
+		}
+	seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << "  Recursive B-splines: " << repeats * numPoints / seconds << " points/sec" << std::endl;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (repeat = 0; repeat < repeats; repeat++)
+		for (g = 0; g < basisTable.numSamples; g++)
+		{
+			u = basisTable.uMin + g * basisTable.uStep;
+			if ((u < uLo) || (u > uHi)) continue;
+			deBoor(knots, 9, splineOrder, controlPoints[0], 2, u, point);
+			sink = sink + point[1];
+		}
+	seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << "  De Boor's algorithm: " << repeats * numPoints / seconds << " points/sec" << std::endl;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (repeat = 0; repeat < repeats; repeat++)
+		for (g = 0; g < basisTable.numSamples; g++)
+		{
+			u = basisTable.uMin + g * basisTable.uStep;
+			if ((u < uLo) || (u > uHi)) continue;
+			span = basisTable.spans[g];
+			N = basisTable.values[g];
+
+			// At the ends of the domain the table's span may lie outside it, as the table
+			// covers every knot span; take the end span within it, as deBoor() does.
+			if ((span < splineOrder - 1) || (span > numControlPoints - 1))
+			{
+				span = (span < splineOrder - 1) ? splineOrder - 1 : numControlPoints - 1;
+				basisFuns(knots, 9, span, splineOrder, u, clampedN);
+				N = clampedN;
+			}
+			point[0] = point[1] = 0.0;
+			for (i = 0; i < splineOrder; i++)
+				for (k = 0; k < 2; k++) point[k] += controlPoints[span - splineOrder + 1 + i][k] * N[i];
+			sink = sink + point[1];
+		}
+	seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << "  Basis table lookup:  " << repeats * numPoints / seconds << " points/sec" << std::endl;
+}
+
 // Keyboard input processing routine.
 void keyInput(unsigned char key, int x, int y)
 {
@@ -339,6 +482,9 @@ void keyInput(unsigned char key, int x, int y)
 		resetKnots();
 		glutPostRedisplay();
 		break;
+	case 'b':
+		benchmarkCurve();
+		break;
 	default:
 		break;
 	}
@@ -347,15 +493,23 @@ void keyInput(unsigned char key, int x, int y)
 // Callback routine for non-ASCII key entry.
 void specialKeyInput(int key, int x, int y)
 {
+	int i;
+	float oldKnots[9];
+
+	for (i = 0; i < 9; i++) oldKnots[i] = knots[i];
 	if (key == GLUT_KEY_LEFT) decreaseKnot(selectedKnot);
 	if (key == GLUT_KEY_RIGHT) increaseKnot(selectedKnot);
+	updateBasisTable(oldKnots);
+
 	if (key == GLUT_KEY_UP)
 	{
 		if (splineOrder < 4) splineOrder++; else splineOrder = 1;
+		rebuildBasisTable();
 	}
 	if (key == GLUT_KEY_DOWN)
 	{
 		if (splineOrder > 1) splineOrder--; else splineOrder = 4;
+		rebuildBasisTable();
 	}
 	glutPostRedisplay();
 }
@@ -367,7 +521,8 @@ void printInteraction(void)
 	std::cout << "Press the up/down arrow keys to cycle between order 1 through 4." << std::endl
 		<< "Press space to select a knot points." << std::endl
 		<< "Press the left/right arrow keys to move the selected knot point." << std::endl
-		<< "Press delete to reset." << std::endl;
+		<< "Press delete to reset." << std::endl
+		<< "Press 'b' to benchmark curve evaluation." << std::endl;
 }
 
 // Main routine.
@@ -0,0 +1,30 @@
+#ifndef BSPLINEBASIS_H
+#define BSPLINEBASIS_H
+
+#define MAX_ORDER 4 // Highest B-spline order handled.
+
+// Table of the non-zero B-spline basis values of one order sampled on a fixed
+// parameter grid. Grid point g is at parameter value uMin + g*uStep.
+struct BasisTable
+{
+	int order; // Order of the tabulated B-splines.
+	int numSamples; // Number of grid points.
+	float uMin; // Parameter value of the first grid point.
+	float uStep; // Grid spacing.
+	int *spans; // Knot span containing each grid point.
+	float (*values)[MAX_ORDER]; // Non-zero basis values at each grid point.
+};
+
+int findSpan(const float *knots, int numKnots, float u);
+void basisFuns(const float *knots, int numKnots, int span, int order, float u, float *N);
+void basisFunsDerivs(const float *knots, int numKnots, int span, int order, float u,
+	                float *N, float *dN);
+float basisValue(const float *N, int span, int order, int index);
+void deBoor(const float *knots, int numKnots, int order,
+	        const float *controlPoints, int dim, float u, float *point);
+
+void createBasisTable(BasisTable &table, int order, float uMin, float uMax, float uStep);
+void fillBasisTable(BasisTable &table, const float *knots, int numKnots, float uLo, float uHi);
+void deleteBasisTable(BasisTable &table);
+
+#endif
@@ -4,6 +4,10 @@
 // This program draws the bicubic B-spline approximation of a 15x10 array of 
 // movable control points over a fixed standard knot vector in either direction.
 //
+// The surface is tessellated by nurbsSurface.cpp into a cached mesh rather than
+// by GLU every frame. Each knot span is divided into steps of at most 25 pixels on
+// screen, and only the patches under a moved control point are re-evaluated.
+//
 // Interaction:
 // Press space, backspace, tab and enter keys to select a control point.
 // Press the right/left arrow keys to move the control point up/down the x-axis.
@@ -20,11 +24,13 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "nurbsSurface.h"
+
 // Begin globals.
 static float controlPoints[15][10][3]; // Control points.
 static float Xangle = 30.0, Yangle = 10.0, Zangle = 40.0; // Angles to rotate surface.
 static int rowCount = 0, columnCount = 0; // Indexes of selected control point.
-static GLUnurbsObj *nurbsObject; // Pointer to NURBS object.
+static NurbsSurface surface; // Tessellated spline surface.
 
 // Standard knot vector along the u-parameter.
 static float uknots[19] =
@@ -65,13 +71,15 @@ void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 
-	// Create NURBS object.
-	nurbsObject = gluNewNurbsRenderer();
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_METHOD, GLU_PATH_LENGTH);
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_TOLERANCE, 100.0);
-	gluNurbsProperty(nurbsObject, GLU_DISPLAY_MODE, GLU_OUTLINE_POLYGON);
-
 	resetControlPoints();
+
+	// Define the spline surface.
+	surface.uknots = uknots; surface.numUKnots = 19; surface.uOrder = 4;
+	surface.vknots = vknots; surface.numVKnots = 14; surface.vOrder = 4;
+	surface.controlPoints = controlPoints[0][0]; surface.dim = 3;
+	surface.tolerance = 25.0;
+	surface.texScale[0] = 1.0; surface.texScale[1] = 1.0;
+	createNurbsSurface(surface);
 }
 
 // Drawing routine.
@@ -88,12 +96,11 @@ void drawScene(void)
 	glRotatef(Yangle, 0.0, 1.0, 0.0);
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
-	// Draw the spline surface.
+	// Draw the spline surface in outline.
 	glColor3f(0.0, 0.0, 0.0);
-	gluBeginSurface(nurbsObject);
-	gluNurbsSurface(nurbsObject, 19, uknots, 14, vknots,
-		30, 3, controlPoints[0][0], 4, 4, GL_MAP2_VERTEX_3);
-	gluEndSurface(nurbsObject);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	drawNurbsSurface(surface);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 	glPointSize(5.0);
 
@@ -8,6 +8,11 @@
 // The bicubic B-spline is the approximation of a 15x10 array of movable control 
 // points over a fixed standard knot vector in either direction.
 //
+// The surface is tessellated by nurbsSurface.cpp into a cached mesh with normals
+// and texture co-ordinates rather than by GLU every frame. Each knot span is divided
+// into steps of at most 10 pixels on screen, and only the patches under a moved
+// control point are re-evaluated.
+//
 // Interaction:
 // Press space, backspace, tab and enter keys to select a control point.
 // Press the right/left arrow keys to move the control point up/down the x-axis.
@@ -29,6 +34,7 @@
 #include <GL/freeglut.h> 
 
 #include "getBMP.h"
+#include "nurbsSurface.h"
 
 // Begin globals.
 static unsigned int texture[1]; // Array of texture indices.
@@ -38,18 +44,11 @@ static float theta = 45.0; // Angle of the sun with the ground.
 static float Xangle = 30.0, Yangle = 10.0, Zangle = 40.0; // Angles to rotate surface.
 static int rowCount = 0, columnCount = 0; // Indexes of selected control point.
 static float lightPos[] = { 0.0, 3.0, -13.0, 1.0 }; // Light position vector
-static GLUnurbsObj *nurbsObject; // Pointer to NURBS object.
+static NurbsSurface surface; // Tessellated spline surface.
 
 // Control points for a real bicubic spline surface.
 static float controlPoints[15][10][3];
 
-// Control points for a spline surface in texture space.
-static float texturePoints[2][2][2] =
-{
-	{ { 0.0, 0.0 },{ 0.0, 5.0 } },
-	{ { 5.0, 0.0 },{ 5.0, 5.0 } }
-};
-
 // Standard knot vector along the u-parameter for the real spline surface.
 static float uknots[19] =
 { 0.0, 0.0, 0.0, 0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0,
@@ -59,14 +58,6 @@ static float uknots[19] =
 static float vknots[14] =
 { 0.0, 0.0, 0.0, 0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0,
 7.0, 7.0, 7.0, 7.0 };
-
-// Standard knot vector along the u-parameter for the spline surface in texture space.
-static float uTextureknots[4] =
-{ 0.0, 0.0, 12.0, 12.0 };
-
-// Standard knot vector along the v-parameter for the spline surface in texture space.
-static float vTextureknots[4] =
-{ 0.0, 0.0, 7.0, 7.0 };
 // End globals.
 
 // Routine to draw a stroke character string.
@@ -153,15 +144,17 @@ void setup(void)
 	// Turn on OpenGL texturing.
 	glEnable(GL_TEXTURE_2D);
 
-	// Create NURBS object.
-	nurbsObject = gluNewNurbsRenderer();
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_METHOD, GLU_PATH_LENGTH);
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_TOLERANCE, 100.0);
-	gluNurbsProperty(nurbsObject, GLU_DISPLAY_MODE, GLU_FILL);
-
 	resetControlPoints(); // Fill control points array for real spline surface.
 
-	glEnable(GL_AUTO_NORMAL); // Enable automatic normal calculation.
+	// Define the spline surface. The texture is repeated 5 times in either direction
+	// over the parameter domain, as a bilinear map from the corners of the domain to
+	// texture co-ordinates (0,0), (5,0), (0,5) and (5,5).
+	surface.uknots = uknots; surface.numUKnots = 19; surface.uOrder = 4;
+	surface.vknots = vknots; surface.numVKnots = 14; surface.vOrder = 4;
+	surface.controlPoints = controlPoints[0][0]; surface.dim = 3;
+	surface.tolerance = 10.0;
+	surface.texScale[0] = 5.0; surface.texScale[1] = 5.0;
+	createNurbsSurface(surface);
 }
 
 // Drawing routine.
@@ -194,12 +187,7 @@ void drawScene(void)
 
 	// Create the spline surface and map the grass texture onto it.
 	glBindTexture(GL_TEXTURE_2D, texture[0]);
-	gluBeginSurface(nurbsObject);
-	gluNurbsSurface(nurbsObject, 19, uknots, 14, vknots,
-		30, 3, controlPoints[0][0], 4, 4, GL_MAP2_VERTEX_3);
-	gluNurbsSurface(nurbsObject, 4, uTextureknots, 4, vTextureknots,
-		4, 2, texturePoints[0][0], 2, 2, GL_MAP2_TEXTURE_COORD_2);
-	gluEndSurface(nurbsObject);
+	drawNurbsSurface(surface);
 
 	glDisable(GL_LIGHTING); // Disable lighting.
 	glDisable(GL_TEXTURE_2D); // Disable texturing.
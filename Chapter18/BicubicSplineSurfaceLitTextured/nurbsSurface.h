@@ -0,0 +1,63 @@
+#ifndef NURBSSURFACE_H
+#define NURBSSURFACE_H
+
+#include <vector>
+
+#include "bSplineBasis.h"
+
+#define NURBS_MAX_SPAN_SAMPLES 64 // Most tessellation steps across one knot span.
+
+// Basis values and derivatives at one tessellation parameter value.
+struct NurbsSample
+{
+	float param; // Parameter value.
+	int span; // Knot span containing it.
+	float N[MAX_ORDER]; // Non-zero B-spline values.
+	float dN[MAX_ORDER]; // Their derivatives.
+};
+
+// A NURBS surface tessellated into a cached indexed triangle mesh with normals and
+// texture co-ordinates. The caller fills in the definition, then createNurbsSurface()
+// and drawNurbsSurface() every frame. Each knot span pair is a patch. The number of
+// steps across each u-span (v-span) is chosen from the screen-space length of its
+// control polygon, shared by the whole column (row) of patches so that neighbouring
+// patches meet without cracks. Grid cells outside the trimming loops are dropped, and
+// those the loops cross are clipped along the line between the points where the loops
+// cross their edges, so that the trimmed edge follows the loops to within a cell. Patches
+// are re-evaluated only when one of their control points has changed, and the mesh is
+// rebuilt only when the steps change.
+struct NurbsSurface
+{
+	// Definition, set by the caller.
+	const float *uknots, *vknots; // Knot vectors.
+	int numUKnots, numVKnots; // Knot vector lengths.
+	int uOrder, vOrder; // Orders in either direction.
+	const float *controlPoints; // Control point i along u, j along v at (i*vCount + j)*dim.
+	int dim; // 3 for polynomial, 4 for homogeneous rational control points.
+	float tolerance; // Largest screen-space length in pixels of a tessellation step.
+	float texScale[2]; // Texture co-ordinates at the far corner of the parameter domain.
+	std::vector< std::vector<float> > trimLoops; // Closed (u,v) polylines, see addPwlTrimLoop().
+
+	// Tessellation cache.
+	std::vector<int> uSteps, vSteps; // Steps across each knot span.
+	std::vector<NurbsSample> uSamples, vSamples; // Tessellation parameter values.
+	std::vector<NurbsSample> trimSamples; // Samples, u then v, of the vertices where cell edges
+	                                      // cross the trimming loops, after the grid's.
+	std::vector<float> cachedControlPoints; // Control points of the current mesh.
+	std::vector<float> vertexData; // Interleaved position, normal, texture co-ordinates.
+	std::vector<unsigned int> indices; // Triangles inside the trimming loops.
+	unsigned int buffer[2]; // Vertex and index buffer ids.
+	bool meshValid; // If the mesh matches uSteps and vSteps.
+};
+
+void createNurbsSurface(NurbsSurface &surface);
+void addPwlTrimLoop(NurbsSurface &surface, const float *points, int numPoints);
+void addSplineTrimLoop(NurbsSurface &surface, const float *knots, int numKnots, int order,
+	                   const float *points, int numSteps);
+void evaluateNurbsSurface(const NurbsSurface &surface, float u, float v, float *point, float *normal);
+void tessellateNurbsSurface(NurbsSurface &surface);
+void drawNurbsSurface(NurbsSurface &surface);
+void drawNurbsTrimLoops(NurbsSurface &surface);
+void deleteNurbsSurface(NurbsSurface &surface);
+
+#endif
@@ -6,6 +6,11 @@
 // knot vector in either direction. There are three trimming loops - two polygonal 
 // and one B-spline. One of the polygonal loops is external.
 //
+// The surface is tessellated by nurbsSurface.cpp into a cached mesh rather than
+// by GLU every frame. Each knot span is divided into steps of at most 10 pixels on
+// screen, grid cells outside the trimming loops are dropped and those they cross are
+// clipped to them, and only the patches under a moved control point are re-evaluated.
+//
 // Interaction:
 // Press space, backspace, tab and enter keys to select a control point.
 // Press the right/left arrow keys to move the control point up/down the x-axis.
@@ -23,6 +28,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "nurbsSurface.h"
+
 #define PI 3.14159265
 
 // Begin globals.
@@ -56,7 +63,7 @@ static float curveKnots[10] =
 { 0.0, 0.0, 0.0, 0.0, 1.0, 2.0, 3.0, 3.0, 3.0, 3.0 };
 
 static int rowCount = 0, columnCount = 0; // Indexes of selected control point.
-static GLUnurbsObj *nurbsObject; // Pointer to NURBS object.
+static NurbsSurface surface; // Tessellated trimmed spline surface.
 // End globals.
 
 // Routine to draw a stroke character string.
@@ -101,14 +108,25 @@ void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 
-	// Create NURBS object.
-	nurbsObject = gluNewNurbsRenderer();
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_METHOD, GLU_PATH_LENGTH);
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_TOLERANCE, 100.0);
-	gluNurbsProperty(nurbsObject, GLU_DISPLAY_MODE, GLU_OUTLINE_POLYGON);
-
 	resetControlPoints();
 	setCirclePoints();
+
+	// Define the spline surface.
+	surface.uknots = uknots; surface.numUKnots = 19; surface.uOrder = 4;
+	surface.vknots = vknots; surface.numVKnots = 14; surface.vOrder = 4;
+	surface.controlPoints = controlPoints[0][0]; surface.dim = 3;
+	surface.tolerance = 10.0;
+	surface.texScale[0] = 1.0; surface.texScale[1] = 1.0;
+	createNurbsSurface(surface);
+
+	// Counter-clockwise oriented trimming rectangle.
+	addPwlTrimLoop(surface, boundaryPoints[0], 5);
+
+	// Clockwise oriented trimming circle.
+	addPwlTrimLoop(surface, circlePoints[0], 11);
+
+	// Clockwise oriented trimming B-spline loop.
+	addSplineTrimLoop(surface, curveKnots, 10, 4, curvePoints[0], 60);
 }
 
 // Drawing routine.
@@ -125,29 +143,12 @@ void drawScene(void)
 	glRotatef(Yangle, 0.0, 1.0, 0.0);
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
-	// Draw the spline surface.
+	// Draw the trimmed spline surface in outline together with the trimming loops.
 	glColor3f(0.0, 0.0, 0.0);
-	gluBeginSurface(nurbsObject);
-	gluNurbsSurface(nurbsObject, 19, uknots, 14, vknots,
-		30, 3, controlPoints[0][0], 4, 4, GL_MAP2_VERTEX_3);
-
-	// Counter-clockwise oriented trimming rectangle.
-	gluBeginTrim(nurbsObject);
-	gluPwlCurve(nurbsObject, 5, boundaryPoints[0], 2, GLU_MAP1_TRIM_2);
-	gluEndTrim(nurbsObject);
-
-	// Cloclwise oriented trimming circle.
-	gluBeginTrim(nurbsObject);
-	gluPwlCurve(nurbsObject, 11, circlePoints[0], 2, GLU_MAP1_TRIM_2);
-	gluEndTrim(nurbsObject);
-
-	// Clockwise oriented trimming B-spline loop.
-	gluBeginTrim(nurbsObject);
-	gluNurbsCurve(nurbsObject, 10, curveKnots, 2, curvePoints[0], 4,
-		GLU_MAP1_TRIM_2);
-	gluEndTrim(nurbsObject);
-
-	gluEndSurface(nurbsObject);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	drawNurbsSurface(surface);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	drawNurbsTrimLoops(surface);
 
 	glPointSize(5.0);
 
@@ -0,0 +1,544 @@
+#include <cmath>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "nurbsSurface.h"
+
+#define VERTEX_FLOATS 8 // Floats per vertex: position, normal, texture co-ordinates.
+
+// Basis values and derivatives at parameter value u, from the span of the domain
+// [knots[order - 1], knots[count]] of count control points containing u.
+static void makeSample(const float *knots, int numKnots, int order, int count, int span,
+	                   float u, NurbsSample &sample)
+{
+	if (span < 0) span = findSpan(knots, numKnots, u);
+	if (span < order - 1) span = order - 1;
+	if (span > count - 1) span = count - 1;
+	sample.param = u;
+	sample.span = span;
+	basisFunsDerivs(knots, numKnots, span, order, u, sample.N, sample.dN);
+}
+
+// Position, unit normal and texture co-ordinates at the sample pair (us, vs).
+static void evaluateVertex(const NurbsSurface &surface, const NurbsSample &us,
+	                       const NurbsSample &vs, float *vertex)
+{
+	int vCount = surface.numVKnots - surface.vOrder;
+	int uCount = surface.numUKnots - surface.uOrder;
+	float A[4] = { 0.0, 0.0, 0.0, 1.0 }, Au[4] = { 0.0 }, Av[4] = { 0.0 };
+	float S[3], Su[3], Sv[3], w, length;
+	const float *P;
+	int a, b, c, i, j;
+
+	if (surface.dim == 4) A[3] = 0.0;
+	for (a = 0; a < surface.uOrder; a++)
+	{
+		i = us.span - surface.uOrder + 1 + a;
+		for (b = 0; b < surface.vOrder; b++)
+		{
+			j = vs.span - surface.vOrder + 1 + b;
+			P = surface.controlPoints + (i * vCount + j) * surface.dim;
+			for (c = 0; c < surface.dim; c++)
+			{
+				A[c] += us.N[a] * vs.N[b] * P[c];
+				Au[c] += us.dN[a] * vs.N[b] * P[c];
+				Av[c] += us.N[a] * vs.dN[b] * P[c];
+			}
+		}
+	}
+
+	// Project rational points and their derivatives by the quotient rule.
+	w = A[3];
+	for (c = 0; c < 3; c++)
+	{
+		S[c] = A[c] / w;
+		Su[c] = (Au[c] - Au[3] * S[c]) / w;
+		Sv[c] = (Av[c] - Av[3] * S[c]) / w;
+	}
+
+	vertex[0] = S[0]; vertex[1] = S[1]; vertex[2] = S[2];
+	vertex[3] = Su[1] * Sv[2] - Su[2] * Sv[1];
+	vertex[4] = Su[2] * Sv[0] - Su[0] * Sv[2];
+	vertex[5] = Su[0] * Sv[1] - Su[1] * Sv[0];
+	length = sqrt(vertex[3] * vertex[3] + vertex[4] * vertex[4] + vertex[5] * vertex[5]);
+	if (length > 0.0) for (c = 3; c < 6; c++) vertex[c] /= length;
+	else { vertex[3] = 0.0; vertex[4] = 0.0; vertex[5] = 1.0; }
+
+	vertex[6] = surface.texScale[0] * (us.param - surface.uknots[surface.uOrder - 1]) /
+		(surface.uknots[uCount] - surface.uknots[surface.uOrder - 1]);
+	vertex[7] = surface.texScale[1] * (vs.param - surface.vknots[surface.vOrder - 1]) /
+		(surface.vknots[vCount] - surface.vknots[surface.vOrder - 1]);
+}
+
+// Winding number of the closed polyline loop about the point (u,v).
+static int windingNumber(const std::vector<float> &loop, float u, float v)
+{
+	int k, winding = 0, numPoints = loop.size() / 2;
+	float cross;
+
+	for (k = 0; k < numPoints - 1; k++)
+	{
+		const float *p = &loop[2 * k], *q = &loop[2 * k + 2];
+		cross = (q[0] - p[0]) * (v - p[1]) - (u - p[0]) * (q[1] - p[1]);
+		if (p[1] <= v)
+		{
+			if ((q[1] > v) && (cross > 0.0)) winding++;
+		}
+		else if ((q[1] <= v) && (cross < 0.0)) winding--;
+	}
+	return winding;
+}
+
+// If (u,v) is inside the trimming loops. As with GLU the region to the left of the
+// loops is kept, i.e., inside counter-clockwise loops and outside clockwise ones.
+static bool insideTrimLoops(const NurbsSurface &surface, float u, float v)
+{
+	int k, winding = 0;
+
+	if (surface.trimLoops.empty()) return true;
+	for (k = 0; k < (int)surface.trimLoops.size(); k++)
+		winding += windingNumber(surface.trimLoops[k], u, v);
+	return winding > 0;
+}
+
+// Fraction of the way along the segment from (u0,v0) to (u1,v1), whose ends are on
+// opposite sides of the trimming loops, where it first crosses one of them, or a half
+// if rounding hides the crossing.
+static float edgeCrossing(const NurbsSurface &surface, float u0, float v0, float u1, float v1)
+{
+	int k, m, numPoints;
+	float first = 2.0, denominator, s, r;
+
+	for (k = 0; k < (int)surface.trimLoops.size(); k++)
+	{
+		const std::vector<float> &loop = surface.trimLoops[k];
+		numPoints = loop.size() / 2;
+		for (m = 0; m < numPoints - 1; m++)
+		{
+			// Solve (u0,v0) + s*((u1,v1) - (u0,v0)) = p + r*(q - p) for s and r.
+			const float *p = &loop[2 * m], *q = &loop[2 * m + 2];
+			denominator = (u1 - u0) * (q[1] - p[1]) - (v1 - v0) * (q[0] - p[0]);
+			if (denominator == 0.0) continue;
+			s = ((p[0] - u0) * (q[1] - p[1]) - (p[1] - v0) * (q[0] - p[0])) / denominator;
+			r = ((p[0] - u0) * (v1 - v0) - (p[1] - v0) * (u1 - u0)) / denominator;
+			if ((s >= 0.0) && (s <= 1.0) && (r >= 0.0) && (r <= 1.0) && (s < first)) first = s;
+		}
+	}
+	return (first <= 1.0) ? first : 0.5;
+}
+
+// Index of the vertex where the trimming loops cross the edge of the grid from vertex a,
+// inside them, to vertex b, outside, next along u or v, adding it to the trim samples the
+// first time the edge is asked for. crossings holds the index for each edge, or -1.
+static int trimVertex(NurbsSurface &surface, int a, int b, std::vector<int> &crossings)
+{
+	int nv = surface.vSamples.size(), nu = surface.uSamples.size(), lower = (a < b) ? a : b;
+	int edge = 2 * lower + ((b - a == 1 || a - b == 1) ? 1 : 0); // Edges along u even, along v odd.
+	const NurbsSample &ua = surface.uSamples[a / nv], &va = surface.vSamples[a % nv];
+	const NurbsSample &ub = surface.uSamples[b / nv], &vb = surface.vSamples[b % nv];
+	NurbsSample us = ua, vs = va;
+	float s;
+
+	if (crossings[edge] >= 0) return crossings[edge];
+
+	s = edgeCrossing(surface, ua.param, va.param, ub.param, vb.param);
+	if (edge % 2 == 0)
+		makeSample(surface.uknots, surface.numUKnots, surface.uOrder, surface.numUKnots - surface.uOrder, -1,
+			ua.param + s * (ub.param - ua.param), us);
+	else
+		makeSample(surface.vknots, surface.numVKnots, surface.vOrder, surface.numVKnots - surface.vOrder, -1,
+			va.param + s * (vb.param - va.param), vs);
+	surface.trimSamples.push_back(us);
+	surface.trimSamples.push_back(vs);
+	crossings[edge] = nu * nv + surface.trimSamples.size() / 2 - 1;
+	return crossings[edge];
+}
+
+// Project a point with the current modelview and projection matrices and viewport
+// to window co-ordinates. Returns false if the point is behind the viewer.
+static bool projectPoint(const float *mv, const float *proj, const int *viewport,
+	                     const float *point, float *window)
+{
+	float eye[4], clip[4];
+	int r;
+
+	for (r = 0; r < 4; r++)
+		eye[r] = mv[r] * point[0] + mv[4 + r] * point[1] + mv[8 + r] * point[2] + mv[12 + r];
+	for (r = 0; r < 4; r++)
+		clip[r] = proj[r] * eye[0] + proj[4 + r] * eye[1] + proj[8 + r] * eye[2] + proj[12 + r] * eye[3];
+	if (clip[3] <= 0.0) return false;
+
+	window[0] = viewport[0] + viewport[2] * (clip[0] / clip[3] + 1.0) / 2.0;
+	window[1] = viewport[1] + viewport[3] * (clip[1] / clip[3] + 1.0) / 2.0;
+	return true;
+}
+
+// Steps across each knot span in either direction, from the longest screen-space
+// control polygon over that span along the whole column (row) of patches.
+static void computeSteps(const NurbsSurface &surface, std::vector<int> &uSteps, std::vector<int> &vSteps)
+{
+	int uCount = surface.numUKnots - surface.uOrder, vCount = surface.numVKnots - surface.vOrder;
+	int i, j, s, a, c, steps;
+	float mv[16], proj[16], point[3], length, maxLength, dx, dy;
+	int viewport[4];
+	std::vector<float> window(uCount * vCount * 2);
+	std::vector<bool> visible(uCount * vCount);
+	const float *P;
+
+	glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+	glGetFloatv(GL_PROJECTION_MATRIX, proj);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	for (i = 0; i < uCount; i++)
+		for (j = 0; j < vCount; j++)
+		{
+			P = surface.controlPoints + (i * vCount + j) * surface.dim;
+			for (c = 0; c < 3; c++) point[c] = (surface.dim == 4) ? P[c] / P[3] : P[c];
+			visible[i * vCount + j] = projectPoint(mv, proj, viewport, point, &window[2 * (i * vCount + j)]);
+		}
+
+	uSteps.assign(uCount - surface.uOrder + 1, 0);
+	for (s = surface.uOrder - 1; s < uCount; s++)
+	{
+		if (surface.uknots[s] == surface.uknots[s + 1]) continue;
+		maxLength = 0.0;
+		for (j = 0; j < vCount; j++)
+		{
+			length = 0.0;
+			for (a = s - surface.uOrder + 2; a <= s; a++)
+			{
+				if (!visible[a * vCount + j] || !visible[(a - 1) * vCount + j]) length = 1.0e10;
+				dx = window[2 * (a * vCount + j)] - window[2 * ((a - 1) * vCount + j)];
+				dy = window[2 * (a * vCount + j) + 1] - window[2 * ((a - 1) * vCount + j) + 1];
+				length += sqrt(dx * dx + dy * dy);
+			}
+			if (length > maxLength) maxLength = length;
+		}
+		steps = (int)ceil(maxLength / surface.tolerance);
+		if (steps < 1) steps = 1;
+		if (steps > NURBS_MAX_SPAN_SAMPLES) steps = NURBS_MAX_SPAN_SAMPLES;
+		uSteps[s - surface.uOrder + 1] = steps;
+	}
+
+	vSteps.assign(vCount - surface.vOrder + 1, 0);
+	for (s = surface.vOrder - 1; s < vCount; s++)
+	{
+		if (surface.vknots[s] == surface.vknots[s + 1]) continue;
+		maxLength = 0.0;
+		for (i = 0; i < uCount; i++)
+		{
+			length = 0.0;
+			for (a = s - surface.vOrder + 2; a <= s; a++)
+			{
+				if (!visible[i * vCount + a] || !visible[i * vCount + a - 1]) length = 1.0e10;
+				dx = window[2 * (i * vCount + a)] - window[2 * (i * vCount + a - 1)];
+				dy = window[2 * (i * vCount + a) + 1] - window[2 * (i * vCount + a - 1) + 1];
+				length += sqrt(dx * dx + dy * dy);
+			}
+			if (length > maxLength) maxLength = length;
+		}
+		steps = (int)ceil(maxLength / surface.tolerance);
+		if (steps < 1) steps = 1;
+		if (steps > NURBS_MAX_SPAN_SAMPLES) steps = NURBS_MAX_SPAN_SAMPLES;
+		vSteps[s - surface.vOrder + 1] = steps;
+	}
+}
+
+// Fill samples with the parameter values dividing each knot span into its steps,
+// neighbouring spans sharing their common end.
+static void makeSamples(const float *knots, int numKnots, int order, const std::vector<int> &steps,
+	                    std::vector<NurbsSample> &samples)
+{
+	int count = numKnots - order, s, k, n;
+	NurbsSample sample;
+
+	samples.clear();
+	for (s = order - 1; s < count; s++)
+	{
+		n = steps[s - order + 1];
+		for (k = 0; k < n; k++)
+		{
+			makeSample(knots, numKnots, order, count, s,
+				knots[s] + (knots[s + 1] - knots[s]) * k / n, sample);
+			samples.push_back(sample);
+		}
+	}
+	makeSample(knots, numKnots, order, count, -1, knots[count], sample);
+	samples.push_back(sample);
+}
+
+// Re-evaluate the whole mesh and its trimmed triangle list.
+static void rebuildMesh(NurbsSurface &surface)
+{
+	int nu, nv, k, l, c, numInside, numPolygon, polygon[6], corner[4], numTrim;
+	float uMid, vMid;
+	std::vector<bool> inside;
+	std::vector<int> crossings;
+
+	makeSamples(surface.uknots, surface.numUKnots, surface.uOrder, surface.uSteps, surface.uSamples);
+	makeSamples(surface.vknots, surface.numVKnots, surface.vOrder, surface.vSteps, surface.vSamples);
+	nu = surface.uSamples.size();
+	nv = surface.vSamples.size();
+
+	surface.vertexData.resize(nu * nv * VERTEX_FLOATS);
+	for (k = 0; k < nu; k++)
+		for (l = 0; l < nv; l++)
+			evaluateVertex(surface, surface.uSamples[k], surface.vSamples[l],
+				&surface.vertexData[(k * nv + l) * VERTEX_FLOATS]);
+
+	// Keep the grid cells whose corners are inside the trimming loops and clip those with
+	// only some inside, as marching squares does: walking round the cell, the corners
+	// inside and the points where the loops cross the edges between corners inside and
+	// outside make a convex polygon in (u,v), drawn as a fan. A cell with only its opposite
+	// corners inside is cut into two corners instead if its centre is outside. A loop
+	// crossing an edge twice between corners on the same side is missed, so features of
+	// the loops smaller than a cell are lost.
+	surface.indices.clear();
+	surface.trimSamples.clear();
+	inside.resize(nu * nv);
+	crossings.assign(2 * nu * nv, -1);
+	for (k = 0; k < nu; k++)
+		for (l = 0; l < nv; l++)
+			inside[k * nv + l] = insideTrimLoops(surface, surface.uSamples[k].param, surface.vSamples[l].param);
+	for (k = 0; k < nu - 1; k++)
+		for (l = 0; l < nv - 1; l++)
+		{
+			corner[0] = k * nv + l; corner[1] = (k + 1) * nv + l;
+			corner[2] = (k + 1) * nv + l + 1; corner[3] = k * nv + l + 1;
+			for (c = 0, numInside = 0; c < 4; c++) if (inside[corner[c]]) numInside++;
+			if (numInside == 0) continue;
+
+			uMid = (surface.uSamples[k].param + surface.uSamples[k + 1].param) / 2.0;
+			vMid = (surface.vSamples[l].param + surface.vSamples[l + 1].param) / 2.0;
+			if ((numInside == 2) && (inside[corner[0]] == inside[corner[2]]) && !insideTrimLoops(surface, uMid, vMid))
+			{
+				for (c = 0; c < 4; c++)
+				{
+					if (!inside[corner[c]]) continue;
+					surface.indices.push_back(trimVertex(surface, corner[c], corner[(c + 3) % 4], crossings));
+					surface.indices.push_back(corner[c]);
+					surface.indices.push_back(trimVertex(surface, corner[c], corner[(c + 1) % 4], crossings));
+				}
+				continue;
+			}
+
+			for (c = 0, numPolygon = 0; c < 4; c++)
+			{
+				if (inside[corner[c]]) polygon[numPolygon++] = corner[c];
+				if (inside[corner[c]] && !inside[corner[(c + 1) % 4]])
+					polygon[numPolygon++] = trimVertex(surface, corner[c], corner[(c + 1) % 4], crossings);
+				else if (!inside[corner[c]] && inside[corner[(c + 1) % 4]])
+					polygon[numPolygon++] = trimVertex(surface, corner[(c + 1) % 4], corner[c], crossings);
+			}
+			for (c = 1; c < numPolygon - 1; c++)
+			{
+				surface.indices.push_back(polygon[0]);
+				surface.indices.push_back(polygon[c]);
+				surface.indices.push_back(polygon[c + 1]);
+			}
+		}
+
+	// Evaluate the vertices on the trimming loops after the grid's.
+	numTrim = surface.trimSamples.size() / 2;
+	surface.vertexData.resize((nu * nv + numTrim) * VERTEX_FLOATS);
+	for (k = 0; k < numTrim; k++)
+		evaluateVertex(surface, surface.trimSamples[2 * k], surface.trimSamples[2 * k + 1],
+			&surface.vertexData[(nu * nv + k) * VERTEX_FLOATS]);
+
+	glBindBuffer(GL_ARRAY_BUFFER, surface.buffer[0]);
+	glBufferData(GL_ARRAY_BUFFER, surface.vertexData.size() * sizeof(float),
+		&surface.vertexData[0], GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, surface.buffer[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, surface.indices.size() * sizeof(unsigned int),
+		surface.indices.empty() ? NULL : &surface.indices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	surface.meshValid = true;
+}
+
+// Re-evaluate only the patches that use a control point which differs from the cached
+// copy, and upload the rows of vertices they cover, and the vertices on the trimming
+// loops, few enough to be re-evaluated all together, if any patch changed.
+static void updateChangedPatches(NurbsSurface &surface)
+{
+	int uCount = surface.numUKnots - surface.uOrder, vCount = surface.numVKnots - surface.vOrder;
+	int numUSpans = uCount - surface.uOrder + 1, numVSpans = vCount - surface.vOrder + 1;
+	int nv = surface.vSamples.size(), nu = surface.uSamples.size(), numTrim = surface.trimSamples.size() / 2;
+	int i, j, c, su, sv, k, l, kFirst, kLast, lFirst, lLast, rowFirst = -1, rowLast = -1;
+	std::vector<bool> dirty(numUSpans * numVSpans, false);
+	std::vector<int> uStart(numUSpans + 1, 0), vStart(numVSpans + 1, 0);
+	bool changed;
+
+	for (i = 0; i < uCount; i++)
+		for (j = 0; j < vCount; j++)
+		{
+			changed = false;
+			for (c = 0; c < surface.dim; c++)
+				if (surface.controlPoints[(i * vCount + j) * surface.dim + c] !=
+					surface.cachedControlPoints[(i * vCount + j) * surface.dim + c]) changed = true;
+			if (!changed) continue;
+
+			// Control point (i,j) is used by the patches on spans i through i + order - 1.
+			for (su = i; (su < i + surface.uOrder) && (su < uCount); su++)
+				for (sv = j; (sv < j + surface.vOrder) && (sv < vCount); sv++)
+					if ((su >= surface.uOrder - 1) && (sv >= surface.vOrder - 1))
+						dirty[(su - surface.uOrder + 1) * numVSpans + sv - surface.vOrder + 1] = true;
+		}
+
+	// First sample index of each span.
+	for (su = 0; su < numUSpans; su++) uStart[su + 1] = uStart[su] + surface.uSteps[su];
+	for (sv = 0; sv < numVSpans; sv++) vStart[sv + 1] = vStart[sv] + surface.vSteps[sv];
+
+	for (su = 0; su < numUSpans; su++)
+		for (sv = 0; sv < numVSpans; sv++)
+		{
+			if (!dirty[su * numVSpans + sv] || (surface.uSteps[su] == 0) || (surface.vSteps[sv] == 0)) continue;
+			kFirst = uStart[su]; kLast = uStart[su + 1];
+			lFirst = vStart[sv]; lLast = vStart[sv + 1];
+			for (k = kFirst; k <= kLast; k++)
+				for (l = lFirst; l <= lLast; l++)
+					evaluateVertex(surface, surface.uSamples[k], surface.vSamples[l],
+						&surface.vertexData[(k * nv + l) * VERTEX_FLOATS]);
+			if ((rowFirst == -1) || (kFirst < rowFirst)) rowFirst = kFirst;
+			if (kLast > rowLast) rowLast = kLast;
+		}
+
+	if (rowFirst == -1) return;
+	for (k = 0; k < numTrim; k++)
+		evaluateVertex(surface, surface.trimSamples[2 * k], surface.trimSamples[2 * k + 1],
+			&surface.vertexData[(nu * nv + k) * VERTEX_FLOATS]);
+
+	glBindBuffer(GL_ARRAY_BUFFER, surface.buffer[0]);
+	glBufferSubData(GL_ARRAY_BUFFER, rowFirst * nv * VERTEX_FLOATS * sizeof(float),
+		(rowLast - rowFirst + 1) * nv * VERTEX_FLOATS * sizeof(float),
+		&surface.vertexData[rowFirst * nv * VERTEX_FLOATS]);
+	if (numTrim > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, nu * nv * VERTEX_FLOATS * sizeof(float),
+			numTrim * VERTEX_FLOATS * sizeof(float), &surface.vertexData[nu * nv * VERTEX_FLOATS]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Generate the buffers for the surface once its definition is filled in.
+void createNurbsSurface(NurbsSurface &surface)
+{
+	glGenBuffers(2, surface.buffer);
+	surface.meshValid = false;
+}
+
+// Add a closed piecewise-linear trimming loop of (u,v) points, the last repeating the first.
+void addPwlTrimLoop(NurbsSurface &surface, const float *points, int numPoints)
+{
+	surface.trimLoops.push_back(std::vector<float>(points, points + 2 * numPoints));
+	surface.meshValid = false;
+}
+
+// Add a closed B-spline trimming loop with (u,v) control points, flattened to numSteps
+// segments by de Boor's algorithm.
+void addSplineTrimLoop(NurbsSurface &surface, const float *knots, int numKnots, int order,
+	                   const float *points, int numSteps)
+{
+	std::vector<float> loop(2 * (numSteps + 1));
+	float uFirst = knots[order - 1], uLast = knots[numKnots - order];
+	int k;
+
+	for (k = 0; k <= numSteps; k++)
+		deBoor(knots, numKnots, order, points, 2, uFirst + (uLast - uFirst) * k / numSteps, &loop[2 * k]);
+	surface.trimLoops.push_back(loop);
+	surface.meshValid = false;
+}
+
+// Point and unit normal of the surface at (u,v).
+void evaluateNurbsSurface(const NurbsSurface &surface, float u, float v, float *point, float *normal)
+{
+	NurbsSample us, vs;
+	float vertex[VERTEX_FLOATS];
+	int c;
+
+	makeSample(surface.uknots, surface.numUKnots, surface.uOrder,
+		surface.numUKnots - surface.uOrder, -1, u, us);
+	makeSample(surface.vknots, surface.numVKnots, surface.vOrder,
+		surface.numVKnots - surface.vOrder, -1, v, vs);
+	evaluateVertex(surface, us, vs, vertex);
+	for (c = 0; c < 3; c++)
+	{
+		point[c] = vertex[c];
+		if (normal) normal[c] = vertex[3 + c];
+	}
+}
+
+// Bring the cached mesh up to date for the current view and control points.
+void tessellateNurbsSurface(NurbsSurface &surface)
+{
+	int numControlFloats = (surface.numUKnots - surface.uOrder) *
+		(surface.numVKnots - surface.vOrder) * surface.dim;
+	std::vector<int> uSteps, vSteps;
+
+	computeSteps(surface, uSteps, vSteps);
+	if (!surface.meshValid || (uSteps != surface.uSteps) || (vSteps != surface.vSteps))
+	{
+		surface.uSteps = uSteps;
+		surface.vSteps = vSteps;
+		rebuildMesh(surface);
+	}
+	else updateChangedPatches(surface);
+
+	surface.cachedControlPoints.assign(surface.controlPoints, surface.controlPoints + numControlFloats);
+}
+
+// Tessellate as needed and draw the surface mesh.
+void drawNurbsSurface(NurbsSurface &surface)
+{
+	tessellateNurbsSurface(surface);
+	if (surface.indices.empty()) return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, surface.buffer[0]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, surface.buffer[1]);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(3, GL_FLOAT, VERTEX_FLOATS * sizeof(float), 0);
+	glNormalPointer(GL_FLOAT, VERTEX_FLOATS * sizeof(float), (void *)(3 * sizeof(float)));
+	glTexCoordPointer(2, GL_FLOAT, VERTEX_FLOATS * sizeof(float), (void *)(6 * sizeof(float)));
+
+	glDrawElements(GL_TRIANGLES, surface.indices.size(), GL_UNSIGNED_INT, 0);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// Draw the trimming loops mapped onto the surface, each segment divided into 8.
+void drawNurbsTrimLoops(NurbsSurface &surface)
+{
+	int k, m, n, numPoints;
+	float point[3], u, v;
+
+	for (k = 0; k < (int)surface.trimLoops.size(); k++)
+	{
+		const std::vector<float> &loop = surface.trimLoops[k];
+		numPoints = loop.size() / 2;
+		glBegin(GL_LINE_STRIP);
+		for (m = 0; m < numPoints - 1; m++)
+			for (n = 0; n <= 8; n++)
+			{
+				if ((n == 8) && (m < numPoints - 2)) continue;
+				u = loop[2 * m] + (loop[2 * m + 2] - loop[2 * m]) * n / 8.0;
+				v = loop[2 * m + 1] + (loop[2 * m + 3] - loop[2 * m + 1]) * n / 8.0;
+				evaluateNurbsSurface(surface, u, v, point, NULL);
+				glVertex3fv(point);
+			}
+		glEnd();
+	}
+}
+
+// Release the surface's buffers.
+void deleteNurbsSurface(NurbsSurface &surface)
+{
+	glDeleteBuffers(2, surface.buffer);
+	surface.meshValid = false;
+}
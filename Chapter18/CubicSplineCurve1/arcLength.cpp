@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cmath>
+
+#include "arcLength.h"
+
+#define MIN_DEPTH 3 // Subdivision levels always made, so that no feature is stepped over.
+#define MAX_DEPTH 16 // Subdivision levels never exceeded, for cusps.
+
+// Distance between two points.
+static float distance(const float *p, const float *q)
+{
+	return sqrt((q[0] - p[0]) * (q[0] - p[0]) + (q[1] - p[1]) * (q[1] - p[1]) + (q[2] - p[2]) * (q[2] - p[2]));
+}
+
+// Distance of point m from the line through p and q.
+static float distanceFromLine(const float *m, const float *p, const float *q)
+{
+	float d[3], e[3], c[3], length;
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		d[i] = q[i] - p[i];
+		e[i] = m[i] - p[i];
+	}
+	c[0] = d[1] * e[2] - d[2] * e[1];
+	c[1] = d[2] * e[0] - d[0] * e[2];
+	c[2] = d[0] * e[1] - d[1] * e[0];
+	length = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	if (length == 0.0) return distance(m, p);
+	return sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]) / length;
+}
+
+// Append the table entries for the curve between u0 (point p0) and u1 (point p1). The
+// piece is split in half until the length through its midpoint exceeds the chord by
+// less than the tolerance, and its halves differ in length by less than twice the
+// tolerance, so that interpolating linearly in the table is off by less than the
+// tolerance at the midpoint. The length of each accepted piece is then extrapolated
+// from the two estimates.
+static void subdivideLength(ArcLengthTable &table, CurveFunction curve, void *data,
+	                        float u0, const float *p0, float u1, const float *p1, float tolerance, int depth)
+{
+	float um = 0.5 * (u0 + u1), pm[3], chord, first, second, halves;
+
+	curve(um, pm, data);
+	chord = distance(p0, p1);
+	first = distance(p0, pm);
+	second = distance(pm, p1);
+	halves = first + second;
+	if (depth >= MAX_DEPTH ||
+		(depth >= MIN_DEPTH && halves - chord < tolerance && fabs(first - second) < 2.0 * tolerance))
+	{
+		table.params.push_back(u1);
+		table.lengths.push_back(table.lengths.back() + halves + (halves - chord) / 3.0);
+		return;
+	}
+	subdivideLength(table, curve, data, u0, p0, um, pm, tolerance, depth + 1);
+	subdivideLength(table, curve, data, um, pm, u1, p1, tolerance, depth + 1);
+}
+
+// Build the arc length table of the curve from uStart to uEnd, each entry accurate to
+// about the tolerance in length.
+void buildArcLengthTable(ArcLengthTable &table, CurveFunction curve, void *data,
+	                     float uStart, float uEnd, float tolerance)
+{
+	float p0[3], p1[3], bucketStart;
+	int numBuckets, b, i;
+
+	table.params.assign(1, uStart);
+	table.lengths.assign(1, 0.0);
+	curve(uStart, p0, data);
+	curve(uEnd, p1, data);
+	subdivideLength(table, curve, data, uStart, p0, uEnd, p1, tolerance, 0);
+	table.totalLength = table.lengths.back();
+
+	// As many buckets as entries, each recording where a search for a length in it starts.
+	numBuckets = table.params.size();
+	table.buckets.resize(numBuckets);
+	for (b = 0, i = 0; b < numBuckets; b++)
+	{
+		bucketStart = table.totalLength * b / numBuckets;
+		while (i + 2 < (int)table.lengths.size() && table.lengths[i + 1] <= bucketStart) i++;
+		table.buckets[b] = i;
+	}
+}
+
+// Parameter value at arc length s from the start, clamped to the curve.
+float arcLengthToParam(const ArcLengthTable &table, float s)
+{
+	int numBuckets = table.buckets.size(), last = table.lengths.size() - 1, b, i;
+	float t;
+
+	if (s <= 0.0 || table.totalLength <= 0.0) return table.params[0];
+	if (s >= table.totalLength) return table.params[last];
+
+	b = std::min((int)(s / table.totalLength * numBuckets), numBuckets - 1);
+	i = table.buckets[b];
+	while (i + 1 < last && table.lengths[i + 1] < s) i++;
+
+	if (table.lengths[i + 1] == table.lengths[i]) return table.params[i];
+	t = (s - table.lengths[i]) / (table.lengths[i + 1] - table.lengths[i]);
+	return table.params[i] + t * (table.params[i + 1] - table.params[i]);
+}
+
+// Arc length from the start to parameter value u, by binary search of the table.
+float paramToArcLength(const ArcLengthTable &table, float u)
+{
+	int i = std::upper_bound(table.params.begin(), table.params.end(), u) - table.params.begin() - 1;
+	float t;
+
+	if (i < 0) return 0.0;
+	if (i >= (int)table.params.size() - 1) return table.totalLength;
+	if (table.params[i + 1] == table.params[i]) return table.lengths[i];
+	t = (u - table.params[i]) / (table.params[i + 1] - table.params[i]);
+	return table.lengths[i] + t * (table.lengths[i + 1] - table.lengths[i]);
+}
+
+// Append the points after p0 of a polyline through the curve between u0 (point p0) and
+// u1 (point p1), split in half until the midpoint lies within the tolerance of the
+// chord. As the midpoint's distance is about the curvature times the square of the
+// chord over 8, pieces are short where the curve bends sharply and long where it is flat.
+static void subdivideFlat(CurveFunction curve, void *data, float u0, const float *p0, float u1, const float *p1,
+	                      float tolerance, int depth, std::vector<float> &points)
+{
+	float um = 0.5 * (u0 + u1), pm[3];
+
+	curve(um, pm, data);
+	if (depth >= MAX_DEPTH || (depth >= MIN_DEPTH && distanceFromLine(pm, p0, p1) < tolerance))
+	{
+		points.insert(points.end(), p1, p1 + 3);
+		return;
+	}
+	subdivideFlat(curve, data, u0, p0, um, pm, tolerance, depth + 1, points);
+	subdivideFlat(curve, data, um, pm, u1, p1, tolerance, depth + 1, points);
+}
+
+// Fill points, 3 floats each, with a polyline through the curve from uStart to uEnd that
+// strays from it by about the tolerance at most.
+void sampleCurveAdaptive(CurveFunction curve, void *data, float uStart, float uEnd, float tolerance,
+	                     std::vector<float> &points)
+{
+	float p0[3], p1[3];
+
+	curve(uStart, p0, data);
+	curve(uEnd, p1, data);
+	points.assign(p0, p0 + 3);
+	subdivideFlat(curve, data, uStart, p0, uEnd, p1, tolerance, 0, points);
+}
@@ -4,21 +4,31 @@
 // This program draws the cubic B-spline approximation of 30 movable control points
 // over a fixed standard knot vector.
 //
+// The curve is drawn as a polyline with vertices placed by adaptive subdivision, so
+// they bunch where it bends and thin out where it is flat. A point can be made to
+// travel along it at constant speed using its arc length table.
+//
 // Interaction: 
 //
 // Press the space bar and backspace key to cycle through the control points.
 // The selected control point (in red) is moved using the arrow keys.
 // Press delete to reset control points.
 //
+// Press 'a' to start/stop the point travelling along the curve.
+//
 // Sumanta Guha
 ///////////////////////////////////////////////////////////////////////////////////
 
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "bSplineBasis.h"
+#include "arcLength.h"
+
 #define PI 3.14159265
 
 // Begin globals.
@@ -32,7 +42,14 @@ static float knots[34] =
 16.0, 17.0, 18.0, 19.0, 20.0, 21.0, 22.0, 23.0, 24.0,
 25.0, 26.0, 27.0, 27.0, 27.0, 27.0 };
 
-static GLUnurbsObj *nurbsObject; // Pointer to NURBS object.
+static float tolerance = 0.1; // Largest distance of the drawn polyline from the curve.
+static std::vector<float> curveVertices; // Vertices of the polyline.
+static ArcLengthTable arcLengthTable; // Arc length table of the curve.
+static int isCurveChanged = 1; // Whether the curve has changed since its polyline and table were made.
+static float distanceTravelled = 0.0; // Arc length from the start of the travelling point.
+static float speed = 0.5; // Arc length covered by the travelling point per frame.
+static int isAnimate = 0; // Animated?
+static int animationPeriod = 20; // Time interval between frames.
 // End globals.
 
 // Reset control points.
@@ -55,18 +72,20 @@ void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 
-	// Create NURBS object.
-	nurbsObject = gluNewNurbsRenderer();
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_METHOD, GLU_PATH_LENGTH);
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_TOLERANCE, 10.0);
-
 	resetControlPoints();
 }
 
+// Routine to evaluate the spline curve at parameter value u.
+void splineCurve(float u, float *point, void *data)
+{
+	deBoor(knots, 34, 4, ctrlpoints[0], 3, u, point);
+}
+
 // Drawing routine.
 void drawScene(void)
 {
 	int i;
+	float point[3];
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -74,9 +93,26 @@ void drawScene(void)
 
 	// Draw the spline curve.
 	glColor3f(0.0, 0.0, 0.0);
-	gluBeginCurve(nurbsObject);
-	gluNurbsCurve(nurbsObject, 34, knots, 3, ctrlpoints[0], 4, GL_MAP1_VERTEX_3);
-	gluEndCurve(nurbsObject);
+	if (isCurveChanged)
+	{
+		// Sample the curve, and make its arc length table, only when it has changed.
+		sampleCurveAdaptive(splineCurve, NULL, knots[3], knots[30], tolerance, curveVertices);
+		buildArcLengthTable(arcLengthTable, splineCurve, NULL, knots[3], knots[30], 0.01);
+		isCurveChanged = 0;
+	}
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, &curveVertices[0]);
+	glDrawArrays(GL_LINE_STRIP, 0, curveVertices.size() / 3);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	// Draw the travelling point at its distance along the curve.
+	if (distanceTravelled > arcLengthTable.totalLength) distanceTravelled = 0.0;
+	splineCurve(arcLengthToParam(arcLengthTable, distanceTravelled), point, NULL);
+	glColor3f(0.0, 0.0, 1.0);
+	glPointSize(8.0);
+	glBegin(GL_POINTS);
+	glVertex3fv(point);
+	glEnd();
 
 	// The following code displays the control points as dots.
 	glPointSize(5.0);
@@ -96,6 +132,19 @@ void drawScene(void)
 	glutSwapBuffers();
 }
 
+// Timer function.
+void animate(int value)
+{
+	if (isAnimate)
+	{
+		distanceTravelled += speed;
+		if (distanceTravelled > arcLengthTable.totalLength) distanceTravelled = 0.0;
+
+		glutPostRedisplay();
+		glutTimerFunc(animationPeriod, animate, 1);
+	}
+}
+
 // OpenGL window reshape routine.
 void resize(int w, int h)
 {
@@ -115,6 +164,14 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'a':
+		if (isAnimate) isAnimate = 0;
+		else
+		{
+			isAnimate = 1;
+			animate(1);
+		}
+		break;
 	case ' ':
 		if (selectedControlPoint < 29) selectedControlPoint++;
 		else selectedControlPoint = 0;
@@ -127,6 +184,7 @@ void keyInput(unsigned char key, int x, int y)
 		break;
 	case 127:
 		resetControlPoints();
+		isCurveChanged = 1;
 		glutPostRedisplay();
 		break;
 	default:
@@ -142,6 +200,7 @@ void specialKeyInput(int key, int x, int y)
 	if (key == GLUT_KEY_LEFT) ctrlpoints[selectedControlPoint][0] -= 1.0;
 	if (key == GLUT_KEY_RIGHT) ctrlpoints[selectedControlPoint][0] += 1.0;
 
+	isCurveChanged = 1;
 	glutPostRedisplay();
 }
 
@@ -151,7 +210,8 @@ void printInteraction(void)
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press the space bar and backspace key to cycle through the control points." << std::endl
 		<< "The selected control point (in red) is moved using the arrow keys." << std::endl
-		<< "Press delete to reset control points." << std::endl;
+		<< "Press delete to reset control points." << std::endl
+		<< "Press 'a' to start/stop the point travelling along the curve." << std::endl;
 }
 
 // Main routine.
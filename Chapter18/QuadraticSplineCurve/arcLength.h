@@ -0,0 +1,28 @@
+#ifndef ARCLENGTH_H
+#define ARCLENGTH_H
+
+#include <vector>
+
+// Routine to evaluate a curve at parameter value u, writing x, y, z to point.
+typedef void (*CurveFunction)(float u, float *point, void *data);
+
+// Arc length of a curve tabulated against parameter value at points chosen by adaptive
+// subdivision, so that the table is dense only where the curve bends. Lookup of the
+// parameter value at a given distance starts from a bucket of equal-length intervals
+// and so takes constant time on average.
+struct ArcLengthTable
+{
+	std::vector<float> params; // Increasing parameter values, the first and last the ends.
+	std::vector<float> lengths; // Arc length from the start to each parameter value.
+	std::vector<int> buckets; // Last entry at or before the start of each bucket.
+	float totalLength; // Length of the whole curve.
+};
+
+void buildArcLengthTable(ArcLengthTable &table, CurveFunction curve, void *data,
+	                     float uStart, float uEnd, float tolerance);
+float arcLengthToParam(const ArcLengthTable &table, float s);
+float paramToArcLength(const ArcLengthTable &table, float u);
+void sampleCurveAdaptive(CurveFunction curve, void *data, float uStart, float uEnd, float tolerance,
+	                     std::vector<float> &points);
+
+#endif
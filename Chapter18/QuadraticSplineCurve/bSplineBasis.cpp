@@ -0,0 +1,175 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "bSplineBasis.h"
+
+// Knot value with indices outside the knot vector clamped to its ends. Only basis
+// functions that do not exist in the knot vector ever read the clamped values.
+static float knotAt(const float *knots, int numKnots, int i)
+{
+	if (i < 0) return knots[0];
+	if (i > numKnots - 1) return knots[numKnots - 1];
+	return knots[i];
+}
+
+// Binary search for the knot span [knots[span], knots[span+1]] with
+// knots[span] < u <= knots[span+1]. Parameter values at or beyond either end of
+// the knot vector are assigned the first or last non-empty span.
+int findSpan(const float *knots, int numKnots, float u)
+{
+	int lo, hi, mid;
+
+	if (u <= knots[0])
+	{
+		for (lo = 0; lo < numKnots - 2; lo++) if (knots[lo] < knots[lo + 1]) break;
+		return lo;
+	}
+	if (u > knots[numKnots - 1])
+	{
+		for (hi = numKnots - 2; hi > 0; hi--) if (knots[hi] < knots[hi + 1]) break;
+		return hi;
+	}
+
+	// Invariant: knots[lo] < u <= knots[hi].
+	lo = 0; hi = numKnots - 1;
+	while (hi - lo > 1)
+	{
+		mid = (lo + hi) / 2;
+		if (knots[mid] < u) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
+
+// Triangular Cox-de Boor computation of all the B-splines of the given order which
+// are non-zero on the knot span, in one O(order^2) pass. On return N[r] is the value
+// at u of the B-spline with index span - order + 1 + r.
+void basisFuns(const float *knots, int numKnots, int span, int order, float u, float *N)
+{
+	float left[MAX_ORDER], right[MAX_ORDER];
+	float saved, temp, denom;
+	int j, r;
+
+	N[0] = 1.0;
+	for (j = 1; j < order; j++)
+	{
+		left[j] = u - knotAt(knots, numKnots, span + 1 - j);
+		right[j] = knotAt(knots, numKnots, span + j) - u;
+		saved = 0.0;
+		for (r = 0; r < j; r++)
+		{
+			denom = right[r + 1] + left[j - r];
+			temp = (denom == 0.0) ? 0.0 : N[r] / denom;
+			N[r] = saved + right[r + 1] * temp;
+			saved = left[j - r] * temp;
+		}
+		N[j] = saved;
+	}
+}
+
+// As basisFuns() but also returns in dN the first derivatives of the non-zero
+// B-splines, from the B-splines one order lower on the same span.
+void basisFunsDerivs(const float *knots, int numKnots, int span, int order, float u,
+	                float *N, float *dN)
+{
+	float M[MAX_ORDER], denom;
+	int i, r;
+
+	basisFuns(knots, numKnots, span, order, u, N);
+	if (order == 1)
+	{
+		dN[0] = 0.0;
+		return;
+	}
+
+	// M[r] is the value of the B-spline of order - 1 with index span - order + 2 + r.
+	basisFuns(knots, numKnots, span, order - 1, u, M);
+	for (r = 0; r < order; r++)
+	{
+		i = span - order + 1 + r;
+		dN[r] = 0.0;
+		denom = knotAt(knots, numKnots, i + order - 1) - knotAt(knots, numKnots, i);
+		if ((r > 0) && (denom != 0.0)) dN[r] += (order - 1) * M[r - 1] / denom;
+		denom = knotAt(knots, numKnots, i + order) - knotAt(knots, numKnots, i + 1);
+		if ((r < order - 1) && (denom != 0.0)) dN[r] -= (order - 1) * M[r] / denom;
+	}
+}
+
+// Value of the B-spline with the given index from the non-zero values N computed on span.
+float basisValue(const float *N, int span, int order, int index)
+{
+	int r = index - (span - order + 1);
+	if ((r < 0) || (r >= order)) return 0.0;
+	return N[r];
+}
+
+// De Boor's algorithm to evaluate at u the B-spline curve of the given order with
+// numKnots - order control points, each of dimension dim (at most 4).
+void deBoor(const float *knots, int numKnots, int order,
+	        const float *controlPoints, int dim, float u, float *point)
+{
+	float d[MAX_ORDER][4];
+	float alpha, denom;
+	int p = order - 1, numControlPoints = numKnots - order;
+	int span, j, r, k;
+
+	// Restrict to spans of the curve's domain [knots[p], knots[numControlPoints]].
+	span = findSpan(knots, numKnots, u);
+	if (span < p) span = p;
+	if (span > numControlPoints - 1) span = numControlPoints - 1;
+
+	for (j = 0; j <= p; j++)
+		for (k = 0; k < dim; k++) d[j][k] = controlPoints[(j + span - p) * dim + k];
+
+	for (r = 1; r <= p; r++)
+		for (j = p; j >= r; j--)
+		{
+			denom = knots[j + 1 + span - r] - knots[j + span - p];
+			alpha = (denom == 0.0) ? 0.0 : (u - knots[j + span - p]) / denom;
+			for (k = 0; k < dim; k++) d[j][k] = (1.0 - alpha) * d[j - 1][k] + alpha * d[j][k];
+		}
+
+	for (k = 0; k < dim; k++) point[k] = d[p][k];
+}
+
+// Allocate a basis table for the grid uMin, uMin + uStep, ... up to uMax.
+void createBasisTable(BasisTable &table, int order, float uMin, float uMax, float uStep)
+{
+	table.order = order;
+	table.uMin = uMin;
+	table.uStep = uStep;
+	table.numSamples = (int)floor((uMax - uMin) / uStep + 0.5) + 1;
+	table.spans = new int[table.numSamples];
+	table.values = new float[table.numSamples][MAX_ORDER];
+}
+
+// Re-evaluate the grid points of the table lying in the parameter interval [uLo, uHi].
+// When a knot moves only the grid points under the B-splines sharing that knot need
+// to be passed, rather than the whole table.
+void fillBasisTable(BasisTable &table, const float *knots, int numKnots, float uLo, float uHi)
+{
+	int g, gFirst, gLast;
+	float u;
+
+	gFirst = (int)ceil((uLo - table.uMin) / table.uStep - 0.001);
+	gLast = (int)floor((uHi - table.uMin) / table.uStep + 0.001);
+	if (gFirst < 0) gFirst = 0;
+	if (gLast > table.numSamples - 1) gLast = table.numSamples - 1;
+
+	for (g = gFirst; g <= gLast; g++)
+	{
+		u = table.uMin + g * table.uStep;
+		table.spans[g] = findSpan(knots, numKnots, u);
+		basisFuns(knots, numKnots, table.spans[g], table.order, u, table.values[g]);
+	}
+}
+
+// Release the table's storage.
+void deleteBasisTable(BasisTable &table)
+{
+	delete[] table.spans;
+	delete[] table.values;
+	table.spans = NULL;
+	table.values = NULL;
+	table.numSamples = 0;
+}
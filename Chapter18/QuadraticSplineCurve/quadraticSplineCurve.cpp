@@ -10,6 +10,10 @@
 // 
 // The knot values can be changed and the control points moved.
 //
+// The curve is drawn as a polyline with vertices placed by adaptive subdivision, so
+// they bunch where it bends and thin out where it is flat. A point can be made to
+// travel along it at constant speed using its arc length table.
+//
 // Interaction: 
 // Press 'c' to enter control points mode -
 // Press the space bar to cycle through the control points.
@@ -21,14 +25,20 @@
 // The selected knot (in red) is increased/decreased using the right/left arrow keys.
 // Press delete to reset knot values.
 //
+// Press 'a' to start/stop the point travelling along the curve.
+//
 // Sumanta Guha
 /////////////////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "bSplineBasis.h"
+#include "arcLength.h"
+
 // Begin globals.
 static int changeControls = 1; // If control points to be changed.
 static int selectedControlPoint = 0; // Selected control point number.
@@ -55,7 +65,14 @@ static float originalControlPoints[9][3] =
 static float knots[12] =
 { 0.0, 7.0, 14.0, 21.0, 28.0, 35.0, 42.0, 49.0, 56.0, 63.0, 70.0, 77.0 };
 
-static GLUnurbsObj *nurbsObject; // Pointer to NURBS object.
+static float tolerance = 0.1; // Largest distance of the drawn polyline from the curve.
+static std::vector<float> curveVertices; // Vertices of the polyline.
+static ArcLengthTable arcLengthTable; // Arc length table of the curve.
+static int isCurveChanged = 1; // Whether the curve has changed since its polyline and table were made.
+static float distanceTravelled = 0.0; // Arc length from the start of the travelling point.
+static float speed = 0.5; // Arc length covered by the travelling point per frame.
+static int isAnimate = 0; // Animated?
+static int animationPeriod = 20; // Time interval between frames.
 // End globals.
 
 // Routine to draw a bitmap character string.
@@ -70,11 +87,6 @@ void writeBitmapString(void *font, char *string)
 void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
-
-	// Create NURBS object.
-	nurbsObject = gluNewNurbsRenderer();
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_METHOD, GLU_PATH_LENGTH);
-	gluNurbsProperty(nurbsObject, GLU_SAMPLING_TOLERANCE, 10.0);
 }
 
 // Function to increase value of a knot.
@@ -153,10 +165,17 @@ float Bspline(int i, int m, float u)
 	}
 }
 
+// Routine to evaluate the spline curve at parameter value u.
+void splineCurve(float u, float *point, void *data)
+{
+	deBoor(knots, 12, 3, controlPoints[0], 3, u, point);
+}
+
 // Drawing routine.
 void drawScene(void)
 {
 	int i, j;
+	float point[3];
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -184,9 +203,26 @@ void drawScene(void)
 
 	// Draw the spline curve.
 	glColor3f(0.0, 0.0, 0.0);
-	gluBeginCurve(nurbsObject);
-	gluNurbsCurve(nurbsObject, 12, knots, 3, controlPoints[0], 3, GL_MAP1_VERTEX_3);
-	gluEndCurve(nurbsObject);
+	if (isCurveChanged)
+	{
+		// Sample the curve, and make its arc length table, only when it has changed.
+		sampleCurveAdaptive(splineCurve, NULL, knots[2], knots[9], tolerance, curveVertices);
+		buildArcLengthTable(arcLengthTable, splineCurve, NULL, knots[2], knots[9], 0.01);
+		isCurveChanged = 0;
+	}
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, &curveVertices[0]);
+	glDrawArrays(GL_LINE_STRIP, 0, curveVertices.size() / 3);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	// Draw the travelling point at its distance along the curve.
+	if (distanceTravelled > arcLengthTable.totalLength) distanceTravelled = 0.0;
+	splineCurve(arcLengthToParam(arcLengthTable, distanceTravelled), point, NULL);
+	glColor3f(0.0, 0.0, 1.0);
+	glPointSize(8.0);
+	glBegin(GL_POINTS);
+	glVertex3fv(point);
+	glEnd();
 
 	// The following code displays the control points as dots.
 	glPointSize(5.0);
@@ -294,6 +330,19 @@ void drawScene(void)
 	glutSwapBuffers();
 }
 
+// Timer function.
+void animate(int value)
+{
+	if (isAnimate)
+	{
+		distanceTravelled += speed;
+		if (distanceTravelled > arcLengthTable.totalLength) distanceTravelled = 0.0;
+
+		glutPostRedisplay();
+		glutTimerFunc(animationPeriod, animate, 1);
+	}
+}
+
 // OpenGL window reshape routine.
 void resize(int w, int h)
 {
@@ -313,6 +362,14 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'a':
+		if (isAnimate) isAnimate = 0;
+		else
+		{
+			isAnimate = 1;
+			animate(1);
+		}
+		break;
 	case 'k':
 		if (changeControls == 1)  changeControls = 0;
 		glutPostRedisplay();
@@ -337,6 +394,7 @@ void keyInput(unsigned char key, int x, int y)
 	case 127:
 		if (changeControls == 1) resetControlPoints();
 		else resetKnots();
+		isCurveChanged = 1;
 		glutPostRedisplay();
 		break;
 	default:
@@ -361,6 +419,7 @@ void specialKeyInput(int key, int x, int y)
 		if (changeControls == 1) controlPoints[selectedControlPoint][0] += 1.0;
 		else increaseKnot(selectedKnot);
 	}
+	isCurveChanged = 1;
 	glutPostRedisplay();
 }
 
@@ -376,7 +435,8 @@ void printInteraction(void)
 		<< "Press 'k' to enter knots mode -" << std::endl
 		<< "Press the space bar to cycle through the knots." << std::endl
 		<< "The selected knot (in red) is increased/decreased using the right/left arrow keys." << std::endl
-		<< "Press delete to reset knot values." << std::endl;
+		<< "Press delete to reset knot values." << std::endl
+		<< "Press 'a' to start/stop the point travelling along the curve." << std::endl;
 }
 
 // Main routine.
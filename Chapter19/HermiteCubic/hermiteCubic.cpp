@@ -4,23 +4,38 @@
 // This program draws a Hermite cubic allowing the user control over the two end control 
 // points and the tangent vectors there.
 //
+// The cubic is drawn as a polyline with vertices placed by adaptive subdivision, so
+// they bunch where it bends and thin out where it is flat. A point can be made to
+// travel along it at constant speed using its arc length table.
+//
 // Interaction:
 // Press space to select a control point or tangent vector.
 // Press the arrow keys to move the selected control point or change the tangent vector.
+// Press 'a' to start/stop the point travelling along the cubic.
 //
 // Sumanta Guha
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "arcLength.h"
+
 // Begin globals.
 static int numVal = 0; // Current selection index.
 static float lengthArrowLine = 2.0; // Length of arrow line.
-static int numVertices = 50; // Number of vertices on cubic.
+static float tolerance = 0.1; // Largest distance of the drawn polyline from the cubic.
+static std::vector<float> curveVertices; // Vertices of the polyline.
+static ArcLengthTable arcLengthTable; // Arc length table of the cubic.
+static int isCurveChanged = 1; // Whether the curve has changed since its polyline and table were made.
+static float distanceTravelled = 0.0; // Arc length from the start of the travelling point.
+static float speed = 0.5; // Arc length covered by the travelling point per frame.
+static int isAnimate = 0; // Animated?
+static int animationPeriod = 20; // Time interval between frames.
 
 // Control points.
 static float controlPoints[2][3] =
@@ -50,6 +65,20 @@ void setup(void)
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 }
 
+// Routine to evaluate the Hermite cubic at parameter value u.
+void hermiteCubic(float u, float *point, void *data)
+{
+	float H0, H1, H2, H3;
+
+	H0 = 2.0*u*u*u - 3 * u*u + 1.0;
+	H1 = -2.0*u*u*u + 3 * u*u;
+	H2 = u*u*u - 2.0*u*u + u;
+	H3 = u*u*u - u*u;
+	for (int j = 0; j < 3; j++)
+		point[j] = H0*controlPoints[0][j] + H1*controlPoints[1][j] +
+		H2*tangentVectors[0][j] + H3*tangentVectors[1][j];
+}
+
 // Routine to compute tangent vector endpoints by adding tangent vector to control point vector.
 void computeEndPointTangentVectors(void)
 {
@@ -99,7 +128,7 @@ void drawScene(void)
 	glColor3f(0.0, 0.0, 0.0);
 
 	int i;
-	float u, H0, H1, H2, H3;
+	float point[3];
 
 	computeEndPointTangentVectors(); // Compute tangent vector endpoints.
 	computeEndPointArrowLines(); // Compute arrow endpoints.
@@ -169,26 +198,45 @@ void drawScene(void)
 	}
 
 	// Draw the cubic curve as a line strip.
-	glColor3f(0.0, 0.0, 0.0);
-	glBegin(GL_LINE_STRIP);
-	for (i = 0; i <= numVertices; ++i)
+	if (isCurveChanged)
 	{
-		u = (float)i / numVertices;
-		H0 = 2.0*u*u*u - 3 * u*u + 1.0;
-		H1 = -2.0*u*u*u + 3 * u*u;
-		H2 = u*u*u - 2.0*u*u + u;
-		H3 = u*u*u - u*u;
-		glVertex3f(H0*controlPoints[0][0] + H1*controlPoints[1][0] +
-			H2*tangentVectors[0][0] + H3*tangentVectors[1][0],
-			H0*controlPoints[0][1] + H1*controlPoints[1][1] +
-			H2*tangentVectors[0][1] + H3*tangentVectors[1][1],
-			0.0);
+		// Sample the cubic, and make its arc length table, only when it has changed.
+		sampleCurveAdaptive(hermiteCubic, NULL, 0.0, 1.0, tolerance, curveVertices);
+		buildArcLengthTable(arcLengthTable, hermiteCubic, NULL, 0.0, 1.0, 0.01);
+		isCurveChanged = 0;
 	}
+	glColor3f(0.0, 0.0, 0.0);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, &curveVertices[0]);
+	glDrawArrays(GL_LINE_STRIP, 0, curveVertices.size() / 3);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	// Draw the travelling point at its distance along the cubic.
+	if (distanceTravelled > arcLengthTable.totalLength) distanceTravelled = 0.0;
+	hermiteCubic(arcLengthToParam(arcLengthTable, distanceTravelled), point, NULL);
+	glColor3f(0.0, 0.0, 1.0);
+	glPointSize(8.0);
+	glBegin(GL_POINTS);
+	glVertex3fv(point);
 	glEnd();
+	glPointSize(5.0);
 
 	glutSwapBuffers();
 }
 
+// Timer function.
+void animate(int value)
+{
+	if (isAnimate)
+	{
+		distanceTravelled += speed;
+		if (distanceTravelled > arcLengthTable.totalLength) distanceTravelled = 0.0;
+
+		glutPostRedisplay();
+		glutTimerFunc(animationPeriod, animate, 1);
+	}
+}
+
 // OpenGL window reshape routine.
 void resize(int w, int h)
 {
@@ -212,6 +260,14 @@ void keyInput(unsigned char key, int x, int y)
 		if (numVal < 3) numVal++; else numVal = 0;
 		glutPostRedisplay();
 		break;
+	case 'a':
+		if (isAnimate) isAnimate = 0;
+		else
+		{
+			isAnimate = 1;
+			animate(1);
+		}
+		break;
 	default:
 		break;
 	}
@@ -241,6 +297,7 @@ void specialKeyInput(int key, int x, int y)
 		else tangentVectors[numVal / 2][0] += 0.5;
 	}
 
+	isCurveChanged = 1;
 	glutPostRedisplay();
 }
 
@@ -250,7 +307,8 @@ void printInteraction(void)
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press space to select a control point or tangent vector." << std::endl
 		<< "Press the arrow keys to move the selected control point or" << std::endl
-		<< "change the tangent vector." << std::endl;
+		<< "change the tangent vector." << std::endl
+		<< "Press 'a' to start/stop the point travelling along the cubic." << std::endl;
 }
 
 // Main routine.
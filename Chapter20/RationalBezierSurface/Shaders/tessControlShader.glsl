@@ -0,0 +1,71 @@
+#version 430 core
+
+// Patches of up to 32 homogeneous control points, row i (along v) and column j
+// (along u) at index i*uOrder + j, passed through unchanged.
+layout(vertices = 32) out;
+
+uniform int uOrder, vOrder;
+uniform mat4 modelViewMat;
+uniform mat4 projMat;
+uniform vec2 viewportSize;
+uniform float tolerance;
+
+vec4 clipCoords[32];
+
+// Screen-space length in pixels of the control polygon from index first in steps of stride.
+float polygonLength(int first, int stride, int count)
+{
+   int k;
+   float len = 0.0;
+   vec2 p, q;
+
+   for (k = 0; k < count; k++)
+      if (clipCoords[first + k*stride].w <= 0.0) return 64.0 * tolerance;
+
+   p = clipCoords[first].xy / clipCoords[first].w;
+   for (k = 1; k < count; k++)
+   {
+      q = clipCoords[first + k*stride].xy / clipCoords[first + k*stride].w;
+	  len += length((q - p) * viewportSize / 2.0);
+	  p = q;
+   }
+   return len;
+}
+
+void main(void)
+{
+   int k, numPoints = uOrder * vOrder;
+   vec4 c;
+   vec3 allBelow, allAbove;
+
+   gl_out[gl_InvocationID].gl_Position = gl_in[min(gl_InvocationID, numPoints - 1)].gl_Position;
+
+   if (gl_InvocationID == 0)
+   {
+      for (k = 0; k < numPoints; k++) clipCoords[k] = projMat * modelViewMat * gl_in[k].gl_Position;
+
+	  // Cull the patch if its control points, hence the patch, lie outside one frustum plane.
+	  allBelow = vec3(1.0); allAbove = vec3(1.0);
+	  for (k = 0; k < numPoints; k++)
+	  {
+	     c = clipCoords[k];
+	     allBelow *= vec3(lessThan(c.xyz, vec3(-c.w)));
+	     allAbove *= vec3(greaterThan(c.xyz, vec3(c.w)));
+	  }
+	  if (any(greaterThan(allBelow + allAbove, vec3(0.0))))
+	  {
+	     gl_TessLevelOuter[0] = gl_TessLevelOuter[1] = gl_TessLevelOuter[2] = gl_TessLevelOuter[3] = 0.0;
+		 gl_TessLevelInner[0] = gl_TessLevelInner[1] = 0.0;
+		 return;
+	  }
+
+	  // Outer levels from the screen-space length of the boundary control polygons:
+	  // edges u = 0, v = 0, u = 1 and v = 1 in turn.
+	  gl_TessLevelOuter[0] = clamp(polygonLength(0, uOrder, vOrder) / tolerance, 1.0, 64.0);
+	  gl_TessLevelOuter[1] = clamp(polygonLength(0, 1, uOrder) / tolerance, 1.0, 64.0);
+	  gl_TessLevelOuter[2] = clamp(polygonLength(uOrder - 1, uOrder, vOrder) / tolerance, 1.0, 64.0);
+	  gl_TessLevelOuter[3] = clamp(polygonLength((vOrder - 1) * uOrder, 1, uOrder) / tolerance, 1.0, 64.0);
+	  gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+	  gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+   }
+}
@@ -0,0 +1,48 @@
+#version 430 core
+
+#define MAX_ORDER 8
+
+layout(quads, equal_spacing, ccw) in;
+
+uniform int uOrder, vOrder;
+uniform mat4 modelViewMat;
+uniform mat4 projMat;
+
+float uBernstein[MAX_ORDER], vBernstein[MAX_ORDER];
+
+// Bernstein polynomials of the given order at t by the triangular recurrence.
+void bernstein(int order, float t, out float B[MAX_ORDER])
+{
+   int j, k;
+   float saved, temp;
+
+   B[0] = 1.0;
+   for (k = 1; k < order; k++)
+   {
+      saved = 0.0;
+	  for (j = 0; j < k; j++)
+	  {
+	     temp = B[j];
+		 B[j] = saved + (1.0 - t) * temp;
+		 saved = t * temp;
+	  }
+	  B[k] = saved;
+   }
+}
+
+void main()
+{
+   int i, j;
+   vec4 point = vec4(0.0);
+
+   bernstein(uOrder, gl_TessCoord.x, uBernstein);
+   bernstein(vOrder, gl_TessCoord.y, vBernstein);
+
+   // The homogeneous sum is projected by the division following the vertex stage,
+   // which makes rational and polynomial patches alike.
+   for (i = 0; i < vOrder; i++)
+      for (j = 0; j < uOrder; j++)
+	     point += vBernstein[i] * uBernstein[j] * gl_in[i*uOrder + j].gl_Position;
+
+   gl_Position = projMat * modelViewMat * point;
+}
@@ -0,0 +1,8 @@
+#version 430 core
+
+layout(location=0) in vec4 controlPointCoords;
+
+void main(void)
+{
+   gl_Position = controlPointCoords;
+}
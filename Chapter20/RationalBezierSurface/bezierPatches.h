@@ -0,0 +1,38 @@
+#ifndef BEZIERPATCHES_H
+#define BEZIERPATCHES_H
+
+#include <vector>
+
+#define BEZIER_MAX_PATCH_POINTS 32 // Most control points of a patch, uOrder*vOrder.
+#define BEZIER_CPU_GRID 20 // Grid size of the CPU-evaluated fallback.
+
+// A set of Bezier patches of the same orders, polynomial or rational, drawn in one call.
+// The control points of patch p are the homogeneous points p*uOrder*vOrder + i*uOrder + j,
+// i along v and j along u, the layout glMap2f() takes with ustride 4 and vstride 4*uOrder.
+// They are uploaded once and again only when updated. Patches are evaluated in the
+// tessellation shaders with levels chosen per edge from its screen-space size; where
+// tessellation shaders are not supported, or when cpuFallback is set, they are
+// evaluated on a fixed grid on the CPU instead.
+struct BezierPatches
+{
+	int uOrder, vOrder; // Orders in either direction.
+	int numPatches; // Number of patches.
+	float tolerance; // Target screen-space length in pixels of a tessellation step.
+	bool tessellationSupported; // If the tessellation program was built.
+	bool cpuFallback; // If to evaluate on the CPU regardless.
+
+	unsigned int programId, vao[1], buffer[1]; // Tessellation path objects.
+	unsigned int uOrderLoc, vOrderLoc, modelViewMatLoc, projMatLoc, viewportSizeLoc,
+		toleranceLoc, patchColorLoc; // Uniform locations.
+
+	std::vector<float> controlPoints; // Copy of the control points for the fallback.
+	std::vector<float> gridVertices; // Fallback grid, homogeneous co-ordinates.
+	std::vector<unsigned int> gridIndices; // Fallback grid triangles.
+	bool gridValid; // If gridVertices matches controlPoints.
+};
+
+void createBezierPatches(BezierPatches &patches, int uOrder, int vOrder, int numPatches);
+void updateBezierPatches(BezierPatches &patches, int firstPatch, int count, const float *controlPoints);
+void drawBezierPatches(BezierPatches &patches, const float *color);
+
+#endif
@@ -4,6 +4,11 @@
 // This program, based on bezierSurface.cpp, allows the user to design a rational Bezier surface 
 // by moving control points and changing their weights.
 //
+// The surface is evaluated by bezierPatches.cpp in tessellation shaders from homogeneous
+// control points uploaded once and again only when changed, with tessellation levels 
+// following the patch's size on screen. Without tessellation shader support it falls 
+// back to a 20x20 grid evaluated on the CPU.
+//
 // Interaction:
 // Press space and tab to select a control point.
 // Press the right/left arrow keys to move the control point up/down the x-axis.
@@ -12,6 +17,7 @@
 // Press < and > to decrease/increase the weight of the control point.
 // Press the x, X, y, Y, z, Z keys to rotate the viewpoint.
 // Press delete to reset control points.
+// Press 'c' to toggle between GPU tessellation and CPU evaluation.
 // 
 // Sumanta Guha.
 //////////////////////////////////////////////////////////////////////////////////////////////// 
@@ -22,6 +28,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "bezierPatches.h"
+
 // Begin globals.
 // Initial control points.
 float controlPoints[6][4][3] =
@@ -43,6 +51,7 @@ float weights[6][4];
 // Control points in homogeneous co-ordinates.
 float controlPointsHomogeneous[6][4][4];
 
+static BezierPatches surface; // The rational Bezier surface as a single patch.
 static float Xangle = 30.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate canoe.
 static int rowCount = 0, columnCount = 0; // Indexes of selected control point.
 static char theStringBuffer[10]; // String buffer.
@@ -85,6 +94,7 @@ void computeControlPointsHomeogeneous(void)
 			}
 			controlPointsHomogeneous[i][j][3] = weights[i][j];
 		}
+	updateBezierPatches(surface, 0, 1, controlPointsHomogeneous[0][0]);
 }
 
 // Restore control points to original settings.
@@ -117,6 +127,8 @@ void setup(void)
 			for (k = 0; k < 3; k++)
 				originalControlPoints[i][j][k] = controlPoints[i][j][k];
 
+	// Order 4 along u, across a row of control points, and 6 along v.
+	createBezierPatches(surface, 4, 6, 1);
 	computeControlPointsHomeogeneous();
 }
 
@@ -157,14 +169,11 @@ void drawScene(void)
 	glVertex3fv(controlPoints[rowCount][columnCount]);
 	glEnd();
 
-	// Specify and enable the Bezier surface.
-	glMap2f(GL_MAP2_VERTEX_4, 0, 1, 4, 4, 0, 1, 16, 6, controlPointsHomogeneous[0][0]);
-	glEnable(GL_MAP2_VERTEX_4);
-
-	// Make a mesh approximation of the Bezier surface.
-	glColor3f(0.0, 0.0, 0.0);
-	glMapGrid2f(20, 0.0, 1.0, 20, 0.0, 1.0);
-	glEvalMesh2(GL_LINE, 0, 20, 0, 20);
+	// Draw the rational Bezier surface as a mesh.
+	float black[4] = { 0.0, 0.0, 0.0, 1.0 };
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	drawBezierPatches(surface, black);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 	// Draw the co-ordinate axes.
 	glLineWidth(2.0);
@@ -291,6 +300,10 @@ void keyInput(unsigned char key, int x, int y)
 		computeControlPointsHomeogeneous();
 		glutPostRedisplay();
 		break;
+	case 'c':
+		surface.cpuFallback = !surface.cpuFallback;
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
@@ -320,7 +333,8 @@ void printInteraction(void)
 		<< "Press the page up/down keys to move the control point up/down the z-axis." << std::endl
 		<< "Press < and > to decrease/increase the weight of the control point." << std::endl
 		<< "Press the x, X, y, Y, z, Z keys to rotate the viewpoint." << std::endl
-		<< "Press delete to reset control points." << std::endl;
+		<< "Press delete to reset control points." << std::endl
+		<< "Press 'c' to toggle between GPU tessellation and CPU evaluation." << std::endl;
 }
 
 // Main routine.
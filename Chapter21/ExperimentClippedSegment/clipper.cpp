@@ -0,0 +1,300 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// clipper.cpp
+//
+// Clipping of segments, by Cohen-Sutherland outcodes and Liang-Barsky, and of convex
+// polygons, by Sutherland-Hodgman, against any set of planes.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "clipper.h"
+#include "float4.h"
+
+// Routine to load four consecutive floats.
+static inline Float4 load4(const float *p)
+{
+#ifdef FLOAT4_SSE
+	return _mm_loadu_ps(p);
+#else
+	return Float4(p[0], p[1], p[2], p[3]);
+#endif
+}
+
+// Routine to store four floats consecutively.
+static inline void store4(float *p, const Float4 &a)
+{
+#ifdef FLOAT4_SSE
+	_mm_storeu_ps(p, a.m);
+#else
+	for (int i = 0; i < 4; i++) p[i] = a.f[i];
+#endif
+}
+
+// Routine to return the signed distance, scaled by the length of its normal, of a point
+// from a plane, negative if it is clipped.
+static inline float distance(const float *plane, const float *point)
+{
+	return plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2] + plane[3] * point[3];
+}
+
+// Add a plane keeping the points with eqn[0] x + eqn[1] y + eqn[2] z + eqn[3] w >= 0.
+void addClipPlane(ClipPlanes &clip, const float *eqn)
+{
+	if (clip.planes.size() / 4 < CLIP_MAX_PLANES) clip.planes.insert(clip.planes.end(), eqn, eqn + 4);
+}
+
+// Add the six planes, in eye coordinates, of the view frustum glFrustum() would set with
+// the same arguments: left, right, bottom, top, near and far.
+void addFrustumPlanes(ClipPlanes &clip, float left, float right, float bottom, float top,
+	                  float nearVal, float farVal)
+{
+	float planes[6][4] =
+	{
+		{ nearVal, 0.0, left, 0.0 },
+		{ -nearVal, 0.0, -right, 0.0 },
+		{ 0.0, nearVal, bottom, 0.0 },
+		{ 0.0, -nearVal, -top, 0.0 },
+		{ 0.0, 0.0, -1.0, -nearVal },
+		{ 0.0, 0.0, 1.0, farVal }
+	};
+
+	for (int i = 0; i < 6; i++) addClipPlane(clip, planes[i]);
+}
+
+// Cohen-Sutherland outcode of a point: bit i set if plane i clips it.
+unsigned int clipOutcode(const ClipPlanes &clip, const float *point)
+{
+	unsigned int code = 0;
+	int i, numPlanes = clip.planes.size() / 4;
+
+	for (i = 0; i < numPlanes; i++)
+		if (distance(&clip.planes[4 * i], point) < 0.0) code |= 1u << i;
+	return code;
+}
+
+// Clip the segment from p0 to p1, each (x, y, z, w), writing the parameters along it of the
+// ends of the part kept, t0 > t1 if none, and returning if any is. Segments with both
+// endpoints inside every plane are accepted, and those with both outside one rejected, by
+// their outcodes; the rest are clipped by Liang-Barsky against the planes they cross.
+bool clipSegment(const ClipPlanes &clip, const float *p0, const float *p1, float &t0, float &t1)
+{
+	unsigned int code0 = clipOutcode(clip, p0), code1 = clipOutcode(clip, p1), crossed;
+	float d0, d1, t;
+	int i;
+
+	t0 = 0.0; t1 = 1.0;
+	if (code0 & code1)
+	{
+		t0 = 1.0; t1 = 0.0;
+		return false;
+	}
+	for (crossed = code0 | code1, i = 0; crossed; crossed >>= 1, i++)
+	{
+		if (!(crossed & 1)) continue;
+		d0 = distance(&clip.planes[4 * i], p0);
+		d1 = distance(&clip.planes[4 * i], p1);
+		t = d0 / (d0 - d1);
+		if (d0 < 0.0) t0 = std::max(t0, t); // Entering.
+		else t1 = std::min(t1, t); // Leaving.
+	}
+	if (t0 > t1)
+	{
+		t0 = 1.0; t1 = 0.0;
+		return false;
+	}
+	return true;
+}
+
+// Add the segment from p0 to p1, each (x, y, z, w).
+void addClipSegment(ClipSegments &segments, const float *p0, const float *p1)
+{
+	segments.x0.push_back(p0[0]); segments.y0.push_back(p0[1]);
+	segments.z0.push_back(p0[2]); segments.w0.push_back(p0[3]);
+	segments.x1.push_back(p1[0]); segments.y1.push_back(p1[1]);
+	segments.z1.push_back(p1[2]); segments.w1.push_back(p1[3]);
+}
+
+// Clip all the segments, writing the part each keeps, exactly as clipSegment() would, and
+// returning how many keep any. Four are clipped at once by Liang-Barsky against every plane,
+// the division skipped at a plane none of the four crosses, and the rest one by one.
+int clipSegments(const ClipPlanes &clip, ClipSegments &segments)
+{
+	int numSegments = segments.x0.size(), numPlanes = clip.planes.size() / 4, numKept = 0, i, j;
+	Float4 zero(0.0), one(1.0);
+
+	segments.t0.resize(numSegments);
+	segments.t1.resize(numSegments);
+
+	for (i = 0; i + 4 <= numSegments; i += 4)
+	{
+		Float4 x0 = load4(&segments.x0[i]), y0 = load4(&segments.y0[i]), z0 = load4(&segments.z0[i]),
+			w0 = load4(&segments.w0[i]), x1 = load4(&segments.x1[i]), y1 = load4(&segments.y1[i]),
+			z1 = load4(&segments.z1[i]), w1 = load4(&segments.w1[i]);
+		Float4 t0 = zero, t1 = one, rejected = zero;
+
+		for (j = 0; j < numPlanes; j++)
+		{
+			const float *plane = &clip.planes[4 * j];
+			Float4 a(plane[0]), b(plane[1]), c(plane[2]), d(plane[3]);
+			Float4 d0 = a * x0 + b * y0 + c * z0 + d * w0, d1 = a * x1 + b * y1 + c * z1 + d * w1;
+			Float4 out0 = d0 < zero, out1 = d1 < zero;
+
+			rejected = rejected | (out0 & out1);
+			if (!bits(andNot(out0 & out1, out0 | out1))) continue;
+			Float4 t = d0 / (d0 - d1);
+			t0 = select(andNot(out1, out0), max(t0, t), t0);
+			t1 = select(andNot(out0, out1), min(t1, t), t1);
+		}
+
+		Float4 kept = andNot(rejected, t0 <= t1);
+		int keptBits = bits(kept);
+		store4(&segments.t0[i], select(kept, t0, one));
+		store4(&segments.t1[i], select(kept, t1, zero));
+		numKept += (keptBits & 1) + (keptBits >> 1 & 1) + (keptBits >> 2 & 1) + (keptBits >> 3);
+	}
+
+	for (; i < numSegments; i++)
+	{
+		float p0[] = { segments.x0[i], segments.y0[i], segments.z0[i], segments.w0[i] };
+		float p1[] = { segments.x1[i], segments.y1[i], segments.z1[i], segments.w1[i] };
+		if (clipSegment(clip, p0, p1, segments.t0[i], segments.t1[i])) numKept++;
+	}
+	return numKept;
+}
+
+// Routine to clip a convex polygon by Sutherland-Hodgman against the planes whose bits are
+// set in mask, one plane after another, writing the vertices of the result to clipped and
+// returning their number. Each new vertex is interpolated from the inside vertex of its
+// edge towards the outside one, so that an edge shared by two polygons, whichever way
+// round they take it, is cut at the same point.
+static int clipAgainst(const ClipPlanes &clip, const float *vertices, int count, int stride,
+	                   unsigned int mask, std::vector<float> &clipped)
+{
+	std::vector<float> buffer[2];
+	const float *in = vertices, *previous, *current, *inside, *outside;
+	float dPrevious, dCurrent, t;
+	int i, j, k, numIn = count, side = 0;
+
+	for (i = 0; mask; mask >>= 1, i++)
+	{
+		if (!(mask & 1)) continue;
+		const float *plane = &clip.planes[4 * i];
+		std::vector<float> &out = buffer[side];
+
+		out.clear();
+		previous = in + (numIn - 1) * stride;
+		dPrevious = distance(plane, previous);
+		for (j = 0; j < numIn; j++)
+		{
+			current = in + j * stride;
+			dCurrent = distance(plane, current);
+			if ((dPrevious < 0.0) != (dCurrent < 0.0))
+			{
+				if (dPrevious < 0.0) { inside = current; outside = previous; t = dCurrent / (dCurrent - dPrevious); }
+				else { inside = previous; outside = current; t = dPrevious / (dPrevious - dCurrent); }
+				for (k = 0; k < stride; k++) out.push_back(inside[k] + t * (outside[k] - inside[k]));
+			}
+			if (dCurrent >= 0.0) out.insert(out.end(), current, current + stride);
+			previous = current;
+			dPrevious = dCurrent;
+		}
+
+		numIn = out.size() / stride;
+		if (numIn == 0) break;
+		in = &out[0];
+		side = 1 - side;
+	}
+
+	clipped.assign(in, in + numIn * stride);
+	return numIn;
+}
+
+// Clip a convex polygon of count vertices, each stride floats, x, y, z and w first, the
+// rest attributes interpolated along with them, writing the vertices of the result to
+// clipped and returning their number, 0 if none is left. Only the planes that clip some
+// vertex are clipped against.
+int clipPolygon(const ClipPlanes &clip, const float *vertices, int count, int stride,
+	            std::vector<float> &clipped)
+{
+	unsigned int any = 0, all = ~0u, code;
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		code = clipOutcode(clip, vertices + i * stride);
+		any |= code;
+		all &= code;
+	}
+	if (count == 0 || all)
+	{
+		clipped.clear();
+		return 0;
+	}
+	if (!any)
+	{
+		clipped.assign(vertices, vertices + count * stride);
+		return count;
+	}
+	return clipAgainst(clip, vertices, count, stride, any, clipped);
+}
+
+// Clip all the polygons, appending what is left of each to clipped, with the same stride,
+// and returning the number left. The outcodes of the vertices are found four at a time, and
+// only polygons straddling a plane are clipped, one by one.
+int clipPolygons(const ClipPlanes &clip, const ClipPolygons &polygons, ClipPolygons &clipped)
+{
+	int stride = polygons.stride, numVertices = polygons.vertices.size() / stride,
+		numPlanes = clip.planes.size() / 4, numLeft = 0, first, i, j, k;
+	std::vector<unsigned int> codes(numVertices, 0);
+	std::vector<float> polygon;
+	const float *v = polygons.vertices.empty() ? NULL : &polygons.vertices[0];
+	Float4 zero(0.0);
+
+	clipped.stride = stride;
+
+	// Outcodes, gathering the coordinates of four vertices into registers.
+	for (i = 0; i + 4 <= numVertices; i += 4)
+	{
+		const float *p = v + i * stride;
+		Float4 x(p[0], p[stride], p[2 * stride], p[3 * stride]),
+			y(p[1], p[stride + 1], p[2 * stride + 1], p[3 * stride + 1]),
+			z(p[2], p[stride + 2], p[2 * stride + 2], p[3 * stride + 2]),
+			w(p[3], p[stride + 3], p[2 * stride + 3], p[3 * stride + 3]);
+
+		for (j = 0; j < numPlanes; j++)
+		{
+			const float *plane = &clip.planes[4 * j];
+			int out = bits(Float4(plane[0]) * x + Float4(plane[1]) * y + Float4(plane[2]) * z +
+				           Float4(plane[3]) * w < zero);
+			for (k = 0; k < 4; k++) codes[i + k] |= (out >> k & 1u) << j;
+		}
+	}
+	for (; i < numVertices; i++) codes[i] = clipOutcode(clip, v + i * stride);
+
+	for (i = 0, first = 0; i < (int)polygons.counts.size(); first += polygons.counts[i], i++)
+	{
+		unsigned int any = 0, all = ~0u;
+		int count = polygons.counts[i];
+
+		for (j = first; j < first + count; j++)
+		{
+			any |= codes[j];
+			all &= codes[j];
+		}
+		if (count == 0 || all) continue;
+		if (!any)
+		{
+			clipped.vertices.insert(clipped.vertices.end(), v + first * stride, v + (first + count) * stride);
+			clipped.counts.push_back(count);
+		}
+		else
+		{
+			count = clipAgainst(clip, v + first * stride, count, stride, any, polygon);
+			if (count == 0) continue;
+			clipped.vertices.insert(clipped.vertices.end(), polygon.begin(), polygon.end());
+			clipped.counts.push_back(count);
+		}
+		numLeft++;
+	}
+	return numLeft;
+}
@@ -0,0 +1,48 @@
+#ifndef CLIPPER_H
+#define CLIPPER_H
+
+#include <vector>
+
+#define CLIP_MAX_PLANES 32 // Most planes clipped against, one bit of an outcode each.
+
+// A set of clipping planes, each (a, b, c, d) keeping the points (x, y, z, w) with
+// a x + b y + c z + d w >= 0, as glClipPlane() does those with w = 1 in eye coordinates.
+// Points are homogeneous so that the planes can be those of a view frustum in eye
+// coordinates, with w = 1, or of the clip volume, for vertices after projection.
+struct ClipPlanes
+{
+	std::vector<float> planes; // 4 floats per plane.
+};
+
+// Segments as a structure of arrays, so that four of them are clipped at once, each
+// coordinate of their endpoints in an SSE register. Clipping writes the parameters along
+// each segment, from 0 at its first endpoint to 1 at its second, of the ends of the part
+// it keeps, t0 > t1 if none.
+struct ClipSegments
+{
+	std::vector<float> x0, y0, z0, w0; // First endpoints.
+	std::vector<float> x1, y1, z1, w1; // Second endpoints.
+	std::vector<float> t0, t1; // Part kept, written by clipSegments().
+};
+
+// Convex polygons with any number of attributes interpolated along with their vertices.
+// Each vertex is stride floats, x, y, z and w first.
+struct ClipPolygons
+{
+	int stride; // Floats per vertex.
+	std::vector<float> vertices; // The vertices of all the polygons, one polygon after another.
+	std::vector<int> counts; // Vertices of each polygon.
+};
+
+void addClipPlane(ClipPlanes &clip, const float *eqn);
+void addFrustumPlanes(ClipPlanes &clip, float left, float right, float bottom, float top,
+	                  float nearVal, float farVal);
+unsigned int clipOutcode(const ClipPlanes &clip, const float *point);
+bool clipSegment(const ClipPlanes &clip, const float *p0, const float *p1, float &t0, float &t1);
+void addClipSegment(ClipSegments &segments, const float *p0, const float *p1);
+int clipSegments(const ClipPlanes &clip, ClipSegments &segments);
+int clipPolygon(const ClipPlanes &clip, const float *vertices, int count, int stride,
+	            std::vector<float> &clipped);
+int clipPolygons(const ClipPlanes &clip, const ClipPolygons &polygons, ClipPolygons &clipped);
+
+#endif
@@ -2,33 +2,107 @@
 // experimentClippedSegment.cpp
 // (modifying box.cpp)
 //
+// The segment can be clipped on the CPU, against the planes of the viewing
+// frustum, by clipper.cpp, to show the part of it OpenGL's clipper keeps.
+//
+// Interaction:
+// Press c to toggle between clipping by OpenGL and on the CPU.
+// Press b to time clipping a million random segments on the CPU.
+//
 // Sumanta Guha.
 /////////////////////////////////
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "clipper.h"
+
+#define NUM_SEGMENTS 1000000 // Segments timed.
+
+// Globals.
+static int isCpuClipped = 0; // Is the segment clipped on the CPU?
+static float segment[2][4] = { { 1.0, 0.0, -10.0, 1.0 }, { 1.0, 0.0, 0.0, 1.0 } }; // Endpoints.
+static ClipPlanes frustumPlanes; // Planes of the viewing frustum in eye coordinates.
+
 // Drawing routine.
 void drawScene(void)
 {
+	float t0 = 0.0, t1 = 1.0;
+
 	glClear(GL_COLOR_BUFFER_BIT);
 	glColor3f(0.0, 0.0, 0.0);
 	glLoadIdentity();
 
+	// On the CPU only the part inside the frustum is drawn, leaving OpenGL nothing to clip.
+	if (isCpuClipped && !clipSegment(frustumPlanes, segment[0], segment[1], t0, t1))
+	{
+		glFlush();
+		return;
+	}
+
 	glBegin(GL_LINES);
-	glVertex3f(1.0, 0.0, -10.0);
-	glVertex3f(1.0, 0.0, 0.0);
+	glVertex3f(segment[0][0] + t0 * (segment[1][0] - segment[0][0]),
+		       segment[0][1] + t0 * (segment[1][1] - segment[0][1]),
+		       segment[0][2] + t0 * (segment[1][2] - segment[0][2]));
+	glVertex3f(segment[0][0] + t1 * (segment[1][0] - segment[0][0]),
+		       segment[0][1] + t1 * (segment[1][1] - segment[0][1]),
+		       segment[0][2] + t1 * (segment[1][2] - segment[0][2]));
 	glEnd();
 
 	glFlush();
 }
 
+// Routine to time clipping random segments against the frustum, four at a time and
+// one by one, and to compare the results.
+void timeClipping(void)
+{
+	ClipSegments segments;
+	float p[2][4], t0, t1;
+	int i, j, numKept, numDifferent = 0;
+
+	// Endpoints in a box around the frustum.
+	for (i = 0; i < NUM_SEGMENTS; i++)
+	{
+		for (j = 0; j < 2; j++)
+		{
+			p[j][0] = -20.0 + 40.0 * rand() / RAND_MAX;
+			p[j][1] = -20.0 + 40.0 * rand() / RAND_MAX;
+			p[j][2] = -110.0 + 110.0 * rand() / RAND_MAX;
+			p[j][3] = 1.0;
+		}
+		addClipSegment(segments, p[0], p[1]);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	numKept = clipSegments(frustumPlanes, segments);
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	std::cout << NUM_SEGMENTS << " segments clipped four at a time in " << 1000.0 * seconds << " ms, "
+		<< NUM_SEGMENTS / seconds / 1.0e6 << " million a second, " << numKept << " kept" << std::endl;
+
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < NUM_SEGMENTS; i++)
+	{
+		float p0[] = { segments.x0[i], segments.y0[i], segments.z0[i], segments.w0[i] };
+		float p1[] = { segments.x1[i], segments.y1[i], segments.z1[i], segments.w1[i] };
+		clipSegment(frustumPlanes, p0, p1, t0, t1);
+		if (t0 != segments.t0[i] || t1 != segments.t1[i]) numDifferent++;
+	}
+	seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	std::cout << NUM_SEGMENTS << " segments clipped one by one in " << 1000.0 * seconds << " ms, "
+		<< NUM_SEGMENTS / seconds / 1.0e6 << " million a second, " << numDifferent << " different" << std::endl;
+}
+
 // Initialization routine.
 void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
+
+	// The frustum glFrustum() sets in resize().
+	addFrustumPlanes(frustumPlanes, -5.0, 5.0, -5.0, 5.0, 5.0, 100.0);
 }
 
 // OpenGL window reshape routine.
@@ -50,14 +124,31 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'c':
+		isCpuClipped = !isCpuClipped;
+		std::cout << "Clipping " << (isCpuClipped ? "on the CPU." : "by OpenGL.") << std::endl;
+		glutPostRedisplay();
+		break;
+	case 'b':
+		timeClipping();
+		break;
 	default:
 		break;
 	}
 }
 
+// Routine to output interaction instructions to the C++ window.
+void printInteraction(void)
+{
+	std::cout << "Interaction:" << std::endl;
+	std::cout << "Press c to toggle between clipping by OpenGL and on the CPU." << std::endl
+		<< "Press b to time clipping a million random segments on the CPU." << std::endl;
+}
+
 // Main routine.
 int main(int argc, char **argv)
 {
+	printInteraction();
 	glutInit(&argc, argv);
 
 	glutInitContextVersion(4, 3);
@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// jobSystem.cpp
+//
+// A job system running parallel loops on a pool of worker threads.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include "jobSystem.h"
+
+// JobSystem constructor.
+JobSystem::JobSystem(int numThreads)
+{
+	int i;
+
+	if (numThreads <= 0) numThreads = std::thread::hardware_concurrency() - 1;
+	job = NULL; count = 0; next = 0; busy = 0; generation = 0; quit = false;
+	for (i = 0; i < numThreads; i++) workers.push_back(std::thread(&JobSystem::workerLoop, this));
+}
+
+// JobSystem destructor.
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &worker : workers) worker.join();
+}
+
+// Run iterations of the current loop till none are left.
+void JobSystem::runIterations()
+{
+	int i;
+	while ((i = next++) < count) (*job)(i);
+}
+
+// Routine run by each worker: wait for a loop, help run it, and report when done.
+void JobSystem::workerLoop()
+{
+	unsigned int seen = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || generation != seen; });
+			if (quit) return;
+			seen = generation;
+		}
+		runIterations();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0) finished.notify_one();
+		}
+	}
+}
+
+// Run job(0), ..., job(count - 1) on the workers and the calling thread.
+void JobSystem::parallelFor(int count, const std::function<void(int)> &job)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (int i = 0; i < count; i++) job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->job = &job;
+		this->count = count;
+		next = 0;
+		busy = workers.size();
+		generation++;
+	}
+	wake.notify_all();
+	runIterations();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [&] { return busy == 0; });
+}
@@ -0,0 +1,394 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// radiosity.cpp
+//
+// A progressive refinement radiosity solver, shooting light from patches to vertices.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+
+#include "radiosity.h"
+
+#define PI 3.14159265358979324
+
+// Routine to return the dot product of two vectors.
+static inline float dot(const float *a, const float *b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Routine to write the cross product of two vectors to c.
+static inline void cross(const float *a, const float *b, float *c)
+{
+	c[0] = a[1] * b[2] - a[2] * b[1];
+	c[1] = a[2] * b[0] - a[0] * b[2];
+	c[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// RadiositySolver constructor.
+RadiositySolver::RadiositySolver(size_t cacheBytes)
+{
+	maxCachedBytes = cacheBytes; cachedBytes = 0;
+	cacheHits = cacheMisses = 0;
+	startUnshot = 0.0; numShots = 0;
+	lightPos[0] = lightPos[1] = lightPos[2] = 0.0;
+	lightColor[0] = lightColor[1] = lightColor[2] = 1.0;
+}
+
+// Add a vertex, returning its index.
+int RadiositySolver::addVertex(const float coords[3], const float normal[3], const float reflectance[3])
+{
+	RadiosityVertex vertex;
+
+	std::copy(coords, coords + 3, vertex.coords);
+	std::copy(normal, normal + 3, vertex.normal);
+	std::copy(reflectance, reflectance + 3, vertex.reflectance);
+	vertex.radiosity[0] = vertex.radiosity[1] = vertex.radiosity[2] = 0.0;
+	vertices.push_back(vertex);
+	return vertices.size() - 1;
+}
+
+// Add a patch of the vertices, counter-clockwise seen from its front. Its normal is along
+// the cross product of its diagonals, and so right for a triangle with v3 == v2 or v3 == v0 too.
+void RadiositySolver::addPatch(int v0, int v1, int v2, int v3)
+{
+	const float *p0 = vertices[v0].coords, *p1 = vertices[v1].coords, *p2 = vertices[v2].coords,
+		*p3 = vertices[v3].coords;
+	float diagonal1[3], diagonal2[3], edge1[3], edge2[3], normal[3], area1, area2, length;
+	RadiosityPatch patch;
+	int j;
+
+	patch.v[0] = v0; patch.v[1] = v1; patch.v[2] = v2; patch.v[3] = v3;
+	for (j = 0; j < 3; j++)
+	{
+		diagonal1[j] = p2[j] - p0[j];
+		diagonal2[j] = p3[j] - p1[j];
+	}
+	cross(diagonal1, diagonal2, patch.normal);
+	length = sqrt(dot(patch.normal, patch.normal));
+	if (length == 0.0) return; // Degenerate.
+	for (j = 0; j < 3; j++) patch.normal[j] /= length;
+
+	// Area and centroid of the triangles v0 v1 v2 and v0 v2 v3.
+	for (j = 0; j < 3; j++) edge1[j] = p1[j] - p0[j];
+	cross(edge1, diagonal1, normal);
+	area1 = 0.5 * sqrt(dot(normal, normal));
+	for (j = 0; j < 3; j++) edge2[j] = p3[j] - p0[j];
+	cross(diagonal1, edge2, normal);
+	area2 = 0.5 * sqrt(dot(normal, normal));
+	patch.area = area1 + area2;
+	for (j = 0; j < 3; j++)
+		patch.center[j] = (area1 * (p0[j] + p1[j] + p2[j]) + area2 * (p0[j] + p2[j] + p3[j])) / (3.0 * patch.area);
+
+	patch.unshot[0] = patch.unshot[1] = patch.unshot[2] = 0.0;
+	patches.push_back(patch);
+}
+
+// Add a sphere blocking light.
+void RadiositySolver::addSphere(const float center[3], float radius)
+{
+	RadiositySphere sphere;
+
+	std::copy(center, center + 3, sphere.center);
+	sphere.radius = radius;
+	spheres.push_back(sphere);
+}
+
+// Add a parallelogram blocking light.
+void RadiositySolver::addQuad(const float corner[3], const float edge1[3], const float edge2[3])
+{
+	RadiosityQuad quad;
+
+	std::copy(corner, corner + 3, quad.corner);
+	std::copy(edge1, edge1 + 3, quad.edge1);
+	std::copy(edge2, edge2 + 3, quad.edge2);
+	quads.push_back(quad);
+}
+
+// Set the light's position and color.
+void RadiositySolver::setLight(const float position[3], const float color[3])
+{
+	std::copy(position, position + 3, lightPos);
+	std::copy(color, color + 3, lightColor);
+}
+
+// Routine to return if the segment between two points, bar a little at either end, misses
+// every occluder.
+bool RadiositySolver::isVisible(const float from[3], const float to[3])
+{
+	float d[3], o[3], p[3], normal[3], axis[3], a, b, c, discriminant, root, t, s, nn;
+	int j;
+
+	for (j = 0; j < 3; j++) d[j] = to[j] - from[j];
+
+	// Spheres: the segment is blocked if the interval of t where it is inside one overlaps
+	// its own.
+	for (const RadiositySphere &sphere : spheres)
+	{
+		for (j = 0; j < 3; j++) o[j] = from[j] - sphere.center[j];
+		a = dot(d, d); b = dot(d, o); c = dot(o, o) - sphere.radius * sphere.radius;
+		discriminant = b * b - a * c;
+		if (discriminant <= 0.0) continue;
+		root = sqrt(discriminant);
+		if ((-b - root) / a < 1.0 - RADIOSITY_EPSILON && (-b + root) / a > RADIOSITY_EPSILON) return false;
+	}
+
+	// Parallelograms: the segment is blocked if it crosses the plane of one inside it.
+	for (const RadiosityQuad &quad : quads)
+	{
+		cross(quad.edge1, quad.edge2, normal);
+		b = dot(normal, d);
+		if (b == 0.0) continue;
+		for (j = 0; j < 3; j++) o[j] = quad.corner[j] - from[j];
+		t = dot(normal, o) / b;
+		if (t <= RADIOSITY_EPSILON || t >= 1.0 - RADIOSITY_EPSILON) continue;
+		for (j = 0; j < 3; j++) p[j] = from[j] + t * d[j] - quad.corner[j];
+		nn = dot(normal, normal);
+		cross(quad.edge2, normal, axis);
+		s = dot(p, axis) / nn;
+		if (s < 0.0 || s > 1.0) continue;
+		cross(normal, quad.edge1, axis);
+		s = dot(p, axis) / nn;
+		if (s < 0.0 || s > 1.0) continue;
+		return false;
+	}
+	return true;
+}
+
+// Cast the form factors from the vertices first to last - 1 to the patch, that of a disk
+// of the patch's area facing the vertex if its centroid is visible from the vertex.
+void RadiositySolver::castRow(int patch, float *formFactors, int first, int last)
+{
+	const RadiosityPatch &shooter = patches[patch];
+	float d[3], distanceSquared, distance, cosShooter, cosReceiver, formFactor;
+	int i, j;
+
+	for (i = first; i < last; i++)
+	{
+		const RadiosityVertex &receiver = vertices[i];
+
+		formFactors[i] = 0.0;
+		for (j = 0; j < 3; j++) d[j] = receiver.coords[j] - shooter.center[j];
+		distanceSquared = dot(d, d);
+		if (distanceSquared == 0.0) continue;
+		distance = sqrt(distanceSquared);
+		cosShooter = dot(shooter.normal, d) / distance;
+		cosReceiver = -dot(receiver.normal, d) / distance;
+		if (cosShooter <= 0.0 || cosReceiver <= 0.0) continue;
+		formFactor = shooter.area * cosShooter * cosReceiver / (PI * distanceSquared + shooter.area);
+		if (isVisible(shooter.center, receiver.coords)) formFactors[i] = formFactor;
+	}
+}
+
+// Add a row to the cache, dropping the least recently used rows till it fits.
+void RadiositySolver::cacheRow(int patch, std::vector<float> &formFactors)
+{
+	size_t bytes = formFactors.size() * sizeof(float);
+
+	if (bytes > maxCachedBytes) return;
+	while (cachedBytes + bytes > maxCachedBytes)
+	{
+		int dropped = uses.back();
+		cachedBytes -= cache[dropped].formFactors.size() * sizeof(float);
+		cache.erase(dropped);
+		uses.pop_back();
+	}
+
+	CachedRow &row = cache[patch];
+	row.formFactors.swap(formFactors);
+	uses.push_front(patch);
+	row.use = uses.begin();
+	cachedBytes += bytes;
+}
+
+// Routine to add the radiosity the vertices received in the last shot to the light the
+// patches have to shoot, each receiving the average of its corners.
+void RadiositySolver::addToPatches(JobSystem &jobs)
+{
+	int numPatches = patches.size();
+
+	jobs.parallelFor((numPatches + RADIOSITY_CHUNK - 1) / RADIOSITY_CHUNK, [&](int chunk)
+	{
+		int last = std::min(numPatches, (chunk + 1) * RADIOSITY_CHUNK), i, j, k;
+
+		for (i = chunk * RADIOSITY_CHUNK; i < last; i++)
+			for (k = 0; k < 4; k++)
+				for (j = 0; j < 3; j++) patches[i].unshot[j] += 0.25 * delta[3 * patches[i].v[k] + j];
+	});
+}
+
+// Shoot the light to the vertices, directly lighting them as OpenGL would a diffuse surface
+// bar the shadows, and set the light the patches have to shoot.
+void RadiositySolver::start(JobSystem &jobs)
+{
+	int numVertices = vertices.size();
+
+	delta.assign(3 * numVertices, 0.0);
+	for (RadiosityPatch &patch : patches) patch.unshot[0] = patch.unshot[1] = patch.unshot[2] = 0.0;
+	numShots = 0;
+
+	jobs.parallelFor((numVertices + RADIOSITY_CHUNK - 1) / RADIOSITY_CHUNK, [&](int chunk)
+	{
+		int last = std::min(numVertices, (chunk + 1) * RADIOSITY_CHUNK), i, j;
+		float d[3], cosReceiver;
+
+		for (i = chunk * RADIOSITY_CHUNK; i < last; i++)
+		{
+			RadiosityVertex &receiver = vertices[i];
+
+			for (j = 0; j < 3; j++) d[j] = lightPos[j] - receiver.coords[j];
+			cosReceiver = dot(receiver.normal, d) / sqrt(dot(d, d));
+			if (cosReceiver <= 0.0 || !isVisible(lightPos, receiver.coords)) cosReceiver = 0.0;
+			for (j = 0; j < 3; j++)
+			{
+				delta[3 * i + j] = receiver.reflectance[j] * lightColor[j] * cosReceiver;
+				receiver.radiosity[j] = delta[3 * i + j];
+			}
+		}
+	});
+	addToPatches(jobs);
+
+	startUnshot = 0.0;
+	startUnshot = getUnshotFraction(); // The total, startUnshot being zero.
+}
+
+// Shoot up to batchSize patches with the most unshot light: cast or look up the form
+// factors of each, gather the light they shoot at the vertices and add it to the patches.
+int RadiositySolver::shoot(JobSystem &jobs, int batchSize)
+{
+	int numVertices = vertices.size(), numChunks = (numVertices + RADIOSITY_CHUNK - 1) / RADIOSITY_CHUNK,
+		numBatch, i, j;
+	std::vector<std::vector<float> > cast;
+	std::vector<int> misses;
+	std::vector<float> shot;
+
+	// The patches with the most unshot light first, ties broken by index.
+	order.clear();
+	for (i = 0; i < (int)patches.size(); i++)
+		if (patches[i].unshot[0] + patches[i].unshot[1] + patches[i].unshot[2] > 0.0) order.push_back(i);
+	numBatch = std::min(batchSize, (int)order.size());
+	if (numBatch == 0) return 0;
+	std::partial_sort(order.begin(), order.begin() + numBatch, order.end(), [&](int a, int b)
+	{
+		const RadiosityPatch &p = patches[a], &q = patches[b];
+		float powerA = (p.unshot[0] + p.unshot[1] + p.unshot[2]) * p.area,
+			powerB = (q.unshot[0] + q.unshot[1] + q.unshot[2]) * q.area;
+		return powerA > powerB || (powerA == powerB && a < b);
+	});
+
+	// Look up the rows of the batch, the most recently used moving to the front.
+	batch.assign(order.begin(), order.begin() + numBatch);
+	rows.assign(numBatch, NULL);
+	cast.resize(numBatch);
+	for (i = 0; i < numBatch; i++)
+	{
+		std::unordered_map<int, CachedRow>::iterator found = cache.find(batch[i]);
+		if (found != cache.end())
+		{
+			uses.splice(uses.begin(), uses, found->second.use);
+			rows[i] = &found->second.formFactors;
+			cacheHits++;
+		}
+		else
+		{
+			cast[i].resize(numVertices);
+			rows[i] = &cast[i];
+			misses.push_back(i);
+			cacheMisses++;
+		}
+	}
+
+	// Cast the missing rows, each a chunk of vertices at a time.
+	jobs.parallelFor(misses.size() * numChunks, [&](int job)
+	{
+		int row = misses[job / numChunks], chunk = job % numChunks;
+		castRow(batch[row], &cast[row][0], chunk * RADIOSITY_CHUNK,
+			    std::min(numVertices, (chunk + 1) * RADIOSITY_CHUNK));
+	});
+
+	// Take the light the batch shoots.
+	shot.resize(3 * numBatch);
+	for (i = 0; i < numBatch; i++)
+		for (j = 0; j < 3; j++)
+		{
+			shot[3 * i + j] = patches[batch[i]].unshot[j];
+			patches[batch[i]].unshot[j] = 0.0;
+		}
+
+	// Gather it at the vertices, each summing over the batch in order.
+	jobs.parallelFor(numChunks, [&](int chunk)
+	{
+		int last = std::min(numVertices, (chunk + 1) * RADIOSITY_CHUNK), v, k, c;
+		float received[3];
+
+		for (v = chunk * RADIOSITY_CHUNK; v < last; v++)
+		{
+			received[0] = received[1] = received[2] = 0.0;
+			for (k = 0; k < numBatch; k++)
+			{
+				float formFactor = (*rows[k])[v];
+				if (formFactor == 0.0) continue;
+				for (c = 0; c < 3; c++) received[c] += shot[3 * k + c] * formFactor;
+			}
+			for (c = 0; c < 3; c++)
+			{
+				delta[3 * v + c] = vertices[v].reflectance[c] * received[c];
+				vertices[v].radiosity[c] += delta[3 * v + c];
+			}
+		}
+	});
+	addToPatches(jobs);
+
+	for (int miss : misses) cacheRow(batch[miss], cast[miss]);
+	numShots += numBatch;
+	return numBatch;
+}
+
+// Light left unshot, each patch's radiosity times its area summed over the colors, as a
+// fraction of that after the light is shot.
+float RadiositySolver::getUnshotFraction()
+{
+	double unshot = 0.0;
+
+	for (const RadiosityPatch &patch : patches)
+		unshot += (patch.unshot[0] + patch.unshot[1] + patch.unshot[2]) * patch.area;
+	return startUnshot > 0.0 ? unshot / startUnshot : unshot;
+}
+
+// Write the RGB colors of the vertices to colors. The ambient estimate, as in Cohen, Chen,
+// Wallace and Greenberg's progressive refinement, is the area-weighted average unshot
+// radiosity reflected again and again by the area-weighted average reflectance.
+void RadiositySolver::getColors(std::vector<float> &colors, bool ambient)
+{
+	double totalArea = 0.0, unshot[3] = { 0.0, 0.0, 0.0 }, reflectance[3] = { 0.0, 0.0, 0.0 };
+	float ambientLight[3] = { 0.0, 0.0, 0.0 };
+	int i, j, k;
+
+	if (ambient && !patches.empty())
+	{
+		for (const RadiosityPatch &patch : patches)
+		{
+			totalArea += patch.area;
+			for (j = 0; j < 3; j++)
+			{
+				unshot[j] += patch.unshot[j] * patch.area;
+				for (k = 0; k < 4; k++) reflectance[j] += 0.25 * vertices[patch.v[k]].reflectance[j] * patch.area;
+			}
+		}
+		for (j = 0; j < 3; j++) ambientLight[j] = unshot[j] / (totalArea - reflectance[j]);
+	}
+
+	colors.resize(3 * vertices.size());
+	for (i = 0; i < (int)vertices.size(); i++)
+		for (j = 0; j < 3; j++)
+			colors[3 * i + j] = vertices[i].radiosity[j] + vertices[i].reflectance[j] * ambientLight[j];
+}
+
+// Bytes held by the mesh, the occluders, the cached rows and the scratch arrays.
+size_t RadiositySolver::getMemoryBytes()
+{
+	return vertices.capacity() * sizeof(RadiosityVertex) + patches.capacity() * sizeof(RadiosityPatch) +
+		spheres.capacity() * sizeof(RadiositySphere) + quads.capacity() * sizeof(RadiosityQuad) +
+		delta.capacity() * sizeof(float) + order.capacity() * sizeof(int) + cachedBytes +
+		cache.size() * (sizeof(CachedRow) + 2 * sizeof(int) + 4 * sizeof(void *));
+}
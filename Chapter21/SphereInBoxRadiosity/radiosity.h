@@ -0,0 +1,121 @@
+#ifndef RADIOSITY_H
+#define RADIOSITY_H
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "jobSystem.h"
+
+#define RADIOSITY_CHUNK 256 // Vertices or patches a job of a parallel loop takes on.
+#define RADIOSITY_EPSILON 1.0e-4 // Fraction of a ray at either end where hits are ignored.
+
+// A vertex of the mesh, receiving light.
+struct RadiosityVertex
+{
+	float coords[3]; // Position.
+	float normal[3]; // Unit normal.
+	float reflectance[3]; // Diffuse reflectance.
+	float radiosity[3]; // Light leaving it so far.
+};
+
+// A patch of the mesh, a quadrilateral of four vertices, two the same for a triangle,
+// counter-clockwise seen from its front, shooting the light it receives.
+struct RadiosityPatch
+{
+	int v[4]; // Corners.
+	float center[3]; // Centroid.
+	float normal[3]; // Unit normal.
+	float area; // Area.
+	float unshot[3]; // Radiosity received but not yet shot.
+};
+
+// A sphere blocking light.
+struct RadiositySphere
+{
+	float center[3], radius;
+};
+
+// A parallelogram blocking light, the points corner + s * edge1 + t * edge2 with
+// s and t in [0, 1].
+struct RadiosityQuad
+{
+	float corner[3], edge1[3], edge2[3];
+};
+
+// Radiosity solver class: progressive refinement radiosity of a mesh of diffuse patches
+// lit by one point light that, as OpenGL's, does not fall off with distance.
+//
+// The light is first shot to every vertex, then the patches in turn shoot the light they
+// have received but not yet shot, the ones with the most of it first, so that the solution,
+// viewable after every shot, converges to the full one as the light left unshot dies away.
+// A patch's light is shot to the vertices, as in Wallace, Elmquist and Haines' ray-traced
+// progressive radiosity, with the form factor from each vertex to the patch that of a disk
+// of the patch's area, and the visibility of the patch by a ray cast between its centroid
+// and the vertex against a set of occluders, spheres and parallelograms standing in for
+// the mesh. What each patch receives is the average of its corners.
+//
+// Patches are shot in batches. The form factors of a batch, a row of one per vertex for
+// each patch, are cast in parallel, a chunk of a row to a job, and the light is then
+// gathered at the vertices in parallel, each vertex summing over the batch in order, so that the
+// solution is the same whatever the number of threads. Rows are kept in a cache, bounded
+// in bytes, that drops the least recently used row when full, as a patch shoots again
+// each time it has received enough light since its last shot.
+class RadiositySolver
+{
+public:
+	RadiositySolver(size_t cacheBytes); // Constructor, with the most bytes of rows cached.
+	int addVertex(const float coords[3], const float normal[3], const float reflectance[3]);
+	void addPatch(int v0, int v1, int v2, int v3);
+	void addSphere(const float center[3], float radius);
+	void addQuad(const float corner[3], const float edge1[3], const float edge2[3]);
+	void setLight(const float position[3], const float color[3]);
+	void start(JobSystem &jobs); // Shoot the light, once the mesh and occluders are added.
+	int shoot(JobSystem &jobs, int batchSize); // Shoot the patches with the most unshot light,
+	                                           // returning how many shot any.
+	float getUnshotFraction(); // Light left unshot, as a fraction of that the light first shot.
+	void getColors(std::vector<float> &colors, bool ambient); // RGB colors of the vertices, with an
+	                                                           // ambient estimate of the unshot light if
+	                                                           // ambient.
+	const std::vector<RadiosityVertex> &getVertices() { return vertices; }
+	const std::vector<RadiosityPatch> &getPatches() { return patches; }
+	long long getNumShots() { return numShots; }
+	long long getCacheHits() { return cacheHits; }
+	long long getCacheMisses() { return cacheMisses; }
+	size_t getCacheBytes() { return cachedBytes; }
+	size_t getMemoryBytes(); // Bytes held by the mesh, the cache and scratch arrays.
+
+private:
+	// A cached row and its place in the order of use.
+	struct CachedRow
+	{
+		std::vector<float> formFactors;
+		std::list<int>::iterator use;
+	};
+
+	bool isVisible(const float from[3], const float to[3]);
+	void castRow(int patch, float *formFactors, int first, int last);
+	void cacheRow(int patch, std::vector<float> &formFactors);
+	void addToPatches(JobSystem &jobs);
+
+	std::vector<RadiosityVertex> vertices;
+	std::vector<RadiosityPatch> patches;
+	std::vector<RadiositySphere> spheres;
+	std::vector<RadiosityQuad> quads;
+	float lightPos[3], lightColor[3];
+
+	std::vector<float> delta; // Radiosity each vertex received in the last shot.
+	std::vector<int> order; // Patches, most unshot light first.
+	std::vector<int> batch; // Patches of the current batch.
+	std::vector<const std::vector<float> *> rows; // Their form factors.
+	float startUnshot; // Light unshot after the light is shot.
+	long long numShots;
+
+	std::unordered_map<int, CachedRow> cache; // Cached rows by patch.
+	std::list<int> uses; // Cached patches, most recently used first.
+	size_t maxCachedBytes, cachedBytes;
+	long long cacheHits, cacheMisses;
+};
+
+#endif
@@ -0,0 +1,327 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// sphereInBoxRadiosity.cpp
+//
+// This command-line program solves the scene of sphereInBox1.cpp by progressive
+// refinement radiosity, to show the light the box and sphere reflect onto one another,
+// as sphereInBoxPovWithRadiosity.jpg does. Each side of the box, its lid opened by a
+// number of steps as in sphereInBox1.cpp, is meshed as a grid, both inside and outside,
+// and the sphere as the sphere of fillSphVertexArray() in Chapter 15, lit by the light
+// of sphereInBox1.cpp with the diffuse colors of its materials. It reports, once a second
+// and at the end, the light left unshot, how fast it is falling, the patches shot a
+// second, the hits of the form-factor cache and the memory used, then bakes the colors
+// of the vertices into a file that sphereInBox1.cpp draws.
+//
+// Usage:
+// SphereInBoxRadiosity [-step n] [-walls n] [-sphere n] [-batch n] [-cache n]
+//                      [-converge n] [-time n] [-threads n] [-out file] [-check]
+// -step n     Steps, of a degree, the lid is open, 0 to 180, 0 by default.
+// -walls n    Rows and columns of patches of a side of the box, 16 by default.
+// -sphere n   Slices and stacks of the sphere, 40 by default.
+// -batch n    Patches shot together, 8 by default.
+// -cache n    Most megabytes of form factors cached, 16 by default.
+// -converge n Percentage of the light left unshot at which to stop, 1 by default.
+// -time n     Most seconds to shoot for, 60 by default.
+// -threads n  Number of threads, by default the number of hardware threads.
+// -out file   Output file, sphereInBoxRadiosity.txt by default.
+// -check      Solve again on a single thread, shooting as many patches, and compare
+//             the colors.
+//
+// The output file has a line "step n" giving the lid's steps, then "vertices n" followed
+// by a line "x y z r g b" for each vertex, then "triangles n" followed by a line "i j k"
+// of vertex indices for each triangle, counter-clockwise seen from its front.
+//
+// Sumanta Guha
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "radiosity.h"
+
+#define PI 3.14159265358979324
+
+// Globals.
+static int step = 0; // Steps in open/closing the box lid.
+static int wallSteps = 16; // Rows and columns of patches of a side.
+static int sphereSteps = 40; // Slices and stacks of the sphere.
+static int batchSize = 8; // Patches shot together.
+static int cacheMegabytes = 16; // Most megabytes of form factors cached.
+static float convergence = 1.0; // Percentage of light left unshot at which to stop.
+static float maxSeconds = 60.0; // Most seconds to shoot for.
+static int numThreads = 0; // Number of threads.
+static std::string outFileName = "sphereInBoxRadiosity.txt"; // Output file.
+
+// Sides of the box as a corner and two edges, their cross product pointing out of the
+// box: front, back, right, left, bottom and the lid.
+static float sides[6][9] =
+{
+	{ -1.0, -1.0, 1.0,  2.0, 0.0, 0.0,  0.0, 2.0, 0.0 },
+	{ 1.0, -1.0, -1.0,  -2.0, 0.0, 0.0,  0.0, 2.0, 0.0 },
+	{ 1.0, -1.0, 1.0,  0.0, 0.0, -2.0,  0.0, 2.0, 0.0 },
+	{ -1.0, -1.0, -1.0,  0.0, 0.0, 2.0,  0.0, 2.0, 0.0 },
+	{ -1.0, -1.0, -1.0,  2.0, 0.0, 0.0,  0.0, 0.0, 2.0 },
+	{ -1.0, 1.0, 1.0,  2.0, 0.0, 0.0,  0.0, 0.0, -2.0 }
+};
+
+// Diffuse colors of the materials of sphereInBox1.cpp.
+static float boxColor[] = { 0.9, 0.0, 0.0 };
+static float sphereColor[] = { 0.0, 0.9, 0.0 };
+
+// Camera and light, the light being in eye coordinates as glLightfv() sets it with the
+// modelview matrix the identity.
+static float eye[] = { 0.0, 3.0, 3.0 }, center[] = { 0.0, 0.0, 0.0 }, up[] = { 0.0, 1.0, 0.0 };
+static float lightEyePos[] = { 0.0, 1.5, 3.0 };
+static float lightColor[] = { 1.0, 1.0, 1.0 };
+
+// Routine to convert a point in eye coordinates to world coordinates.
+void eyeToWorld(const float *eyeCoords, float *worldCoords)
+{
+	float forward[3], right[3], top[3], length;
+	int j;
+
+	for (j = 0; j < 3; j++) forward[j] = center[j] - eye[j];
+	length = sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+	for (j = 0; j < 3; j++) forward[j] /= length;
+	right[0] = forward[1] * up[2] - forward[2] * up[1];
+	right[1] = forward[2] * up[0] - forward[0] * up[2];
+	right[2] = forward[0] * up[1] - forward[1] * up[0];
+	length = sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+	for (j = 0; j < 3; j++) right[j] /= length;
+	top[0] = right[1] * forward[2] - right[2] * forward[1];
+	top[1] = right[2] * forward[0] - right[0] * forward[2];
+	top[2] = right[0] * forward[1] - right[1] * forward[0];
+
+	// The eye looks down its -z axis.
+	for (j = 0; j < 3; j++)
+		worldCoords[j] = eye[j] + eyeCoords[0] * right[j] + eyeCoords[1] * top[j] - eyeCoords[2] * forward[j];
+}
+
+// Routine to add a side of the box, given by its corner and edges, as a grid of patches
+// outside and another inside, and as an occluder. The lid is rotated by step degrees about
+// its hinge, the edge y = 1, z = -1, as glRotatef(step, -1.0, 0.0, 0.0) would.
+void addSide(RadiositySolver &solver, const float *side, bool isLid)
+{
+	float angle = -step * PI / 180.0, c = cos(angle), s = sin(angle), y, z;
+	float corner[3], edge1[3], edge2[3], normal[3], inward[3], coords[3], length;
+	int i, j, k, face, first[2];
+
+	std::copy(side, side + 3, corner);
+	std::copy(side + 3, side + 6, edge1);
+	std::copy(side + 6, side + 9, edge2);
+	if (isLid)
+	{
+		y = corner[1] - 1.0; z = corner[2] + 1.0;
+		corner[1] = y * c - z * s + 1.0;
+		corner[2] = y * s + z * c - 1.0;
+		y = edge1[1]; z = edge1[2];
+		edge1[1] = y * c - z * s; edge1[2] = y * s + z * c;
+		y = edge2[1]; z = edge2[2];
+		edge2[1] = y * c - z * s; edge2[2] = y * s + z * c;
+	}
+	normal[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+	normal[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+	normal[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+	length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	for (k = 0; k < 3; k++)
+	{
+		normal[k] /= length;
+		inward[k] = -normal[k];
+	}
+
+	// A grid of vertices for each face, outside then inside.
+	for (face = 0; face < 2; face++)
+	{
+		first[face] = solver.getVertices().size();
+		for (j = 0; j <= wallSteps; j++)
+			for (i = 0; i <= wallSteps; i++)
+			{
+				for (k = 0; k < 3; k++)
+					coords[k] = corner[k] + edge1[k] * i / wallSteps + edge2[k] * j / wallSteps;
+				solver.addVertex(coords, face == 0 ? normal : inward, boxColor);
+			}
+	}
+
+	// Patches counter-clockwise seen from outside, then from inside.
+	for (j = 0; j < wallSteps; j++)
+		for (i = 0; i < wallSteps; i++)
+		{
+			k = j * (wallSteps + 1) + i;
+			solver.addPatch(first[0] + k, first[0] + k + 1, first[0] + k + wallSteps + 2, first[0] + k + wallSteps + 1);
+			solver.addPatch(first[1] + k, first[1] + k + wallSteps + 1, first[1] + k + wallSteps + 2, first[1] + k + 1);
+		}
+
+	solver.addQuad(corner, edge1, edge2);
+}
+
+// Routine to add the sphere of radius 1 about the origin as fillSphVertexArray() samples
+// it, with sphereSteps longitudinal and latitudinal slices, and as an occluder a little
+// smaller, inside the centroids of its patches.
+void addSphere(RadiositySolver &solver)
+{
+	float coords[3], origin[] = { 0.0, 0.0, 0.0 };
+	int i, j, first = solver.getVertices().size(), k;
+
+	for (j = 0; j <= sphereSteps; j++)
+		for (i = 0; i <= sphereSteps; i++)
+		{
+			coords[0] = cos(-PI / 2 + (float)j / sphereSteps * PI) * cos(2.0 * (float)i / sphereSteps * PI);
+			coords[1] = sin(-PI / 2 + (float)j / sphereSteps * PI);
+			coords[2] = cos(-PI / 2 + (float)j / sphereSteps * PI) * sin(2.0 * (float)i / sphereSteps * PI);
+			solver.addVertex(coords, coords, sphereColor);
+		}
+
+	// Patches counter-clockwise seen from outside, those at the poles triangles.
+	for (j = 0; j < sphereSteps; j++)
+		for (i = 0; i < sphereSteps; i++)
+		{
+			k = first + j * (sphereSteps + 1) + i;
+			solver.addPatch(k, k + sphereSteps + 1, k + sphereSteps + 2, k + 1);
+		}
+
+	// No patch spans more than 2 * PI / sphereSteps about its centroid.
+	solver.addSphere(origin, cos(2.0 * PI / sphereSteps));
+}
+
+// Routine to fill the solver with the scene.
+void fillScene(RadiositySolver &solver)
+{
+	float lightPos[3];
+	int i;
+
+	for (i = 0; i < 6; i++) addSide(solver, sides[i], i == 5);
+	addSphere(solver);
+	eyeToWorld(lightEyePos, lightPos);
+	solver.setLight(lightPos, lightColor);
+}
+
+// Routine to solve the scene on a number of threads, shooting till the light left unshot
+// falls to the convergence percentage, maxSeconds pass or, if maxShots is positive,
+// maxShots patches are shot, reporting the progress once a second if report.
+void solveScene(RadiositySolver &solver, int threads, long long maxShots, bool report)
+{
+	JobSystem jobs(threads - 1);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	float seconds = 0.0, lastSeconds = 0.0, unshot, lastUnshot = 1.0;
+	long long lastShots = 0;
+	bool done = false;
+
+	solver.start(jobs);
+	while (!done)
+	{
+		int shot = solver.shoot(jobs, maxShots > 0 ? (int)std::min((long long)batchSize, maxShots - solver.getNumShots())
+			                                       : batchSize);
+		seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+		unshot = solver.getUnshotFraction();
+		if (maxShots > 0) done = solver.getNumShots() >= maxShots || shot == 0;
+		else done = shot == 0 || 100.0 * unshot <= convergence || seconds >= maxSeconds;
+
+		if (report && (done || seconds - lastSeconds >= 1.0))
+		{
+			long long hits = solver.getCacheHits(), lookups = hits + solver.getCacheMisses();
+			std::cout << seconds << " s: " << solver.getNumShots() << " shots, " << 100.0 * unshot
+				<< "% unshot, falling " << 100.0 * (lastUnshot - unshot) / (seconds - lastSeconds)
+				<< "% a second, " << (solver.getNumShots() - lastShots) / (seconds - lastSeconds)
+				<< " shots a second, cache " << (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "% hits and "
+				<< solver.getCacheBytes() / 1048576.0 << " MB, " << solver.getMemoryBytes() / 1048576.0
+				<< " MB in all" << std::endl;
+			lastSeconds = seconds; lastUnshot = unshot; lastShots = solver.getNumShots();
+		}
+	}
+}
+
+// Routine to write the vertices, their colors and the triangles of the patches to the
+// output file, returning if it could.
+bool writeScene(RadiositySolver &solver, const std::vector<float> &colors)
+{
+	const std::vector<RadiosityVertex> &vertices = solver.getVertices();
+	const std::vector<RadiosityPatch> &patches = solver.getPatches();
+	std::vector<int> triangles;
+	int i, k, corner[] = { 0, 1, 2, 0, 2, 3 };
+
+	std::ofstream file(outFileName.c_str());
+	if (!file) return false;
+
+	// Two triangles of a patch, or one if it is a triangle.
+	for (const RadiosityPatch &patch : patches)
+		for (k = 0; k < 6; k += 3)
+		{
+			int a = patch.v[corner[k]], b = patch.v[corner[k + 1]], c = patch.v[corner[k + 2]];
+			if (a == b || b == c || c == a) continue;
+			triangles.push_back(a); triangles.push_back(b); triangles.push_back(c);
+		}
+
+	file << "step " << step << std::endl << "vertices " << vertices.size() << std::endl;
+	for (i = 0; i < (int)vertices.size(); i++)
+		file << vertices[i].coords[0] << " " << vertices[i].coords[1] << " " << vertices[i].coords[2] << " "
+			<< colors[3 * i] << " " << colors[3 * i + 1] << " " << colors[3 * i + 2] << std::endl;
+	file << "triangles " << triangles.size() / 3 << std::endl;
+	for (i = 0; i < (int)triangles.size(); i += 3)
+		file << triangles[i] << " " << triangles[i + 1] << " " << triangles[i + 2] << std::endl;
+	return (bool)file;
+}
+
+// Main routine.
+int main(int argc, char **argv)
+{
+	std::vector<float> colors, singleColors;
+	bool check = false;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-step" && i + 1 < argc) step = std::min(std::max(atoi(argv[++i]), 0), 180);
+		else if (arg == "-walls" && i + 1 < argc) wallSteps = std::max(atoi(argv[++i]), 1);
+		else if (arg == "-sphere" && i + 1 < argc) sphereSteps = std::max(atoi(argv[++i]), 8);
+		else if (arg == "-batch" && i + 1 < argc) batchSize = std::max(atoi(argv[++i]), 1);
+		else if (arg == "-cache" && i + 1 < argc) cacheMegabytes = std::max(atoi(argv[++i]), 0);
+		else if (arg == "-converge" && i + 1 < argc) convergence = atof(argv[++i]);
+		else if (arg == "-time" && i + 1 < argc) maxSeconds = atof(argv[++i]);
+		else if (arg == "-threads" && i + 1 < argc) numThreads = atoi(argv[++i]);
+		else if (arg == "-out" && i + 1 < argc) outFileName = argv[++i];
+		else if (arg == "-check") check = true;
+		else
+		{
+			std::cout << "Usage: SphereInBoxRadiosity [-step n] [-walls n] [-sphere n] [-batch n] [-cache n]"
+				<< " [-converge n] [-time n] [-threads n] [-out file] [-check]" << std::endl;
+			return 1;
+		}
+	}
+	if (numThreads <= 0) numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	RadiositySolver solver((size_t)cacheMegabytes << 20);
+	fillScene(solver);
+	std::cout << solver.getVertices().size() << " vertices, " << solver.getPatches().size() << " patches, "
+		<< batchSize << " shot at a time, " << cacheMegabytes << " MB cache, " << numThreads << " threads"
+		<< std::endl;
+
+	solveScene(solver, numThreads, 0, true);
+	solver.getColors(colors, true);
+
+	if (!writeScene(solver, colors))
+	{
+		std::cout << "Could not write " << outFileName << "." << std::endl;
+		return 1;
+	}
+	std::cout << "Colors written to " << outFileName << "." << std::endl;
+
+	if (check)
+	{
+		RadiositySolver singleSolver((size_t)cacheMegabytes << 20);
+		fillScene(singleSolver);
+		solveScene(singleSolver, 1, solver.getNumShots(), false);
+		singleSolver.getColors(singleColors, true);
+		bool same = singleColors == colors;
+		std::cout << "Single-threaded colors " << (same ? "the same." : "DIFFERENT.") << std::endl;
+		if (!same) return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,60 @@
+// Routine to write a 32-bit color RGBA image file, bottom row first as getBMP() returns
+// it, to an uncompressed 24-bit unindexed color RGB BMP file (alpha values being dropped)
+// that getBMP() reads back.
+
+#include <fstream>
+#include <vector>
+
+#include "putBMP.h"
+
+// Routine to write a little-endian integer of the given number of bytes.
+static void putInt(std::ofstream &outFile, unsigned int value, int numBytes)
+{
+	for (int i = 0; i < numBytes; i++) outFile.put((char)((value >> (8 * i)) & 0xFF));
+}
+
+bool putBMP(std::string fileName, const imageFile *image)
+{
+	int w = image->width, h = image->height;
+
+	// Each pixel row of a BMP file is 4-byte aligned by padding with zero bytes.
+	int padding = (3 * w) % 4 ? 4 - (3 * w) % 4 : 0;
+	int imageSize = (3 * w + padding) * h;
+
+	std::ofstream outFile(fileName.c_str(), std::ios::binary);
+	if (!outFile) return false;
+
+	// File header: signature, file size, reserved, offset of image data.
+	outFile.put('B'); outFile.put('M');
+	putInt(outFile, 54 + imageSize, 4);
+	putInt(outFile, 0, 4);
+	putInt(outFile, 54, 4);
+
+	// Info header: its size, width, height, planes, bits per pixel, no compression, 
+	// image size, resolution of 72 dpi, no palette.
+	putInt(outFile, 40, 4);
+	putInt(outFile, w, 4);
+	putInt(outFile, h, 4);
+	putInt(outFile, 1, 2);
+	putInt(outFile, 24, 2);
+	putInt(outFile, 0, 4);
+	putInt(outFile, imageSize, 4);
+	putInt(outFile, 2835, 4);
+	putInt(outFile, 2835, 4);
+	putInt(outFile, 0, 4);
+	putInt(outFile, 0, 4);
+
+	// Pixel rows, performing RGB to BGR conversion.
+	std::vector<char> row(3 * w + padding, 0);
+	for (int j = 0; j < h; j++)
+	{
+		for (int i = 0; i < w; i++)
+		{
+			row[3 * i] = image->data[4 * (w * j + i) + 2];
+			row[3 * i + 1] = image->data[4 * (w * j + i) + 1];
+			row[3 * i + 2] = image->data[4 * (w * j + i)];
+		}
+		outFile.write(&row[0], row.size());
+	}
+	return !outFile.fail();
+}
@@ -0,0 +1,10 @@
+#ifndef PUTBMP_H
+#define PUTBMP_H
+
+#include <string>
+
+#include "getBMP.h"
+
+bool putBMP(std::string fileName, const imageFile *image);
+
+#endif
@@ -0,0 +1,561 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// rayTracer.cpp
+//
+// A Whitted ray tracer of triangle meshes, tracing packets of rays through a BVH.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "rayTracer.h"
+
+#define PI 3.14159265358979324
+
+// Vector routines on float[3].
+static inline float dot3(const float *a, const float *b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+static inline void cross3(const float *a, const float *b, float *c)
+{
+	c[0] = a[1] * b[2] - a[2] * b[1];
+	c[1] = a[2] * b[0] - a[0] * b[2];
+	c[2] = a[0] * b[1] - a[1] * b[0];
+}
+static inline void normalize3(float *a)
+{
+	float length = sqrt(dot3(a, a));
+	if (length > 0.0) { a[0] /= length; a[1] /= length; a[2] /= length; }
+}
+
+// Routine to return the number of rays of a mask's bits.
+static inline int countBits(int bits)
+{
+	return (bits & 1) + (bits >> 1 & 1) + (bits >> 2 & 1) + (bits >> 3 & 1);
+}
+
+// Routine to return the surface area of a box.
+static inline float area(const float *lower, const float *upper)
+{
+	float x = upper[0] - lower[0], y = upper[1] - lower[1], z = upper[2] - lower[2];
+	return 2.0f * (x * y + y * z + z * x);
+}
+
+// Routine to make every ray of a packet inactive, with harmless values.
+static void clearPacket(RayPacket &packet)
+{
+	packet.ox = packet.oy = packet.oz = Float4(0.0f);
+	packet.dx = packet.dy = packet.dz = Float4(1.0f);
+	packet.idx = packet.idy = packet.idz = Float4(1.0f);
+	packet.tMax = packet.u = packet.v = Float4(0.0f);
+	packet.active = Float4(0.0f);
+	packet.triangle[0] = packet.triangle[1] = packet.triangle[2] = packet.triangle[3] = -1;
+}
+
+// Routine to set ray k of a packet and make it active.
+static void setRay(RayPacket &packet, int k, const float *origin, const float *direction, float tMax)
+{
+	packet.ox[k] = origin[0]; packet.oy[k] = origin[1]; packet.oz[k] = origin[2];
+	packet.dx[k] = direction[0]; packet.dy[k] = direction[1]; packet.dz[k] = direction[2];
+
+	// Directions parallel to a slab get a huge, not infinite, inverse, which keeps the
+	// slab test free of 0 * infinity.
+	packet.idx[k] = 1.0f / (direction[0] != 0.0 ? direction[0] : 1.0e-20f);
+	packet.idy[k] = 1.0f / (direction[1] != 0.0 ? direction[1] : 1.0e-20f);
+	packet.idz[k] = 1.0f / (direction[2] != 0.0 ? direction[2] : 1.0e-20f);
+	packet.tMax[k] = tMax;
+	packet.active.u[k] = 0xFFFFFFFF;
+	packet.triangle[k] = -1;
+}
+
+// RayTracer constructor.
+RayTracer::RayTracer()
+{
+	float origin[] = { 0.0, 0.0, 0.0 }, center[] = { 0.0, 0.0, -1.0 }, yAxis[] = { 0.0, 1.0, 0.0 };
+
+	numLeaves = 0;
+	maxDepth = 0;
+	setCamera(origin, center, yAxis, 60.0);
+	setLight(origin, 0.2);
+	setBackground(1.0, 1.0, 1.0);
+}
+
+// Add a material, returning its index.
+int RayTracer::addMaterial(const RayMaterial &material)
+{
+	materials.push_back(material);
+	return materials.size() - 1;
+}
+
+// Add a triangle.
+void RayTracer::addTriangle(const RayTriangle &triangle)
+{
+	triangles.push_back(triangle);
+}
+
+// Set the camera as gluLookAt() and gluPerspective() would, the aspect ratio being the image's.
+void RayTracer::setCamera(const float eye[3], const float center[3], const float up[3], float fovy)
+{
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		this->eye[i] = eye[i];
+		forward[i] = center[i] - eye[i];
+	}
+	normalize3(forward);
+	cross3(forward, up, right);
+	normalize3(right);
+	cross3(right, forward, this->up);
+	tanHalfFovy = tan(fovy * PI / 360.0);
+}
+
+// Set the light's position and the global ambient light, a gray.
+void RayTracer::setLight(const float position[3], float ambient)
+{
+	for (int i = 0; i < 3; i++) lightPos[i] = position[i];
+	this->ambient = ambient;
+}
+
+// Set the color of rays that hit nothing.
+void RayTracer::setBackground(float r, float g, float b)
+{
+	background[0] = r; background[1] = g; background[2] = b;
+}
+
+// Build the BVH, ordering the triangles as its leaves.
+void RayTracer::buildBvh()
+{
+	int n = triangles.size(), i, j, k;
+	std::vector<int> order(n);
+	std::vector<float> centroids(3 * n), bounds(6 * n);
+	std::vector<RayTriangle> ordered(n);
+
+	// Each triangle's bounding box and its center.
+	for (i = 0; i < n; i++)
+	{
+		order[i] = i;
+		for (j = 0; j < 3; j++)
+		{
+			bounds[6 * i + j] = bounds[6 * i + 3 + j] = triangles[i].v[0][j];
+			for (k = 1; k < 3; k++)
+			{
+				bounds[6 * i + j] = std::min(bounds[6 * i + j], triangles[i].v[k][j]);
+				bounds[6 * i + 3 + j] = std::max(bounds[6 * i + 3 + j], triangles[i].v[k][j]);
+			}
+			centroids[3 * i + j] = 0.5f * (bounds[6 * i + j] + bounds[6 * i + 3 + j]);
+		}
+	}
+
+	// A binary tree of leaves with at least one triangle has fewer than 2n nodes, so
+	// reserving them keeps the nodes in place while the tree is built.
+	nodes.clear();
+	nodes.reserve(std::max(1, 2 * n - 1));
+	nodes.push_back(RayBvhNode());
+	numLeaves = 0;
+	buildNode(0, 0, n, 0, order, centroids, bounds);
+
+	// Put the triangles in the order of the leaves.
+	for (i = 0; i < n; i++) ordered[i] = triangles[order[i]];
+	triangles.swap(ordered);
+	bvhTriangles.resize(n);
+	for (i = 0; i < n; i++)
+		for (j = 0; j < 3; j++)
+		{
+			bvhTriangles[i].v0[j] = triangles[i].v[0][j];
+			bvhTriangles[i].v1[j] = triangles[i].v[1][j];
+			bvhTriangles[i].v2[j] = triangles[i].v[2][j];
+		}
+	for (i = 0; i < n; i++)
+	{
+		const float *v = triangles[i].v[0], *v1 = triangles[i].v[1], *v2 = triangles[i].v[2];
+		float e1[3] = { v1[0] - v[0], v1[1] - v[1], v1[2] - v[2] }, e2[3] = { v2[0] - v[0], v2[1] - v[1], v2[2] - v[2] };
+
+		bvhTriangles[i].n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		bvhTriangles[i].n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		bvhTriangles[i].n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+}
+
+// Make a node of the triangles order[first], ..., order[first + count - 1], splitting
+// them between two children where the SAH finds that cheaper than a leaf.
+void RayTracer::buildNode(int node, int first, int count, int depth, std::vector<int> &order,
+	                      const std::vector<float> &centroids, const std::vector<float> &bounds)
+{
+	float lower[3], upper[3], cLower[3], cUpper[3], scale[3];
+	float binLower[RAY_BINS][3], binUpper[RAY_BINS][3], rightArea[RAY_BINS], rightLower[3], rightUpper[3];
+	float leftLower[3], leftUpper[3], cost, bestCost;
+	int binCount[RAY_BINS], rightCount[RAY_BINS], leftCount;
+	int i, j, b, t, axis, bestAxis = -1, bestSplit = 0, middle, left;
+
+	// Bounding box of the triangles and of their centroids.
+	for (j = 0; j < 3; j++)
+	{
+		lower[j] = cLower[j] = FLT_MAX;
+		upper[j] = cUpper[j] = -FLT_MAX;
+	}
+	for (i = first; i < first + count; i++)
+		for (t = order[i], j = 0; j < 3; j++)
+		{
+			lower[j] = std::min(lower[j], bounds[6 * t + j]);
+			upper[j] = std::max(upper[j], bounds[6 * t + 3 + j]);
+			cLower[j] = std::min(cLower[j], centroids[3 * t + j]);
+			cUpper[j] = std::max(cUpper[j], centroids[3 * t + j]);
+		}
+	for (j = 0; j < 3; j++)
+	{
+		nodes[node].lower[j] = count > 0 ? lower[j] : 0.0f;
+		nodes[node].upper[j] = count > 0 ? upper[j] : 0.0f;
+		scale[j] = cUpper[j] > cLower[j] ? RAY_BINS / (cUpper[j] - cLower[j]) : 0.0f;
+	}
+
+	// Bin of a triangle's centroid along an axis.
+	auto binOf = [&](int t, int axis)
+	{
+		return std::min(RAY_BINS - 1, (int)((centroids[3 * t + axis] - cLower[axis]) * scale[axis]));
+	};
+
+	// Costs relative to that of intersecting a triangle, a node costing as much, each
+	// multiplied by the node's surface area: count for a leaf, 1 plus the expected
+	// triangles of the children for a split.
+	bestCost = count * area(lower, upper);
+	for (axis = 0; axis < 3 && depth < RAY_STACK_SIZE - 1; axis++)
+	{
+		if (scale[axis] == 0.0) continue;
+		for (b = 0; b < RAY_BINS; b++)
+		{
+			binCount[b] = 0;
+			for (j = 0; j < 3; j++)
+			{
+				binLower[b][j] = FLT_MAX;
+				binUpper[b][j] = -FLT_MAX;
+			}
+		}
+		for (i = first; i < first + count; i++)
+		{
+			t = order[i];
+			b = binOf(t, axis);
+			binCount[b]++;
+			for (j = 0; j < 3; j++)
+			{
+				binLower[b][j] = std::min(binLower[b][j], bounds[6 * t + j]);
+				binUpper[b][j] = std::max(binUpper[b][j], bounds[6 * t + 3 + j]);
+			}
+		}
+
+		// Sweep from the right, recording the area and count right of each boundary,
+		// then from the left, costing each split.
+		for (j = 0; j < 3; j++)
+		{
+			rightLower[j] = leftLower[j] = FLT_MAX;
+			rightUpper[j] = leftUpper[j] = -FLT_MAX;
+		}
+		rightCount[RAY_BINS - 1] = 0;
+		for (b = RAY_BINS - 1; b > 0; b--)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				rightLower[j] = std::min(rightLower[j], binLower[b][j]);
+				rightUpper[j] = std::max(rightUpper[j], binUpper[b][j]);
+			}
+			rightCount[b - 1] = rightCount[b] + binCount[b];
+			rightArea[b - 1] = rightCount[b - 1] > 0 ? area(rightLower, rightUpper) : 0.0f;
+		}
+		for (b = 0, leftCount = 0; b < RAY_BINS - 1; b++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				leftLower[j] = std::min(leftLower[j], binLower[b][j]);
+				leftUpper[j] = std::max(leftUpper[j], binUpper[b][j]);
+			}
+			leftCount += binCount[b];
+			if (leftCount == 0 || rightCount[b] == 0) continue;
+			cost = area(lower, upper) + leftCount * area(leftLower, leftUpper) + rightCount[b] * rightArea[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	// A leaf if no split is cheaper, unless it would be too big and can be split.
+	if (bestAxis < 0 && (count <= RAY_MAX_LEAF || depth >= RAY_STACK_SIZE - 1))
+	{
+		nodes[node].first = first;
+		nodes[node].count = count;
+		numLeaves++;
+		return;
+	}
+
+	// Divide the triangles between the children by the best split or, their centroids
+	// all the same, in half.
+	if (bestAxis >= 0)
+		middle = std::partition(order.begin() + first, order.begin() + first + count,
+			                    [&](int t) { return binOf(t, bestAxis) <= bestSplit; }) - order.begin();
+	else
+	{
+		middle = first + count / 2;
+		bestAxis = 0;
+	}
+
+	left = nodes.size();
+	nodes.push_back(RayBvhNode());
+	nodes.push_back(RayBvhNode());
+	nodes[node].first = left;
+	nodes[node].count = -1 - bestAxis;
+	buildNode(left, first, middle - first, depth + 1, order, centroids, bounds);
+	buildNode(left + 1, middle, first + count - middle, depth + 1, order, centroids, bounds);
+}
+
+// Trace the active rays of a packet through the BVH. Unless anyHit, each ray's nearest
+// hit is recorded in the packet; if anyHit, the rays are shadow rays, each traced only
+// till it hits something, and the mask of those that did is returned.
+Float4 RayTracer::traverse(RayPacket &packet, bool anyHit)
+{
+	int stack[RAY_STACK_SIZE], top = 0, node = 0, lane, axis, near, hitBits, i, k;
+	bool negative[3];
+	Float4 zero(0.0f), one(1.0f), blocked(0.0f);
+	Float4 t0, t1, tNear, tFar, ax, ay, az, bx, by, bz, cx, cy, cz, w0, w1, w2, det, inv, u, v, t, hit;
+
+	if (nodes.empty() || !bits(packet.active)) return blocked;
+
+	// Children are visited nearest first along the direction of the first active ray.
+	for (lane = 0; !(bits(packet.active) >> lane & 1); lane++);
+	negative[0] = packet.dx[lane] < 0.0;
+	negative[1] = packet.dy[lane] < 0.0;
+	negative[2] = packet.dz[lane] < 0.0;
+
+	for (;;)
+	{
+		const RayBvhNode &n = nodes[node];
+
+		// Slab test of the node's box against all four rays.
+		t0 = (Float4(n.lower[0]) - packet.ox) * packet.idx;
+		t1 = (Float4(n.upper[0]) - packet.ox) * packet.idx;
+		tNear = min(t0, t1);
+		tFar = max(t0, t1);
+		t0 = (Float4(n.lower[1]) - packet.oy) * packet.idy;
+		t1 = (Float4(n.upper[1]) - packet.oy) * packet.idy;
+		tNear = max(tNear, min(t0, t1));
+		tFar = min(tFar, max(t0, t1));
+		t0 = (Float4(n.lower[2]) - packet.oz) * packet.idz;
+		t1 = (Float4(n.upper[2]) - packet.oz) * packet.idz;
+		tNear = max(max(tNear, min(t0, t1)), zero);
+		tFar = min(min(tFar, max(t0, t1)), packet.tMax);
+
+		if (bits((tNear <= tFar) & packet.active))
+		{
+			if (n.count < 0)
+			{
+				// Visit the nearer child, and the other later.
+				axis = -1 - n.count;
+				near = n.first + (negative[axis] ? 1 : 0);
+				stack[top++] = 2 * n.first + 1 - near;
+				node = near;
+				continue;
+			}
+
+			// Intersection of each triangle with all four rays by the signs of its edge functions,
+			// w0, w1 and w2, the volumes a ray spans with the edges opposite v0, v1 and v2, which
+			// are also the barycentric coordinates of the hit scaled by their sum. An edge shared by
+			// two triangles is taken from the same vertices in the opposite order by each, and its
+			// function rounds to exactly the negated value, so that a ray through the edge is inside
+			// one triangle or the other, or on the edge of both, and never slips between them,
+			// as it can between triangles tested by Moller-Trumbore.
+			for (i = n.first; i < n.first + n.count; i++)
+			{
+				const RayBvhTriangle &tri = bvhTriangles[i];
+
+				ax = Float4(tri.v0[0]) - packet.ox; ay = Float4(tri.v0[1]) - packet.oy; az = Float4(tri.v0[2]) - packet.oz;
+				bx = Float4(tri.v1[0]) - packet.ox; by = Float4(tri.v1[1]) - packet.oy; bz = Float4(tri.v1[2]) - packet.oz;
+				cx = Float4(tri.v2[0]) - packet.ox; cy = Float4(tri.v2[1]) - packet.oy; cz = Float4(tri.v2[2]) - packet.oz;
+				w0 = packet.dx * (by * cz - bz * cy) + packet.dy * (bz * cx - bx * cz) + packet.dz * (bx * cy - by * cx);
+				w1 = packet.dx * (cy * az - cz * ay) + packet.dy * (cz * ax - cx * az) + packet.dz * (cx * ay - cy * ax);
+				w2 = packet.dx * (ay * bz - az * by) + packet.dy * (az * bx - ax * bz) + packet.dz * (ax * by - ay * bx);
+				det = w0 + w1 + w2;
+				inv = one / det;
+				u = w1 * inv;
+				v = w2 * inv;
+				t = (ax * Float4(tri.n[0]) + ay * Float4(tri.n[1]) + az * Float4(tri.n[2])) * inv;
+
+				// Inside if the edge functions have the same sign, either, as the triangles are
+				// two-sided. Parallel rays give a zero det, so t is not a number or infinite, and
+				// fail the comparisons of t.
+				hit = ((w0 >= zero) & (w1 >= zero) & (w2 >= zero)) | ((w0 <= zero) & (w1 <= zero) & (w2 <= zero));
+				hit = packet.active & hit & (t > zero) & (t < packet.tMax);
+				hitBits = bits(hit);
+				if (!hitBits) continue;
+
+				if (anyHit)
+				{
+					blocked = blocked | hit;
+					packet.active = andNot(hit, packet.active);
+					if (!bits(packet.active)) return blocked;
+					continue;
+				}
+				packet.tMax = select(hit, t, packet.tMax);
+				packet.u = select(hit, u, packet.u);
+				packet.v = select(hit, v, packet.v);
+				for (k = 0; k < 4; k++) if (hitBits >> k & 1) packet.triangle[k] = i;
+			}
+		}
+		if (top == 0) break;
+		node = stack[--top];
+	}
+	return blocked;
+}
+
+// Trace a packet of rays, writing the color each active ray sees, lit by the light
+// unless in shadow, plus what it sees reflected, till maxDepth reflections.
+void RayTracer::trace(RayPacket &packet, int depth, float colors[4][3], long long &numRays)
+{
+	RayPacket shadow, reflected;
+	float point[3], normal[4][3], toLight[4][3], direction[3], origin[3], reflectedColors[4][3];
+	float u, v, w, distance, nDotL, halfway[3];
+	int activeBits = bits(packet.active), shadowBits, reflectedBits, j, k;
+	Float4 blocked;
+
+	numRays += countBits(activeBits);
+	traverse(packet, false);
+
+	clearPacket(shadow);
+	clearPacket(reflected);
+	for (k = 0; k < 4; k++)
+	{
+		if (!(activeBits >> k & 1)) continue;
+		if (packet.triangle[k] < 0)
+		{
+			for (j = 0; j < 3; j++) colors[k][j] = background[j];
+			continue;
+		}
+
+		const RayTriangle &tri = triangles[packet.triangle[k]];
+		const RayMaterial &material = materials[tri.material];
+
+		// Point hit and the normal there, interpolated and turned to face the ray.
+		u = packet.u[k]; v = packet.v[k]; w = 1.0f - u - v;
+		direction[0] = packet.dx[k]; direction[1] = packet.dy[k]; direction[2] = packet.dz[k];
+		point[0] = packet.ox[k] + packet.tMax[k] * direction[0];
+		point[1] = packet.oy[k] + packet.tMax[k] * direction[1];
+		point[2] = packet.oz[k] + packet.tMax[k] * direction[2];
+		for (j = 0; j < 3; j++) normal[k][j] = w * tri.n[0][j] + u * tri.n[1][j] + v * tri.n[2][j];
+		normalize3(normal[k]);
+		if (dot3(normal[k], direction) > 0.0)
+			for (j = 0; j < 3; j++) normal[k][j] = -normal[k][j];
+		for (j = 0; j < 3; j++) origin[j] = point[j] + RAY_EPSILON * normal[k][j];
+
+		// Global ambient light.
+		for (j = 0; j < 3; j++) colors[k][j] = ambient * material.color[j];
+
+		// A shadow ray to the light if the surface faces it.
+		for (j = 0; j < 3; j++) toLight[k][j] = lightPos[j] - point[j];
+		distance = sqrt(dot3(toLight[k], toLight[k]));
+		normalize3(toLight[k]);
+		if (dot3(normal[k], toLight[k]) > 0.0) setRay(shadow, k, origin, toLight[k], distance - RAY_EPSILON);
+
+		// A reflected ray.
+		if (depth < maxDepth && material.reflection > 0.0)
+		{
+			float r[3], d = dot3(direction, normal[k]);
+			for (j = 0; j < 3; j++) r[j] = direction[j] - 2.0f * d * normal[k][j];
+			setRay(reflected, k, origin, r, FLT_MAX);
+		}
+	}
+
+	// Diffuse and specular light where the light is not blocked.
+	shadowBits = bits(shadow.active);
+	if (shadowBits)
+	{
+		numRays += countBits(shadowBits);
+		blocked = traverse(shadow, true);
+		shadowBits &= ~bits(blocked);
+		for (k = 0; k < 4; k++)
+		{
+			if (!(shadowBits >> k & 1)) continue;
+
+			const RayMaterial &material = materials[triangles[packet.triangle[k]].material];
+
+			nDotL = dot3(normal[k], toLight[k]);
+			halfway[0] = toLight[k][0] - packet.dx[k];
+			halfway[1] = toLight[k][1] - packet.dy[k];
+			halfway[2] = toLight[k][2] - packet.dz[k];
+			normalize3(halfway);
+			w = material.specular * pow(std::max(dot3(normal[k], halfway), 0.0f), material.shininess);
+			for (j = 0; j < 3; j++) colors[k][j] += nDotL * material.color[j] + w;
+		}
+	}
+
+	// What the reflected rays see.
+	reflectedBits = bits(reflected.active);
+	if (reflectedBits)
+	{
+		trace(reflected, depth + 1, reflectedColors, numRays);
+		for (k = 0; k < 4; k++)
+		{
+			if (!(reflectedBits >> k & 1)) continue;
+
+			const RayMaterial &material = materials[triangles[packet.triangle[k]].material];
+
+			for (j = 0; j < 3; j++) colors[k][j] += material.reflection * reflectedColors[k][j];
+		}
+	}
+}
+
+// Render a tile, 2 x 2 pixels at a time.
+void RayTracer::renderTile(int tile, int width, int height, std::vector<unsigned char> &image, long long &numRays)
+{
+	int tilesX = (width + RAY_TILE_SIZE - 1) / RAY_TILE_SIZE;
+	int x0 = (tile % tilesX) * RAY_TILE_SIZE, y0 = (tile / tilesX) * RAY_TILE_SIZE;
+	int x1 = std::min(x0 + RAY_TILE_SIZE, width), y1 = std::min(y0 + RAY_TILE_SIZE, height);
+	float aspect = (float)width / height, direction[3], sx, sy, colors[4][3];
+	RayPacket packet;
+	int x, y, px, py, j, k;
+
+	for (y = y0; y < y1; y += 2)
+		for (x = x0; x < x1; x += 2)
+		{
+			// Rays through the centers of the pixels.
+			clearPacket(packet);
+			for (k = 0; k < 4; k++)
+			{
+				px = x + (k & 1);
+				py = y + (k >> 1);
+				if (px >= x1 || py >= y1) continue;
+				sx = (2.0f * (px + 0.5f) / width - 1.0f) * tanHalfFovy * aspect;
+				sy = (2.0f * (py + 0.5f) / height - 1.0f) * tanHalfFovy;
+				for (j = 0; j < 3; j++) direction[j] = forward[j] + sx * right[j] + sy * up[j];
+				normalize3(direction);
+				setRay(packet, k, eye, direction, FLT_MAX);
+			}
+			trace(packet, 0, colors, numRays);
+
+			for (k = 0; k < 4; k++)
+			{
+				px = x + (k & 1);
+				py = y + (k >> 1);
+				if (px >= x1 || py >= y1) continue;
+				for (j = 0; j < 3; j++)
+					image[4 * (width * py + px) + j] = (unsigned char)(255.0f * std::min(colors[k][j], 1.0f) + 0.5f);
+				image[4 * (width * py + px) + 3] = 0xFF;
+			}
+		}
+}
+
+// Render an image of the size into RGBA pixels, bottom row first, on the pool's threads,
+// returning the number of rays traced.
+long long RayTracer::render(TilePool &pool, int width, int height, std::vector<unsigned char> &image)
+{
+	int numTiles = ((width + RAY_TILE_SIZE - 1) / RAY_TILE_SIZE) * ((height + RAY_TILE_SIZE - 1) / RAY_TILE_SIZE);
+	std::vector<long long> threadRays(pool.numThreads(), 0);
+	long long numRays = 0;
+
+	image.resize(4 * width * height);
+	pool.run(numTiles, [&](int tile, int thread)
+	{
+		long long tileRays = 0;
+		renderTile(tile, width, height, image, tileRays);
+		threadRays[thread] += tileRays;
+	});
+	for (size_t i = 0; i < threadRays.size(); i++) numRays += threadRays[i];
+	return numRays;
+}
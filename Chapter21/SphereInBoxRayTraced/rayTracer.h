@@ -0,0 +1,110 @@
+#ifndef RAYTRACER_H
+#define RAYTRACER_H
+
+#include <vector>
+
+#include "float4.h"
+#include "tilePool.h"
+
+#define RAY_TILE_SIZE 16 // Width and height in pixels of the tiles threads render.
+#define RAY_MAX_LEAF 4 // Most triangles of a leaf the SAH would rather split.
+#define RAY_BINS 16 // Bins along an axis among which the SAH chooses splits.
+#define RAY_STACK_SIZE 64 // Deepest BVH traversed.
+#define RAY_EPSILON 1.0e-4 // Offset of secondary rays from the surface they leave.
+
+// Material of the OpenGL fixed-function lighting model, as glMaterialfv() sets it with
+// the ambient and diffuse colors the same and white specular color, and the fraction of
+// light it reflects as a mirror.
+struct RayMaterial
+{
+	float color[3]; // Ambient and diffuse color.
+	float specular; // Specular color, gray.
+	float shininess; // Shininess exponent.
+	float reflection; // Fraction reflected.
+};
+
+// A triangle with a normal at each vertex, interpolated across it.
+struct RayTriangle
+{
+	float v[3][3]; // Vertices.
+	float n[3][3]; // Unit normals at the vertices.
+	int material; // Index of its material.
+};
+
+// A node of the BVH, 32 bytes. An interior node's children are consecutive.
+struct RayBvhNode
+{
+	float lower[3]; // Least corner of the bounding box.
+	int first; // First triangle of a leaf, or left child of an interior node.
+	float upper[3]; // Greatest corner of the bounding box.
+	int count; // Triangles of a leaf, or -1 - the axis split by an interior node.
+};
+
+// A triangle as intersected: its vertices and the cross product of the edges from the first.
+struct RayBvhTriangle
+{
+	float v0[3], v1[3], v2[3], n[3];
+};
+
+// Four rays traced together, lane i of each member belonging to ray i.
+struct RayPacket
+{
+	Float4 ox, oy, oz; // Origins.
+	Float4 dx, dy, dz; // Directions.
+	Float4 idx, idy, idz; // Inverses of the directions.
+	Float4 tMax; // Parameter of the nearest hit, or of the furthest point to look for one.
+	Float4 u, v; // Barycentric coordinates of the nearest hit.
+	Float4 active; // Mask of the rays traced.
+	int triangle[4]; // Triangle hit, -1 if none.
+};
+
+// Ray tracer class: Whitted ray tracing of triangle meshes lit by one point light with
+// the OpenGL fixed-function lighting model, two-sided and with a local viewer, with
+// shadows and mirror reflections.
+//
+// The triangles are held in a bounding volume hierarchy built top-down choosing each split
+// by the surface area heuristic, evaluated at the boundaries of bins of triangle
+// centroids. Rays are traced in packets of four, 2 x 2 pixels of the image or the
+// shadow and reflection rays spawned by them, each node being tested against all four at
+// once with SIMD instructions and visited if any ray meets it. The image is divided into
+// tiles rendered by a work-stealing tile pool, every pixel's color depending only on its
+// own rays, so that the image is the same whatever the number of threads.
+class RayTracer
+{
+public:
+	RayTracer();
+	int addMaterial(const RayMaterial &material);
+	void addTriangle(const RayTriangle &triangle);
+	void buildBvh(); // Build the BVH, once the triangles are added.
+	void setCamera(const float eye[3], const float center[3], const float up[3], float fovy); // As gluLookAt()
+	                                                                                         // and gluPerspective().
+	void setLight(const float position[3], float ambient); // Light position and global ambient gray.
+	void setBackground(float r, float g, float b);
+	void setMaxDepth(int depth) { maxDepth = depth; } // Most reflections followed.
+	long long render(TilePool &pool, int width, int height, std::vector<unsigned char> &image); // Render into 
+	                                                              // RGBA pixels, bottom row first, returning
+	                                                              // the number of rays traced.
+	int getNumTriangles() { return triangles.size(); }
+	int getNumNodes() { return nodes.size(); }
+	int getNumLeaves() { return numLeaves; }
+
+private:
+	void buildNode(int node, int first, int count, int depth, std::vector<int> &order,
+		           const std::vector<float> &centroids, const std::vector<float> &bounds);
+	Float4 traverse(RayPacket &packet, bool anyHit);
+	void trace(RayPacket &packet, int depth, float colors[4][3], long long &numRays);
+	void renderTile(int tile, int width, int height, std::vector<unsigned char> &image, long long &numRays);
+
+	std::vector<RayMaterial> materials;
+	std::vector<RayTriangle> triangles; // Triangles, in the order of the leaves once the BVH is built.
+	std::vector<RayBvhTriangle> bvhTriangles; // The same, as intersected.
+	std::vector<RayBvhNode> nodes; // The BVH, the root first.
+	int numLeaves;
+
+	float eye[3], forward[3], right[3], up[3], tanHalfFovy; // Camera.
+	float lightPos[3], ambient; // Light.
+	float background[3];
+	int maxDepth;
+};
+
+#endif
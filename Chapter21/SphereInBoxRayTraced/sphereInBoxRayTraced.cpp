@@ -0,0 +1,318 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// sphereInBoxRayTraced.cpp
+//
+// This command-line program ray traces the scene of sphereInBox1.cpp, to give reference
+// images of it and to time the ray tracer. The box, its lid opened by a number of steps
+// as in sphereInBox1.cpp, and the sphere, tessellated as glutSolidSphere() does, are 
+// lit by the same light with the same materials, seen by the same camera, and shaded 
+// with the same lighting model, but with shadows and, as in sphereInBoxPOV.pov, with
+// every surface reflecting 0.4 of the light. The image is written to a BMP file that 
+// getBMP() reads, and the time taken and rays traced per second are reported.
+//
+// Usage:
+// SphereInBoxRayTraced [-size w h] [-step n] [-sphere n] [-depth n] [-threads n] [-runs n]
+//                      [-out file] [-check]
+// -size w h   Image width and height, 500 x 500 by default.
+// -step n     Steps, of a degree, the lid is open, 0 to 180, 0 by default.
+// -sphere n   Slices and stacks of the sphere, 40 by default.
+// -depth n    Most reflections followed, 4 by default, 0 for none.
+// -threads n  Number of threads, by default the number of hardware threads.
+// -runs n     Number of times the image is rendered and timed, 1 by default.
+// -out file   Output BMP file, sphereInBoxRayTraced.bmp by default.
+// -check      Render again on a single thread and compare the images, read the BMP
+//             file back and compare it with the image, and render the scene with the lid
+//             open at an odd width, looking for pinholes down its middle column.
+//
+// Sumanta Guha
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "getBMP.h"
+#include "putBMP.h"
+#include "rayTracer.h"
+
+#define PI 3.14159265358979324
+#define ONE_BY_ROOT_THREE 0.57735
+
+// Globals.
+static int width = 500, height = 500; // Image size.
+static int step = 0; // Steps in open/closing the box lid.
+static int sphereSteps = 40; // Slices and stacks of the sphere.
+static int maxDepth = 4; // Most reflections followed.
+static int numThreads = 0; // Number of threads.
+static int numRuns = 1; // Number of renders timed.
+static std::string outFileName = "sphereInBoxRayTraced.bmp"; // Output file.
+
+// Box vertex co-ordinate vectors, as in sphereInBox1.cpp.
+static float vertices[] =
+{
+	1.0, -1.0, 1.0,
+	1.0, 1.0, 1.0,
+	1.0, 1.0, -1.0,
+	1.0, -1.0, -1.0,
+	-1.0, -1.0, 1.0,
+	-1.0, 1.0, 1.0,
+	-1.0, 1.0, -1.0,
+	-1.0, -1.0, -1.0
+};
+
+// Vertex indices of triangle strips around the sides, and of the bottom and top.
+static unsigned char stripIndices0[] = { 5, 4, 1, 0, 2, 3, 6, 7, 5, 4 };
+static unsigned char stripIndices1[] = { 0, 4, 3, 7 };
+static unsigned char stripIndices2[] = { 6, 5, 2, 1 };
+
+// Camera and light, the light being in eye coordinates as glLightfv() sets it with the
+// modelview matrix the identity.
+static float eye[] = { 0.0, 3.0, 3.0 }, center[] = { 0.0, 0.0, 0.0 }, up[] = { 0.0, 1.0, 0.0 };
+static float lightEyePos[] = { 0.0, 1.5, 3.0 };
+
+// Routine to add the triangles of a strip of the box, with the normal at each vertex 
+// along the line from the origin to it, rotating the lid by step degrees about its 
+// hinge, the edge y = 1, z = -1, if isLid.
+void addStrip(RayTracer &tracer, const unsigned char *indices, int count, int material, bool isLid)
+{
+	float angle = -step * PI / 180.0, c = cos(angle), s = sin(angle), y, z;
+	RayTriangle triangle;
+	int i, k, j;
+
+	triangle.material = material;
+	for (i = 0; i + 2 < count; i++)
+	{
+		for (k = 0; k < 3; k++)
+			for (j = 0; j < 3; j++)
+			{
+				triangle.v[k][j] = vertices[3 * indices[i + k] + j];
+				triangle.n[k][j] = ONE_BY_ROOT_THREE * vertices[3 * indices[i + k] + j];
+			}
+		if (isLid)
+			for (k = 0; k < 3; k++)
+			{
+				// glRotatef(step, -1.0, 0.0, 0.0) about the hinge.
+				y = triangle.v[k][1] - 1.0; z = triangle.v[k][2] + 1.0;
+				triangle.v[k][1] = y * c - z * s + 1.0;
+				triangle.v[k][2] = y * s + z * c - 1.0;
+				y = triangle.n[k][1]; z = triangle.n[k][2];
+				triangle.n[k][1] = y * c - z * s;
+				triangle.n[k][2] = y * s + z * c;
+			}
+		tracer.addTriangle(triangle);
+	}
+}
+
+// Routine to add a sphere of radius 1 about the origin of the slices and stacks that
+// glutSolidSphere() would draw, with the normals of a true sphere.
+void addSphere(RayTracer &tracer, int slices, int stacks, int material)
+{
+	float p[4][3], theta, phi;
+	RayTriangle triangle;
+	int i, j, k, corner[] = { 0, 1, 3, 0, 3, 2 };
+
+	triangle.material = material;
+	for (i = 0; i < stacks; i++)
+		for (j = 0; j < slices; j++)
+		{
+			// Corners of the patch, the poles along the z-axis.
+			for (k = 0; k < 4; k++)
+			{
+				// The last slice ends at the first's vertices, not at 2 pi, so that the seam is closed.
+				phi = PI * (i + (k >> 1)) / stacks;
+				theta = 2.0 * PI * ((j + (k & 1)) % slices) / slices;
+				p[k][0] = sin(phi) * cos(theta);
+				p[k][1] = sin(phi) * sin(theta);
+				p[k][2] = cos(phi);
+			}
+
+			// Two triangles, only one at a pole.
+			for (k = 0; k < 6; k++)
+			{
+				if (i == 0 && k < 3) continue;
+				if (i == stacks - 1 && k >= 3) continue;
+				std::copy(p[corner[k]], p[corner[k]] + 3, triangle.v[k % 3]);
+				std::copy(p[corner[k]], p[corner[k]] + 3, triangle.n[k % 3]);
+				if (k % 3 == 2) tracer.addTriangle(triangle);
+			}
+		}
+}
+
+// Routine to convert a point in eye coordinates to world coordinates.
+void eyeToWorld(const float *eyeCoords, float *worldCoords)
+{
+	float forward[3], right[3], top[3], length;
+	int j;
+
+	for (j = 0; j < 3; j++) forward[j] = center[j] - eye[j];
+	length = sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+	for (j = 0; j < 3; j++) forward[j] /= length;
+	right[0] = forward[1] * up[2] - forward[2] * up[1];
+	right[1] = forward[2] * up[0] - forward[0] * up[2];
+	right[2] = forward[0] * up[1] - forward[1] * up[0];
+	length = sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+	for (j = 0; j < 3; j++) right[j] /= length;
+	top[0] = right[1] * forward[2] - right[2] * forward[1];
+	top[1] = right[2] * forward[0] - right[0] * forward[2];
+	top[2] = right[0] * forward[1] - right[1] * forward[0];
+
+	// The eye looks down its -z axis.
+	for (j = 0; j < 3; j++)
+		worldCoords[j] = eye[j] + eyeCoords[0] * right[j] + eyeCoords[1] * top[j] - eyeCoords[2] * forward[j];
+}
+
+// Routine to fill the tracer with the scene.
+void fillScene(RayTracer &tracer)
+{
+	RayMaterial boxMaterial = { { 0.9, 0.0, 0.0 }, 1.0, 50.0, 0.4 };
+	RayMaterial sphereMaterial = { { 0.0, 0.9, 0.0 }, 1.0, 50.0, 0.4 };
+	float lightPos[3];
+	int box = tracer.addMaterial(boxMaterial), sphere = tracer.addMaterial(sphereMaterial);
+
+	addStrip(tracer, stripIndices0, 10, box, false);
+	addStrip(tracer, stripIndices1, 4, box, false);
+	addStrip(tracer, stripIndices2, 4, box, true);
+	addSphere(tracer, sphereSteps, sphereSteps, sphere);
+
+	tracer.setCamera(eye, center, up, 60.0);
+	eyeToWorld(lightEyePos, lightPos);
+	tracer.setLight(lightPos, 0.2);
+	tracer.setBackground(1.0, 1.0, 1.0);
+	tracer.setMaxDepth(maxDepth);
+}
+
+// Routine to find how much two RGBA pixels differ, the sum of the differences of their colors.
+int pixelDifference(const unsigned char *a, const unsigned char *b)
+{
+	return abs(a[0] - b[0]) + abs(a[1] - b[1]) + abs(a[2] - b[2]);
+}
+
+// Routine to count the pinholes down the middle column of an image: pixels differing by
+// well over the aliasing of reflections from those above and below and from those on
+// either side, which agree. With an odd width the column's rays lie in the plane x = 0,
+// along which a meridian of the sphere's edges lies, and show any ray slipping between
+// triangles there.
+int countPinholes(const std::vector<unsigned char> &image, int imageWidth, int imageHeight)
+{
+	int x = imageWidth / 2, count = 0, i;
+
+	if (x == 0 || x == imageWidth - 1) return 0;
+	for (i = 1; i < imageHeight - 1; i++)
+	{
+		const unsigned char *pixel = &image[4 * (i * imageWidth + x)];
+		if (pixelDifference(pixel, pixel - 4) > 64 && pixelDifference(pixel, pixel + 4) > 64 &&
+			pixelDifference(pixel - 4, pixel + 4) < 32 && pixelDifference(pixel, pixel - 4 * imageWidth) > 64 &&
+			pixelDifference(pixel, pixel + 4 * imageWidth) > 64)
+			count++;
+	}
+	return count;
+}
+
+// Routine to render the image on a number of threads, reporting the times if report.
+void renderScene(RayTracer &tracer, int threads, std::vector<unsigned char> &image, bool report)
+{
+	TilePool pool(threads);
+	long long numRays;
+	int i;
+
+	for (i = 0; i < (report ? numRuns : 1); i++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		numRays = tracer.render(pool, width, height, image);
+		float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+		if (report)
+			std::cout << "Render " << i + 1 << ": " << 1000.0 * seconds << " ms, " << numRays << " rays, "
+				<< numRays / seconds / 1.0e6 << " million rays per second" << std::endl;
+	}
+}
+
+// Main routine.
+int main(int argc, char **argv)
+{
+	RayTracer tracer;
+	std::vector<unsigned char> image, singleImage;
+	bool check = false;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-size" && i + 2 < argc) { width = atoi(argv[++i]); height = atoi(argv[++i]); }
+		else if (arg == "-step" && i + 1 < argc) step = std::min(std::max(atoi(argv[++i]), 0), 180);
+		else if (arg == "-sphere" && i + 1 < argc) sphereSteps = std::max(atoi(argv[++i]), 2);
+		else if (arg == "-depth" && i + 1 < argc) maxDepth = std::max(atoi(argv[++i]), 0);
+		else if (arg == "-threads" && i + 1 < argc) numThreads = atoi(argv[++i]);
+		else if (arg == "-runs" && i + 1 < argc) numRuns = std::max(atoi(argv[++i]), 1);
+		else if (arg == "-out" && i + 1 < argc) outFileName = argv[++i];
+		else if (arg == "-check") check = true;
+		else
+		{
+			std::cout << "Usage: SphereInBoxRayTraced [-size w h] [-step n] [-sphere n] [-depth n] [-threads n]"
+				<< " [-runs n] [-out file] [-check]" << std::endl;
+			return 1;
+		}
+	}
+	if (width <= 0 || height <= 0)
+	{
+		std::cout << "The image size must be positive." << std::endl;
+		return 1;
+	}
+	if (numThreads <= 0) numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	// Build the scene and its BVH.
+	fillScene(tracer);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	tracer.buildBvh();
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	std::cout << tracer.getNumTriangles() << " triangles, BVH of " << tracer.getNumNodes() << " nodes and "
+		<< tracer.getNumLeaves() << " leaves built in " << 1000.0 * seconds << " ms" << std::endl
+		<< width << " x " << height << " pixels, " << maxDepth << " reflections, " << numThreads << " threads" 
+		<< std::endl;
+
+	renderScene(tracer, numThreads, image, true);
+
+	imageFile out = { width, height, &image[0] };
+	if (!putBMP(outFileName, &out))
+	{
+		std::cout << "Could not write " << outFileName << "." << std::endl;
+		return 1;
+	}
+	std::cout << "Image written to " << outFileName << "." << std::endl;
+
+	if (check)
+	{
+		renderScene(tracer, 1, singleImage, false);
+		bool same = singleImage == image;
+		std::cout << "Single-threaded image " << (same ? "the same." : "DIFFERENT.") << std::endl;
+
+		imageFile *in = getBMP(outFileName);
+		bool readBack = in->width == width && in->height == height && std::equal(image.begin(), image.end(), in->data);
+		std::cout << "Image read back by getBMP() " << (readBack ? "the same." : "DIFFERENT.") << std::endl;
+		delete[] in->data;
+		delete in;
+
+		// The scene with the lid open, at an odd width, so that the middle column has rays
+		// through the meridian of the sphere at x = 0.
+		RayTracer openTracer;
+		std::vector<unsigned char> openImage;
+		int savedWidth = width, savedStep = step, pinholes;
+		width |= 1;
+		step = 60;
+		fillScene(openTracer);
+		openTracer.buildBvh();
+		renderScene(openTracer, numThreads, openImage, false);
+		pinholes = countPinholes(openImage, width, height);
+		std::cout << "Image " << width << " x " << height << " with the lid open: " << pinholes << " pinholes."
+			<< std::endl;
+		width = savedWidth;
+		step = savedStep;
+		if (!same || !readBack || pinholes) return 1;
+	}
+	return 0;
+}
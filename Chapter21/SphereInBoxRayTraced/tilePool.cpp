@@ -0,0 +1,127 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// tilePool.cpp
+//
+// A work-stealing pool of threads running the tiles of an image.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "tilePool.h"
+
+// TilePool constructor.
+TilePool::TilePool(int numThreads)
+	: shares(numThreads > 0 ? numThreads : std::max(1, (int)std::thread::hardware_concurrency()))
+{
+	int i;
+
+	job = NULL; busy = 0; generation = 0; quit = false;
+	for (i = 0; i < (int)shares.size(); i++) shares[i].first = shares[i].last = 0;
+	for (i = 1; i < (int)shares.size(); i++) workers.push_back(std::thread(&TilePool::workerLoop, this, i));
+}
+
+// TilePool destructor.
+TilePool::~TilePool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &worker : workers) worker.join();
+}
+
+// Take the next tile of the thread's share or, the share being empty, steal the back half
+// of another's, returning false when no thread has tiles left.
+bool TilePool::takeTile(int thread, int &tile)
+{
+	int n = shares.size(), i, victim, first = 0, last = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(shares[thread].mutex);
+		if (shares[thread].first < shares[thread].last)
+		{
+			tile = shares[thread].first++;
+			return true;
+		}
+	}
+
+	// Try the other threads in turn, starting with the next, never holding two locks.
+	for (i = 1; i < n && first == last; i++)
+	{
+		victim = (thread + i) % n;
+		std::lock_guard<std::mutex> lock(shares[victim].mutex);
+		if (shares[victim].first < shares[victim].last)
+		{
+			last = shares[victim].last;
+			first = last - (last - shares[victim].first + 1) / 2;
+			shares[victim].last = first;
+		}
+	}
+	if (first == last) return false;
+
+	// Run the first stolen tile and keep the rest.
+	std::lock_guard<std::mutex> lock(shares[thread].mutex);
+	tile = first;
+	shares[thread].first = first + 1;
+	shares[thread].last = last;
+	return true;
+}
+
+// Run tiles till none are left.
+void TilePool::runTiles(int thread)
+{
+	int tile;
+	while (takeTile(thread, tile)) (*job)(tile, thread);
+}
+
+// Routine run by each worker: wait for a run, help with it, and report when done.
+void TilePool::workerLoop(int thread)
+{
+	unsigned int seen = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || generation != seen; });
+			if (quit) return;
+			seen = generation;
+		}
+		runTiles(thread);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0) finished.notify_one();
+		}
+	}
+}
+
+// Run job(tile, thread) for tiles 0, ..., numTiles - 1 on the workers and the calling thread.
+void TilePool::run(int numTiles, const std::function<void(int, int)> &job)
+{
+	int n = shares.size(), i;
+
+	if (workers.empty())
+	{
+		for (i = 0; i < numTiles; i++) job(i, 0);
+		return;
+	}
+
+	// Deal the tiles out in contiguous shares.
+	for (i = 0; i < n; i++)
+	{
+		std::lock_guard<std::mutex> lock(shares[i].mutex);
+		shares[i].first = (long long)numTiles * i / n;
+		shares[i].last = (long long)numTiles * (i + 1) / n;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->job = &job;
+		busy = workers.size();
+		generation++;
+	}
+	wake.notify_all();
+	runTiles(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [&] { return busy == 0; });
+}
@@ -0,0 +1,46 @@
+#ifndef TILEPOOL_H
+#define TILEPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tile pool class: a pool of worker threads that, together with the calling thread, run
+// the tiles of an image, each thread starting on a contiguous share of them and, its own
+// share done, stealing the back half of what is left of another's. Each thread so works
+// on neighboring tiles for as long as it can, and none sits idle while another has tiles
+// left, however unevenly costly the tiles are.
+class TilePool
+{
+public:
+	TilePool(int numThreads = 0); // Constructor, by default one thread per core, the caller included.
+	~TilePool();
+	int numThreads() { return workers.size() + 1; } // Threads running tiles, the caller included.
+	void run(int numTiles, const std::function<void(int, int)> &job); // Run job(tile, thread) for every
+	                                                                  // tile and return when all have.
+
+private:
+	// Tiles a thread has yet to run, first to last - 1.
+	struct Share
+	{
+		std::mutex mutex;
+		int first, last;
+	};
+
+	void workerLoop(int thread);
+	void runTiles(int thread);
+	bool takeTile(int thread, int &tile);
+
+	std::vector<std::thread> workers;
+	std::vector<Share> shares; // Each thread's share, the caller's first.
+	std::mutex mutex;
+	std::condition_variable wake, finished;
+	const std::function<void(int, int)> *job; // Job of the current run.
+	int busy; // Workers still in the current run.
+	unsigned int generation; // Number of runs started.
+	bool quit;
+};
+
+#endif
@@ -3,10 +3,15 @@
 // 
 // This program augments circularAnnuluses.cpp with two clipping planes.
 //
+// The annuluses can be clipped either by OpenGL or on the CPU by clipper.cpp, the discs
+// and the triangles of the lower annulus being clipped as polygons against the enabled 
+// planes, which should look the same.
+//
 // Interaction:
 // Press the space bar to toggle between wireframe and filled for the lower annulus.
 // Press '0' to enable/disable clipping plane 0.
 // Press '1' to enable/disable clipping plane 1.
+// Press 'c' to toggle between clipping by OpenGL and on the CPU.
 //
 // Sumanta Guha.
 //////////////////////////////////////////////////////////////////////////////////// 
@@ -18,6 +23,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "clipper.h"
+
 #define PI 3.14159265
 #define N 40.0 // Number of vertices on boundary of disc.
 
@@ -25,6 +32,8 @@
 static int isWire = 0; // Is wireframe?
 static int isClip0 = 0; // Is clipping plane 0 enabled?
 static int isClip1 = 0; // Is clipping plane 1 enabled?
+static int isCpuClip = 0; // Are the enabled planes clipped against on the CPU?
+static ClipPlanes cpuPlanes; // The enabled planes, when clipping on the CPU.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
 
 // Routine to draw a bitmap character string.
@@ -35,6 +44,21 @@ void writeBitmapString(void *font, char *string)
 	for (c = string; *c != '\0'; c++) glutBitmapCharacter(font, *c);
 }
 
+// Function to draw polygons, each vertex (x, y, z, w), clipped on the CPU.
+void drawClippedPolygons(const ClipPolygons &polygons)
+{
+	ClipPolygons clipped;
+	int i, j, first;
+
+	clipPolygons(cpuPlanes, polygons, clipped);
+	for (i = 0, first = 0; i < (int)clipped.counts.size(); first += clipped.counts[i], i++)
+	{
+		glBegin(GL_POLYGON);
+		for (j = first; j < first + clipped.counts[i]; j++) glVertex4fv(&clipped.vertices[4 * j]);
+		glEnd();
+	}
+}
+
 // Function to draw a disc with center at (X, Y, Z), radius R, parallel to the
 // xy-plane.
 void drawDisc(float R, float X, float Y, float Z)
@@ -42,6 +66,25 @@ void drawDisc(float R, float X, float Y, float Z)
 	float t;
 	int i;
 
+	// On the CPU the disc is clipped as the polygon of its boundary.
+	if (isCpuClip)
+	{
+		ClipPolygons disc;
+		disc.stride = 4;
+		disc.vertices.resize(4 * (int)N);
+		for (i = 0; i < N; ++i)
+		{
+			t = 2 * PI * i / N;
+			disc.vertices[4 * i] = X + cos(t) * R;
+			disc.vertices[4 * i + 1] = Y + sin(t) * R;
+			disc.vertices[4 * i + 2] = Z;
+			disc.vertices[4 * i + 3] = 1.0;
+		}
+		disc.counts.push_back((int)N);
+		drawClippedPolygons(disc);
+		return;
+	}
+
 	glBegin(GL_TRIANGLE_FAN);
 	glVertex3f(X, Y, Z);
 	for (i = 0; i <= N; ++i)
@@ -67,12 +110,17 @@ void drawScene(void)
 	glClipPlane(GL_CLIP_PLANE0, eqn0); // Specify clipping plane 0.
 	glClipPlane(GL_CLIP_PLANE1, eqn1); // Specify clipping plane 1.
 
-	if (isClip0) glEnable(GL_CLIP_PLANE0); // Clip points s.t. z > 0.25.
+	if (isClip0 && !isCpuClip) glEnable(GL_CLIP_PLANE0); // Clip points s.t. z > 0.25.
 	else glDisable(GL_CLIP_PLANE0);
 
-	if (isClip1) glEnable(GL_CLIP_PLANE1); // Clip points s.t. x > 75.0.
+	if (isClip1 && !isCpuClip) glEnable(GL_CLIP_PLANE1); // Clip points s.t. x > 75.0.
 	else glDisable(GL_CLIP_PLANE1);
 
+	// The same planes for clipping on the CPU, the modelview matrix being the identity.
+	cpuPlanes.planes.clear();
+	if (isClip0) cpuPlanes.planes.insert(cpuPlanes.planes.end(), eqn0, eqn0 + 4);
+	if (isClip1) cpuPlanes.planes.insert(cpuPlanes.planes.end(), eqn1, eqn1 + 4);
+
 	// Upper left circular annulus: the white disc overwrites the red disc.
 	glColor3f(1.0, 0.0, 0.0);
 	drawDisc(20.0, 25.0, 75.0, 0.0);
@@ -90,14 +138,41 @@ void drawScene(void)
 							  // Lower circular annulus: with a true hole.
 	if (isWire) glPolygonMode(GL_FRONT, GL_LINE);else glPolygonMode(GL_FRONT, GL_FILL);
 	glColor3f(1.0, 0.0, 0.0);
-	glBegin(GL_TRIANGLE_STRIP);
-	for (i = 0; i <= N; ++i)
+	if (isCpuClip)
 	{
-		angle = 2 * PI * i / N;
-		glVertex3f(50 + cos(angle) * 10.0, 30 + sin(angle) * 10.0, 0.0);
-		glVertex3f(50 + cos(angle) * 20.0, 30 + sin(angle) * 20.0, 0.0);
+		// On the CPU each triangle of the strip is clipped, every other one turned round
+		// to face the same way, as OpenGL draws them.
+		ClipPolygons triangles;
+		float strip[2 * ((int)N + 1)][4];
+		triangles.stride = 4;
+		for (i = 0; i <= N; ++i)
+		{
+			angle = 2 * PI * i / N;
+			strip[2 * i][0] = 50 + cos(angle) * 10.0; strip[2 * i][1] = 30 + sin(angle) * 10.0;
+			strip[2 * i + 1][0] = 50 + cos(angle) * 20.0; strip[2 * i + 1][1] = 30 + sin(angle) * 20.0;
+			strip[2 * i][2] = strip[2 * i + 1][2] = 0.0;
+			strip[2 * i][3] = strip[2 * i + 1][3] = 1.0;
+		}
+		for (i = 0; i < 2 * N; ++i)
+		{
+			triangles.vertices.insert(triangles.vertices.end(), strip[i + i % 2], strip[i + i % 2] + 4);
+			triangles.vertices.insert(triangles.vertices.end(), strip[i + 1 - i % 2], strip[i + 1 - i % 2] + 4);
+			triangles.vertices.insert(triangles.vertices.end(), strip[i + 2], strip[i + 2] + 4);
+			triangles.counts.push_back(3);
+		}
+		drawClippedPolygons(triangles);
+	}
+	else
+	{
+		glBegin(GL_TRIANGLE_STRIP);
+		for (i = 0; i <= N; ++i)
+		{
+			angle = 2 * PI * i / N;
+			glVertex3f(50 + cos(angle) * 10.0, 30 + sin(angle) * 10.0, 0.0);
+			glVertex3f(50 + cos(angle) * 20.0, 30 + sin(angle) * 20.0, 0.0);
+		}
+		glEnd();
 	}
-	glEnd();
 
 	// Write labels.
 	glColor3f(0.0, 0.0, 0.0);
@@ -148,6 +223,12 @@ void keyInput(unsigned char key, int x, int y)
 		else isClip1 = 0;
 		glutPostRedisplay();
 		break;
+	case 'c':
+		if (isCpuClip == 0) isCpuClip = 1;
+		else isCpuClip = 0;
+		std::cout << "Clipping " << (isCpuClip ? "on the CPU." : "by OpenGL.") << std::endl;
+		glutPostRedisplay();
+		break;
 	case 27:
 		exit(0);
 		break;
@@ -163,7 +244,8 @@ void printInteraction(void)
 	std::cout << "Press the space bar to toggle between wireframe and filled" << std::endl
 		<< "for the lower annulus." << std::endl
 		<< "Press '0' to enable/disable clipping plane 0." << std::endl
-		<< "Press '1' to enable/disable clipping plane 1." << std::endl;
+		<< "Press '1' to enable/disable clipping plane 1." << std::endl
+		<< "Press 'c' to toggle between clipping by OpenGL and on the CPU." << std::endl;
 }
 
 // Main routine.
@@ -0,0 +1,75 @@
+#ifndef GEOMETRYRECORDER_H
+#define GEOMETRYRECORDER_H
+
+#include <cstddef>
+#include <vector>
+
+#define RECORDER_STRIDE 10 // Floats per recorded vertex: x, y, z, nx, ny, nz, r, g, b, a.
+
+// Geometry recorder class: records a sequence of primitives, issued through calls that
+// mirror glBegin(), glColor*(), glNormal*(), glVertex*() and glEnd(), once into an
+// interleaved vertex buffer and an index buffer, and replays it with a glDrawElements() call
+// per kind of primitive recorded, triangles, lines and points, usually just the one.
+//
+// Every mode of glBegin() is accepted: strips, fans, loops, quadrilaterals and polygons are
+// turned into lists of triangles or lines as they are recorded, so that a polygon drawn with
+// glPolygonMode() set to GL_LINE shows the diagonals it is split along. Each triangle and line
+// ends with the vertex OpenGL would take its color from with glShadeModel(GL_FLAT), so that
+// flat shading colors a replay as it does the primitive. The current color and normal are
+// kept as OpenGL keeps them, across primitives, and stored with each vertex. If no color, or
+// no normal, is given while recording, none is replayed either, and the current OpenGL one
+// applies to the whole recording, as it would to a display list.
+//
+// A recording is made with a key, computed by the caller from the parameters generating
+// it, e.g., with recordingKey(), and is valid only while the key asked for is the same, so
+// that changing a parameter sets off a new recording the next time it is drawn:
+//
+//    if (!recorder.isRecorded(key)) { recorder.startRecording(key); ...; recorder.finishRecording(); }
+//    recorder.draw();
+//
+// Replay is through a VAO, with the fixed-function vertex, normal and color arrays set in
+// the compatibility profile or, if the recorder is made for the core profile, the generic
+// attributes 0, 1 and 2 for a shader to take position, normal and color from.
+class GeometryRecorder
+{
+public:
+	GeometryRecorder(bool coreProfile = false); // Constructor, for replay by shader if coreProfile.
+	bool isRecorded(unsigned long long key) { return recorded && key == recordedKey; }
+	void startRecording(unsigned long long key); // Drop any recording and start one with this key.
+	void begin(unsigned int mode); // As glBegin().
+	void color3f(float r, float g, float b) { color4f(r, g, b, 1.0); }
+	void color4f(float r, float g, float b, float a);
+	void normal3f(float nx, float ny, float nz);
+	void vertex2f(float x, float y) { vertex3f(x, y, 0.0); }
+	void vertex3f(float x, float y, float z);
+	void end(); // As glEnd().
+	void finishRecording(); // Copy the recording to the buffers, ready to draw.
+	void draw(); // Replay the recording.
+	void invalidate() { recorded = false; } // Record again at the next chance, whatever the key.
+	void release(); // Delete the buffers and VAO, while the context is still current.
+	int getNumVertices() { return numVertices; }
+	int getNumIndices() { return numTriangleIndices + numLineIndices + numPointIndices; }
+
+private:
+	void addIndices(); // Turn the vertices of the primitive just ended into indices.
+
+	bool coreProfile;
+	bool recorded; // Whether the buffers hold a recording.
+	unsigned long long recordedKey;
+
+	std::vector<float> vertices; // RECORDER_STRIDE floats per vertex.
+	std::vector<unsigned int> triangleIndices, lineIndices, pointIndices;
+	unsigned int mode; // Mode of the primitive being recorded.
+	int first; // Its first vertex.
+	float currentColor[4], currentNormal[3];
+	bool hasColors, hasNormals; // Whether any color, or normal, was given.
+
+	unsigned int vao, buffer[2]; // VAO and buffer ids, 0 until made.
+	int numVertices, numTriangleIndices, numLineIndices, numPointIndices; // What was copied to the
+	                                                                       // buffers.
+	bool drawColors, drawNormals; // Whether the buffers hold colors, or normals, to replay.
+};
+
+unsigned long long recordingKey(const float *params, int count);
+
+#endif
@@ -3,6 +3,15 @@
 //
 // This program draws several helixes using a display list.
 // 
+// They can be drawn instead from a recording of the helix in vertex and index buffers,
+// made by a GeometryRecorder the first time it is drawn.
+//
+// Interaction:
+// Press r to toggle between the display list and the recording.
+// Press w/W to widen/narrow the helixes.
+// Press t/T to add/remove turns.
+// Press s/S to add/remove steps per half turn.
+//
 // Sumanta Guha.
 ///////////////////////////////////////////////////////////
 
@@ -13,29 +22,78 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "geometryRecorder.h"
+
 #define PI 3.14159265
 
 // Globals.
 static unsigned int aHelix; // List index.
-
-// Initialization routine.
-void setup(void)
+static GeometryRecorder helix; // Recording of the helix.
+static int isRecording = 0; // Draw the recording instead of the display list?
+static float helixRadius = 20.0; // Helix parameters: radius, number of turns and
+static float helixTurns = 10.0;  // steps per half turn.
+static float helixSteps = 20.0;
+
+// Routine to draw a helix, to the recorder if it is given, else in immediate mode.
+void drawHelix(GeometryRecorder *recorder)
 {
 	float t; // Angle parameter.
 
-	aHelix = glGenLists(1); // Return a list index.
+	if (recorder)
+	{
+		recorder->begin(GL_LINE_STRIP);
+		for (t = -helixTurns * PI; t <= helixTurns * PI; t += PI / helixSteps)
+			recorder->vertex3f(helixRadius * cos(t), helixRadius * sin(t), t);
+		recorder->end();
+		return;
+	}
 
+	glBegin(GL_LINE_STRIP);
+	for (t = -helixTurns * PI; t <= helixTurns * PI; t += PI / helixSteps)
+		glVertex3f(helixRadius * cos(t), helixRadius * sin(t), t);
+	glEnd();
+}
+
+// Routine to draw one helix, by the display list or, recording it first if its
+// parameters have changed, by the recording.
+void callHelix(void)
+{
+	float params[] = { helixRadius, helixTurns, helixSteps };
+	unsigned long long key = recordingKey(params, 3);
+
+	if (!isRecording)
+	{
+		glCallList(aHelix); // Execute display list.
+		return;
+	}
+
+	if (!helix.isRecorded(key))
+	{
+		helix.startRecording(key);
+		drawHelix(&helix);
+		helix.finishRecording();
+	}
+	helix.draw(); // Replay recording, taking the current color as the display list does.
+}
+
+// Routine to (re)compile the display list for the current helix parameters.
+void compileHelix(void)
+{
 	// Begin create a display list.
 	glNewList(aHelix, GL_COMPILE);
 
 	// Draw a helix.
-	glBegin(GL_LINE_STRIP);
-	for (t = -10 * PI; t <= 10 * PI; t += PI / 20.0)
-		glVertex3f(20 * cos(t), 20 * sin(t), t);
-	glEnd();
+	drawHelix(NULL);
 
 	glEndList();
 	// End create a display list.
+}
+
+// Initialization routine.
+void setup(void)
+{
+	aHelix = glGenLists(1); // Return a list index.
+	compileHelix();
 
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 }
@@ -49,42 +107,42 @@ void drawScene(void)
 	glColor3f(1.0, 0.0, 0.0);
 	glPushMatrix();
 	glTranslatef(0.0, 0.0, -70.0);
-	glCallList(aHelix); // Execute display list.
+	callHelix();
 	glPopMatrix();
 
 	glColor3f(0.0, 1.0, 0.0);
 	glPushMatrix();
 	glTranslatef(30.0, 0.0, -70.0);
 	glScalef(0.5, 0.5, 0.5);
-	glCallList(aHelix); // Execute display list.
+	callHelix();
 	glPopMatrix();
 
 	glColor3f(0.0, 0.0, 1.0);
 	glPushMatrix();
 	glTranslatef(-25.0, 0.0, -70.0);
 	glRotatef(90.0, 0.0, 1.0, 0.0);
-	glCallList(aHelix); // Execute display list.
+	callHelix();
 	glPopMatrix();
 
 	glColor3f(1.0, 1.0, 0.0);
 	glPushMatrix();
 	glTranslatef(0.0, -20.0, -70.0);
 	glRotatef(90.0, 0.0, 0.0, 1.0);
-	glCallList(aHelix); // Execute display list.
+	callHelix();
 	glPopMatrix();
 
 	glColor3f(1.0, 0.0, 1.0);
 	glPushMatrix();
 	glTranslatef(-40.0, 40.0, -70.0);
 	glScalef(0.5, 0.5, 0.5);
-	glCallList(aHelix); // Execute display list.
+	callHelix();
 	glPopMatrix();
 
 	glColor3f(0.0, 1.0, 1.0);
 	glPushMatrix();
 	glTranslatef(30.0, 30.0, -70.0);
 	glRotatef(90.0, 1.0, 0.0, 0.0);
-	glCallList(aHelix); // Execute display list.
+	callHelix();
 	glPopMatrix();
 
 	glFlush();
@@ -109,14 +167,59 @@ void keyInput(unsigned char key, int x, int y)
 	case 27:
 		exit(0);
 		break;
+	case 'r':
+		isRecording = !isRecording;
+		glutPostRedisplay();
+		break;
+	case 'w':
+		if (helixRadius < 40.0) helixRadius += 5.0;
+		compileHelix();
+		glutPostRedisplay();
+		break;
+	case 'W':
+		if (helixRadius > 5.0) helixRadius -= 5.0;
+		compileHelix();
+		glutPostRedisplay();
+		break;
+	case 't':
+		if (helixTurns < 20.0) helixTurns += 1.0;
+		compileHelix();
+		glutPostRedisplay();
+		break;
+	case 'T':
+		if (helixTurns > 1.0) helixTurns -= 1.0;
+		compileHelix();
+		glutPostRedisplay();
+		break;
+	case 's':
+		if (helixSteps < 100.0) helixSteps += 5.0;
+		compileHelix();
+		glutPostRedisplay();
+		break;
+	case 'S':
+		if (helixSteps > 5.0) helixSteps -= 5.0;
+		compileHelix();
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
 }
 
+// Routine to output interaction instructions to the C++ window.
+void printInteraction(void)
+{
+	std::cout << "Interaction:" << std::endl;
+	std::cout << "Press r to toggle between the display list and the recording." << std::endl
+		<< "Press w/W to widen/narrow the helixes." << std::endl
+		<< "Press t/T to add/remove turns." << std::endl
+		<< "Press s/S to add/remove steps per half turn." << std::endl;
+}
+
 // Main routine.
 int main(int argc, char **argv)
 {
+	printInteraction();
 	glutInit(&argc, argv);
 
 	glutInitContextVersion(4, 3);
@@ -1,8 +1,9 @@
 ///////////////////////////////////////////////////////////////////////////      
 // ballAndTorusPicking.cpp
 //
-// This program, based on ballAndTorus.cpp illustrates picking with 
-// use of the OpenGL pick matrix and selection mechanisms.
+// This program, based on ballAndTorus.cpp illustrates picking by casting
+// the ray under the cursor against a bounding volume hierarchy over the
+// triangles of each object, so that a pick needs no redraw.
 //
 // Interaction:
 // Press space to toggle between animation on and off.
@@ -14,11 +15,17 @@
 // Sumanta Guha.
 ///////////////////////////////////////////////////////////////////////////
 
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "bvh.h"
+
+#define PI 3.14159265
+
 // Globals.
 static float latAngle = 0.0; // Latitudinal angle.
 static float longAngle = 0.0; // Longitudinal angle.
@@ -26,10 +33,9 @@ static float Xangle = 0.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate scene
 static int isAnimate = 0; // Animated?
 static int animationPeriod = 100; // Time interval between frames.  
 static int highlightFrames = 10; // Number of frames to keep highlight. 10
-static int isSelecting = 0; // In selection mode?
-static int hits; // Number of entries in hit buffer.
-static unsigned int buffer[1024]; // Hit buffer.
 static unsigned int closestName = 0; // Name of closest hit.
+static Bvh torusBvh, ballBvh; // Bounding volume hierarchies of the torus and ball.
+static float torusModelViewMat[16], ballModelViewMat[16]; // Modelview matrices last drawn with.
 
 // Draw ball and torus.
 void drawBallAndTorus(void)
@@ -44,7 +50,7 @@ void drawBallAndTorus(void)
 	glRotatef(Xangle, 1.0, 0.0, 0.0);
 
 	// Fixed torus.
-	if (isSelecting) glLoadName(1); // Name of torus is 1.
+	glGetFloatv(GL_MODELVIEW_MATRIX, torusModelViewMat);
 	if ((highlightFrames > 0) && (closestName == 1)) glColor3f(1.0, 0.0, 0.0); // Highlight if selected.
 	else glColor3f(0.0, 1.0, 0.0);
 	glutWireTorus(2.0, 12.0, 20, 20);
@@ -58,14 +64,12 @@ void drawBallAndTorus(void)
 
 	glTranslatef(20.0, 0.0, 0.0);
 
-	if (isSelecting) glLoadName(2); // Name of ball is 2. 
+	glGetFloatv(GL_MODELVIEW_MATRIX, ballModelViewMat);
 	if ((highlightFrames > 0) && (closestName == 2)) glColor3f(1.0, 0.0, 0.0); // Highlight if selected. 
 	else glColor3f(0.0, 0.0, 1.0); 
 	glutWireSphere(2.0, 10, 10);
 	// End revolving ball.
 
-	if (isSelecting) glPopName(); // Clear name stack.
-
 	glutSwapBuffers();
 }
 
@@ -75,74 +79,84 @@ void drawScene(void)
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glColor3f(1.0, 1.0, 1.0);
 
-	// Draw ball and torus in rendering mode.
-	isSelecting = 0;
 	drawBallAndTorus();
 }
 
-// Process hit buffer to find record with smallest min-z value.
-void findClosestHit(int hits, unsigned int buffer[])
+// Routine to append the triangles of the surface sampled on a grid of (m + 1) x (n + 1)
+// points, 3 floats each, with point (i, j) at index j*(m + 1) + i.
+void appendGrid(std::vector<float> &triangles, const std::vector<float> &points, int m, int n)
 {
-	unsigned int *ptr, minZ;
+	std::vector<unsigned int> strip;
+	int i, j;
 
-	minZ = 0xffffffff; // 2^32 - 1
-	ptr = buffer;
-	closestName = 0;
-	for (int i = 0; i < hits; i++)
+	for (j = 0; j < n; j++)
 	{
-		ptr++;
-		if (*ptr < minZ)
+		strip.clear();
+		for (i = 0; i <= m; i++)
 		{
-			minZ = *ptr;
-			ptr += 2;
-			closestName = *ptr;
-			ptr++;
+			strip.push_back((j + 1) * (m + 1) + i);
+			strip.push_back(j * (m + 1) + i);
 		}
-		else ptr += 3;
+		appendTriangleStrip(triangles, &points[0], 3, &strip[0], strip.size());
 	}
-	if (closestName != 0) highlightFrames = 10;
+}
+
+// Routine to build the hierarchies over the torus and ball as drawn by glutWireTorus()
+// and glutWireSphere().
+void buildBvhs(void)
+{
+	std::vector<float> points, triangles;
+	float theta, phi;
+	int i, j;
+
+	// Torus of radii 2 and 12 about the z-axis, 20 sides and rings.
+	for (j = 0; j <= 20; j++)
+		for (i = 0; i <= 20; i++)
+		{
+			theta = 2.0 * PI * i / 20;
+			phi = 2.0 * PI * j / 20;
+			points.push_back((12.0 + 2.0 * cos(phi)) * cos(theta));
+			points.push_back((12.0 + 2.0 * cos(phi)) * sin(theta));
+			points.push_back(2.0 * sin(phi));
+		}
+	appendGrid(triangles, points, 20, 20);
+	buildBvh(torusBvh, triangles);
+
+	// Sphere of radius 2 about the z-axis, 10 slices and stacks.
+	points.clear();
+	triangles.clear();
+	for (j = 0; j <= 10; j++)
+		for (i = 0; i <= 10; i++)
+		{
+			theta = 2.0 * PI * i / 10;
+			phi = -PI / 2 + PI * j / 10;
+			points.push_back(2.0 * cos(phi) * cos(theta));
+			points.push_back(2.0 * cos(phi) * sin(theta));
+			points.push_back(2.0 * sin(phi));
+		}
+	appendGrid(triangles, points, 10, 10);
+	buildBvh(ballBvh, triangles);
 }
 
 // The mouse callback routine.
 void pickFunction(int button, int state, int x, int y)
 {
 	int viewport[4]; // Viewport data.
+	float projMat[16], origin[3], direction[3], t = 1.0;
 
 	if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN) return; // Don't react unless left button is pressed.
 
 	glGetIntegerv(GL_VIEWPORT, viewport); // Get viewport data.
+	glGetFloatv(GL_PROJECTION_MATRIX, projMat);
 
-	glSelectBuffer(1024, buffer); // Specify buffer to write hit records in selection mode
-	(void)glRenderMode(GL_SELECT); // Enter selection mode.
-
-	// Save the viewing volume defined in the resize routine.
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-
-	// Define a selection volume corresponding to selecting in 3 x 3 region around the cursor.
-	glLoadIdentity();
-	gluPickMatrix((float)x, (float)(viewport[3] - y), 3.0, 3.0, viewport);
-	glFrustum(-5.0, 5.0, -5.0, 5.0, 5.0, 100.0); // Copied from the reshape routine.
-
-	glMatrixMode(GL_MODELVIEW); // Return to modelview mode before drawing.
-	glLoadIdentity();
-
-	glInitNames(); // Initializes the name stack to empty.
-	glPushName(0); // Puts name 0 on top of stack.
-
-	// Determine hits by calling drawBallAndTorus() so that names are assigned.
-	isSelecting = 1;
-	drawBallAndTorus();
-
-	hits = glRenderMode(GL_RENDER); // Return to rendering mode, returning number of hits.
-
-	// Restore viewing volume of the resize routine and return to modelview mode.
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-	glMatrixMode(GL_MODELVIEW);
-
-	// Determine closest of the hit objects (if any).
-	findClosestHit(hits, buffer);
+	// Cast the ray under the cursor at each object in its own co-ordinates, keeping the
+	// nearest hit: t is shared as the ray runs from the near to the far plane for both.
+	closestName = 0;
+	if (pickRay(torusModelViewMat, projMat, viewport, x, viewport[3] - 1 - y, origin, direction) &&
+		intersectBvh(torusBvh, origin, direction, t)) closestName = 1;
+	if (pickRay(ballModelViewMat, projMat, viewport, x, viewport[3] - 1 - y, origin, direction) &&
+		intersectBvh(ballBvh, origin, direction, t)) closestName = 2;
+	if (closestName != 0) highlightFrames = 10;
 
 	glutPostRedisplay();
 }
@@ -169,6 +183,8 @@ void setup(void)
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 	glEnable(GL_DEPTH_TEST); // Enable depth testing.
 
+	buildBvhs();
+
 	glutTimerFunc(5, animate, 1);
 }
 
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#include "bvh.h"
+
+// Grow the box lo, hi to contain point p.
+static void growBox(float *lo, float *hi, const float *p)
+{
+	for (int k = 0; k < 3; k++)
+	{
+		lo[k] = std::min(lo[k], p[k]);
+		hi[k] = std::max(hi[k], p[k]);
+	}
+}
+
+// Surface area of the box lo, hi, or 0 if it is empty.
+static float boxArea(const float *lo, const float *hi)
+{
+	float d[3];
+
+	for (int k = 0; k < 3; k++)
+	{
+		d[k] = hi[k] - lo[k];
+		if (d[k] < 0.0) return 0.0;
+	}
+	return 2.0 * (d[0] * d[1] + d[1] * d[2] + d[2] * d[0]);
+}
+
+// Append the triangles of a triangle strip given by count indices into vertices, each
+// vertex stride floats apart with x, y, z first.
+void appendTriangleStrip(std::vector<float> &triangles, const float *vertices, int stride,
+	                     const unsigned int *indices, int count)
+{
+	int i, j, k;
+
+	for (i = 0; i + 2 < count; i++)
+		for (j = 0; j < 3; j++)
+			for (k = 0; k < 3; k++) triangles.push_back(vertices[indices[i + j] * stride + k]);
+}
+
+// Build the node at the given depth for triangles first to first + count - 1 of order
+// and, recursively, its children. A node is split where the surface area heuristic,
+// evaluated at BVH_BINS equal bins of triangle centroids along the widest axis, is least,
+// or made a leaf if no split is cheaper or it is at BVH_MAX_DEPTH, however many triangles
+// it has.
+static void buildNode(Bvh &bvh, const std::vector<float> &triangles, const std::vector<float> &centroids,
+	                  std::vector<int> &order, int first, int count, int depth)
+{
+	BvhNode node;
+	float cLo[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, cHi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	float binLo[BVH_BINS][3], binHi[BVH_BINS][3], lo[3], hi[3], leftArea[BVH_BINS];
+	int binCount[BVH_BINS], leftCount[BVH_BINS];
+	float cost, bestCost, scale, extent;
+	int axis, bin, bestBin, i, j, k, self, mid;
+
+	for (k = 0; k < 3; k++)
+	{
+		node.boxMin[k] = FLT_MAX;
+		node.boxMax[k] = -FLT_MAX;
+	}
+	for (i = first; i < first + count; i++)
+	{
+		for (j = 0; j < 3; j++) growBox(node.boxMin, node.boxMax, &triangles[9 * order[i] + 3 * j]);
+		growBox(cLo, cHi, &centroids[3 * order[i]]);
+	}
+	self = bvh.nodes.size();
+	node.count = count;
+	node.rightOrFirst = first;
+	bvh.nodes.push_back(node);
+	if (count <= BVH_LEAF_SIZE || depth == BVH_MAX_DEPTH) return;
+
+	axis = 0;
+	for (k = 1; k < 3; k++) if (cHi[k] - cLo[k] > cHi[axis] - cLo[axis]) axis = k;
+	extent = cHi[axis] - cLo[axis];
+	if (extent <= 0.0) return;
+
+	// Bin the centroids.
+	scale = BVH_BINS / extent;
+	for (bin = 0; bin < BVH_BINS; bin++)
+	{
+		binCount[bin] = 0;
+		for (k = 0; k < 3; k++)
+		{
+			binLo[bin][k] = FLT_MAX;
+			binHi[bin][k] = -FLT_MAX;
+		}
+	}
+	for (i = first; i < first + count; i++)
+	{
+		bin = std::min((int)((centroids[3 * order[i] + axis] - cLo[axis]) * scale), BVH_BINS - 1);
+		binCount[bin]++;
+		for (j = 0; j < 3; j++) growBox(binLo[bin], binHi[bin], &triangles[9 * order[i] + 3 * j]);
+	}
+
+	// Sweep from the left, then from the right, costing the split after each bin.
+	for (k = 0; k < 3; k++) { lo[k] = FLT_MAX; hi[k] = -FLT_MAX; }
+	for (bin = 0, j = 0; bin < BVH_BINS - 1; bin++)
+	{
+		j += binCount[bin];
+		growBox(lo, hi, binLo[bin]);
+		growBox(lo, hi, binHi[bin]);
+		leftCount[bin] = j;
+		leftArea[bin] = boxArea(lo, hi);
+	}
+	for (k = 0; k < 3; k++) { lo[k] = FLT_MAX; hi[k] = -FLT_MAX; }
+	bestCost = count * boxArea(node.boxMin, node.boxMax);
+	bestBin = -1;
+	for (bin = BVH_BINS - 1; bin > 0; bin--)
+	{
+		growBox(lo, hi, binLo[bin]);
+		growBox(lo, hi, binHi[bin]);
+		if (leftCount[bin - 1] == 0 || leftCount[bin - 1] == count) continue;
+		cost = leftCount[bin - 1] * leftArea[bin - 1] + (count - leftCount[bin - 1]) * boxArea(lo, hi);
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestBin = bin - 1;
+		}
+	}
+	if (bestBin < 0 && count <= 4 * BVH_LEAF_SIZE) return;
+
+	// Partition about the chosen bin, or about the middle of the centroids when the
+	// heuristic finds no split cheaper than a leaf but the leaf would be too large.
+	if (bestBin < 0) bestBin = BVH_BINS / 2 - 1;
+	i = first;
+	j = first + count - 1;
+	while (i <= j)
+	{
+		bin = std::min((int)((centroids[3 * order[i] + axis] - cLo[axis]) * scale), BVH_BINS - 1);
+		if (bin <= bestBin) i++;
+		else std::swap(order[i], order[j--]);
+	}
+	mid = i;
+	if (mid == first || mid == first + count) mid = first + count / 2;
+
+	bvh.nodes[self].count = 0;
+	buildNode(bvh, triangles, centroids, order, first, mid - first, depth + 1);
+	bvh.nodes[self].rightOrFirst = bvh.nodes.size();
+	buildNode(bvh, triangles, centroids, order, mid, first + count - mid, depth + 1);
+}
+
+// Build the hierarchy over triangles, 9 floats per triangle.
+void buildBvh(Bvh &bvh, const std::vector<float> &triangles)
+{
+	int numTriangles = triangles.size() / 9, i, k;
+	std::vector<float> centroids(3 * numTriangles);
+	std::vector<int> order(numTriangles);
+
+	for (i = 0; i < numTriangles; i++)
+	{
+		order[i] = i;
+		for (k = 0; k < 3; k++)
+			centroids[3 * i + k] = (triangles[9 * i + k] + triangles[9 * i + 3 + k] + triangles[9 * i + 6 + k]) / 3.0;
+	}
+
+	bvh.nodes.clear();
+	bvh.nodes.reserve(2 * numTriangles / BVH_LEAF_SIZE + 1);
+	if (numTriangles > 0) buildNode(bvh, triangles, centroids, order, 0, numTriangles, 0);
+
+	// Store the triangles in leaf order.
+	bvh.triangles.resize(triangles.size());
+	for (i = 0; i < numTriangles; i++)
+		std::copy(&triangles[9 * order[i]], &triangles[9 * order[i]] + 9, &bvh.triangles[9 * i]);
+}
+
+// Parameter value where the ray enters the box if before tMax, else FLT_MAX.
+static float intersectBox(const BvhNode &node, const float *origin, const float *inverse, float tMax)
+{
+	float tNear = 0.0, tFar = tMax, t0, t1;
+
+	for (int k = 0; k < 3; k++)
+	{
+		t0 = (node.boxMin[k] - origin[k]) * inverse[k];
+		t1 = (node.boxMax[k] - origin[k]) * inverse[k];
+		if (t0 > t1) std::swap(t0, t1);
+		tNear = std::max(tNear, t0);
+		tFar = std::min(tFar, t1);
+	}
+	return (tNear <= tFar) ? tNear : FLT_MAX;
+}
+
+// Moller-Trumbore intersection of the ray with triangle tri, returning the parameter
+// value of the hit, or FLT_MAX if none.
+static float intersectTriangle(const float *tri, const float *origin, const float *direction)
+{
+	float e1[3], e2[3], p[3], s[3], q[3], det, u, v;
+	int k;
+
+	for (k = 0; k < 3; k++)
+	{
+		e1[k] = tri[3 + k] - tri[k];
+		e2[k] = tri[6 + k] - tri[k];
+		s[k] = origin[k] - tri[k];
+	}
+	p[0] = direction[1] * e2[2] - direction[2] * e2[1];
+	p[1] = direction[2] * e2[0] - direction[0] * e2[2];
+	p[2] = direction[0] * e2[1] - direction[1] * e2[0];
+	det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+	if (fabs(det) < 1.0e-12) return FLT_MAX;
+
+	u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / det;
+	if (u < 0.0 || u > 1.0) return FLT_MAX;
+	q[0] = s[1] * e1[2] - s[2] * e1[1];
+	q[1] = s[2] * e1[0] - s[0] * e1[2];
+	q[2] = s[0] * e1[1] - s[1] * e1[0];
+	v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) / det;
+	if (v < 0.0 || u + v > 1.0) return FLT_MAX;
+	return (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+}
+
+// Cast the ray origin + t*direction, t >= 0, against the hierarchy. If it hits a triangle
+// before the given t, set t to the nearest hit and return true. Nearer children are
+// visited first, and subtrees whose boxes the ray enters after the nearest hit so far
+// are skipped. Each node popped pushes at most its two children, so the stack holds at 
+// most one node more than the depth of the hierarchy.
+bool intersectBvh(const Bvh &bvh, const float *origin, const float *direction, float &t)
+{
+	int stack[BVH_MAX_DEPTH + 1], top = 0, near, far, i, k;
+	float inverse[3], tHit, tNear, tFar;
+	bool hit = false;
+
+	if (bvh.nodes.empty()) return false;
+	for (k = 0; k < 3; k++) inverse[k] = 1.0 / direction[k];
+	if (intersectBox(bvh.nodes[0], origin, inverse, t) == FLT_MAX) return false;
+
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const BvhNode &n = bvh.nodes[stack[--top]];
+		if (n.count > 0)
+		{
+			for (i = n.rightOrFirst; i < n.rightOrFirst + n.count; i++)
+			{
+				tHit = intersectTriangle(&bvh.triangles[9 * i], origin, direction);
+				if (tHit >= 0.0 && tHit < t)
+				{
+					t = tHit;
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		near = &n - &bvh.nodes[0] + 1;
+		far = n.rightOrFirst;
+		tNear = intersectBox(bvh.nodes[near], origin, inverse, t);
+		tFar = intersectBox(bvh.nodes[far], origin, inverse, t);
+		if (tFar < tNear)
+		{
+			std::swap(near, far);
+			std::swap(tNear, tFar);
+		}
+		assert(top + 2 <= BVH_MAX_DEPTH + 1);
+		if (tFar != FLT_MAX) stack[top++] = far;
+		if (tNear != FLT_MAX) stack[top++] = near;
+	}
+	return hit;
+}
+
+// Invert the column-major 4x4 matrix m into inv, returning false if it is singular.
+static bool invertMatrix(const float *m, float *inv)
+{
+	float det;
+	int i;
+
+	inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+	if (det == 0.0) return false;
+	for (i = 0; i < 16; i++) inv[i] /= det;
+	return true;
+}
+
+// Unproject the centre of pixel x, y, counted from the bottom left of the viewport, on
+// the near and far planes through the inverse of projMat * modelViewMat, both
+// column-major, giving the ray in the co-ordinates the modelview matrix acts on. The
+// ray starts on the near plane and reaches the far plane at t = 1, so that t compares
+// across objects picked with the same projection.
+bool pickRay(const float *modelViewMat, const float *projMat, const int *viewport, int x, int y,
+	         float *origin, float *direction)
+{
+	float m[16], inv[16], ndc[2], p[2][4];
+	int i, j, k;
+
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < 4; j++)
+		{
+			m[4 * j + i] = 0.0;
+			for (k = 0; k < 4; k++) m[4 * j + i] += projMat[4 * k + i] * modelViewMat[4 * j + k];
+		}
+	if (!invertMatrix(m, inv)) return false;
+
+	ndc[0] = 2.0 * (x + 0.5 - viewport[0]) / viewport[2] - 1.0;
+	ndc[1] = 2.0 * (y + 0.5 - viewport[1]) / viewport[3] - 1.0;
+	for (j = 0; j < 2; j++)
+		for (i = 0; i < 4; i++)
+			p[j][i] = inv[i] * ndc[0] + inv[4 + i] * ndc[1] + inv[8 + i] * (2.0 * j - 1.0) + inv[12 + i];
+	for (i = 0; i < 3; i++)
+	{
+		origin[i] = p[0][i] / p[0][3];
+		direction[i] = p[1][i] / p[1][3] - origin[i];
+	}
+	return true;
+}
@@ -0,0 +1,36 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+
+#define BVH_LEAF_SIZE 4 // Most triangles in a leaf.
+#define BVH_BINS 12 // Number of bins to choose a split from.
+#define BVH_MAX_DEPTH 48 // Deepest a node may be, the root being at depth 0, so that a
+                         // traversal needs a stack of at most BVH_MAX_DEPTH + 1 nodes.
+
+// Node of a bounding volume hierarchy. The left child of an interior node follows it in
+// the node array and the index of its right child is stored.
+struct BvhNode
+{
+	float boxMin[3], boxMax[3]; // Bounding box.
+	int rightOrFirst; // Right child if interior, first triangle if leaf.
+	int count; // Number of triangles if leaf, 0 if interior.
+};
+
+// Bounding volume hierarchy over a triangle mesh, built once in the mesh's own
+// co-ordinates. Rays are cast in those co-ordinates too, so a moving object needs
+// only its ray transformed, never the hierarchy rebuilt.
+struct Bvh
+{
+	std::vector<float> triangles; // 9 floats per triangle, reordered to match the leaves.
+	std::vector<BvhNode> nodes; // Depth-first, the root first.
+};
+
+void appendTriangleStrip(std::vector<float> &triangles, const float *vertices, int stride,
+	                     const unsigned int *indices, int count);
+void buildBvh(Bvh &bvh, const std::vector<float> &triangles);
+bool intersectBvh(const Bvh &bvh, const float *origin, const float *direction, float &t);
+bool pickRay(const float *modelViewMat, const float *projMat, const int *viewport, int x, int y,
+	         float *origin, float *direction);
+
+#endif
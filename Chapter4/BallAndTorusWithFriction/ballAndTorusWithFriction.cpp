@@ -4,6 +4,12 @@
 // This program modifies ballAndTorus.cpp to simulate the motion of
 // the ball in a viscous medium subject to an accelarating force.
 //
+// The distance the ball has travelled along its path is the x co-ordinate of a body 
+// of a physics world, pushed by the applied force and slowed by drag, stepped at a 
+// fixed rate however often frames are drawn and interpolated between steps for 
+// drawing. Time is measured in units of animationPeriod milliseconds, as the original 
+// timer ticks were.
+//
 // Interaction:
 // Keep space key pressed to apply force to the ball. Release to stop application.
 // Press up/down arrow keys to increase/decrease the applied force.
@@ -13,22 +19,28 @@
 // Sumanta Guha.
 ////////////////////////////////////////////////////////////////////  
 
+#include <cmath>
 #include <iostream>
 #include <fstream>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "physics.h"
+
+#define FRAME_PERIOD 16 // Time interval between frames in milliseconds.
+#define TIME_STEP 0.1 // Physics time step.
+
 // Globals.
 static float latAngle = 0.0; // Latitudinal angle.
 static float longAngle = 0.0; // Longitudinal angle.
 static float Xangle = 0.0, Yangle = 0.0, Zangle = 0.0; // Angles to rotate scene.
-static int animationPeriod = 100; // Time interval between frames.
-static float velocity = 0.0; // Velocity of ball.
+static int animationPeriod = 100; // Milliseconds per unit of time.
 static float drag = 0.005; // Drag co-efficient.
 static float applied_acceleration = 0.02; // Acceleration (force) applied when up key is pressed.
-float acceleration = 0.0; // Acceleration of ball.
-static int isForce = 0; // Force being applied (= up key pressed)?
+static int lastTime; // Time the last frame was drawn in milliseconds.
+static PhysicsWorld world(TIME_STEP); // Physics world.
+static int ball; // Body whose x co-ordinate is the distance travelled by the ball.
 static char theStringBuffer[10]; // String buffer.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
 
@@ -71,6 +83,12 @@ void drawScene(void)
 
 	writeData();
 
+	// The angles are proportional to the distance travelled.
+	float distance, y, z;
+	world.getPosition(ball, distance, y, z);
+	latAngle = fmod(5.0 * distance, 360.0);
+	longAngle = fmod(1.0 * distance, 360.0);
+
 	glTranslatef(0.0, 0.0, -25.0);
 
 	// Rotate scene.
@@ -101,25 +119,13 @@ void drawScene(void)
 // Timer function.
 void animate(int value)
 {
-	if (isForce)
-	{
-		acceleration = applied_acceleration - drag*velocity; // Acceleration from force applied minus frictional
-							                                 // deceleration proportional to velocity.
-		isForce = 0; // Set force to 0 - this makes it necessary to keep pressing the up key in order 
-			         // to continue applying force.	  
-	}
-	else
-		acceleration = -drag*velocity; // Only frictional deceleration proportional to velocity.
-
-	velocity += acceleration; // Euler's method: change in velocity in unit time = acceleration.
-
-	latAngle += 5.0 * velocity; // Change in latAngle is proportional to velocity.
-	if (latAngle > 360.0) latAngle -= 360.0;
-	longAngle += 1.0 * velocity; // Change in longAngle is proportional to velocity.
-	if (longAngle > 360.0) longAngle -= 360.0;
+	// Advance the world by the time since the last frame.
+	int time = glutGet(GLUT_ELAPSED_TIME);
+	world.advance((float)(time - lastTime) / animationPeriod);
+	lastTime = time;
 
 	glutPostRedisplay();
-	glutTimerFunc(animationPeriod, animate, 1);
+	glutTimerFunc(FRAME_PERIOD, animate, 1);
 }
 
 // Initialization routine.
@@ -128,6 +134,11 @@ void setup(void)
 	glClearColor(1.0, 1.0, 1.0, 0.0);
 	glEnable(GL_DEPTH_TEST); // Enable depth testing.
 
+	// Frictional deceleration proportional to velocity.
+	world.setDrag(drag);
+	ball = world.addBody(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0);
+
+	lastTime = glutGet(GLUT_ELAPSED_TIME);
 	glutTimerFunc(5, animate, 1);
 }
 
@@ -151,7 +162,9 @@ void keyInput(unsigned char key, int x, int y)
 		exit(0);
 		break;
 	case ' ':
-		isForce = 1;
+		// Apply force for one unit of time - this makes it necessary to keep pressing the 
+		// key in order to continue applying force.
+		world.setAcceleration(ball, applied_acceleration, 0.0, 0.0, 1.0);
 		glutPostRedisplay();
 		break;
 	case 'x':
@@ -196,6 +209,7 @@ void specialKeyInput(int key, int x, int y)
 	if (key == GLUT_KEY_DOWN) if (applied_acceleration > 0.01) applied_acceleration -= 0.005;
 	if (key == GLUT_KEY_PAGE_UP) drag += 0.0005;
 	if (key == GLUT_KEY_PAGE_DOWN) if (drag > 0.001) drag -= 0.0005;
+	world.setDrag(drag);
 
 	glutPostRedisplay();
 }
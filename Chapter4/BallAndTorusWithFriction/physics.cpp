@@ -0,0 +1,475 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// physics.cpp
+//
+// A fixed-timestep physics world of spherical bodies colliding with planes, tori 
+// and one another.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "physics.h"
+
+#define CORRECTION 0.8 // Fraction of a penetration corrected in a pass.
+#define SLOP 0.005 // Penetration left uncorrected, so that resting contacts stay in touch.
+#define RESTING_SPEED 1.0 // Closing speed below which a contact does not bounce.
+#define PAIR_VALUES 8 // Values stored per pair by resolvePairs().
+
+// PhysicsWorld constructor.
+PhysicsWorld::PhysicsWorld(float timeStep, JobSystem *jobs)
+{
+	this->timeStep = timeStep;
+	this->jobs = jobs;
+	accumulator = 0.0;
+	gravity[0] = gravity[1] = gravity[2] = 0.0;
+	drag = 0.0;
+	restitution = 1.0;
+}
+
+// Add a body, returning its index. A mass of 0 makes the body immovable by collisions.
+int PhysicsWorld::addBody(float x, float y, float z, float vx, float vy, float vz, float radius, float mass)
+{
+	this->x.push_back(x); this->y.push_back(y); this->z.push_back(z);
+	prevX.push_back(x); prevY.push_back(y); prevZ.push_back(z);
+	this->vx.push_back(vx); this->vy.push_back(vy); this->vz.push_back(vz);
+	ax.push_back(0.0); ay.push_back(0.0); az.push_back(0.0);
+	accelSteps.push_back(-1);
+	this->radius.push_back(radius);
+	invMass.push_back(mass > 0.0 ? 1.0 / mass : 0.0);
+	order.clear(); // Sort afresh.
+	return this->x.size() - 1;
+}
+
+// Add a plane n.p = d, normalizing n.
+void PhysicsWorld::addPlane(float nx, float ny, float nz, float d)
+{
+	float length = sqrt(nx*nx + ny*ny + nz*nz);
+	PhysicsPlane plane = { nx / length, ny / length, nz / length, d / length };
+	planes.push_back(plane);
+}
+
+// Add a torus about an axis parallel to the z-axis.
+void PhysicsWorld::addTorus(float cx, float cy, float cz, float inRad, float outRad)
+{
+	PhysicsTorus torus = { cx, cy, cz, inRad, outRad };
+	tori.push_back(torus);
+}
+
+// Apply an acceleration to a body for a duration, rounded to whole steps, or forever if 
+// the duration is negative.
+void PhysicsWorld::setAcceleration(int body, float ax, float ay, float az, float duration)
+{
+	this->ax[body] = ax; this->ay[body] = ay; this->az[body] = az;
+	accelSteps[body] = duration < 0.0 ? -1 : (int)(duration / timeStep + 0.5);
+}
+
+// Move a body, with no interpolation from its old position.
+void PhysicsWorld::setPosition(int body, float x, float y, float z)
+{
+	this->x[body] = prevX[body] = x;
+	this->y[body] = prevY[body] = y;
+	this->z[body] = prevZ[body] = z;
+}
+
+// Set a body's velocity.
+void PhysicsWorld::setVelocity(int body, float vx, float vy, float vz)
+{
+	this->vx[body] = vx; this->vy[body] = vy; this->vz[body] = vz;
+}
+
+// Run job(0), ..., job(count - 1), on the job system if there is one.
+void PhysicsWorld::parallelFor(int count, const std::function<void(int)> &job)
+{
+	if (jobs) jobs->parallelFor(count, job);
+	else for (int i = 0; i < count; i++) job(i);
+}
+
+// Add frameTime to the time not yet simulated and take the steps due, at most 
+// PHYSICS_MAX_STEPS, dropping the rest of the time if there are more.
+int PhysicsWorld::advance(float frameTime)
+{
+	int steps = 0;
+
+	accumulator += frameTime;
+	while (accumulator >= timeStep && steps < PHYSICS_MAX_STEPS)
+	{
+		step();
+		accumulator -= timeStep;
+		steps++;
+	}
+	if (accumulator >= timeStep) accumulator = fmod(accumulator, timeStep);
+	return steps;
+}
+
+// Take one step.
+void PhysicsWorld::step()
+{
+	int numChunks = (x.size() + PHYSICS_CHUNK - 1) / PHYSICS_CHUNK;
+
+	// Move the bodies and keep them off the planes and tori.
+	parallelFor(numChunks, [&](int chunk)
+	{
+		int first = chunk * PHYSICS_CHUNK, last = std::min((int)x.size(), first + PHYSICS_CHUNK);
+		integrate(first, last);
+		collideStatic(first, last);
+	});
+
+	// Then off one another.
+	findPairs();
+	resolvePairs();
+}
+
+// Semi-implicit Euler step of bodies first to last - 1.
+void PhysicsWorld::integrate(int first, int last)
+{
+	int i;
+	float dt = timeStep;
+
+	for (i = first; i < last; i++)
+	{
+		prevX[i] = x[i]; prevY[i] = y[i]; prevZ[i] = z[i];
+		if (invMass[i] == 0.0) continue;
+
+		vx[i] += (gravity[0] + ax[i] - drag * vx[i]) * dt;
+		vy[i] += (gravity[1] + ay[i] - drag * vy[i]) * dt;
+		vz[i] += (gravity[2] + az[i] - drag * vz[i]) * dt;
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+		z[i] += vz[i] * dt;
+
+		if (accelSteps[i] > 0 && --accelSteps[i] == 0) ax[i] = ay[i] = az[i] = 0.0;
+	}
+}
+
+// Push bodies first to last - 1 out of the planes and tori, reflecting the part of their
+// velocity into them scaled by the restitution, or only stopping it if slow.
+void PhysicsWorld::collideStatic(int first, int last)
+{
+	int i;
+	float nx, ny, nz, dist, depth, vn, bounce, qx, qy, rho;
+
+	for (i = first; i < last; i++)
+	{
+		if (invMass[i] == 0.0) continue;
+
+		for (auto &plane : planes)
+		{
+			depth = radius[i] - (plane.nx * x[i] + plane.ny * y[i] + plane.nz * z[i] - plane.d);
+			if (depth < 0.0) continue;
+			x[i] += depth * plane.nx; y[i] += depth * plane.ny; z[i] += depth * plane.nz;
+			vn = plane.nx * vx[i] + plane.ny * vy[i] + plane.nz * vz[i];
+			if (vn < 0.0)
+			{
+				bounce = vn < -RESTING_SPEED ? restitution : 0.0;
+				vx[i] -= (1.0 + bounce) * vn * plane.nx;
+				vy[i] -= (1.0 + bounce) * vn * plane.ny;
+				vz[i] -= (1.0 + bounce) * vn * plane.nz;
+			}
+		}
+
+		for (auto &torus : tori)
+		{
+			// Nearest point of the tube's center circle.
+			qx = x[i] - torus.cx; qy = y[i] - torus.cy;
+			rho = sqrt(qx*qx + qy*qy);
+			if (rho > 0.0) { qx *= torus.outRad / rho; qy *= torus.outRad / rho; }
+			else { qx = torus.outRad; qy = 0.0; }
+
+			nx = x[i] - torus.cx - qx; ny = y[i] - torus.cy - qy; nz = z[i] - torus.cz;
+			dist = sqrt(nx*nx + ny*ny + nz*nz);
+			depth = torus.inRad + radius[i] - dist;
+			if (depth < 0.0 || dist == 0.0) continue;
+			nx /= dist; ny /= dist; nz /= dist;
+			x[i] += depth * nx; y[i] += depth * ny; z[i] += depth * nz;
+			vn = nx * vx[i] + ny * vy[i] + nz * vz[i];
+			if (vn < 0.0)
+			{
+				bounce = vn < -RESTING_SPEED ? restitution : 0.0;
+				vx[i] -= (1.0 + bounce) * vn * nx;
+				vy[i] -= (1.0 + bounce) * vn * ny;
+				vz[i] -= (1.0 + bounce) * vn * nz;
+			}
+		}
+	}
+}
+
+// Sweep and prune along x, in columns: the bodies are sorted by the cell of a grid in y 
+// and z holding their centers and, within a cell, by the low end of their x extent, so 
+// that each cell's bodies form a run in x order. Then each body's extent is swept for the 
+// bodies starting within it in its own cell after it and in the four neighbouring cells 
+// after its own (the other four sweep toward it), testing their spheres. Spheres within 
+// SLOP of touching are paired too, so that a resting contact corrected to its slop keeps 
+// its pair and the impulse carried with it. The cells are at least a diameter and SLOP 
+// wide, so that no such pair is missed, and keep a sweep from passing every body in the 
+// same slab of x.
+//
+// The sort is an insertion sort of last step's order, which the bodies' coherence makes 
+// nearly linear, and ties are broken by index so that the order is unique. Jobs sweep 
+// runs of the order into lists of their own, joined in order.
+void PhysicsWorld::findPairs()
+{
+	const long long neighbours[4] = { 1, (1LL << 32) - 1, 1LL << 32, (1LL << 32) + 1 }; // (y, z) + (0, 1), 
+	                                                                                    // (1, -1), (1, 0), (1, 1).
+	int n = x.size(), i, j, k, numChunks = (n + PHYSICS_CHUNK - 1) / PHYSICS_CHUNK;
+	float maxRadius = 0.0, cellSize;
+
+	for (i = 0; i < n; i++) maxRadius = std::max(maxRadius, radius[i]);
+	cellSize = std::max(2.0f * maxRadius + (float)SLOP, 1e-6f);
+
+	cellKey.resize(n);
+	for (i = 0; i < n; i++)
+		cellKey[i] = ((long long)floor(y[i] / cellSize) << 32) + (long long)floor(z[i] / cellSize);
+
+	auto precedes = [&](int a, int b)
+	{
+		if (cellKey[a] != cellKey[b]) return cellKey[a] < cellKey[b];
+		float minA = x[a] - radius[a], minB = x[b] - radius[b];
+		return minA < minB || (minA == minB && a < b);
+	};
+
+	if ((int)order.size() != n)
+	{
+		order.resize(n);
+		for (i = 0; i < n; i++) order[i] = i;
+		std::sort(order.begin(), order.end(), precedes);
+	}
+	else
+		for (i = 1; i < n; i++)
+		{
+			k = order[i];
+			for (j = i - 1; j >= 0 && precedes(k, order[j]); j--) order[j + 1] = order[j];
+			order[j + 1] = k;
+		}
+
+	// Positions, radii and low ends in order, so that the sweeps read memory in order, the cells with the start of each one's run, and each cell's 
+	// neighbours after it, -1 where empty.
+	sorted.resize(4 * n);
+	sortedMinX.resize(n);
+	sortedCell.resize(n);
+	cells.clear(); cellStart.clear();
+	for (i = 0; i < n; i++)
+	{
+		k = order[i];
+		sorted[4 * i] = x[k]; sorted[4 * i + 1] = y[k]; sorted[4 * i + 2] = z[k]; sorted[4 * i + 3] = radius[k];
+		sortedMinX[i] = x[k] - radius[k];
+		if (i == 0 || cellKey[order[i]] != cells.back())
+		{
+			cells.push_back(cellKey[order[i]]);
+			cellStart.push_back(i);
+		}
+		sortedCell[i] = cells.size() - 1;
+	}
+	cellStart.push_back(n);
+
+	cellNeighbours.resize(4 * cells.size());
+	for (i = 0; i < (int)cells.size(); i++)
+		for (k = 0; k < 4; k++)
+		{
+			long long key = cells[i] + neighbours[k];
+			j = std::lower_bound(cells.begin() + i, cells.end(), key) - cells.begin();
+			cellNeighbours[4 * i + k] = (j < (int)cells.size() && cells[j] == key) ? j : -1;
+		}
+
+	chunkPairs.resize(numChunks);
+	parallelFor(numChunks, [&](int chunk)
+	{
+		int first = chunk * PHYSICS_CHUNK, last = std::min(n, first + PHYSICS_CHUNK), s, t, c, k, end;
+		int cursor[4], cursorEnd[4];
+		float maxX, dx, dy, dz, r;
+		const float *p, *q;
+		std::vector<PhysicsPair> &found = chunkPairs[chunk];
+
+		auto test = [&](int s, int t)
+		{
+			p = &sorted[4 * s]; q = &sorted[4 * t];
+			dx = q[0] - p[0]; dy = q[1] - p[1]; dz = q[2] - p[2];
+			r = p[3] + q[3] + SLOP;
+			if (dx*dx + dy*dy + dz*dz < r*r)
+			{
+				PhysicsPair pair = { order[s], order[t] };
+				found.push_back(pair);
+			}
+		};
+
+		found.clear();
+		for (s = first; s < last; s++)
+		{
+			maxX = sorted[4 * s] + sorted[4 * s + 3] + SLOP;
+
+			// Own cell, after the body.
+			for (t = s + 1, end = cellStart[sortedCell[s] + 1]; t < end && sortedMinX[t] <= maxX; t++)
+				test(s, t);
+
+			// Neighbouring cells, from the first body that may reach back to this one's low end.
+			// Moving on through a cell, that body only moves on, so a cursor per neighbour 
+			// merges the runs.
+			if (s == first || sortedCell[s] != sortedCell[s - 1])
+				for (k = 0; k < 4; k++)
+				{
+					c = cellNeighbours[4 * sortedCell[s] + k];
+					cursor[k] = c < 0 ? 0 : cellStart[c];
+					cursorEnd[k] = c < 0 ? 0 : cellStart[c + 1];
+				}
+			for (k = 0; k < 4; k++)
+			{
+				while (cursor[k] < cursorEnd[k] && sortedMinX[cursor[k]] < sortedMinX[s] - 2.0f * maxRadius - SLOP) cursor[k]++;
+				for (t = cursor[k]; t < cursorEnd[k] && sortedMinX[t] <= maxX; t++) test(s, t);
+			}
+		}
+	});
+
+	pairs.clear();
+	for (auto &found : chunkPairs) pairs.insert(pairs.end(), found.begin(), found.end());
+}
+
+// Resolve the pairs Jacobi-style, in PHYSICS_ITERATIONS passes: in each, compute each 
+// pair's change of impulse and position correction from the state before any is applied, 
+// then have each body sum those of its pairs in pair order and push itself off the planes 
+// and tori again. The changes are divided by the larger number of pairs of the two bodies, 
+// so that a body in many contacts is not pushed by all of them at full strength at once, 
+// and the pair's impulse as a whole never pulls the bodies together.
+//
+// A pass only carries an impulse one pair further through a stack, so each pair starts 
+// with the impulse it ended the last step with, if it was paired then too. Without this 
+// a stack keeps the velocity that the passes of a step did not take out, sinking and 
+// jittering instead of coming to rest.
+void PhysicsWorld::resolvePairs()
+{
+	int n = x.size(), numPairs = pairs.size(), i, iteration;
+
+	if (numPairs == 0)
+	{
+		lastPairs.clear(); lastContactStart.clear(); lastContacts.clear(); lastPairImpulse.clear();
+		return;
+	}
+
+	// List each body's pairs, in pair order.
+	contactStart.assign(n + 1, 0);
+	for (auto &pair : pairs) { contactStart[pair.a + 1]++; contactStart[pair.b + 1]++; }
+	for (i = 0; i < n; i++) contactStart[i + 1] += contactStart[i];
+	contacts.resize(2 * numPairs);
+	{
+		std::vector<int> fill(contactStart.begin(), contactStart.end() - 1);
+		for (i = 0; i < numPairs; i++)
+		{
+			contacts[fill[pairs[i].a]++] = 2 * i;
+			contacts[fill[pairs[i].b]++] = 2 * i + 1;
+		}
+	}
+
+	// Each pair's normal, the speed it bounces apart at, the share of a change applied, and 
+	// the impulse carried from the last step, found among the last pairs of its first body 
+	// and applied in the first pass.
+	pairImpulse.resize(numPairs * PAIR_VALUES);
+	parallelFor((numPairs + PHYSICS_CHUNK - 1) / PHYSICS_CHUNK, [&](int chunk)
+	{
+		int first = chunk * PHYSICS_CHUNK, last = std::min(numPairs, first + PHYSICS_CHUNK), p, q, a, b, c;
+		float nx, ny, nz, dist, vn, *values;
+
+		for (p = first; p < last; p++)
+		{
+			a = pairs[p].a; b = pairs[p].b;
+			values = &pairImpulse[p * PAIR_VALUES];
+			nx = x[b] - x[a]; ny = y[b] - y[a]; nz = z[b] - z[a];
+			dist = sqrt(nx*nx + ny*ny + nz*nz);
+			if (dist > 0.0) { nx /= dist; ny /= dist; nz /= dist; }
+			else { nx = 1.0; ny = nz = 0.0; }
+			vn = (vx[b] - vx[a]) * nx + (vy[b] - vy[a]) * ny + (vz[b] - vz[a]) * nz;
+
+			values[0] = nx; values[1] = ny; values[2] = nz;
+			values[3] = vn < -RESTING_SPEED ? -restitution * vn : 0.0;
+			values[4] = 1.0f / std::max(contactStart[a + 1] - contactStart[a], contactStart[b + 1] - contactStart[b]);
+			values[5] = values[6] = values[7] = 0.0;
+			if (a + 1 < (int)lastContactStart.size())
+				for (c = lastContactStart[a]; c < lastContactStart[a + 1]; c++)
+				{
+					q = lastContacts[c] / 2;
+					if (lastPairs[q].a + lastPairs[q].b == a + b) { values[5] = values[6] = lastPairImpulse[q]; break; }
+				}
+		}
+	});
+
+	for (iteration = 0; iteration <= PHYSICS_ITERATIONS; iteration++)
+	{
+		// Then each pair's change of impulse and its correction.
+		if (iteration > 0)
+			parallelFor((numPairs + PHYSICS_CHUNK - 1) / PHYSICS_CHUNK, [&](int chunk)
+			{
+				int first = chunk * PHYSICS_CHUNK, last = std::min(numPairs, first + PHYSICS_CHUNK), p, a, b;
+				float nx, ny, nz, dist, depth, invSum, vn, impulse, *values;
+
+				for (p = first; p < last; p++)
+				{
+					a = pairs[p].a; b = pairs[p].b;
+					values = &pairImpulse[p * PAIR_VALUES];
+					invSum = invMass[a] + invMass[b];
+					if (invSum == 0.0) { values[6] = values[7] = 0.0; continue; }
+					nx = values[0]; ny = values[1]; nz = values[2];
+
+					vn = (vx[b] - vx[a]) * nx + (vy[b] - vy[a]) * ny + (vz[b] - vz[a]) * nz;
+					impulse = std::max(values[5] + values[4] * (values[3] - vn) / invSum, 0.0f);
+					values[6] = impulse - values[5];
+					values[5] = impulse;
+
+					nx = x[b] - x[a]; ny = y[b] - y[a]; nz = z[b] - z[a];
+					dist = sqrt(nx*nx + ny*ny + nz*nz);
+					depth = radius[a] + radius[b] - dist - SLOP;
+					values[7] = depth > 0.0 ? values[4] * CORRECTION * depth / invSum : 0.0;
+				}
+			});
+
+		parallelFor((n + PHYSICS_CHUNK - 1) / PHYSICS_CHUNK, [&](int chunk)
+		{
+			int first = chunk * PHYSICS_CHUNK, last = std::min(n, first + PHYSICS_CHUNK), b, c;
+			float sign, *values;
+
+			for (b = first; b < last; b++)
+			{
+				if (invMass[b] == 0.0) continue;
+				for (c = contactStart[b]; c < contactStart[b + 1]; c++)
+				{
+					values = &pairImpulse[(contacts[c] / 2) * PAIR_VALUES];
+					sign = (contacts[c] & 1) ? invMass[b] : -invMass[b]; // The second body is pushed along the normal.
+					vx[b] += sign * values[6] * values[0];
+					vy[b] += sign * values[6] * values[1];
+					vz[b] += sign * values[6] * values[2];
+					x[b] += sign * values[7] * values[0];
+					y[b] += sign * values[7] * values[1];
+					z[b] += sign * values[7] * values[2];
+				}
+			}
+			collideStatic(first, last);
+		});
+	}
+
+	// Keep the pairs and their impulses for the next step.
+	lastPairs = pairs;
+	lastContactStart = contactStart;
+	lastContacts = contacts;
+	lastPairImpulse.resize(numPairs);
+	for (i = 0; i < numPairs; i++) lastPairImpulse[i] = pairImpulse[i * PAIR_VALUES + 5];
+}
+
+// Position of a body interpolated between the last two steps by the fraction of a step left over.
+void PhysicsWorld::getPosition(int body, float &x, float &y, float &z)
+{
+	float alpha = getAlpha();
+	x = prevX[body] + (this->x[body] - prevX[body]) * alpha;
+	y = prevY[body] + (this->y[body] - prevY[body]) * alpha;
+	z = prevZ[body] + (this->z[body] - prevZ[body]) * alpha;
+}
+
+// FNV-1a hash of the bodies' positions and velocities, to check that runs agree.
+unsigned int PhysicsWorld::hashState()
+{
+	unsigned int hash = 2166136261u;
+	const std::vector<float> *arrays[] = { &x, &y, &z, &vx, &vy, &vz };
+
+	for (auto array : arrays)
+	{
+		const unsigned char *bytes = (const unsigned char *)array->data();
+		for (size_t i = 0; i < array->size() * sizeof(float); i++) hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
@@ -0,0 +1,111 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <vector>
+
+#include "jobSystem.h"
+
+#define PHYSICS_MAX_STEPS 10 // Most steps taken in one advance, so that a slow frame does not
+                             // make the next slower still.
+#define PHYSICS_CHUNK 1024 // Bodies or pairs handled by one job.
+#define PHYSICS_ITERATIONS 4 // Passes over the pairs in a step.
+
+// A plane n.p = d bounding the bodies, n being a unit normal pointing to their side.
+struct PhysicsPlane
+{
+	float nx, ny, nz, d;
+};
+
+// A torus about an axis parallel to the z-axis, as glutWireTorus() draws it: a tube of 
+// radius inRad about a circle of radius outRad centered at (cx, cy, cz).
+struct PhysicsTorus
+{
+	float cx, cy, cz, inRad, outRad;
+};
+
+// A pair of bodies whose spheres overlap.
+struct PhysicsPair
+{
+	int a, b;
+};
+
+// Physics world class: spherical bodies moving under gravity, applied acceleration and 
+// viscous drag, colliding with fixed planes and tori and with one another.
+//
+// The world advances in steps of a fixed time, however long the frames between advances 
+// are, the time left over being carried to the next advance, so that the motion does not 
+// depend on the frame rate. Positions are drawn interpolated between the last two steps 
+// by the fraction of a step left over. Each step is semi-implicit Euler: velocity is 
+// updated from the acceleration first and position from the new velocity.
+//
+// Body state is kept as a structure of arrays. Pairs of bodies that may touch are found 
+// by sweep and prune along x within columns of a grid in y and z, and contacts are 
+// resolved Jacobi-style in a few passes, every pair's impulse being computed from the 
+// state before any is applied, and each body summing its pairs' in a fixed order. Each 
+// pair's impulse is carried to the next step, so that stacks come to rest. With a job 
+// system the work is spread over its threads, the result being the same, bit for bit, 
+// whatever the number of threads.
+class PhysicsWorld
+{
+public:
+	PhysicsWorld(float timeStep, JobSystem *jobs = NULL);
+	int addBody(float x, float y, float z, float vx, float vy, float vz, float radius, float mass);
+	void addPlane(float nx, float ny, float nz, float d);
+	void addTorus(float cx, float cy, float cz, float inRad, float outRad);
+	void setGravity(float x, float y, float z) { gravity[0] = x; gravity[1] = y; gravity[2] = z; }
+	void setDrag(float d) { drag = d; }
+	void setRestitution(float e) { restitution = e; }
+	void setAcceleration(int body, float ax, float ay, float az, float duration = -1.0); // Apply for a duration,
+	                                                                                     // forever if negative.
+	void setPosition(int body, float x, float y, float z); // Move without interpolating from the old position.
+	void setVelocity(int body, float vx, float vy, float vz);
+
+	int advance(float frameTime); // Take the steps due after frameTime more time, returning their number.
+	void step(); // Take one step.
+	void getPosition(int body, float &x, float &y, float &z); // Position interpolated for drawing.
+	float getAlpha() { return accumulator / timeStep; } // Fraction of a step left over.
+	void resetTime() { accumulator = 0.0; } // Drop the time left over, as when the bodies are put back.
+	int getNumBodies() { return x.size(); }
+	int getNumPairs() { return pairs.size(); }
+	unsigned int hashState(); // Hash of the positions and velocities.
+
+	// Body state.
+	std::vector<float> x, y, z; // Positions.
+	std::vector<float> prevX, prevY, prevZ; // Positions before the last step.
+	std::vector<float> vx, vy, vz; // Velocities.
+	std::vector<float> ax, ay, az; // Applied accelerations.
+	std::vector<int> accelSteps; // Steps the applied acceleration lasts, negative if forever.
+	std::vector<float> radius, invMass; // Radii and inverse masses.
+
+private:
+	void parallelFor(int count, const std::function<void(int)> &job);
+	void integrate(int first, int last);
+	void collideStatic(int first, int last);
+	void findPairs();
+	void resolvePairs();
+
+	JobSystem *jobs;
+	float timeStep, accumulator;
+	float gravity[3], drag, restitution;
+	std::vector<PhysicsPlane> planes;
+	std::vector<PhysicsTorus> tori;
+
+	std::vector<long long> cellKey; // Each body's cell of the sweep grid.
+	std::vector<int> order; // Bodies sorted by cell and the low end of their x extent.
+	std::vector<float> sorted; // Positions and radii in that order, four floats a body.
+	std::vector<float> sortedMinX; // The low ends in that order.
+	std::vector<long long> cells; // The cells holding bodies, in order.
+	std::vector<int> cellStart; // Start of each cell's run of the order.
+	std::vector<int> sortedCell; // Cell of each body in the order.
+	std::vector<int> cellNeighbours; // Each cell's four neighbours after it, -1 where empty.
+	std::vector<std::vector<PhysicsPair> > chunkPairs; // Pairs found by each job.
+	std::vector<PhysicsPair> pairs; // All pairs.
+	std::vector<float> pairImpulse; // Normal, bounce speed, share, impulse, its change and position 
+	                                // correction of each pair.
+	std::vector<int> contactStart, contacts; // Each body's pairs, as 2 * pair + side.
+	std::vector<PhysicsPair> lastPairs; // The last step's pairs,
+	std::vector<int> lastContactStart, lastContacts; // each body's pairs then,
+	std::vector<float> lastPairImpulse; // and the pairs' impulses at its end.
+};
+
+#endif
@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// physicsBenchmark.cpp
+//
+// This command-line program times the physics world of throwBall.cpp and 
+// ballAndTorusWithFriction.cpp on a large scene: balls dropped in a box onto a torus, 
+// colliding with the floor, the walls, the torus and one another. It reports steps and 
+// body steps per second and, with -check, runs the scene again on a single thread to
+// confirm that the result is the same whatever the number of threads, and drops a column 
+// of balls on the floor to confirm that it comes to rest standing.
+//
+// Usage:
+// PhysicsBenchmark [-bodies n] [-steps n] [-threads n] [-check]
+// -bodies n   Number of balls, 100000 by default.
+// -steps n    Number of steps timed, 200 by default.
+// -threads n  Number of threads, by default the number of hardware threads.
+// -check      Repeat on one thread and compare the final states, and check a resting stack.
+//
+// Sumanta Guha
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "physics.h"
+
+#define TIME_STEP 0.01 // Step in seconds.
+#define BALL_RADIUS 0.5 // Radius of a ball.
+#define BALL_SPACING 1.25 // Distance between balls at the start.
+#define BOX_SIZE 40.0 // Half the width of the box.
+#define STACK_BALLS 10 // Balls in the column of the stack check.
+#define STACK_STEPS 1000 // Steps the column is given to come to rest.
+
+// Globals.
+static int numBodies = 100000; // Number of balls.
+static int numSteps = 200; // Number of steps timed.
+static int numThreads = 0; // Number of threads.
+
+// Routine to fill a world with the scene: balls on a grid over the floor, each 
+// with a small pseudo-random velocity, and a torus standing on the floor.
+void fillWorld(PhysicsWorld &world)
+{
+	int perRow = (int)(2.0 * (BOX_SIZE - BALL_RADIUS) / BALL_SPACING), i;
+	unsigned int seed = 1;
+
+	auto random = [&]() // Pseudo-random number in [-1, 1].
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return (seed >> 8) / 8388608.0f - 1.0f;
+	};
+
+	world.setGravity(0.0, -9.8, 0.0);
+	world.setRestitution(0.5);
+	world.setDrag(0.05);
+	world.addPlane(0.0, 1.0, 0.0, 0.0); // Floor.
+	world.addPlane(1.0, 0.0, 0.0, -BOX_SIZE); // Walls.
+	world.addPlane(-1.0, 0.0, 0.0, -BOX_SIZE);
+	world.addPlane(0.0, 0.0, 1.0, -BOX_SIZE);
+	world.addPlane(0.0, 0.0, -1.0, -BOX_SIZE);
+	world.addTorus(0.0, 15.0, 0.0, 3.0, 12.0);
+
+	for (i = 0; i < numBodies; i++)
+		world.addBody(-BOX_SIZE + BALL_RADIUS + BALL_SPACING * (i % perRow),
+			2.0 * BALL_RADIUS + BALL_SPACING * (i / (perRow * perRow)),
+			-BOX_SIZE + BALL_RADIUS + BALL_SPACING * ((i / perRow) % perRow),
+			random(), random(), random(), BALL_RADIUS, 1.0);
+}
+
+// Routine to run the scene on a number of threads, returning the final state's hash.
+unsigned int runScene(int threads, bool report)
+{
+	JobSystem *jobs = threads > 1 ? new JobSystem(threads - 1) : NULL; // None for one thread, as no
+	                                                                    // workers means one a core.
+	PhysicsWorld world(TIME_STEP, jobs);
+	long long numPairs = 0;
+	int i;
+
+	fillWorld(world);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < numSteps; i++)
+	{
+		world.step();
+		numPairs += world.getNumPairs();
+	}
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+	if (report)
+	{
+		std::cout << world.getNumBodies() << " bodies, " << numSteps << " steps, " << threads << " threads" << std::endl
+			<< "Time: " << seconds << " s, " << 1000.0 * seconds / numSteps << " ms per step" << std::endl
+			<< "Steps per second: " << numSteps / seconds << std::endl
+			<< "Body steps per second: " << (double)numBodies * numSteps / seconds << std::endl
+			<< "Contacts per step: " << numPairs / numSteps << std::endl;
+	}
+	delete jobs;
+	return world.hashState();
+}
+
+// Routine to drop a column of balls, barely apart, on the floor and check that it comes 
+// to rest standing: the top ball near its height with the balls touching, the bottom one 
+// not sunk into the floor and the balls all but still.
+bool checkStack()
+{
+	PhysicsWorld world(TIME_STEP);
+	float meanSpeed2 = 0.0, top, bottom;
+	int i;
+
+	world.setGravity(0.0, -9.8, 0.0);
+	world.setRestitution(0.5);
+	world.setDrag(0.05);
+	world.addPlane(0.0, 1.0, 0.0, 0.0);
+	for (i = 0; i < STACK_BALLS; i++)
+		world.addBody(0.0, BALL_RADIUS + (2.0 * BALL_RADIUS + 0.01) * i, 0.0, 0.0, 0.0, 0.0, BALL_RADIUS, 1.0);
+
+	for (i = 0; i < STACK_STEPS; i++) world.step();
+
+	for (i = 0; i < STACK_BALLS; i++)
+		meanSpeed2 += (world.vx[i] * world.vx[i] + world.vy[i] * world.vy[i] + world.vz[i] * world.vz[i]) / STACK_BALLS;
+	top = world.y[STACK_BALLS - 1];
+	bottom = world.y[0];
+
+	std::cout << "Stack of " << STACK_BALLS << ": top at " << top << " of " << (2 * STACK_BALLS - 1) * BALL_RADIUS
+		<< ", bottom at " << bottom << ", mean squared speed " << meanSpeed2 << std::endl;
+	return fabs(top - (2 * STACK_BALLS - 1) * BALL_RADIUS) < 0.02 * STACK_BALLS 
+		&& bottom > 0.99 * BALL_RADIUS && meanSpeed2 < 1e-3;
+}
+
+// Main routine.
+int main(int argc, char **argv)
+{
+	bool check = false;
+	unsigned int hash;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-bodies" && i + 1 < argc) numBodies = atoi(argv[++i]);
+		else if (arg == "-steps" && i + 1 < argc) numSteps = atoi(argv[++i]);
+		else if (arg == "-threads" && i + 1 < argc) numThreads = atoi(argv[++i]);
+		else if (arg == "-check") check = true;
+		else
+		{
+			std::cout << "Usage: PhysicsBenchmark [-bodies n] [-steps n] [-threads n] [-check]" << std::endl;
+			return 1;
+		}
+	}
+	if (numThreads <= 0) numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	hash = runScene(numThreads, true);
+	std::cout << "State hash: " << std::hex << hash << std::dec << std::endl;
+
+	if (check)
+	{
+		unsigned int singleHash = runScene(1, false);
+		std::cout << "Single-threaded state hash: " << std::hex << singleHash << std::dec
+			<< (singleHash == hash ? " (same)" : " (DIFFERENT)") << std::endl;
+		if (singleHash != hash) return 1;
+
+		if (!checkStack())
+		{
+			std::cout << "The stack did not come to rest." << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -4,6 +4,11 @@
 // This program shows the motion of a ball subject to gravity. The gravitational
 // acceleration and initial velocity of the ball are changeable.
 //
+// The ball is a body of a physics world stepped at a fixed rate, however often frames
+// are drawn, and drawn at its position interpolated between steps. It bounces on a 
+// floor at the height it is thrown from. Time is measured in units of animationPeriod 
+// milliseconds, as the original timer ticks were.
+//
 // Interaction:
 // Press space to toggle between animation on and off.
 // Press right/left arrow kes to increase/decrease the initial horizontal velocity.
@@ -22,17 +27,25 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
 
+#include "physics.h"
+
 #define PI 3.14159265
+#define FRAME_PERIOD 16 // Time interval between frames in milliseconds.
+#define TIME_STEP 0.1 // Physics time step.
+#define BALL_RADIUS 2.0 // Radius of the ball.
 
 // Globals.
 static int isAnimate = 0; // Animated?
-static int animationPeriod = 100; // Time interval between frames.
+static int animationPeriod = 100; // Milliseconds per unit of time.
 static float t = 0.0; // Time parameter.
+static int lastTime; // Time the last frame was drawn in milliseconds.
 static float h = 0.5; // Horizontal component of initial velocity.
 static float v = 4.0; // Vertical component of initial velocity.
 static float g = 0.2;  // Gravitational accelaration.
 static char theStringBuffer[10]; // String buffer.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
+static PhysicsWorld world(TIME_STEP); // Physics world.
+static int ball; // Body of the ball.
 
 // Routine to draw a bitmap character string.
 void writeBitmapString(void *font, char *string)
@@ -81,8 +94,10 @@ void drawScene(void)
 	// Place scene in frustum.
 	glTranslatef(-15.0, -15.0, -25.0);
 
-	// Apply equations of motion to transform sphere.
-	glTranslatef(h*t, v*t - (g / 2.0)*t*t, 0.0);
+	// Move sphere to the ball's position.
+	float x, y, z;
+	world.getPosition(ball, x, y, z);
+	glTranslatef(x, y, z);
 
 	// Sphere.
 	glColor3f(0.0, 0.0, 1.0);
@@ -96,16 +111,34 @@ void animate(int value)
 {
 	if (isAnimate)
 	{
-		t += 1.0;
+		// Advance the world by the time since the last frame.
+		int time = glutGet(GLUT_ELAPSED_TIME);
+		t += world.advance((float)(time - lastTime) / animationPeriod) * TIME_STEP;
+		lastTime = time;
+
 		glutPostRedisplay();
-		glutTimerFunc(animationPeriod, animate, 1);
+		glutTimerFunc(FRAME_PERIOD, animate, 1);
 	}
 }
 
+// Routine to put the ball back at the start with the initial velocity.
+void resetBall(void)
+{
+	world.setPosition(ball, 0.0, 0.0, 0.0);
+	world.setVelocity(ball, h, v, 0.0);
+	world.resetTime();
+	t = 0.0;
+}
+
 // Initialization routine.
 void setup(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 0.0);
+
+	world.setGravity(0.0, -g, 0.0);
+	world.setRestitution(0.8);
+	world.addPlane(0.0, 1.0, 0.0, -BALL_RADIUS); // Floor.
+	ball = world.addBody(0.0, 0.0, 0.0, h, v, 0.0, BALL_RADIUS, 1.0);
 }
 
 // OpenGL window reshape routine.
@@ -132,12 +165,13 @@ void keyInput(unsigned char key, int x, int y)
 		else
 		{
 			isAnimate = 1;
+			lastTime = glutGet(GLUT_ELAPSED_TIME);
 			animate(1);
 		}
 		break;
 	case 'r':
 		isAnimate = 0;
-		t = 0.0;
+		resetBall();
 		glutPostRedisplay();
 		break;
 	default:
@@ -155,6 +189,10 @@ void specialKeyInput(int key, int x, int y)
 	if (key == GLUT_KEY_PAGE_UP) g += 0.05;
 	if (key == GLUT_KEY_PAGE_DOWN) if (g > 0.1) g -= 0.05;
 
+	// Gravity changes at once, the initial velocity only before the ball is thrown.
+	world.setGravity(0.0, -g, 0.0);
+	if (t == 0.0) resetBall();
+
 	glutPostRedisplay();
 }
 
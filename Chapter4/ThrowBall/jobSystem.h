@@ -0,0 +1,38 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Job system class: a pool of worker threads that, together with the calling thread,
+// run the iterations of a parallel loop, each thread taking the next iteration
+// until none are left.
+class JobSystem
+{
+public:
+	JobSystem(int numThreads = 0); // Constructor, by default one worker per core but one.
+	~JobSystem();
+	int numThreads() { return workers.size() + 1; } // Threads running a loop, the caller included.
+	void parallelFor(int count, const std::function<void(int)> &job); // Run job(0), ..., job(count - 1) 
+	                                                                   // and return when all have.
+
+private:
+	void workerLoop();
+	void runIterations();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake, finished;
+	const std::function<void(int)> *job; // Job of the current loop.
+	int count; // Iterations of the current loop.
+	std::atomic<int> next; // Next iteration to run.
+	int busy; // Workers still in the current loop.
+	unsigned int generation; // Number of loops started.
+	bool quit;
+};
+
+#endif
@@ -0,0 +1,224 @@
+/////////////////////////////////////////////////////////////////////////////////////
+// framePipeline.cpp
+//
+// A job system running parallel loops on a pool of worker threads and a frame 
+// pipeline overlapping the update of one frame's state with the submission of the 
+// frame before it.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include "framePipeline.h"
+
+// JobSystem constructor.
+JobSystem::JobSystem(int numThreads)
+{
+	int i;
+
+	if (numThreads <= 0) numThreads = std::thread::hardware_concurrency() - 1;
+	job = NULL; count = 0; next = 0; busy = 0; generation = 0; quit = false;
+	for (i = 0; i < numThreads; i++) workers.push_back(std::thread(&JobSystem::workerLoop, this));
+}
+
+// JobSystem destructor.
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &worker : workers) worker.join();
+}
+
+// Run iterations of the current loop till none are left.
+void JobSystem::runIterations()
+{
+	int i;
+	while ((i = next++) < count) (*job)(i);
+}
+
+// Routine run by each worker: wait for a loop, help run it, and report when done.
+void JobSystem::workerLoop()
+{
+	unsigned int seen = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || generation != seen; });
+			if (quit) return;
+			seen = generation;
+		}
+		runIterations();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0) finished.notify_one();
+		}
+	}
+}
+
+// Run job(0), ..., job(count - 1) on the workers and the calling thread.
+void JobSystem::parallelFor(int count, const std::function<void(int)> &job)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (int i = 0; i < count; i++) job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->job = &job;
+		this->count = count;
+		next = 0;
+		busy = workers.size();
+		generation++;
+	}
+	wake.notify_all();
+	runIterations();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [&] { return busy == 0; });
+}
+
+// FramePipeline constructor.
+FramePipeline::FramePipeline(std::function<void(int)> capture, std::function<void(int)> update)
+{
+	this->capture = capture;
+	this->update = update;
+	updateSlot = -1; updating = false; pipelined = true; quit = false;
+	updateTime = 0.0; slot = 0;
+	sums.update = sums.wait = sums.submit = sums.frame = 0.0;
+	averages = sums;
+	numFrames = 0; timingsReady = false;
+	frameStart = Clock::now();
+	updater = std::thread(&FramePipeline::updateLoop, this);
+}
+
+// FramePipeline destructor.
+FramePipeline::~FramePipeline()
+{
+	waitForUpdate();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_one();
+	updater.join();
+}
+
+// Routine run by the update thread: wait for a slot to update, update it, and report when done.
+void FramePipeline::updateLoop()
+{
+	Clock::time_point start;
+	int s;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || updateSlot >= 0; });
+			if (quit) return;
+			s = updateSlot;
+		}
+		start = Clock::now();
+		update(s);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			updateTime = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+			updateSlot = -1;
+		}
+		done.notify_one();
+	}
+}
+
+// Wait for the update in flight, if any, to finish.
+void FramePipeline::waitForUpdate()
+{
+	if (!updating) return;
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [&] { return updateSlot < 0; });
+	updating = false;
+}
+
+// Return the slot of the snapshot to submit. When pipelined that is the one updated 
+// during the last frame, and the update of the other is started; otherwise the 
+// snapshot is updated here first.
+int FramePipeline::beginFrame()
+{
+	Clock::time_point now = Clock::now(), start;
+	float wait = 0.0;
+
+	// Record the frame just ended.
+	sums.frame += std::chrono::duration<float, std::milli>(now - frameStart).count();
+	frameStart = now;
+
+	if (updating)
+	{
+		start = Clock::now();
+		waitForUpdate();
+		wait = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		slot = 1 - slot;
+	}
+	else
+	{
+		// Nothing in flight, so update the snapshot in place.
+		capture(slot);
+		start = Clock::now();
+		update(slot);
+		updateTime = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+	sums.update += updateTime;
+	sums.wait += wait;
+
+	// Start updating the other slot, free since its frame was submitted.
+	if (pipelined)
+	{
+		capture(1 - slot);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			updateSlot = 1 - slot;
+		}
+		updating = true;
+		wake.notify_one();
+	}
+
+	submitStart = Clock::now();
+	return slot;
+}
+
+// Mark the end of the submission of the frame.
+void FramePipeline::endFrame()
+{
+	sums.submit += std::chrono::duration<float, std::milli>(Clock::now() - submitStart).count();
+	if (++numFrames == TIMING_FRAMES)
+	{
+		averages.update = sums.update / numFrames;
+		averages.wait = sums.wait / numFrames;
+		averages.submit = sums.submit / numFrames;
+		averages.frame = sums.frame / numFrames;
+		sums.update = sums.wait = sums.submit = sums.frame = 0.0;
+		numFrames = 0;
+		timingsReady = true;
+	}
+}
+
+// Turn pipelining on or off, letting any update in flight finish first.
+void FramePipeline::setPipelined(bool on)
+{
+	if (!on && updating)
+	{
+		waitForUpdate();
+		slot = 1 - slot; // The updated snapshot is the latest.
+	}
+	pipelined = on;
+}
+
+// Return true, with the average timings, once every TIMING_FRAMES frames.
+bool FramePipeline::getTimings(FrameTimings &timings)
+{
+	timings = averages;
+	if (!timingsReady) return false;
+	timingsReady = false;
+	return true;
+}
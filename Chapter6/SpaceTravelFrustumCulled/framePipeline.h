@@ -0,0 +1,91 @@
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Job system class: a pool of worker threads that, together with the calling thread,
+// run the iterations of a parallel loop, each thread taking the next iteration
+// until none are left.
+class JobSystem
+{
+public:
+	JobSystem(int numThreads = 0); // Constructor, by default one worker per core but one.
+	~JobSystem();
+	int numThreads() { return workers.size() + 1; } // Threads running a loop, the caller included.
+	void parallelFor(int count, const std::function<void(int)> &job); // Run job(0), ..., job(count - 1) 
+	                                                                   // and return when all have.
+
+private:
+	void workerLoop();
+	void runIterations();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake, finished;
+	const std::function<void(int)> *job; // Job of the current loop.
+	int count; // Iterations of the current loop.
+	std::atomic<int> next; // Next iteration to run.
+	int busy; // Workers still in the current loop.
+	unsigned int generation; // Number of loops started.
+	bool quit;
+};
+
+// Times of the stages of a frame in milliseconds, averaged over a number of frames.
+struct FrameTimings
+{
+	float update; // Updating a frame's state, on the update thread when pipelined.
+	float wait; // Render thread waiting for that update.
+	float submit; // Render thread submitting a frame.
+	float frame; // Whole frame, from the start of one to the start of the next.
+};
+
+// Frame pipeline class. The state a frame is drawn from is a snapshot, held in one of 
+// two slots, written by an update function and only read by the render thread. When 
+// pipelined, the snapshot of frame N + 1 is updated on a thread of its own while the 
+// render thread submits frame N from the other slot, so that updating and submitting 
+// overlap and a frame takes the longer of the two rather than their sum; otherwise each 
+// frame is updated and then submitted on the render thread. 
+//
+// The capture function, called on the render thread before each update, copies into the
+// slot whatever the update reads that the render thread may change, such as input.
+class FramePipeline
+{
+public:
+	FramePipeline(std::function<void(int)> capture, std::function<void(int)> update);
+	~FramePipeline();
+	int beginFrame(); // Return the slot of the snapshot to submit, starting the update of the next.
+	void endFrame(); // Mark the end of submission.
+	void setPipelined(bool on); // Turn pipelining on or off.
+	bool isPipelined() { return pipelined; }
+	bool getTimings(FrameTimings &timings); // Return true, with the averages, every TIMING_FRAMES frames.
+
+	static const int TIMING_FRAMES = 100;
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+	void updateLoop();
+	void waitForUpdate();
+
+	std::function<void(int)> capture, update;
+	std::thread updater;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	int updateSlot; // Slot being updated, -1 if none.
+	bool updating; // Is an update in flight?
+	bool pipelined, quit;
+	float updateTime; // Time of the last update.
+	int slot; // Slot being submitted.
+
+	Clock::time_point frameStart, submitStart;
+	FrameTimings sums, averages;
+	int numFrames;
+	bool timingsReady;
+};
+
+#endif
@@ -6,6 +6,12 @@
 // asteroids. The view in the left viewport is from a fixed camera; the view in 
 // the right viewport is from the spacecraft.There is approximate collision detection.  
 // Frustum culling is implemented by means of a quadtree data structure.
+//
+// Each frame is drawn from a snapshot of the spacecraft and the asteroids visible in
+// each viewport. With the frame pipeline on, the snapshot of the next frame is updated
+// on a thread of its own, culling subtrees of the quadtree in parallel on a job system,
+// while the current frame is drawn; the average update, wait, submit and frame times
+// are shown in the window and written to the C++ window.
 // 
 // EXECUTION NOTE: If ROWS and COLUMNS are large the quadtree takes time to build so
 //                 the display may take several seconds to come up.
@@ -20,6 +26,7 @@
 // Press the left/right arrow keys to turn the craft.
 // Press the up/down arrow keys to move the craft.
 // Press space to toggle between frustum culling enabled and disabled.
+// Press p to toggle the frame pipeline on and off.
 // 
 // Sumanta Guha.
 ////////////////////////////////////////////////////////////////////////////////////// 
@@ -27,7 +34,9 @@
 #include <cstdlib>
 #include <cmath>
 #include <list>
+#include <vector>
 #include <iostream>
+#include <sstream>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h> 
@@ -35,11 +44,13 @@
 #define PI 3.14159265
 
 #include "intersectionDetectionRoutines.h"
+#include "framePipeline.h"
 
 #define ROWS 100  // Number of rows of asteroids.
 #define COLUMNS 100 // Number of columns of asteroids.
 #define FILL_PROBABILITY 100 // Percentage probability that a particular row-column slot will be 
 // filled with an asteroid. It should be an integer between 0 and 100.
+#define CULL_DEPTH 3 // Depth of the quadtree subtrees culled as separate jobs.
 
 // Globals.
 static long font = (long)GLUT_BITMAP_8_BY_13; // Font selection.
@@ -49,6 +60,8 @@ static float xVal = 0, zVal = 0; // Co-ordinates of the spacecraft.
 static int isFrustumCulled = 0;
 static int isCollision = 0; // Is there collision between the spacecraft and an asteroid?
 static unsigned int spacecraft; // Display lists base index.
+static JobSystem jobs; // Worker threads for per-object work.
+static FrameTimings timings; // Latest average stage times.
 
 // Routine to draw a bitmap character string.
 void writeBitmapString(void *font, char *string)
@@ -128,12 +141,16 @@ public:
 				  // if it intersects at most one asteroid leave it as a leaf and add the intersecting 
 				  // asteroid, if any, to a local list of asteroids.
 
-	void drawAsteroids(float x1, float z1, float x2, float z2,  // Recursive routine to draw the asteroids
-		float x3, float z3, float x4, float z4); // in a square's list if the square is a
-												 // leaf and it intersects the frustum (which
-												 // is specified by the input parameters); 
-												 // if the square is not a leaf, the routine
-												 // recursively calls itself on its children.
+	void findAsteroids(float x1, float z1, float x2, float z2,  // Recursive routine to add the asteroids
+		float x3, float z3, float x4, float z4,  // in a square's list to a list of visible 
+		std::vector<Asteroid*> &visible);        // asteroids if the square is a leaf and it 
+												 // intersects the frustum (which is specified 
+												 // by the input parameters); if the square is 
+												 // not a leaf, the routine recursively calls 
+												 // itself on its children.
+
+	void collectSubtrees(int depth, std::vector<QuadtreeNode*> &subtrees); // Collect the nodes at a depth,
+																		   // and leaves above it, in order.
 
 private:
 	float SWCornerX, SWCornerZ; // x and z co-ordinates of the SW corner of the square.
@@ -199,11 +216,11 @@ void QuadtreeNode::build()
 	}
 }
 
-// Recursive routine to draw the asteroids in a square's list if the square is a
-// leaf and it intersects the frustum (which is specified by the input parameters);
-// if the square is not a leaf, the routine recursively calls itself on its children.
-void QuadtreeNode::drawAsteroids(float x1, float z1, float x2, float z2,
-	float x3, float z3, float x4, float z4)
+// Recursive routine to add the asteroids in a square's list to a list of visible asteroids
+// if the square is a leaf and it intersects the frustum (which is specified by the input 
+// parameters); if the square is not a leaf, the routine recursively calls itself on its children.
+void QuadtreeNode::findAsteroids(float x1, float z1, float x2, float z2,
+	float x3, float z3, float x4, float z4, std::vector<Asteroid*> &visible)
 {
 	// If the square does not intersect the frustum do nothing.
 	if (checkQuadrilateralsIntersection(x1, z1, x2, z2, x3, z3, x4, z4,
@@ -212,19 +229,33 @@ void QuadtreeNode::drawAsteroids(float x1, float z1, float x2, float z2,
 	{
 		if (SWChild == NULL) // Square is leaf.
 		{
-			// Draw all the asteroids in asteroidList.
-			for (auto asteroid : asteroidList) { asteroid.draw(); }
+			// Add all the asteroids in asteroidList.
+			for (auto &asteroid : asteroidList) { visible.push_back(&asteroid); }
 		}
 		else
 		{
-			SWChild->drawAsteroids(x1, z1, x2, z2, x3, z3, x4, z4);
-			NWChild->drawAsteroids(x1, z1, x2, z2, x3, z3, x4, z4);
-			NEChild->drawAsteroids(x1, z1, x2, z2, x3, z3, x4, z4);
-			SEChild->drawAsteroids(x1, z1, x2, z2, x3, z3, x4, z4);
+			SWChild->findAsteroids(x1, z1, x2, z2, x3, z3, x4, z4, visible);
+			NWChild->findAsteroids(x1, z1, x2, z2, x3, z3, x4, z4, visible);
+			NEChild->findAsteroids(x1, z1, x2, z2, x3, z3, x4, z4, visible);
+			SEChild->findAsteroids(x1, z1, x2, z2, x3, z3, x4, z4, visible);
 		}
 	}
 }
 
+// Collect the nodes at a depth below this one, and the leaves above that depth, 
+// in the order findAsteroids() visits them.
+void QuadtreeNode::collectSubtrees(int depth, std::vector<QuadtreeNode*> &subtrees)
+{
+	if (depth == 0 || SWChild == NULL) subtrees.push_back(this);
+	else
+	{
+		SWChild->collectSubtrees(depth - 1, subtrees);
+		NWChild->collectSubtrees(depth - 1, subtrees);
+		NEChild->collectSubtrees(depth - 1, subtrees);
+		SEChild->collectSubtrees(depth - 1, subtrees);
+	}
+}
+
 // Quadtree class.
 class Quadtree
 {
@@ -234,12 +265,15 @@ public:
 												// till each leaf node intersects at
 												// most one asteroid.
 
-	void drawAsteroids(float x1, float z1, float x2, float z2,  // Routine to draw all the asteroids in the  
-		float x3, float z3, float x4, float z4); // asteroid list of each leaf square that
-												 // intersects the frustum.
+	void findAsteroids(float x1, float z1, float x2, float z2,  // Routine to list all the asteroids in the  
+		float x3, float z3, float x4, float z4,  // asteroid list of each leaf square that
+		std::vector<Asteroid*> &visible);        // intersects the frustum, culling subtrees 
+												 // of the quadtree in parallel.
 
 private:
 	QuadtreeNode *header;
+	std::vector<QuadtreeNode*> subtrees; // Subtrees culled as separate jobs.
+	std::vector<std::vector<Asteroid*> > found; // Asteroids found in each subtree.
 };
 
 // Initialize quadtree by splitting nodes till each leaf node intersects at most one asteroid.
@@ -247,17 +281,78 @@ void Quadtree::initialize(float x, float z, float s)
 {
 	header = new QuadtreeNode(x, z, s);
 	header->build();
+	header->collectSubtrees(CULL_DEPTH, subtrees);
+	found.resize(subtrees.size());
 }
 
-// Routine to draw all the asteroids in the asteroid list of each leaf square that intersects the frustum.
-void Quadtree::drawAsteroids(float x1, float z1, float x2, float z2,
-	float x3, float z3, float x4, float z4)
+// Routine to list all the asteroids in the asteroid list of each leaf square that intersects 
+// the frustum. The subtrees are culled as separate jobs, each into a list of its own, and the 
+// lists joined in order, so that the result is the same as that of culling from the root.
+// The nodes above the subtrees are not tested, which costs little as few of them are.
+void Quadtree::findAsteroids(float x1, float z1, float x2, float z2,
+	float x3, float z3, float x4, float z4, std::vector<Asteroid*> &visible)
 {
-	header->drawAsteroids(x1, z1, x2, z2, x3, z3, x4, z4);
+	jobs.parallelFor(subtrees.size(), [&](int i)
+	{
+		found[i].clear();
+		subtrees[i]->findAsteroids(x1, z1, x2, z2, x3, z3, x4, z4, found[i]);
+	});
+
+	visible.clear();
+	for (auto &list : found) visible.insert(visible.end(), list.begin(), list.end());
 }
 
 Quadtree asteroidsQuadtree; // Global quadtree.
 
+// Snapshot of the state a frame is drawn from.
+struct FrameState
+{
+	float xVal, zVal, angle; // Co-ordinates and angle of the spacecraft.
+	int isFrustumCulled, isCollision;
+	std::vector<Asteroid*> fixedVisible, craftVisible; // Asteroids visible from the fixed camera
+	                                                   // and the spacecraft when culling.
+};
+
+static FrameState frameStates[2]; // Snapshots of the frame being drawn and the frame being updated.
+
+// Routine to copy the state changed by input into a snapshot, on the render thread.
+void captureFrameState(int slot)
+{
+	FrameState &state = frameStates[slot];
+	state.xVal = xVal;
+	state.zVal = zVal;
+	state.angle = angle;
+	state.isFrustumCulled = isFrustumCulled;
+	state.isCollision = isCollision;
+}
+
+// Routine to update a snapshot: find the asteroids visible in each viewport.
+void updateFrameState(int slot)
+{
+	FrameState &state = frameStates[slot];
+	float x = state.xVal, z = state.zVal, a = state.angle;
+
+	if (!state.isFrustumCulled) return;
+
+	// Fixed frustum with apex at the origin.
+	asteroidsQuadtree.findAsteroids(-5.0, -5.0, -250.0, -250.0, 250.0, -250.0, 5.0, -5.0, state.fixedVisible);
+
+	// Frustum "carried" by the spacecraft with apex at its tip and oriented with its axis
+	// along the spacecraft's axis. Note that the tip is at 
+	// ( x - 10 * sin( (PI/180.0) * a), 0, z - 10 * cos( (PI/180.0) * a) ).
+	asteroidsQuadtree.findAsteroids(x - 10 * sin((PI / 180.0) * a) - 7.072 * sin((PI / 180.0) * (45.0 + a)),
+		z - 10 * cos((PI / 180.0) * a) - 7.072 * cos((PI / 180.0) * (45.0 + a)),
+		x - 10 * sin((PI / 180.0) * a) - 353.6 * sin((PI / 180.0) * (45.0 + a)),
+		z - 10 * cos((PI / 180.0) * a) - 353.6 * cos((PI / 180.0) * (45.0 + a)),
+		x - 10 * sin((PI / 180.0) * a) + 353.6 * sin((PI / 180.0) * (45.0 - a)),
+		z - 10 * cos((PI / 180.0) * a) - 353.6 * cos((PI / 180.0) * (45.0 - a)),
+		x - 10 * sin((PI / 180.0) * a) + 7.072 * sin((PI / 180.0) * (45.0 - a)),
+		z - 10 * cos((PI / 180.0) * a) - 7.072 * cos((PI / 180.0) * (45.0 - a)),
+		state.craftVisible);
+}
+
+static FramePipeline *pipeline; // Frame pipeline, created once the quadtree is built.
+
 // Initialization routine.
 void setup(void)
 {
@@ -295,6 +390,8 @@ void setup(void)
 	else initialSize = (ROWS - 1)*30.0 + 6.0;
 	asteroidsQuadtree.initialize(-initialSize / 2.0, -37.0, initialSize);
 
+	pipeline = new FramePipeline(captureFrameState, updateFrameState);
+
 	glEnable(GL_DEPTH_TEST);
 	glClearColor(0.0, 0.0, 0.0, 0.0);
 }
@@ -326,10 +423,25 @@ int asteroidCraftCollision(float x, float z, float a)
 	return 0;
 }
 
+// Routine to write the average stage times.
+void writeTimings(void)
+{
+	std::ostringstream text;
+	text.setf(std::ios::fixed);
+	text.precision(1);
+	text << (pipeline->isPipelined() ? "Pipelined" : "Serial") << " ms: update " << timings.update
+		<< " wait " << timings.wait << " submit " << timings.submit << " frame " << timings.frame;
+	writeBitmapString((void*)font, (char*)text.str().c_str());
+}
+
 // Drawing routine.
 void drawScene(void)
 {
 	int i, j;
+
+	// Take the snapshot of this frame, starting the update of the next.
+	const FrameState &state = frameStates[pipeline->beginFrame()];
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Begin left viewport.
@@ -340,17 +452,19 @@ void drawScene(void)
 	glPushMatrix();
 	glColor3f(1.0, 1.0, 1.0);
 	glRasterPos3f(5.0, 25.0, -30.0);
-	if (isFrustumCulled) writeBitmapString((void*)font, "Frustum culling on!");
+	if (state.isFrustumCulled) writeBitmapString((void*)font, "Frustum culling on!");
 	else writeBitmapString((void*)font, "Frustum culling off!");
+	glRasterPos3f(-28.0, -28.0, -30.0);
+	writeTimings();
 	glColor3f(1.0, 0.0, 0.0);
 	glRasterPos3f(-28.0, 25.0, -30.0);
-	if (isCollision) writeBitmapString((void*)font, "Cannot - will crash!");
+	if (state.isCollision) writeBitmapString((void*)font, "Cannot - will crash!");
 	glPopMatrix();
 
 	// Fixed camera.
 	gluLookAt(0.0, 10.0, 20.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
 
-	if (!isFrustumCulled)
+	if (!state.isFrustumCulled)
 		// Draw all the asteroids in arrayAsteroids.
 	{
 		for (j = 0; j<COLUMNS; j++)
@@ -358,13 +472,13 @@ void drawScene(void)
 				arrayAsteroids[i][j].draw();
 	}
 	else // Draw only asteroids in leaf squares of the quadtree that intersect the fixed frustum
-		 // with apex at the origin.
-		asteroidsQuadtree.drawAsteroids(-5.0, -5.0, -250.0, -250.0, 250.0, -250.0, 5.0, -5.0);
+		 // with apex at the origin, as found by the update.
+		for (auto asteroid : state.fixedVisible) asteroid->draw();
 
 	// Draw spacecraft.
 	glPushMatrix();
-	glTranslatef(xVal, 0.0, zVal);
-	glRotatef(angle, 0.0, 1.0, 0.0);
+	glTranslatef(state.xVal, 0.0, state.zVal);
+	glRotatef(state.angle, 0.0, 1.0, 0.0);
 	glCallList(spacecraft);
 	glPopMatrix();
 	// End left viewport.
@@ -377,11 +491,11 @@ void drawScene(void)
 	glPushMatrix();
 	glColor3f(1.0, 1.0, 1.0);
 	glRasterPos3f(5.0, 25.0, -30.0);
-	if (isFrustumCulled)  writeBitmapString((void*)font, "Frustum culling on.");
+	if (state.isFrustumCulled)  writeBitmapString((void*)font, "Frustum culling on.");
 	else writeBitmapString((void*)font, "Frustum culling off.");
 	glColor3f(1.0, 0.0, 0.0);
 	glRasterPos3f(-28.0, 25.0, -30.0);
-	if (isCollision)  writeBitmapString((void*)font, "Cannot - will crash!");
+	if (state.isCollision)  writeBitmapString((void*)font, "Cannot - will crash!");
 	glPopMatrix();
 
 	// Draw a vertical line on the left of the viewport to separate the two viewports
@@ -394,17 +508,17 @@ void drawScene(void)
 	glLineWidth(1.0);
 
 	// Locate the camera at the tip of the cone and pointing in the direction of the cone.
-	gluLookAt(xVal - 10 * sin((PI / 180.0) * angle),
+	gluLookAt(state.xVal - 10 * sin((PI / 180.0) * state.angle),
 		0.0,
-		zVal - 10 * cos((PI / 180.0) * angle),
-		xVal - 11 * sin((PI / 180.0) * angle),
+		state.zVal - 10 * cos((PI / 180.0) * state.angle),
+		state.xVal - 11 * sin((PI / 180.0) * state.angle),
 		0.0,
-		zVal - 11 * cos((PI / 180.0) * angle),
+		state.zVal - 11 * cos((PI / 180.0) * state.angle),
 		0.0,
 		1.0,
 		0.0);
 
-	if (!isFrustumCulled)
+	if (!state.isFrustumCulled)
 		// Draw all the asteroids in arrayAsteroids.
 	{
 		for (j = 0; j<COLUMNS; j++)
@@ -412,21 +526,18 @@ void drawScene(void)
 				arrayAsteroids[i][j].draw();
 	}
 	else // Draw only asteroids in leaf squares of the quadtree that intersect the frustum
-		 // "carried" by the spacecraft with apex at its tip and oriented with its axis
-		 // along the spacecraft's axis. Note that the tip is at 
-		 // ( xVal - 10 * sin( (PI/180.0) * angle), 0, zVal - 10 * cos( (PI/180.0) * angle) ).
-		asteroidsQuadtree.drawAsteroids(xVal - 10 * sin((PI / 180.0) * angle) - 7.072 * sin((PI / 180.0) * (45.0 + angle)),
-			zVal - 10 * cos((PI / 180.0) * angle) - 7.072 * cos((PI / 180.0) * (45.0 + angle)),
-			xVal - 10 * sin((PI / 180.0) * angle) - 353.6 * sin((PI / 180.0) * (45.0 + angle)),
-			zVal - 10 * cos((PI / 180.0) * angle) - 353.6 * cos((PI / 180.0) * (45.0 + angle)),
-			xVal - 10 * sin((PI / 180.0) * angle) + 353.6 * sin((PI / 180.0) * (45.0 - angle)),
-			zVal - 10 * cos((PI / 180.0) * angle) - 353.6 * cos((PI / 180.0) * (45.0 - angle)),
-			xVal - 10 * sin((PI / 180.0) * angle) + 7.072 * sin((PI / 180.0) * (45.0 - angle)),
-			zVal - 10 * cos((PI / 180.0) * angle) - 7.072 * cos((PI / 180.0) * (45.0 - angle))
-		);
+		 // "carried" by the spacecraft, as found by the update.
+		for (auto asteroid : state.craftVisible) asteroid->draw();
 	// End right viewport.
 
+	pipeline->endFrame();
+	if (pipeline->getTimings(timings))
+		std::cout << (pipeline->isPipelined() ? "Pipelined" : "Serial") << " frame pipeline, average ms: update "
+		<< timings.update << ", wait " << timings.wait << ", submit " << timings.submit
+		<< ", frame " << timings.frame << std::endl;
+
 	glutSwapBuffers();
+	glutPostRedisplay(); // Keep drawing, to keep the timings current.
 }
 
 // OpenGL window reshape routine.
@@ -449,11 +560,17 @@ void keyInput(unsigned char key, int x, int y)
 	switch (key)
 	{
 	case 27:
+		delete pipeline;
 		exit(0);
 		break;
 	case ' ':
 		isFrustumCulled = 1 - isFrustumCulled;
 		glutPostRedisplay();
+		break;
+	case 'p':
+		pipeline->setPipelined(!pipeline->isPipelined());
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
@@ -504,7 +621,8 @@ void printInteraction(void)
 	std::cout << "Interaction:" << std::endl;
 	std::cout << "Press the left/right arrow keys to turn the craft." << std::endl
 		<< "Press the up/down arrow keys to move the craft." << std::endl
-		<< "Press space to toggle between frustum culling enabled and disabled." << std::endl;
+		<< "Press space to toggle between frustum culling enabled and disabled." << std::endl
+		<< "Press p to toggle the frame pipeline on and off." << std::endl;
 }
 
 // Main routine.